@@ -47,6 +47,7 @@
 #include <Common/CMS/ModManager.hpp>
 #include <Common/Save.hpp>
 #include <Common/Voxels/InventoryManager.hpp>
+#include <Common/Voxels/TerrainGenerator.hpp>
 
 #include <Client/Graphics/SelectionBoxRenderer.hpp>
 #include <Client/Voxels/AudioEventHandler.hpp>
@@ -83,6 +84,9 @@ namespace phx::client
 		void onEvent(events::Event& e) override;
 		void tick(float dt) override;
 
+		/// @brief The most chunks loaded in the background added each frame.
+		static constexpr std::size_t CHUNKS_PER_FRAME = 16;
+
 	private:
 		/**
 		 * @brief This confirms that the prediction on the client was accurate
@@ -137,5 +141,7 @@ namespace phx::client
         Save* m_save = nullptr;
         voxels::Map*              m_map        = nullptr;
         voxels::InventoryManager* m_invManager = nullptr;
+
+		std::shared_ptr<voxels::TerrainGenerator> m_terrain;
 	};
 } // namespace phx::client
@@ -53,17 +53,36 @@ namespace phx::gfx
 	 * yet. As the project gains maturity and we have more features, this will
 	 * be improved.
 	 *
+	 * Meshing works on a snapshot of the chunk, so it doesn't need to happen
+	 * on the thread that changes the chunk.
+	 *
 	 * @paragraph Usage
 	 * @code
-	 * auto mesh = ChunkMesher::mesh(chunk, renderer->getTextureTable(),
-	 * blockRegistry);
+	 * auto mesh = ChunkMesher::mesh(chunk->snapshot(), blockRegistry);
 	 * @endcode
 	 *
 	 */
 	class ChunkMesher
 	{
 	public:
-		static std::vector<float> mesh(voxels::Chunk*         chunk,
-		                               client::BlockRegistry* blockRegistry);
+		static std::vector<float> mesh(
+		    const voxels::ChunkSnapshot& chunk,
+		    client::BlockRegistry*       blockRegistry);
+
+		/**
+		 * @brief Meshes a slice of a chunk.
+		 * @param chunk A snapshot of the chunk to mesh.
+		 * @param blockRegistry The registry to get models and textures from.
+		 * @param zBegin The first z layer to mesh.
+		 * @param zEnd One past the last z layer to mesh.
+		 * @return The vertices of the blocks in the slice.
+		 *
+		 * Blocks are stored z layer by z layer, so a slice is a single range
+		 * of blocks. Meshing every slice in order gives the same vertices as
+		 * meshing the whole chunk at once.
+		 */
+		static std::vector<float> mesh(
+		    const voxels::ChunkSnapshot& chunk,
+		    client::BlockRegistry* blockRegistry, int zBegin, int zEnd);
 	};
 } // namespace phx::gfx
@@ -40,11 +40,15 @@
 #include <Client/Graphics/TexturePacker.hpp>
 #include <Client/Voxels/BlockRegistry.hpp>
 
+#include <Common/Utility/FlatMap.hpp>
 #include <Common/Voxels/Map.hpp>
 
 #include <entt/entt.hpp>
 
 #include <Common/Position.hpp>
+
+#include <algorithm>
+#include <array>
 #include <unordered_map>
 #include <vector>
 
@@ -114,9 +118,23 @@ namespace phx::gfx
 
 		void prep();
 
+		/// @brief The amount of z layers meshed together. When a chunk
+		/// changes only the slices around the change are meshed again.
+		static constexpr int SLICE_DEPTH =
+		    std::min(4, voxels::Chunk::CHUNK_DEPTH);
+
+		/// @brief The amount of slices in a chunk.
+		static constexpr int SLICE_COUNT =
+		    voxels::Chunk::CHUNK_DEPTH / SLICE_DEPTH;
+
     private:
+		using SlicedMesh = std::array<std::vector<float>, SLICE_COUNT>;
+
         static ChunkRenderData generate(const std::vector<float>& mesh);
 
+		/// @brief Joins the slices of a chunk's mesh into a single mesh.
+		static std::vector<float> join(const SlicedMesh& slices);
+
 	public:
 		void add(voxels::Chunk* chunk);
 		void update(voxels::Chunk* chunk);
@@ -149,10 +167,17 @@ namespace phx::gfx
 		// to be remeshed that are being rendered rn.
 		std::vector<voxels::Chunk*> m_chunks;
 
-		std::unordered_map<math::vec3, ChunkRenderData, math::Vector3Hasher,
-		                   math::Vector3KeyComparator>
+		// both keyed by the coordinates of the chunk.
+		FlatMap<math::vec3i, ChunkRenderData, math::MortonHasher,
+		        math::Vector3KeyComparator>
 		    m_buffers;
 
+		// the mesh of every chunk split into slices, so a change to a chunk
+		// only needs the slices it touches meshing again.
+		FlatMap<math::vec3i, SlicedMesh, math::MortonHasher,
+		        math::Vector3KeyComparator>
+		    m_meshes;
+
 		static const int m_vertexAttributeLocation = 0;
 		static const int m_uvAttributeLocation     = 1;
 		static const int m_normalAttributeLocation = 2;
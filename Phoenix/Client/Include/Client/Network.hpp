@@ -80,6 +80,13 @@ namespace phx::client
 
 		void parseData(phx::net::Packet& packet);
 
+		/**
+		 * @brief Adds the metadata keys the server sent.
+		 *
+		 * @param reader The packet, after its type
+		 */
+		void parseMetadataKeys(phx::Reader& reader);
+
 	public:
 		/**
 		 * @brief Sends a state packet to a client
@@ -102,6 +109,17 @@ namespace phx::client
 		phx::BlockingQueue<std::pair<math::vec3, std::vector<std::byte>>>
 		    chunkQueue;
 
+		/// @brief The most metadata keys a server can send.
+		static constexpr std::size_t MAX_METADATA_KEYS = 4096;
+
+		/**
+		 * @brief The IDs of metadata keys in the chunks the server sends.
+		 *
+		 * Every name it sends is interned, so there's a limit to how many it
+		 * can send.
+		 */
+		MetadataDictionary metadataKeys {MAX_METADATA_KEYS};
+
 	private:
 		bool            m_running = false;
 		phx::net::Host* m_client;
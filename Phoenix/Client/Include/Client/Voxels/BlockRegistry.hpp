@@ -36,6 +36,7 @@
 #include <Common/Registry.hpp>
 #include <Common/Voxels/BlockReferrer.hpp>
 
+#include <array>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -241,6 +242,10 @@ namespace phx::client
 					    }
 
 					    models.add(block.uid, model);
+
+					    // only full cubes hide the faces of their neighbors.
+					    blocks.get(block.uid)->opaque =
+					        model == gfx::BlockModel::BLOCK;
 				    }
 
 				    sol::optional<std::vector<std::string>> luaSoundOnBreak =
@@ -292,5 +297,62 @@ namespace phx::client
 				    }
 			    });
 		}
+
+		/// @brief The texture of each face of a block, see gfx::BlockFace.
+		using FaceTextures = std::array<gfx::TexturePacker::Handle, 6>;
+
+		/**
+		 * @brief Builds the property tables once every block is registered.
+		 *
+		 * On top of the common properties, this resolves the model and the
+		 * texture of every face for each block so the mesher can index them
+		 * by UID rather than looking them up for every block it meshes.
+		 */
+		void freeze()
+		{
+			voxels::BlockReferrer::freeze();
+
+			const std::size_t count = properties.size();
+			m_modelTable.assign(count, gfx::BlockModel::BLOCK);
+			m_faceTextures.assign(count, {});
+			for (std::size_t uid = 0; uid < count; ++uid)
+			{
+				m_modelTable[uid] = *models.get(uid);
+
+				// blocks either have one texture for every face or one per
+				// face, slopes only have 5 faces.
+				const auto&       handles = *textureHandles.get(uid);
+				const std::size_t faces =
+				    m_modelTable[uid] == gfx::BlockModel::SLOPE ? 5 : 6;
+				for (std::size_t face = 0; face < 6; ++face)
+				{
+					m_faceTextures[uid][face] =
+					    handles.size() == faces && face < faces
+					        ? handles[face]
+					        : handles[0];
+				}
+			}
+		}
+
+		gfx::BlockModel getModel(std::size_t uid) const
+		{
+			return m_modelTable[tableIndex(uid)];
+		}
+
+		const FaceTextures& getFaceTextures(std::size_t uid) const
+		{
+			return m_faceTextures[tableIndex(uid)];
+		}
+
+	private:
+		std::size_t tableIndex(std::size_t uid) const
+		{
+			return uid < m_modelTable.size()
+			           ? uid
+			           : voxels::BlockType::UNKNOWN_BLOCK;
+		}
+
+		std::vector<gfx::BlockModel> m_modelTable;
+		std::vector<FaceTextures>    m_faceTextures;
 	};
 } // namespace phx::client
@@ -39,6 +39,7 @@
 #include <Common/Movement.hpp>
 
 #include <Common/PlayerView.hpp>
+#include <algorithm>
 #include <cmath>
 #include <tuple>
 
@@ -116,6 +117,69 @@ Game::Game(gfx::Window* window, entt::registry* registry, bool networked)
 		                               auto block = m_map->getBlockAt(pos);
 		                               return block->id;
 	                               });
+
+	// the ids of every block in a box, x first, then y, then z. Each chunk
+	// is only looked up once rather than once per block.
+	m_modManager->registerFunction(
+	    "voxel.map.getBlocks", [this](math::vec3 from, math::vec3 to) {
+		    const voxels::BlockPos min = voxels::BlockPos::fromWorld(
+		        {std::min(from.x, to.x), std::min(from.y, to.y),
+		         std::min(from.z, to.z)});
+		    const voxels::BlockPos max = voxels::BlockPos::fromWorld(
+		        {std::max(from.x, to.x), std::max(from.y, to.y),
+		         std::max(from.z, to.z)});
+
+		    std::vector<std::string> ids;
+		    ids.reserve(static_cast<std::size_t>(max.x - min.x + 1) *
+		                static_cast<std::size_t>(max.y - min.y + 1) *
+		                static_cast<std::size_t>(max.z - min.z + 1));
+
+		    voxels::Map::Accessor accessor(m_map, min);
+		    for (int z = min.z; z <= max.z; ++z)
+		    {
+			    for (int y = min.y; y <= max.y; ++y)
+			    {
+				    for (int x = min.x; x <= max.x; ++x)
+				    {
+					    accessor.moveTo({x, y, z});
+					    ids.push_back(accessor.getBlock()->id);
+				    }
+			    }
+		    }
+
+		    return sol::as_table(std::move(ids));
+	    });
+
+	// the batched functions fire one update per chunk rather than one per
+	// block, so mods should prefer them for anything bigger than a block.
+	m_modManager->registerFunction(
+	    "voxel.map.fill",
+	    [this](math::vec3 from, math::vec3 to, std::string id) {
+		    m_map->fill(from, to, m_blockRegistry.getByID(id));
+	    });
+	m_modManager->registerFunction(
+	    "voxel.map.setBlocks", [this](sol::table edits) {
+		    std::vector<voxels::Map::BlockEdit> batch;
+		    batch.reserve(edits.size());
+
+		    // each entry is a {position, id} pair.
+		    for (const auto& edit : edits)
+		    {
+			    sol::table entry = edit.second;
+			    batch.push_back(
+			        {entry.get<math::vec3>(1),
+			         m_blockRegistry.getByID(entry.get<std::string>(2))});
+		    }
+
+		    m_map->applyBatch(batch);
+	    });
+
+	// the save keeps its seed, so the world comes out the same every time.
+	m_terrain = std::make_shared<voxels::TerrainGenerator>(&m_blockRegistry,
+	                                                       m_save->getSeed());
+
+	// biomes can only be registered while mods are loading.
+	m_terrain->registerAPI(m_modManager);
 }
 
 Game::~Game()
@@ -142,17 +206,25 @@ void Game::onAttach()
 		exit(EXIT_FAILURE);
 	}
 
+	// every block has been registered now, so the lookup tables can be built.
+	m_blockRegistry.freeze();
+
 	LOG_INFO("MAIN") << "Registering world";
 	if (m_network)
 	{
         m_chat = new gfx::ChatBox(m_window, &m_network->messageQueue);
-		m_map =
-		    new voxels::Map(&m_network->chunkQueue, &m_blockRegistry);
+		m_map = new voxels::Map(&m_network->chunkQueue, &m_blockRegistry,
+		                        &m_network->metadataKeys);
 	}
 	else
 	{
         m_chat = new gfx::ChatBox(m_window, nullptr);
 		m_map = m_save->getOrCreateMap("Map1", &m_blockRegistry);
+
+		// every biome has been registered too, the map's workers are about
+		// to start generating.
+		m_terrain->freeze();
+		m_map->setGenerator(m_terrain);
 	}
 	m_invManager =
 	    new voxels::InventoryManager(m_save, &m_itemRegistry);
@@ -324,6 +396,10 @@ void Game::tick(float dt)
 		confirmState(position);
 	}
 
+	// picks up chunks loaded in the background or received from the server,
+	// and writes changed ones to the save every so often.
+	m_map->update(CHUNKS_PER_FRAME);
+
 	if (m_followCam)
 	{
 		m_prevPos = position.position;
@@ -32,46 +32,80 @@
 
 using namespace phx::gfx;
 
-std::vector<float> ChunkMesher::mesh(phx::voxels::Chunk*         chunk,
-                                     phx::client::BlockRegistry* blockRegistry)
+std::vector<float> ChunkMesher::mesh(
+    const phx::voxels::ChunkSnapshot& chunk,
+    phx::client::BlockRegistry*       blockRegistry)
+{
+	return mesh(chunk, blockRegistry, 0, voxels::Chunk::CHUNK_DEPTH);
+}
+
+std::vector<float> ChunkMesher::mesh(
+    const phx::voxels::ChunkSnapshot& chunk,
+    phx::client::BlockRegistry* blockRegistry, int zBegin, int zEnd)
 {
 	std::vector<float> mesh;
 
-	auto&           blocks   = chunk->getBlocks();
-	phx::math::vec3 chunkPos = chunk->getChunkPos();
+	// only solid blocks produce any vertices, so a chunk without any (most of
+	// them at any view distance) has nothing to mesh.
+	if (chunk.isEmpty())
+	{
+		return mesh;
+	}
+
+	const voxels::BlockStorage& blocks   = chunk.getStorage();
+	phx::math::vec3             chunkPos = chunk.getChunkPos();
 
 	using namespace voxels;
-	for (std::size_t i = 0;
-	     i < Chunk::CHUNK_WIDTH * Chunk::CHUNK_HEIGHT * Chunk::CHUNK_DEPTH; ++i)
+
+	// the faces of full blocks that aren't covered by another full block,
+	// worked out for the whole chunk at once from the occupancy masks.
+	using Axis = Chunk::Mask::Axis;
+
+	const Chunk::Mask& solid  = chunk.getSolidMask();
+	const Chunk::Mask  north  = chunk.getVisibleFaces(Axis::Z, -1);
+	const Chunk::Mask  south  = chunk.getVisibleFaces(Axis::Z, 1);
+	const Chunk::Mask  bottom = chunk.getVisibleFaces(Axis::Y, -1);
+	const Chunk::Mask  top    = chunk.getVisibleFaces(Axis::Y, 1);
+	const Chunk::Mask  east   = chunk.getVisibleFaces(Axis::X, -1);
+	const Chunk::Mask  west   = chunk.getVisibleFaces(Axis::X, 1);
+
+	// a z layer is a whole number of mask words, so a slice always starts on
+	// a word boundary.
+	const std::size_t layerSize = Chunk::Geometry::LAYER;
+	const std::size_t end       = zEnd * layerSize;
+	for (std::size_t i = zBegin * layerSize; i < end; ++i)
 	{
-		BlockType* block = blocks[i];
+		// skip 64 blocks at a time when none of them are solid.
+		if ((i & 63) == 0 && solid.getWords()[i >> 6] == 0)
+		{
+			i += 63;
+			continue;
+		}
 
-		if (block->category != BlockCategory::SOLID)
+		if (!solid.test(i))
 			continue;
 
+		BlockType* block = blocks.get(i);
+
 		// get position of block in chunk.
-		const std::size_t x = i % Chunk::CHUNK_WIDTH;
-		const std::size_t y = (i / Chunk::CHUNK_WIDTH) % Chunk::CHUNK_HEIGHT;
-		const std::size_t z = i / (Chunk::CHUNK_WIDTH * Chunk::CHUNK_HEIGHT);
+		const std::size_t x = Chunk::Geometry::xOf(i);
+		const std::size_t y = Chunk::Geometry::yOf(i);
+		const std::size_t z = Chunk::Geometry::zOf(i);
 
 		// get textures since at this point we know we're gonna be meshing
 		// something.
-		std::vector<TexturePacker::Handle>* tex = blockRegistry->textureHandles.get(block->uid);
+		std::vector<TexturePacker::Handle>* tex =
+		    blockRegistry->textureHandles.get(block->uid);
+		const client::BlockRegistry::FaceTextures& faceTextures =
+		    blockRegistry->getFaceTextures(block->uid);
 
-		auto insertToMesh = [&mesh, tex, blockRegistry,
+		auto insertToMesh = [&mesh, &faceTextures, blockRegistry,
 		                     chunkPos](DefaultMeshVertex const* vertex,
 		                               std::size_t vertexCount, BlockFace face,
-		                               const math::vec3& blockPos) {	
-			const TextureData* texData = nullptr;
-			if ((*tex).size() != 6)
-			{
-				texData = blockRegistry->texturePacker.getData((*tex)[0]);
-			}
-			else
-			{
-				texData = blockRegistry->texturePacker.getData((*tex)[static_cast<std::size_t>(face)]);
-			}
-			
+		                               const math::vec3& blockPos) {
+			const TextureData* texData = blockRegistry->texturePacker.getData(
+			    faceTextures[static_cast<std::size_t>(face)]);
+
 			for (std::size_t i = 0; i < vertexCount; ++i)
 			{
 				DefaultMeshVertex const* current = vertex + i;
@@ -107,134 +141,49 @@ std::vector<float> ChunkMesher::mesh(phx::voxels::Chunk*         chunk,
 		// a look sooner than later, but a couple hundred extra verts shouldn't
 		// kill any modern GPU. This was written 1st Oct, 2020.
 
-		const BlockModel blockModel =
-		    *blockRegistry->models.get(block->uid);
+		const BlockModel blockModel = blockRegistry->getModel(block->uid);
 
 		switch (blockModel)
 		{
 		case BlockModel::BLOCK:
 		{
-			// check if block is on the north border of the chunk.
-			if (z == 0)
+			// faces on the border of the chunk are always added, as are faces
+			// next to anything that isn't a solid full block.
+			if (north.test(i))
 			{
-				// if on north border, add north face.
 				insertToMesh(BLOCK_FRONT, BLOCK_FACE_VERT_COUNT,
 				             BlockFace::NORTH, {x, y, z});
 			}
-			else
-			{
-				// else get the block to the north.
-				BlockType* north = blocks[Chunk::getVectorIndex(x, y, z - 1)];
-
-				// if the block to the north is not solid, or is not a full
-				// block, add the north face.
-				if (north->category != BlockCategory::SOLID ||
-				    *blockRegistry->models.get(north->uid) !=
-				        BlockModel::BLOCK)
-				{
-					insertToMesh(BLOCK_FRONT, BLOCK_FACE_VERT_COUNT,
-					             BlockFace::NORTH, {x, y, z});
-				}
-			}
 
-			// check if the block is on the south border
-			if (z == Chunk::CHUNK_DEPTH - 1)
+			if (south.test(i))
 			{
 				insertToMesh(BLOCK_BACK, BLOCK_FACE_VERT_COUNT,
 				             BlockFace::SOUTH, {x, y, z});
 			}
-			else
-			{
-				// else get the block to the south.
-				BlockType* south = blocks[Chunk::getVectorIndex(x, y, z + 1)];
-
-				// if the block to the south is not solid, or is not a full
-				// block, add the south face.
-				if (south->category != BlockCategory::SOLID ||
-				    *blockRegistry->models.get(south->uid) !=
-				        BlockModel::BLOCK)
-				{
-					insertToMesh(BLOCK_BACK, BLOCK_FACE_VERT_COUNT,
-					             BlockFace::SOUTH, {x, y, z});
-				}
-			}
 
-			// check if block is on the bottom border of the chunk.
-			if (y == 0)
+			if (bottom.test(i))
 			{
-				// if on bottom border, add bottom face.
 				insertToMesh(BLOCK_BOTTOM, BLOCK_FACE_VERT_COUNT,
 				             BlockFace::BOTTOM, {x, y, z});
 			}
-			else
-			{
-				// else get the block underneath.
-				BlockType* bottom = blocks[Chunk::getVectorIndex(x, y - 1, z)];
 
-				if (bottom->category != BlockCategory::SOLID ||
-				    *blockRegistry->models.get(bottom->uid) !=
-				        BlockModel::BLOCK)
-				{
-					insertToMesh(BLOCK_BOTTOM, BLOCK_FACE_VERT_COUNT,
-					             BlockFace::BOTTOM, {x, y, z});
-				}
-			}
-
-			// check if the block is on the top border.
-			if (y == Chunk::CHUNK_HEIGHT - 1)
+			if (top.test(i))
 			{
 				insertToMesh(BLOCK_TOP, BLOCK_FACE_VERT_COUNT, BlockFace::TOP,
 				             {x, y, z});
 			}
-			else
-			{
-				// else get the block to the top of it.
-				BlockType* top = blocks[Chunk::getVectorIndex(x, y + 1, z)];
-
-				if (top->category != BlockCategory::SOLID ||
-				    *blockRegistry->models.get(top->uid) !=
-				        BlockModel::BLOCK)
-				{
-					insertToMesh(BLOCK_TOP, BLOCK_FACE_VERT_COUNT,
-					             BlockFace::TOP, {x, y, z});
-				}
-			}
 
-			if (x == 0)
+			if (east.test(i))
 			{
 				insertToMesh(BLOCK_RIGHT, BLOCK_FACE_VERT_COUNT,
 				             BlockFace::EAST, {x, y, z});
 			}
-			else
-			{
-				BlockType* east = blocks[Chunk::getVectorIndex(x - 1, y, z)];
-
-				if (east->category != BlockCategory::SOLID ||
-				    *blockRegistry->models.get(east->uid) !=
-				        BlockModel::BLOCK)
-				{
-					insertToMesh(BLOCK_RIGHT, BLOCK_FACE_VERT_COUNT,
-					             BlockFace::EAST, {x, y, z});
-				}
-			}
 
-			if (x == Chunk::CHUNK_WIDTH - 1)
+			if (west.test(i))
 			{
 				insertToMesh(BLOCK_LEFT, BLOCK_FACE_VERT_COUNT, BlockFace::WEST,
 				             {x, y, z});
 			}
-			else
-			{
-				BlockType* west = blocks[Chunk::getVectorIndex(x + 1, y, z)];
-
-				if (west->category != BlockCategory::SOLID ||
-				    *blockRegistry->models.get(west->uid) !=
-				        BlockModel::BLOCK)
-				{
-					insertToMesh(BLOCK_LEFT, BLOCK_FACE_VERT_COUNT,
-					             BlockFace::WEST, {x, y, z});
-				}
-			}
 		}
 		break;
 		case BlockModel::SLAB:
@@ -33,6 +33,7 @@
 
 #include <glad/glad.h>
 
+#include <algorithm>
 #include <unordered_set>
 
 using namespace phx::gfx;
@@ -106,6 +107,23 @@ ChunkRenderData ChunkRenderer::generate(const std::vector<float>& mesh)
     return data;
 }
 
+std::vector<float> ChunkRenderer::join(const SlicedMesh& slices)
+{
+	std::size_t size = 0;
+	for (const auto& slice : slices)
+	{
+		size += slice.size();
+	}
+
+	std::vector<float> mesh;
+	mesh.reserve(size);
+	for (const auto& slice : slices)
+	{
+		mesh.insert(mesh.end(), slice.begin(), slice.end());
+	}
+	return mesh;
+}
+
 void ChunkRenderer::add(phx::voxels::Chunk* chunk)
 {
 	const auto it = std::find(m_chunks.begin(), m_chunks.end(), chunk);
@@ -119,14 +137,25 @@ void ChunkRenderer::add(phx::voxels::Chunk* chunk)
 		return;
 	}
 
-	auto mesh = ChunkMesher::mesh(chunk, m_blockRegistry);
+	const voxels::ChunkSnapshot snapshot = chunk->snapshot();
+
+	SlicedMesh& slices = m_meshes[chunk->getChunkCoords()];
+	for (int slice = 0; slice < SLICE_COUNT; ++slice)
+	{
+		slices[slice] = ChunkMesher::mesh(snapshot, m_blockRegistry,
+		                                  slice * SLICE_DEPTH,
+		                                  (slice + 1) * SLICE_DEPTH);
+	}
+	chunk->markClean(voxels::Chunk::MESHER);
+
+	auto mesh = join(slices);
 	if (mesh.empty())
 	{
 		// the mesh is empty, don't bother with adding it or anything.
 		return;
 	}
 
-	m_buffers.insert({chunk->getChunkPos(), generate(mesh)});
+	m_buffers.emplace(chunk->getChunkCoords(), generate(mesh));
 }
 
 void ChunkRenderer::update(phx::voxels::Chunk* chunk)
@@ -134,18 +163,44 @@ void ChunkRenderer::update(phx::voxels::Chunk* chunk)
 	const auto it = std::find(m_chunks.begin(), m_chunks.end(), chunk);
 	if (it == m_chunks.end())
 	{
-		// add a chunk if not exists for compatibility.
-		add(chunk);
+		// the chunk has left the view, it might not even be loaded anymore.
 		return;
 	}
 
-	auto mesh = ChunkMesher::mesh(chunk, m_blockRegistry);
+	if (!chunk->isDirty(voxels::Chunk::MESHER))
+	{
+		// nothing has changed since the chunk was last meshed.
+		return;
+	}
+
+	// the faces of blocks next to a change can change too, so the slices
+	// one layer either side of the changed region are meshed again.
+	const voxels::DirtyRegion region = chunk->markClean(voxels::Chunk::MESHER);
+	if (region.isEmpty())
+	{
+		return;
+	}
+
+	const int zMin = std::max(region.min.z - 1, 0);
+	const int zMax = std::min(region.max.z + 1, voxels::Chunk::CHUNK_DEPTH - 1);
+
+	const voxels::ChunkSnapshot snapshot = chunk->snapshot();
+
+	SlicedMesh& slices = m_meshes[chunk->getChunkCoords()];
+	for (int slice = zMin / SLICE_DEPTH; slice <= zMax / SLICE_DEPTH; ++slice)
+	{
+		slices[slice] = ChunkMesher::mesh(snapshot, m_blockRegistry,
+		                                  slice * SLICE_DEPTH,
+		                                  (slice + 1) * SLICE_DEPTH);
+	}
+
+	auto mesh = join(slices);
 
 	// we can't just say return if the mesh is empty, since we might be emptying
 	// a mesh (breaking the final block in a chunk so only air is left or
 	// something)
 
-	auto            bufferExist = m_buffers.find(chunk->getChunkPos());
+	auto            bufferExist = m_buffers.find(chunk->getChunkCoords());
 	if (bufferExist == m_buffers.end())
 	{
 		// data does not exist on GPU, we gotta make it.
@@ -155,7 +210,7 @@ void ChunkRenderer::update(phx::voxels::Chunk* chunk)
 			return;
 		}
 
-		m_buffers.insert({chunk->getChunkPos(), generate(mesh)});
+		m_buffers.emplace(chunk->getChunkCoords(), generate(mesh));
 	}
 	else
 	{
@@ -188,7 +243,7 @@ void ChunkRenderer::remove(phx::voxels::Chunk* chunk)
 		// chunks is found, lets do something.
 
 		// delete the opengl buffers.
-		const auto buffer = m_buffers.find((*it)->getChunkPos());
+		const auto buffer = m_buffers.find((*it)->getChunkCoords());
 		if (buffer != m_buffers.end())
 		{
 			glDeleteBuffers(1, &buffer->second.vbo);
@@ -196,7 +251,8 @@ void ChunkRenderer::remove(phx::voxels::Chunk* chunk)
 		}
 
 		// remove the buffer and chunk from internal memory.
-		m_buffers.erase((*it)->getChunkPos());
+		m_buffers.erase((*it)->getChunkCoords());
+		m_meshes.erase((*it)->getChunkCoords());
 		m_chunks.erase(it);
 	}
 }
@@ -239,11 +295,25 @@ void ChunkRenderer::tick(
     m_renderPipeline.setVector3("u_LightDir", lightdir);
     m_renderPipeline.setFloat("u_Brightness", 0.6f);
 
-	for (auto& chunk : PlayerView::update(registry, entity))
+	std::vector<math::vec3i> dropped;
+	for (auto& chunk : PlayerView::update(registry, entity, &dropped))
 	{
 		add(chunk);
 	}
 
+	// the map can unload these chunks from now on, so stop drawing them.
+	for (const math::vec3i& coords : dropped)
+	{
+		const auto it = std::find_if(
+		    m_chunks.begin(), m_chunks.end(), [&coords](voxels::Chunk* chunk) {
+			    return chunk->getChunkCoords() == coords;
+		    });
+		if (it != m_chunks.end())
+		{
+			remove(*it);
+		}
+	}
+
 	voxels::MapEvent e;
 	while (m_mapEvents.try_pop(e))
 	{
@@ -55,8 +55,7 @@ void SelectionBoxRenderer::tick(
         ActorSystem::getTarget(registry, entity).getCurrentPosition();
     selection.floor();
     // do not waste cpu time if we aren't targeting a solid block
-    if (position.map->getBlockAt(selection)->category !=
-        voxels::BlockCategory::SOLID)
+    if (!position.map->isSolidAt(selection))
     {
         return;
     }
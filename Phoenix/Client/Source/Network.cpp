@@ -29,6 +29,7 @@
 #include <Client/Network.hpp>
 
 #include <Common/Logger.hpp>
+#include <Common/Utility/Codec.hpp>
 #include <Common/Voxels/Chunk.hpp>
 
 using namespace phx::client;
@@ -102,13 +103,10 @@ void Network::parseEvent(phx::net::Packet& packet)
 
 void Network::parseState(phx::net::Packet& packet)
 {
-	auto data = packet.getData();
-
-	phx::Serializer ser;
-	ser.setBuffer(data.data(), packet.getSize());
+	phx::Reader reader = packet.getReader(phx::Encoding::COMPACT);
 
 	std::size_t sequence;
-	ser >> sequence;
+	reader >> sequence;
 	if (sequence < m_currentSequence && sequence > 10)
 	{
 		return;
@@ -116,7 +114,11 @@ void Network::parseState(phx::net::Packet& packet)
 	m_currentSequence = sequence;
 
 	Position input;
-	ser >> input.position.x >> input.position.y >> input.position.z;
+	reader >> input.position.x >> input.position.y >> input.position.z;
+	if (!reader)
+	{
+		return;
+	}
 
 	stateQueue.push(std::pair(input, sequence));
 }
@@ -125,31 +127,77 @@ void Network::parseMessage(phx::net::Packet& packet)
 {
 	std::string input;
 
-	auto data = packet.getData();
-
-	phx::Serializer ser;
-	ser.setBuffer(reinterpret_cast<std::byte*>(data.data()), data.size());
-	ser >> input;
+	phx::Reader reader = packet.getReader();
+	reader >> input;
+	if (!reader)
+	{
+		return;
+	}
 
 	messageQueue.push(input);
 }
 
 void Network::parseData(phx::net::Packet& packet)
 {
-	auto data = packet.getData();
+	// decompressed here, so the main thread doesn't have to.
+	phx::data::Data data = packet.getData();
+	if (phx::codec::isCompressed(data.data(), data.size()))
+	{
+		phx::data::Data decompressed;
+		if (!phx::codec::decompress(data.data(), data.size(), decompressed))
+		{
+			return;
+		}
+		data = std::move(decompressed);
+	}
+
+	char type;
+
+	phx::Reader reader(data);
+	reader >> type;
+	if (!reader)
+	{
+		return;
+	}
+
+	if (type == static_cast<char>(phx::net::DataType::METADATA_KEYS))
+	{
+		parseMetadataKeys(reader);
+		return;
+	}
+	if (type != static_cast<char>(phx::net::DataType::CHUNK))
+	{
+		LOG_WARNING("NETWORK") << "Received data of unknown type " << type;
+		return;
+	}
 
 	math::vec3 pos;
-	
-	phx::Serializer ser;
-	ser.setBuffer(reinterpret_cast<std::byte*>(data.data()), sizeof(float) * 3);
-	ser >> pos.x >> pos.y >> pos.z;
+	reader >> pos.x >> pos.y >> pos.z;
+	if (!reader)
+	{
+		return;
+	}
+
+	// the chunk is read later on the main thread, after the packet is gone.
+	// The keys it uses are added before then, they're sent ahead of it.
+	chunkQueue.push(
+	    {pos, std::vector<std::byte>(data.begin() + 1, data.end())});
+}
 
-	chunkQueue.push({pos, data});
+void Network::parseMetadataKeys(phx::Reader& reader)
+{
+	if (!metadataKeys.readNames(reader))
+	{
+		LOG_WARNING("NETWORK")
+		    << "The server sent damaged metadata keys or more than "
+		    << MAX_METADATA_KEYS << ", some metadata will be missing";
+	}
 }
 
 void Network::sendState(const phx::InputState& inputState)
 {
-	Serializer ser;
+	// states are sent every tick, they're kept as small as possible.
+	Serializer ser(phx::Encoding::COMPACT);
 	ser << inputState;
 
 	phx::net::Packet packet =
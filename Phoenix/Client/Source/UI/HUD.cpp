@@ -60,10 +60,9 @@ void HUD::tick(float dt)
 		auto target =
 		    ActorSystem::getTarget(m_registry, m_player).getCurrentPosition();
 		target.floor();
-		auto targetBlock = map->getBlockAt(target);
-		if (targetBlock->category == voxels::BlockCategory::SOLID)
+		if (map->isSolidAt(target))
 		{
-			ImGui::Text("%s", targetBlock->displayName.c_str());
+			ImGui::Text("%s", map->getBlockAt(target)->displayName.c_str());
 		}
 		else
 		{
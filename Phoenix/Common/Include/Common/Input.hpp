@@ -29,21 +29,13 @@
 #pragma once
 
 #include <Common/Math/Math.hpp>
-#include <Common/Utility/Serializer.hpp>
+#include <Common/Utility/Schema.hpp>
 #include <cstddef>
 
 namespace phx
 {
-	struct InputState : ISerializable
+	struct InputState
 	{
-		InputState()          = default;
-		virtual ~InputState() = default;
-
-		InputState(const InputState& other)            = default;
-		InputState& operator=(const InputState& other) = default;
-		InputState(InputState&& other)                 = default;
-		InputState& operator=(InputState&& other)      = default;
-
 		bool forward  = false;
 		bool backward = false;
 		bool left     = false;
@@ -55,7 +47,7 @@ namespace phx
 
 		std::size_t sequence = 0;
 
-		Serializer& operator>>(Serializer& serializer) const override;
-		Serializer& operator<<(Serializer& serializer) override;
+		PHX_SERIALIZABLE(InputState, forward, backward, left, right, up, down,
+		                 rotation.x, rotation.y, sequence);
 	};
 } // namespace phx
@@ -0,0 +1,132 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace phx::math
+{
+	/**
+	 * @brief Seeded gradient noise, in 2D and 3D.
+	 *
+	 * This is Perlin's improved noise, with the permutation shuffled by the
+	 * seed. The shuffle doesn't use <random>, whose distributions differ
+	 * between standard libraries, so a seed gives the same noise everywhere.
+	 * Every value only depends on the seed and the position, so samples can
+	 * be taken from any amount of threads in any order.
+	 *
+	 * Noise is 0 on every integer position and smooth in between, scale the
+	 * position down (or use a Fractal) to get features bigger than 1.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * const Noise noise(1234);
+	 *
+	 * noise.get(0.5f, 2.25f);       // between -1 and 1.
+	 * noise.get(0.5f, 2.25f, 7.f);  // the same in 3D.
+	 *
+	 * // 16 samples along x, one block apart.
+	 * std::array<float, 16> row;
+	 * noise.getRow(row.data(), row.size(), 0.f, 2.25f, 1.f / 16.f);
+	 * @endcode
+	 */
+	class Noise
+	{
+	public:
+		/// @brief Several octaves of noise added up, for detail at every
+		/// scale.
+		struct Fractal
+		{
+			/// @brief The amount of layers of noise.
+			int octaves = 4;
+
+			/// @brief The scale of the first octave.
+			float frequency = 1.f / 64.f;
+
+			/// @brief How much the frequency grows every octave.
+			float lacunarity = 2.f;
+
+			/// @brief How much the amplitude shrinks every octave.
+			float gain = .5f;
+		};
+
+	public:
+		/// @brief Creates the noise for a seed.
+		explicit Noise(std::uint64_t seed = 0);
+
+		/// @brief Gets the seed the noise was made with.
+		std::uint64_t getSeed() const { return m_seed; }
+
+		/// @brief Samples 2D noise, between -1 and 1.
+		float get(float x, float y) const;
+
+		/// @brief Samples 3D noise, between -1 and 1.
+		float get(float x, float y, float z) const;
+
+		/**
+		 * @brief Samples a row of 2D noise.
+		 * @param out Where to write the samples.
+		 * @param count The amount of samples.
+		 * @param x The x position of the first sample.
+		 * @param y The y position of every sample.
+		 * @param step The distance between samples along x.
+		 *
+		 * Sample i is exactly get(x + i * step, y). The loop has no branches
+		 * and only writes to out, so it's cheaper than calling get for every
+		 * sample and the compiler can vectorise it.
+		 */
+		void getRow(float* out, std::size_t count, float x, float y,
+		            float step) const;
+
+		/// @brief Samples fractal 2D noise, between -1 and 1.
+		float getFractal(float x, float y, const Fractal& fractal) const;
+
+		/// @brief Samples fractal 3D noise, between -1 and 1.
+		float getFractal(float x, float y, float z,
+		                 const Fractal& fractal) const;
+
+		/**
+		 * @brief Samples a row of fractal 2D noise.
+		 *
+		 * Sample i is exactly getFractal(x + i * step, y, fractal), see
+		 * getRow.
+		 */
+		void getFractalRow(float* out, std::size_t count, float x, float y,
+		                   float step, const Fractal& fractal) const;
+
+	private:
+		std::uint64_t m_seed;
+
+		// the shuffled numbers 0 to 255, twice, so hashing a corner doesn't
+		// need to wrap.
+		std::array<std::uint8_t, 512> m_permutation;
+	};
+} // namespace phx::math
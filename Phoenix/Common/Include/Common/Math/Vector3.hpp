@@ -29,8 +29,12 @@
 #pragma once
 
 #include <cmath>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
 #include <iostream>
 #include <ostream>
+#include <type_traits>
 
 namespace phx::math
 {
@@ -334,8 +338,66 @@ namespace phx::math
 		template <typename T>
 		std::size_t operator()(const detail::Vector3<T>& k) const
 		{
-			return std::hash<T>()(k.x) ^ std::hash<T>()(k.y) ^
-			       std::hash<T>()(k.z);
+			// each axis is mixed into the ones before it, so swapping axes
+			// around gives a different hash.
+			std::size_t hash = std::hash<T>()(k.x);
+			for (const T& axis : {k.y, k.z})
+			{
+				hash ^= std::hash<T>()(axis) + 0x9e3779b9 + (hash << 6) +
+				        (hash >> 2);
+			}
+			return hash;
+		}
+	};
+
+	/**
+	 * @brief Hasher for integer vectors, such as the coordinates of chunks.
+	 *
+	 * The low 21 bits of each axis are interleaved into a Morton code, so
+	 * nearby positions share their high bits, then a multiply-shift finalizer
+	 * spreads every bit of the code over the whole hash. Unlike xor-ing the
+	 * axes together, (1, 0, 0), (0, 1, 0) and (0, 0, 1) don't collide, and
+	 * the low bits are good enough to index a power of two sized table with.
+	 */
+	struct MortonHasher
+	{
+		/// @brief Spreads the low 21 bits of a value out to every third bit.
+		static constexpr std::uint64_t spread(std::uint64_t value)
+		{
+			value &= 0x1fffff;
+			value = (value | value << 32) & 0x1f00000000ffff;
+			value = (value | value << 16) & 0x1f0000ff0000ff;
+			value = (value | value << 8) & 0x100f00f00f00f00f;
+			value = (value | value << 4) & 0x10c30c30c30c30c3;
+			value = (value | value << 2) & 0x1249249249249249;
+			return value;
+		}
+
+		/// @brief Interleaves the low 21 bits of each axis, x lowest.
+		template <typename T>
+		static constexpr std::uint64_t morton(const detail::Vector3<T>& k)
+		{
+			static_assert(std::is_integral_v<T>,
+			              "Morton codes need integer coordinates.");
+
+			// negative coordinates wrap around, they're still distinct
+			// within 2^20 of the origin.
+			return spread(static_cast<std::uint32_t>(k.x)) |
+			       spread(static_cast<std::uint32_t>(k.y)) << 1 |
+			       spread(static_cast<std::uint32_t>(k.z)) << 2;
+		}
+
+		template <typename T>
+		std::size_t operator()(const detail::Vector3<T>& k) const
+		{
+			// the finalizer from MurmurHash3.
+			std::uint64_t hash = morton(k);
+			hash ^= hash >> 33;
+			hash *= 0xff51afd7ed558ccd;
+			hash ^= hash >> 33;
+			hash *= 0xc4ceb9fe1a85ec53;
+			hash ^= hash >> 33;
+			return static_cast<std::size_t>(hash);
 		}
 	};
 
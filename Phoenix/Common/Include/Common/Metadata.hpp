@@ -36,19 +36,92 @@
 
 #pragma once
 
+#include <Common/Math/Math.hpp>
 #include <Common/Utility/Serializer.hpp>
 
-#include <any>
+#include <cstdint>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
 
 namespace phx
 {
+	/**
+	 * @brief A global table of metadata keys.
+	 *
+	 * Metadata keys like "core.rotation" are interned to small integers the
+	 * first time they are used, so metadata never stores or compares key
+	 * strings. The IDs depend on the order keys were first used in, so they
+	 * only mean something inside one process, saves and the network number
+	 * keys with a MetadataDictionary instead.
+	 *
+	 * Keys are interned by the game and by whatever is read from a save.
+	 * The table only has room for so many keys, so keys read from the
+	 * network go through a dictionary with a smaller limit rather than being
+	 * interned however many there are.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * static const std::optional<MetadataKeys::Key> rotation =
+	 *     MetadataKeys::intern("core.rotation");
+	 * if (rotation)
+	 *     metadata.set(*rotation, math::vec3 {90, 0, 0});
+	 * @endcode
+	 */
+	class MetadataKeys
+	{
+	public:
+		using Key = std::uint16_t;
+
+		/**
+		 * @brief Gets the ID of a key, adding it to the table if it's new.
+		 * @param name The name of the key.
+		 * @return The ID of the key, or nothing if it's new and the table is
+		 * full.
+		 */
+		static std::optional<Key> intern(const std::string& name);
 
+		/**
+		 * @brief Gets the ID of a key without adding it.
+		 * @param name The name of the key.
+		 * @return The ID of the key, or nothing if it hasn't been interned.
+		 */
+		static std::optional<Key> find(const std::string& name);
+
+		/**
+		 * @brief Gets the name of a key.
+		 * @param key The ID of the key.
+		 * @return The name of the key, or an empty string if it's unknown.
+		 */
+		static std::string getName(Key key);
+
+		/**
+		 * @brief Gets the amount of interned keys.
+		 * @return The amount of keys in the table.
+		 */
+		static std::size_t size();
+	};
+
+	/**
+	 * @brief Stores unique data for a single block or item.
+	 *
+	 * Values are a fixed set of types rather than anything at all, so they
+	 * are stored inline without any allocation. Entries are kept in a small
+	 * list sorted by key, which for the handful of keys an object ever has is
+	 * faster than any map.
+	 */
 	class Metadata : public ISerializable
 	{
 	public:
+		using Key   = MetadataKeys::Key;
+		using Value = std::variant<int, float, math::vec3>;
+
 		/**
 		 * @brief QOL "typedef" for use in implementations where metadata needs
 		 * stored in relation to indexed objects and this is obnoxious to type.
@@ -58,38 +131,211 @@ namespace phx
 
 		/**
 		 * @brief Sets or inserts metadata.
-		 * @param key The key associated with the metadata.
+		 * @param key The ID of the key associated with the metadata.
+		 * @param data The new value.
+		 * @return true If the data was set.
+		 * @return false If the data already exists with a different data type.
+		 */
+		bool set(Key key, const Value& data);
+
+		/**
+		 * @brief Sets or inserts metadata.
+		 * @param key The key associated with the metadata, it is interned if
+		 * it hasn't been already.
+		 * @param data The new value.
 		 * @return true If the data was set.
 		 * @return false If the data already exists with a different data type
-		 * or an incompatible data type was provided.
+		 * OR there's no room left for a new key.
+		 */
+		bool set(const std::string& key, const Value& data)
+		{
+			const std::optional<Key> id = MetadataKeys::intern(key);
+			return id && set(*id, data);
+		}
+
+		/**
+		 * @brief Gets metadata by key.
+		 * @param key The ID of the key associated with the metadata.
+		 * @return A pointer to the data, or nullptr if it isn't set.
 		 */
-		bool set(const std::string& key, const std::any& data);
+		const Value* get(Key key) const;
 
 		/**
 		 * @brief Gets metadata by key.
 		 * @param key The key associated with the metadata.
-		 * @return A pointer to the data.
+		 * @return A pointer to the data, or nullptr if it isn't set.
+		 */
+		const Value* get(const std::string& key) const;
+
+		/**
+		 * @brief Gets metadata of a specific type by key.
+		 * @tparam T The type of the data.
+		 * @param key The ID of the key associated with the metadata.
+		 * @return A pointer to the data, or nullptr if it isn't set or is
+		 * another type.
 		 */
-		const std::any* get(const std::string& key) const;
+		template <typename T>
+		const T* getAs(Key key) const
+		{
+			const Value* value = get(key);
+			return value == nullptr ? nullptr : std::get_if<T>(value);
+		}
 
 		/**
 		 * @brief Erases metadata.
-		 * @param key The key associated with the metadata.
+		 * @param key The ID of the key associated with the metadata.
 		 */
-		void erase(const std::string& key) { m_data.erase(key); };
+		void erase(Key key);
 
 		/**
-		 * @return the size of the contained map object.
+		 * @return the amount of entries stored.
 		 */
-		std::size_t size() { return m_data.size(); };
+		std::size_t size() const { return m_data.size(); };
+
+		/**
+		 * @return true if nothing is stored.
+		 */
+		bool empty() const { return m_data.empty(); }
+
+		bool operator==(const Metadata& rhs) const
+		{
+			return m_data == rhs.m_data;
+		}
 
-		// serialize.
+		// serialize, with the name of every key.
 		Serializer& operator>>(Serializer& ser) const override;
 
-		// deserialize.
-		Serializer& operator<<(Serializer& ser) override;
+		// deserialize, interning the keys. Only for trusted data like saves,
+		// the network uses a MetadataDictionary.
+		Reader& operator<<(Reader& ser) override;
 
 	private:
-		std::unordered_map<std::string, std::any> m_data;
+		friend class MetadataDictionary;
+
+		// sorted by key.
+		std::vector<std::pair<Key, Value>> m_data;
+	};
+
+	/**
+	 * @brief Numbers the metadata keys used by a save or a connection.
+	 *
+	 * Like blocks (see voxels::BlockDictionary), keys are numbered the first
+	 * time they're written, and the names for those numbers are kept with
+	 * the save and sent to clients when they connect. Metadata written with
+	 * a dictionary stores small integers rather than the name of every key.
+	 *
+	 * Names read from a save are interned however many there are. A client
+	 * limits the dictionary of its connection instead, so a server can't use
+	 * up every key by sending made up ones.
+	 *
+	 * Saving can happen from more than one thread, so every method locks.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * MetadataDictionary keys;
+	 * keys.write(ser, metadata);
+	 * keys.read(reader, metadata);
+	 * @endcode
+	 */
+	class MetadataDictionary
+	{
+	public:
+		using ID = std::uint16_t;
+
+		/// @brief The most keys a dictionary can number.
+		static constexpr std::size_t MAX_KEYS =
+		    std::numeric_limits<ID>::max() + std::size_t {1};
+
+		/**
+		 * @brief Creates an empty dictionary.
+		 * @param limit The most keys it can have, names added past that are
+		 * ignored.
+		 */
+		explicit MetadataDictionary(std::size_t limit = MAX_KEYS);
+
+		MetadataDictionary(const MetadataDictionary&) = delete;
+		MetadataDictionary& operator=(const MetadataDictionary&) = delete;
+
+		/**
+		 * @brief Gets the ID of a key, numbering it if it's new.
+		 * @param key The key to get the ID of.
+		 * @return The ID the key is written as, or nothing if it's new and
+		 * the dictionary is full.
+		 */
+		std::optional<ID> getID(MetadataKeys::Key key);
+
+		/**
+		 * @brief Writes metadata with its keys replaced by their IDs.
+		 * @param ser The serializer to write to.
+		 * @param metadata The metadata to write, new keys are numbered.
+		 */
+		void write(Serializer& ser, const Metadata& metadata);
+
+		/**
+		 * @brief Reads metadata written by write.
+		 * @param ser The reader to read from.
+		 * @param metadata Where to read the metadata into.
+		 *
+		 * Values with an ID the dictionary doesn't have a key for are
+		 * skipped, the rest of the metadata is still read.
+		 */
+		void read(Reader& ser, Metadata& metadata) const;
+
+		/**
+		 * @brief Gets the names of the keys, in the order of their IDs.
+		 * @param first The ID to start from.
+		 */
+		std::vector<std::string> getNames(std::size_t first = 0) const;
+
+		/**
+		 * @brief Adds names that follow on from the ones already in the
+		 * dictionary, interning them.
+		 * @param first The ID of the first name, names the dictionary already
+		 * has are skipped. It can't be past the end of the dictionary.
+		 * @param names The names to add.
+		 * @return false if there wasn't room for all of them.
+		 */
+		bool add(std::size_t first, const std::vector<std::string>& names);
+
+		/**
+		 * @brief Replaces the dictionary with one loaded from a save.
+		 * @param names The names of the keys, as returned by getNames.
+		 */
+		void restore(const std::vector<std::string>& names);
+
+		/**
+		 * @brief Writes the names of the keys, to send them over the network.
+		 * @param ser The serializer to write to.
+		 * @param first The ID to start from.
+		 * @return The ID after the last name written.
+		 */
+		std::size_t writeNames(Serializer& ser, std::size_t first = 0) const;
+
+		/**
+		 * @brief Reads names written by writeNames, adding them.
+		 * @param ser The reader to read from.
+		 * @return false if the names are cut short or there wasn't room for
+		 * all of them.
+		 */
+		bool readNames(Reader& ser);
+
+		/// @brief The amount of keys in the dictionary.
+		std::size_t size() const;
+
+	private:
+		// adds names without locking, as add.
+		bool append(std::size_t first, const std::vector<std::string>& names);
+
+		mutable std::mutex m_mutex;
+		std::size_t        m_limit;
+
+		std::vector<std::string> m_names;
+
+		// keys by ID, empty when the name couldn't be interned.
+		std::vector<std::optional<MetadataKeys::Key>> m_keys;
+
+		// IDs by key, so writing doesn't look names up. -1 when the key
+		// isn't numbered yet.
+		std::vector<std::int32_t> m_ids;
 	};
-}
\ No newline at end of file
+} // namespace phx
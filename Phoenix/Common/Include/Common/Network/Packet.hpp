@@ -30,6 +30,7 @@
 
 #include <Common/EnumTools.hpp>
 #include <Common/Network/Types.hpp>
+#include <Common/Utility/Reader.hpp>
 
 #include <enet/enet.h>
 
@@ -116,6 +117,17 @@ namespace phx::net
 		 */
 		Data getData() const;
 
+		/**
+		 * @brief Gets a reader over the data of the packet, without copying.
+		 * @param encoding How the data was written.
+		 * @return A reader that is only valid as long as the packet is.
+		 */
+		Reader getReader(Encoding encoding = Encoding::FIXED) const
+		{
+			return {reinterpret_cast<const std::byte*>(m_packet->data),
+			        m_packet->dataLength, encoding};
+		}
+
 		/**
 		 * @brief Resizes the packet.
 		 * @param size The new size for the packet.
@@ -64,6 +64,19 @@ namespace phx
 			speed incoming;
 			speed outgoing;
 		};
+
+		/**
+		 * @brief What a packet on the data channel holds, it's the first
+		 * byte of the packet before it's compressed.
+		 *
+		 * Metadata keys are sent on the same channel as chunks, so they
+		 * arrive before the chunks that use them.
+		 */
+		enum class DataType : char
+		{
+			CHUNK         = 'c',
+			METADATA_KEYS = 'k'
+		};
 	} // namespace net
 } // namespace phx
 
@@ -29,10 +29,12 @@
 #pragma once
 
 #include <Common/Position.hpp>
+#include <Common/Utility/FlatMap.hpp>
 #include <Common/Voxels/Map.hpp>
 
 #include <entt/entt.hpp>
 
+#include <functional>
 #include <vector>
 
 namespace phx
@@ -41,10 +43,66 @@ namespace phx
 	{
 		PlayerView(voxels::Map* map) : map(map) {}
 
-		std::vector<math::vec3> chunks;
-		voxels::Map*            map;
+		/// @brief How far a player can see, in chunks.
+		static constexpr int VIEW_DISTANCE = 3;
 
-		static std::vector<voxels::Chunk*> update(entt::registry* registry,
-		                                          entt::entity    entity);
+		/// @brief A set of chunk coordinates, the values aren't used.
+		using ChunkSet = FlatMap<math::vec3i, bool, math::MortonHasher,
+		                         math::Vector3KeyComparator>;
+
+		/// @brief The coordinates of the chunks in view, each held on to in
+		/// the map.
+		ChunkSet     chunks;
+		voxels::Map* map;
+
+		/// @brief Chunks that have been requested but aren't loaded yet.
+		ChunkSet requested;
+
+		/**
+		 * @brief Loads every chunk that has come into view, and lets go of
+		 * the ones that have left it.
+		 * @param registry The registry the player is in.
+		 * @param entity The player.
+		 * @param dropped If set, the chunks that left the view are added to
+		 * it. The map can unload them from its next update on.
+		 * @return The chunks that came into view.
+		 */
+		static std::vector<voxels::Chunk*> update(
+		    entt::registry* registry, entt::entity entity,
+		    std::vector<math::vec3i>* dropped = nullptr);
+
+		/**
+		 * @brief Requests every chunk that has come into view, without
+		 * waiting for them to load.
+		 * @param registry The registry the player is in.
+		 * @param entity The player.
+		 * @param onLoaded Called with every chunk once it's loaded, from
+		 * Map::update.
+		 *
+		 * Chunks nearer the player are loaded first.
+		 */
+		static void request(entt::registry* registry, entt::entity entity,
+		                    const std::function<void(voxels::Chunk*)>& onLoaded);
+
+		/**
+		 * @brief Lets go of every chunk in view, so the map can unload them.
+		 * This needs calling before the view is removed.
+		 */
+		void clear();
+
+	private:
+		/// @brief Gets the chunk the player is in.
+		static math::vec3i getCentre(entt::registry* registry,
+		                             entt::entity    entity);
+
+		/// @brief Gets the chunks in view that haven't been loaded or
+		/// requested, nearest first.
+		static std::vector<math::vec3i> findMissing(entt::registry* registry,
+		                                            entt::entity    entity);
+
+		/// @brief Lets go of the chunks that have left the view.
+		static void dropOutOfView(entt::registry*           registry,
+		                          entt::entity              entity,
+		                          std::vector<math::vec3i>* dropped);
 	};
 } // namespace phx
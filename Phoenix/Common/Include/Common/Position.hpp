@@ -85,5 +85,17 @@ namespace phx
         {
 			return math::mat4::lookAt(position, (position + getDirection()), getUp());
 		};
+
+		/**
+		 * @brief Gets the block the entity is in.
+		 * @return The position of the block in the world.
+		 *
+		 * Entity positions are in half blocks, offset by half a block, this
+		 * is the one place they're converted to blocks.
+		 */
+		voxels::BlockPos getBlockPos() const
+		{
+			return voxels::BlockPos::fromWorld(position / 2.f + .5f);
+		}
 	};
 } // namespace phx
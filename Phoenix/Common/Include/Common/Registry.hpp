@@ -28,11 +28,16 @@
 
 #pragma once
 
+#include <deque>
+#include <iterator>
+#include <optional>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
 
 namespace phx
 {
-	template <typename Key, typename Value>
+	template <typename Key, typename Value, typename = void>
 	class Registry
 	{
 	public:
@@ -92,4 +97,160 @@ namespace phx
 
 		Value* m_unknownValueReturnVal = nullptr;
 	};
+
+	/**
+	 * @brief A registry for integer keys, stored densely by key.
+	 *
+	 * Every registry keyed by an integer in the engine uses keys handed out
+	 * in order (block and item UIDs, sound handles), so rather than hashing
+	 * the key this stores the values in a list indexed by it. Lookups are a
+	 * bounds check and an index. Values are kept in a deque so pointers
+	 * returned by get() stay valid as more values are added, since things
+	 * like chunks hold on to them.
+	 *
+	 * Iterating yields std::pair<const Key, Value&> by value, so use
+	 * `auto [key, value]` rather than `auto& [key, value]`.
+	 */
+	template <typename Key, typename Value>
+	class Registry<Key, Value, std::enable_if_t<std::is_integral_v<Key>>>
+	{
+		using Storage = std::deque<std::optional<Value>>;
+
+		template <typename Slots, typename Ref>
+		class BasicIterator
+		{
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type        = std::pair<const Key, Ref>;
+			using difference_type   = std::ptrdiff_t;
+			using pointer           = void;
+			using reference         = value_type;
+
+			BasicIterator(Slots* slots, std::size_t index)
+			    : m_slots(slots), m_index(index)
+			{
+				skipEmpty();
+			}
+
+			reference operator*() const
+			{
+				return {static_cast<Key>(m_index), *(*m_slots)[m_index]};
+			}
+
+			BasicIterator& operator++()
+			{
+				++m_index;
+				skipEmpty();
+				return *this;
+			}
+
+			bool operator==(const BasicIterator& rhs) const
+			{
+				return m_index == rhs.m_index;
+			}
+
+			bool operator!=(const BasicIterator& rhs) const
+			{
+				return m_index != rhs.m_index;
+			}
+
+		private:
+			void skipEmpty()
+			{
+				while (m_index < m_slots->size() &&
+				       !(*m_slots)[m_index].has_value())
+				{
+					++m_index;
+				}
+			}
+
+			Slots*      m_slots;
+			std::size_t m_index;
+		};
+
+	public:
+		using Iterator      = BasicIterator<Storage, Value&>;
+		using ConstIterator = BasicIterator<const Storage, const Value&>;
+
+	public:
+		Registry()  = default;
+		~Registry() = default;
+
+		void add(const Key& key, const Value& value)
+		{
+			std::optional<Value>& slot = slotFor(key);
+			if (!slot.has_value())
+			{
+				++m_count;
+			}
+
+			// assigns in place so existing pointers see the new value.
+			slot = value;
+		}
+
+		void add(Key&& key, Value&& value)
+		{
+			std::optional<Value>& slot = slotFor(key);
+			if (!slot.has_value())
+			{
+				++m_count;
+				slot.emplace(std::move(value));
+			}
+		}
+
+		const Value* get(const Key& key) const
+		{
+			const auto index = static_cast<std::size_t>(key);
+			if (index >= m_values.size() || !m_values[index].has_value())
+			{
+				return m_unknownValueReturnVal;
+			}
+
+			return &*m_values[index];
+		}
+
+		Value* get(const Key& key)
+		{
+			const auto index = static_cast<std::size_t>(key);
+			if (index >= m_values.size() || !m_values[index].has_value())
+			{
+				return m_unknownValueReturnVal;
+			}
+
+			return &*m_values[index];
+		}
+
+		// use this to return a specific value if not found in the registry.
+		// will otherwise return nullptr;
+		void setUnknownReturnVal(Value* value)
+		{
+			m_unknownValueReturnVal = value;
+		}
+
+		Iterator      begin() { return {&m_values, 0}; }
+		Iterator      end() { return {&m_values, m_values.size()}; }
+		ConstIterator begin() const { return {&m_values, 0}; }
+		ConstIterator end() const { return {&m_values, m_values.size()}; }
+		std::size_t   size() const { return m_count; }
+		bool          empty() const { return m_count == 0; }
+
+	private:
+		std::optional<Value>& slotFor(const Key& key)
+		{
+			const auto index = static_cast<std::size_t>(key);
+			if (index >= m_values.size())
+			{
+				// growing a deque at the end never moves existing values.
+				m_values.resize(index + 1);
+			}
+
+			return m_values[index];
+		}
+
+	private:
+		Storage     m_values;
+		std::size_t m_count = 0;
+
+		Value* m_unknownValueReturnVal = nullptr;
+	};
 } // namespace phx
@@ -28,10 +28,12 @@
 
 #pragma once
 
+#include <Common/Voxels/BlockDictionary.hpp>
 #include <Common/Voxels/Map.hpp>
 
 #include <nlohmann/json.hpp>
 
+#include <cstdint>
 #include <filesystem>
 #include <string>
 #include <unordered_map>
@@ -47,7 +49,9 @@ namespace phx
 	 *
 	 * Saves will be directories inside the Save/ folder. The saves will contain
 	 * a JSON file containing settings for a specific save (not much currently,
-	 * but it will definitely be useful down the line).
+	 * but it will definitely be useful down the line), along with the names
+	 * of the blocks and metadata keys its chunks are saved with (see
+	 * BlockDictionary and MetadataDictionary).
 	 */
 	class Save
 	{
@@ -86,8 +90,22 @@ namespace phx
 		 */
 		const nlohmann::json& getSettings() const;
 
+		/**
+		 * @brief Gets the seed the terrain of the save is generated from.
+		 * @return The "seed" setting, picked at random when the save was
+		 * created if it wasn't given.
+		 */
+		std::uint64_t getSeed() const;
+
         voxels::Map* getOrCreateMap(const std::string& name,
                                     voxels::BlockReferrer* referrer);
+
+		/**
+		 * @brief Gets the IDs metadata keys are saved with.
+		 * @return The dictionary shared by every map, which is also what
+		 * the server numbers keys with when it sends chunks.
+		 */
+		MetadataDictionary* getMetadataKeys();
 //		void         setDefaultMap(voxels::Map* map);
 //      voxels::Map* getDefaultMap();
 //		const std::vector<std::string>& getMaps() const;
@@ -103,6 +121,13 @@ namespace phx
 		 */
 		void toFile(const std::string& name = "");
 
+	private:
+		/**
+		 * @brief Writes the JSON file describing the save.
+		 * @param path The path of the JSON file.
+		 */
+		void writeSettings(const std::filesystem::path& path);
+
 	private:
 		std::string           m_name;
         std::filesystem::path m_savePath;
@@ -110,6 +135,19 @@ namespace phx
 		std::vector<std::string> m_mods;
 		nlohmann::json           m_settings;
 
+		/**
+		 * @brief The saved IDs of the blocks, shared by every map.
+		 *
+		 * Declared before the maps so it outlives them, their workers and
+		 * flusher still use it while the maps are being destroyed.
+		 */
+		voxels::BlockDictionary m_blocks;
+		std::size_t             m_savedBlocks = 0;
+
+		/// @brief The saved IDs of metadata keys, kept like m_blocks.
+		MetadataDictionary m_metadataKeys;
+		std::size_t        m_savedMetadataKeys = 0;
+
         std::unordered_map<std::string, voxels::Map> m_maps;
 
 		/**
@@ -0,0 +1,232 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <Common/Utility/Internal/SharedTypes.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace phx::codec
+{
+	/// @brief The codecs that can be used, stored in the header of a frame.
+	enum class Type : std::uint8_t
+	{
+		STORE = 0,
+		LZ    = 1
+	};
+
+	/**
+	 * @brief Data that's likely to show up in what's being compressed.
+	 *
+	 * Small inputs like a single chunk don't have much to find repeats in.
+	 * With a dictionary matches can also point into data shared ahead of
+	 * time, such as the bytes every chunk save starts with. Both ends need
+	 * the same dictionary, frames store its ID to check that.
+	 */
+	class Dictionary
+	{
+	public:
+		explicit Dictionary(data::Data content);
+
+		/**
+		 * @brief Builds a dictionary out of the most common parts of some
+		 * samples.
+		 * @param samples Data like what's going to be compressed, such as
+		 * chunk saves.
+		 * @param size The size of the dictionary, in bytes.
+		 */
+		static Dictionary train(const std::vector<data::Data>& samples,
+		                        std::size_t                    size);
+
+		const data::Data& getContent() const { return m_content; }
+
+		/// @brief A hash of the content, never 0.
+		std::uint32_t getID() const { return m_id; }
+
+	private:
+		friend class LZCodec;
+
+		data::Data    m_content;
+		std::uint32_t m_id;
+
+		// where 4 byte strings were last seen in the content, worked out
+		// once rather than for everything that's compressed.
+		std::vector<std::int32_t> m_head;
+		std::vector<std::int32_t> m_chain;
+	};
+
+	/**
+	 * @brief A way of compressing data.
+	 *
+	 * Codecs only deal with the payload, compress() and decompress() below
+	 * wrap it in a frame that says how to read it back.
+	 */
+	class Codec
+	{
+	public:
+		virtual ~Codec() = default;
+
+		virtual Type getType() const = 0;
+
+		/**
+		 * @brief Compresses data.
+		 * @param data The data to compress.
+		 * @param size The size of the data.
+		 * @param dictionary The dictionary to use, can be nullptr.
+		 * @param out Where to append the compressed data.
+		 */
+		virtual void compress(const std::byte* data, std::size_t size,
+		                      const Dictionary* dictionary,
+		                      data::Data&       out) const = 0;
+
+		/**
+		 * @brief Decompresses data.
+		 * @param data The compressed data.
+		 * @param size The size of the compressed data.
+		 * @param rawSize The size the data was before compressing.
+		 * @param dictionary The dictionary it was compressed with.
+		 * @param out Where to append the data.
+		 * @return false if the data is corrupt.
+		 */
+		virtual bool decompress(const std::byte* data, std::size_t size,
+		                        std::size_t rawSize, const Dictionary* dictionary,
+		                        data::Data& out) const = 0;
+
+		/**
+		 * @brief The most data a payload of a size can expand to.
+		 * @param size The size of the compressed data.
+		 * @return The largest raw size that isn't corrupt.
+		 */
+		virtual std::size_t getMaxRawSize(std::size_t size) const = 0;
+	};
+
+	/// @brief Doesn't compress at all, for data that doesn't compress.
+	class StoreCodec final : public Codec
+	{
+	public:
+		Type getType() const override { return Type::STORE; }
+
+		void compress(const std::byte* data, std::size_t size,
+		              const Dictionary* dictionary,
+		              data::Data&       out) const override;
+
+		bool decompress(const std::byte* data, std::size_t size,
+		                std::size_t rawSize, const Dictionary* dictionary,
+		                data::Data& out) const override;
+
+		std::size_t getMaxRawSize(std::size_t size) const override
+		{
+			return size;
+		}
+	};
+
+	/**
+	 * @brief A fast LZ77 codec.
+	 *
+	 * Data is stored as literal bytes followed by copies of earlier data,
+	 * a copy can overlap itself so runs of the same bytes (very common in
+	 * chunks) take a few bytes. Decompressing is just copying, it's the
+	 * same speed whatever level the data was compressed with.
+	 */
+	class LZCodec final : public Codec
+	{
+	public:
+		static constexpr int MIN_LEVEL = 1;
+		static constexpr int MAX_LEVEL = 9;
+
+		/**
+		 * @param level How hard to look for matches. 1 only checks the last
+		 * place every 4 bytes were seen, each level after that checks twice
+		 * as many places, for a better ratio.
+		 */
+		explicit LZCodec(int level = MIN_LEVEL);
+
+		Type getType() const override { return Type::LZ; }
+
+		void compress(const std::byte* data, std::size_t size,
+		              const Dictionary* dictionary,
+		              data::Data&       out) const override;
+
+		bool decompress(const std::byte* data, std::size_t size,
+		                std::size_t rawSize, const Dictionary* dictionary,
+		                data::Data& out) const override;
+
+		std::size_t getMaxRawSize(std::size_t size) const override;
+
+	private:
+		int m_level;
+	};
+
+	/// @brief How to compress something.
+	struct Options
+	{
+		Type type  = Type::LZ;
+		int  level = LZCodec::MIN_LEVEL;
+
+		std::shared_ptr<const Dictionary> dictionary;
+	};
+
+	/// @brief For saves, which are written far less often than they're read.
+	inline const Options DISK {Type::LZ, 6, nullptr};
+
+	/// @brief For packets, which are compressed for every player.
+	inline const Options NETWORK {Type::LZ, 1, nullptr};
+
+	/**
+	 * @brief Compresses data into a self describing frame.
+	 * @param data The data to compress.
+	 * @param size The size of the data.
+	 * @param options How to compress it.
+	 * @return The frame, falls back to storing the data if compressing
+	 * wouldn't make it smaller.
+	 */
+	data::Data compress(const std::byte* data, std::size_t size,
+	                    const Options& options);
+
+	/**
+	 * @brief Checks if some data is a frame written by compress.
+	 */
+	bool isCompressed(const std::byte* data, std::size_t size);
+
+	/**
+	 * @brief Reads back a frame written by compress.
+	 * @param data The frame.
+	 * @param size The size of the frame.
+	 * @param out Where to write the data, replacing its contents.
+	 * @param dictionary The dictionary, if the frame was compressed with
+	 * one.
+	 * @return false if the frame is corrupt or needs a dictionary that
+	 * wasn't given.
+	 */
+	bool decompress(const std::byte* data, std::size_t size, data::Data& out,
+	                const Dictionary* dictionary = nullptr);
+} // namespace phx::codec
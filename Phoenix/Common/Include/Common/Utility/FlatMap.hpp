@@ -0,0 +1,417 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace phx
+{
+	/**
+	 * @brief A hash map storing its entries in one flat array.
+	 *
+	 * Entries are found by linear probing from the slot the hash points at,
+	 * so a lookup usually touches one or two neighbouring slots rather than
+	 * following a bucket's linked list around the heap like
+	 * std::unordered_map does. Whether a slot is in use is kept in a separate
+	 * array of bytes, so skipping over empty slots doesn't pull the entries
+	 * into the cache.
+	 *
+	 * The table is a power of two in size and only the low bits of the hash
+	 * are used, so the hash needs to mix its input well (see
+	 * math::MortonHasher). Keys and values need to be default constructible,
+	 * and entries move around when the table grows or an entry is erased -
+	 * store a pointer as the value if it needs to stay put.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * FlatMap<math::vec3i, int, math::MortonHasher> map;
+	 * map[{1, 2, 3}] = 4;
+	 *
+	 * auto it = map.find({1, 2, 3});
+	 * if (it != map.end())
+	 * {
+	 *     map.erase(it);
+	 * }
+	 * @endcode
+	 *
+	 * @tparam Key The type of the keys.
+	 * @tparam Value The type of the values.
+	 * @tparam Hash Hashes a key.
+	 * @tparam KeyEqual Compares two keys.
+	 */
+	template <typename Key, typename Value, typename Hash = std::hash<Key>,
+	          typename KeyEqual = std::equal_to<Key>>
+	class FlatMap
+	{
+	public:
+		using key_type    = Key;
+		using mapped_type = Value;
+		using value_type  = std::pair<Key, Value>;
+		using size_type   = std::size_t;
+
+		/// @brief The smallest table allocated once something is inserted.
+		static constexpr size_type MIN_CAPACITY = 16;
+
+		template <bool CONST>
+		class Iterator
+		{
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type        = FlatMap::value_type;
+			using difference_type   = std::ptrdiff_t;
+			using pointer =
+			    std::conditional_t<CONST, const value_type*, value_type*>;
+			using reference =
+			    std::conditional_t<CONST, const value_type&, value_type&>;
+
+			using Owner = std::conditional_t<CONST, const FlatMap, FlatMap>;
+
+			Iterator() = default;
+			Iterator(Owner* map, size_type index) : m_map(map), m_index(index)
+			{
+				skipUnused();
+			}
+
+			// iterators convert to const iterators.
+			template <bool OTHER, typename = std::enable_if_t<CONST && !OTHER>>
+			Iterator(const Iterator<OTHER>& other)
+			    : m_map(other.m_map), m_index(other.m_index)
+			{
+			}
+
+			reference operator*() const { return m_map->m_slots[m_index]; }
+			pointer   operator->() const { return &m_map->m_slots[m_index]; }
+
+			Iterator& operator++()
+			{
+				++m_index;
+				skipUnused();
+				return *this;
+			}
+
+			Iterator operator++(int)
+			{
+				Iterator result = *this;
+				++(*this);
+				return result;
+			}
+
+			bool operator==(const Iterator& other) const
+			{
+				return m_index == other.m_index;
+			}
+
+			bool operator!=(const Iterator& other) const
+			{
+				return m_index != other.m_index;
+			}
+
+		private:
+			friend class FlatMap;
+
+			template <bool>
+			friend class Iterator;
+
+			void skipUnused()
+			{
+				while (m_index < m_map->m_used.size() &&
+				       !m_map->m_used[m_index])
+				{
+					++m_index;
+				}
+			}
+
+			Owner*    m_map   = nullptr;
+			size_type m_index = 0;
+		};
+
+		using iterator       = Iterator<false>;
+		using const_iterator = Iterator<true>;
+
+		FlatMap() = default;
+
+		iterator       begin() { return {this, 0}; }
+		const_iterator begin() const { return {this, 0}; }
+		iterator       end() { return {this, m_used.size()}; }
+		const_iterator end() const { return {this, m_used.size()}; }
+
+		size_type size() const { return m_size; }
+		bool      empty() const { return m_size == 0; }
+
+		/// @brief Gets the amount of slots in the table.
+		size_type capacity() const { return m_used.size(); }
+
+		/**
+		 * @brief Finds the entry of a key.
+		 * @param key The key to look for.
+		 * @return The entry, end() if there isn't one.
+		 */
+		iterator find(const Key& key) { return {this, locate(key)}; }
+
+		const_iterator find(const Key& key) const
+		{
+			return {this, locate(key)};
+		}
+
+		/// @brief Checks if there is an entry for a key.
+		bool contains(const Key& key) const
+		{
+			return locate(key) != m_used.size();
+		}
+
+		/**
+		 * @brief Gets the value of a key that has to be in the map.
+		 * @param key The key of the entry.
+		 * @return The value of the entry.
+		 * @throws std::out_of_range If there is no entry for the key.
+		 */
+		Value& at(const Key& key)
+		{
+			const size_type index = locate(key);
+			if (index == m_used.size())
+			{
+				throw std::out_of_range("FlatMap::at");
+			}
+			return m_slots[index].second;
+		}
+
+		const Value& at(const Key& key) const
+		{
+			const size_type index = locate(key);
+			if (index == m_used.size())
+			{
+				throw std::out_of_range("FlatMap::at");
+			}
+			return m_slots[index].second;
+		}
+
+		/// @brief Gets the value of a key, adding an entry if there isn't one.
+		Value& operator[](const Key& key)
+		{
+			return try_emplace(key).first->second;
+		}
+
+		/**
+		 * @brief Adds an entry for a key, unless there already is one.
+		 * @param key The key of the entry.
+		 * @param args What the value is constructed from, if it's added.
+		 * @return The entry of the key, and true if it was added.
+		 */
+		template <typename... Args>
+		std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args)
+		{
+			if ((m_size + 1) * 4 > m_used.size() * 3)
+			{
+				rehash(std::max(MIN_CAPACITY, m_used.size() * 2));
+			}
+
+			size_type index = home(key);
+			while (m_used[index])
+			{
+				if (m_equal(m_slots[index].first, key))
+				{
+					return {iterator(this, index), false};
+				}
+				index = (index + 1) & (m_used.size() - 1);
+			}
+
+			m_slots[index].first  = key;
+			m_slots[index].second = Value(std::forward<Args>(args)...);
+			m_used[index]         = 1;
+			++m_size;
+
+			return {iterator(this, index), true};
+		}
+
+		/// @brief The same as try_emplace, for code written against
+		/// std::unordered_map.
+		template <typename V>
+		std::pair<iterator, bool> emplace(const Key& key, V&& value)
+		{
+			return try_emplace(key, std::forward<V>(value));
+		}
+
+		/**
+		 * @brief Removes an entry.
+		 * @param it The entry to remove, it must be in the map.
+		 *
+		 * Entries after it are moved back to fill the gap, every iterator is
+		 * invalidated.
+		 */
+		void erase(const_iterator it) { eraseAt(it.m_index); }
+
+		/**
+		 * @brief Removes the entry of a key.
+		 * @param key The key of the entry.
+		 * @return The amount of entries removed, 0 or 1.
+		 */
+		size_type erase(const Key& key)
+		{
+			const size_type index = locate(key);
+			if (index == m_used.size())
+			{
+				return 0;
+			}
+
+			eraseAt(index);
+			return 1;
+		}
+
+		/// @brief Removes every entry, keeping the table allocated.
+		void clear()
+		{
+			for (size_type i = 0; i < m_used.size(); ++i)
+			{
+				if (m_used[i])
+				{
+					m_slots[i] = value_type();
+					m_used[i]  = 0;
+				}
+			}
+			m_size = 0;
+		}
+
+		/**
+		 * @brief Makes room for a number of entries without growing again.
+		 * @param count The amount of entries.
+		 */
+		void reserve(size_type count)
+		{
+			size_type capacity = MIN_CAPACITY;
+			while (count * 4 > capacity * 3)
+			{
+				capacity *= 2;
+			}
+
+			if (capacity > m_used.size())
+			{
+				rehash(capacity);
+			}
+		}
+
+	private:
+		size_type home(const Key& key) const
+		{
+			return m_hash(key) & (m_used.size() - 1);
+		}
+
+		// gets the slot of a key, the size of the table if it's not in it.
+		size_type locate(const Key& key) const
+		{
+			if (m_size == 0)
+			{
+				return m_used.size();
+			}
+
+			size_type index = home(key);
+			while (m_used[index])
+			{
+				if (m_equal(m_slots[index].first, key))
+				{
+					return index;
+				}
+				index = (index + 1) & (m_used.size() - 1);
+			}
+			return m_used.size();
+		}
+
+		void eraseAt(size_type index)
+		{
+			const size_type mask = m_used.size() - 1;
+
+			// move entries that probed past this slot back into it, so
+			// lookups never stop early at the gap. No tombstones are needed.
+			size_type next = index;
+			while (true)
+			{
+				next = (next + 1) & mask;
+				if (!m_used[next])
+				{
+					break;
+				}
+
+				// entries only move back if the gap is between the slot
+				// they hash to and the slot they're in.
+				const size_type wanted = home(m_slots[next].first);
+				const bool      between =
+				    index <= next ? (index < wanted && wanted <= next)
+				                  : (index < wanted || wanted <= next);
+				if (!between)
+				{
+					m_slots[index] = std::move(m_slots[next]);
+					index          = next;
+				}
+			}
+
+			m_slots[index] = value_type();
+			m_used[index]  = 0;
+			--m_size;
+		}
+
+		void rehash(size_type capacity)
+		{
+			std::vector<value_type>   slots(capacity);
+			std::vector<std::uint8_t> used(capacity, 0);
+			slots.swap(m_slots);
+			used.swap(m_used);
+
+			for (size_type i = 0; i < used.size(); ++i)
+			{
+				if (!used[i])
+				{
+					continue;
+				}
+
+				size_type index = home(slots[i].first);
+				while (m_used[index])
+				{
+					index = (index + 1) & (capacity - 1);
+				}
+
+				m_slots[index] = std::move(slots[i]);
+				m_used[index]  = 1;
+			}
+		}
+
+		std::vector<value_type>   m_slots;
+		std::vector<std::uint8_t> m_used;
+		size_type                 m_size = 0;
+
+		Hash     m_hash;
+		KeyEqual m_equal;
+	};
+} // namespace phx
@@ -144,6 +144,7 @@
 #endif
 // clang-format on
 
+#include <cstring>
 #include <type_traits>
 
 namespace phx::data::endian
@@ -240,8 +241,63 @@ namespace phx::data::endian
 				return *reinterpret_cast<const double*>(&t);
 			}
 		};
+
+		// an unsigned integer of the same size, used to swap the bytes of
+		// any type (including floats) in bulk.
+		template <std::size_t N>
+		struct UnsignedOfSize
+		{
+		};
+
+		template <>
+		struct UnsignedOfSize<2>
+		{
+			using Type = std::uint16_t;
+		};
+
+		template <>
+		struct UnsignedOfSize<4>
+		{
+			using Type = std::uint32_t;
+		};
+
+		template <>
+		struct UnsignedOfSize<8>
+		{
+			using Type = std::uint64_t;
+		};
 	} // namespace detail
 
+	/**
+	 * @brief Swaps an array of values between host and network byte order.
+	 * @tparam T The type of the values. (must be integral or floating point)
+	 * @param bytes The values, they don't need to be aligned.
+	 * @param count The amount of values.
+	 *
+	 * Swapping is its own inverse, so this works in both directions. It does
+	 * nothing at all if the host already uses network byte order, otherwise
+	 * every value is swapped with a plain loop that compilers turn into
+	 * vector byte shuffles.
+	 */
+	template <typename T,
+	          typename U =
+	              std::enable_if_t<detail::IsEndianChangable<T>::value, void>>
+	void swapArray(std::byte* bytes, std::size_t count)
+	{
+		if constexpr (sizeof(T) > 1 && Endian::NATIVE != Endian::NET)
+		{
+			using Word = typename detail::UnsignedOfSize<sizeof(T)>::Type;
+
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				Word word;
+				std::memcpy(&word, bytes + i * sizeof(T), sizeof(T));
+				word = detail::ByteSwapper<sizeof(T)>()(word);
+				std::memcpy(bytes + i * sizeof(T), &word, sizeof(T));
+			}
+		}
+	}
+
 	/**
 	 * @brief Swaps the endianness of data for sending over a network.
 	 * @tparam T The type of data being converted. (must be integral type)
@@ -0,0 +1,135 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+
+namespace phx
+{
+	/**
+	 * @brief A read only view of a whole file, mapped into memory.
+	 *
+	 * Reading a file through a stream copies it from the page cache into a
+	 * buffer before anything can look at it. A mapping instead hands out the
+	 * page cache itself, so data can be read straight from it with a Reader,
+	 * and the OS can be told which parts are going to be needed next so it
+	 * can start reading them from disk ahead of time.
+	 *
+	 * Changes made to the file through other means are visible through the
+	 * mapping, as long as the file doesn't grow past the size it had when it
+	 * was mapped.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * MappedFile file;
+	 * if (file.open(path))
+	 * {
+	 *     file.prefetch(offset, size);
+	 *     // ... do something else while it's read in ...
+	 *     Reader reader(file.data() + offset, size);
+	 * }
+	 * @endcode
+	 */
+	class MappedFile
+	{
+	public:
+		/// @brief How a mapping is going to be read, so the OS can read
+		/// ahead accordingly.
+		enum class Access
+		{
+			NORMAL,
+			SEQUENTIAL,
+			RANDOM
+		};
+
+		MappedFile() = default;
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		/**
+		 * @brief Maps a file, unmapping whatever was mapped before.
+		 * @param path The file to map.
+		 * @return false if the file couldn't be opened or mapped.
+		 */
+		bool open(const std::filesystem::path& path);
+
+		/// @brief Unmaps the file.
+		void close();
+
+		bool isOpen() const { return m_opened; }
+
+		/// @brief The mapped bytes, nullptr if the file is empty.
+		const std::byte* data() const { return m_data; }
+
+		/// @brief The size of the file when it was mapped.
+		std::size_t size() const { return m_size; }
+
+		/**
+		 * @brief Tells the OS how the whole mapping is going to be read.
+		 * @param access The pattern the mapping is going to be read in.
+		 */
+		void advise(Access access) const;
+
+		/**
+		 * @brief Starts reading part of the file into memory in the
+		 * background.
+		 * @param offset Where to start, in bytes.
+		 * @param size The amount of bytes that are going to be needed.
+		 *
+		 * This only hints, it doesn't block, and does nothing on systems
+		 * without a way to hint.
+		 */
+		void prefetch(std::size_t offset, std::size_t size) const;
+
+		/**
+		 * @brief Counts how many pages of part of the file are in memory.
+		 * @param offset Where to start, in bytes.
+		 * @param size The amount of bytes to check.
+		 * @return The amount of pages already in memory. Systems that can't
+		 * tell report every page as being in memory.
+		 */
+		std::size_t getResidentPages(std::size_t offset,
+		                             std::size_t size) const;
+
+		/// @brief The size of a page, mappings are made of whole pages.
+		static std::size_t getPageSize();
+
+	private:
+		const std::byte* m_data   = nullptr;
+		std::size_t      m_size   = 0;
+		bool             m_opened = false;
+
+		// the handles of the file and the mapping, only needed on Windows.
+		void* m_file    = nullptr;
+		void* m_mapping = nullptr;
+	};
+} // namespace phx
@@ -0,0 +1,225 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <Common/Utility/Serializer.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace phx
+{
+	/**
+	 * @brief Reads data written by a Serializer without copying it.
+	 *
+	 * A Serializer consumes its buffer from the front, which moves every
+	 * byte left in the buffer each time a value is read. A reader instead
+	 * only keeps an offset into bytes owned by someone else (a packet, a
+	 * file loaded into memory, a Serializer's buffer), so reading N bytes
+	 * costs N bytes worth of copying at most. The bytes must outlive the
+	 * reader.
+	 *
+	 * Every read is bounds checked. Reading past the end doesn't touch any
+	 * memory, it leaves the value default constructed and puts the reader
+	 * into a failed state - every read after that fails too, so a whole
+	 * object can be read and checked once at the end.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * Reader reader(packet.getReader());
+	 * reader >> sequence >> position.x >> position.y >> position.z;
+	 *
+	 * if (!reader)
+	 * {
+	 *     LOG_WARNING("NETWORK") << "Received a truncated packet.";
+	 *     return;
+	 * }
+	 * @endcode
+	 */
+	class Reader
+	{
+	public:
+		Reader() = default;
+
+		/**
+		 * @brief Creates a reader over some bytes.
+		 * @param data The bytes to read, must outlive the reader.
+		 * @param size The amount of bytes.
+		 * @param encoding How the data was written.
+		 */
+		Reader(const std::byte* data, std::size_t size,
+		       Encoding encoding = Encoding::FIXED)
+		    : m_data(data), m_size(size), m_encoding(encoding)
+		{
+		}
+
+		/**
+		 * @brief Creates a reader over a buffer.
+		 * @param data The buffer to read, must outlive the reader and not
+		 * be resized while it's being read.
+		 * @param encoding How the data was written.
+		 */
+		explicit Reader(const data::Data& data,
+		                Encoding          encoding = Encoding::FIXED)
+		    : Reader(data.data(), data.size(), encoding)
+		{
+		}
+
+		Encoding getEncoding() const { return m_encoding; }
+
+		/**
+		 * @brief Changes how the rest of the data is read.
+		 * @param encoding The encoding the rest of the data was written with.
+		 *
+		 * This is for formats that say how they're encoded in a header.
+		 */
+		void setEncoding(Encoding encoding)
+		{
+			m_encoding = encoding;
+			m_bitCount = 8;
+		}
+
+		/**
+		 * @brief Checks if every read so far has succeeded.
+		 * @return false once a read has run past the end of the bytes.
+		 */
+		bool ok() const { return !m_failed; }
+		explicit operator bool() const { return ok(); }
+
+		/**
+		 * @brief Marks the reader as failed and skips to the end.
+		 *
+		 * For values that were read fine but make no sense, so whoever is
+		 * reading finds out the same way as if the bytes had run out.
+		 */
+		void fail();
+
+		/// @brief The amount of bytes read so far.
+		std::size_t tell() const { return m_offset; }
+
+		/// @brief The amount of bytes left to read.
+		std::size_t remaining() const { return m_size - m_offset; }
+
+		/// @brief The total amount of bytes, read or not.
+		std::size_t size() const { return m_size; }
+
+		/**
+		 * @brief Reads raw bytes without copying them.
+		 * @param size The amount of bytes to read.
+		 * @return A pointer to the bytes, valid as long as the underlying
+		 * data is. nullptr if there aren't enough bytes left.
+		 */
+		const std::byte* readBytes(std::size_t size);
+
+		/**
+		 * @brief Looks at the next bytes without reading them.
+		 * @param size The amount of bytes to look at.
+		 * @return A pointer to the bytes, nullptr if there aren't enough
+		 * bytes left. Unlike readBytes, this doesn't fail the reader.
+		 */
+		const std::byte* peekBytes(std::size_t size) const
+		{
+			return size <= m_size - m_offset ? m_data + m_offset : nullptr;
+		}
+
+		/**
+		 * @brief Skips over some bytes.
+		 * @param size The amount of bytes to skip.
+		 * @return false if there weren't enough bytes left.
+		 */
+		bool skip(std::size_t size) { return readBytes(size) != nullptr; }
+
+		/**
+		 * @brief Reads a run of values in one go.
+		 * @param out Where to write the values.
+		 * @param count The amount of values to read.
+		 * @return false if there weren't enough bytes left, out is left
+		 * untouched in that case.
+		 *
+		 * This reads the same bytes as reading each value one by one, but
+		 * with a single bounds check. Only numbers can be read like this.
+		 */
+		template <typename T>
+		bool read(T* out, std::size_t count);
+
+		Reader& operator>>(bool& val);
+		Reader& operator>>(char& val);
+		Reader& operator>>(unsigned char& val);
+		Reader& operator>>(float& val);
+		Reader& operator>>(double& val);
+		Reader& operator>>(std::int16_t& val);
+		Reader& operator>>(std::int32_t& val);
+		Reader& operator>>(std::int64_t& val);
+		Reader& operator>>(std::uint16_t& val);
+		Reader& operator>>(std::uint32_t& val);
+		Reader& operator>>(std::uint64_t& val);
+		Reader& operator>>(ISerializable& val);
+
+// idk but mac seems to complain without this.
+#ifdef PHX_INT32_EQUAL_LONG
+		Reader& operator>>(long& val);
+		Reader& operator>>(unsigned long& val);
+#endif
+
+		template <typename T>
+		Reader& operator>>(std::basic_string<T>& val);
+
+		template <typename T>
+		Reader& operator>>(std::vector<T>& val);
+
+	private:
+		template <typename T>
+		void pop(T& data);
+
+		template <typename T>
+		void popCompact(T& data);
+
+		bool popVarint(std::uint64_t& value);
+
+		/// @brief The least amount of bytes a T can take up.
+		template <typename T>
+		std::size_t minimumSize() const;
+
+	private:
+		const std::byte* m_data     = nullptr;
+		std::size_t      m_size     = 0;
+		std::size_t      m_offset   = 0;
+		bool             m_failed   = false;
+		Encoding         m_encoding = Encoding::FIXED;
+
+		// the byte bools are currently unpacked from, and how many of its
+		// bits have been used.
+		std::uint8_t m_bits     = 0;
+		int          m_bitCount = 8;
+	};
+} // namespace phx
+
+#include <Common/Utility/Reader.inl>
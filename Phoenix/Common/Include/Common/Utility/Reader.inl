@@ -0,0 +1,342 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace phx
+{
+	inline const std::byte* Reader::readBytes(std::size_t size)
+	{
+		if (m_failed || size > m_size - m_offset)
+		{
+			fail();
+			return nullptr;
+		}
+
+		const std::byte* bytes = m_data + m_offset;
+		m_offset += size;
+		return bytes;
+	}
+
+	template <typename T>
+	bool Reader::read(T* out, std::size_t count)
+	{
+		static_assert(std::is_arithmetic_v<T>,
+		              "only numbers can be copied off the wire in bulk");
+
+		if constexpr (std::is_integral_v<T> && sizeof(T) > 1)
+		{
+			// compact integers have to be decoded one by one.
+			if (m_encoding == Encoding::COMPACT)
+			{
+				if (m_failed || count > remaining())
+				{
+					fail();
+					return false;
+				}
+
+				for (std::size_t i = 0; i < count; ++i)
+				{
+					pop(out[i]);
+				}
+
+				return ok();
+			}
+		}
+
+		// checked before multiplying, so a huge count can't wrap around.
+		if (m_failed || count > (m_size - m_offset) / sizeof(T))
+		{
+			fail();
+			return false;
+		}
+
+		const std::byte* bytes = readBytes(count * sizeof(T));
+		std::memcpy(out, bytes, count * sizeof(T));
+		data::endian::swapArray<T>(reinterpret_cast<std::byte*>(out), count);
+
+		return true;
+	}
+
+	inline void Reader::fail()
+	{
+		m_failed = true;
+		m_offset = m_size;
+	}
+
+	template <typename T>
+	void Reader::pop(T& data)
+	{
+		if constexpr (std::is_integral_v<T> &&
+		              (sizeof(T) > 1 || std::is_same_v<T, bool>))
+		{
+			if (m_encoding == Encoding::COMPACT)
+			{
+				popCompact(data);
+				return;
+			}
+		}
+
+		const std::byte* bytes = readBytes(sizeof(T));
+		if (bytes == nullptr)
+		{
+			data = T {};
+			return;
+		}
+
+		T value;
+		std::memcpy(&value, bytes, sizeof(T));
+		data = data::endian::swapForHost(value);
+	}
+
+	template <typename T>
+	void Reader::popCompact(T& data)
+	{
+		if constexpr (std::is_same_v<T, bool>)
+		{
+			// the mirror of the Serializer, a byte is read for the first of
+			// every 8 bools and the rest come out of it.
+			if (m_bitCount == 8)
+			{
+				const std::byte* bytes = readBytes(1);
+				if (bytes == nullptr)
+				{
+					data = false;
+					return;
+				}
+
+				m_bits     = static_cast<std::uint8_t>(*bytes);
+				m_bitCount = 0;
+			}
+
+			data = ((m_bits >> m_bitCount) & 1u) != 0;
+			++m_bitCount;
+		}
+		else
+		{
+			using Unsigned = std::make_unsigned_t<T>;
+
+			std::uint64_t value;
+			if (!popVarint(value) ||
+			    value > std::numeric_limits<Unsigned>::max())
+			{
+				fail();
+				data = T {};
+				return;
+			}
+
+			const auto raw = static_cast<Unsigned>(value);
+			if constexpr (std::is_signed_v<T>)
+			{
+				// undo the zigzag.
+				data = static_cast<T>(static_cast<Unsigned>(raw >> 1) ^
+				                      static_cast<Unsigned>(-(raw & 1u)));
+			}
+			else
+			{
+				data = raw;
+			}
+		}
+	}
+
+	inline bool Reader::popVarint(std::uint64_t& value)
+	{
+		value = 0;
+		for (int shift = 0; shift < 64; shift += 7)
+		{
+			const std::byte* bytes = readBytes(1);
+			if (bytes == nullptr)
+			{
+				return false;
+			}
+
+			const auto byte = static_cast<std::uint8_t>(*bytes);
+			value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+
+			if ((byte & 0x80) == 0)
+			{
+				return true;
+			}
+		}
+
+		// more than 10 bytes can't be a 64 bit number.
+		fail();
+		return false;
+	}
+
+	template <typename T>
+	std::size_t Reader::minimumSize() const
+	{
+		if constexpr (std::is_integral_v<T>)
+		{
+			if (m_encoding == Encoding::COMPACT)
+			{
+				return 1;
+			}
+		}
+
+		return sizeof(T);
+	}
+
+	inline Reader& Reader::operator>>(bool& val)
+	{
+		pop(val);
+		return *this;
+	}
+
+	inline Reader& Reader::operator>>(char& val)
+	{
+		pop(val);
+		return *this;
+	}
+
+	inline Reader& Reader::operator>>(unsigned char& val)
+	{
+		pop(val);
+		return *this;
+	}
+
+	inline Reader& Reader::operator>>(float& val)
+	{
+		pop(val);
+		return *this;
+	}
+
+	inline Reader& Reader::operator>>(double& val)
+	{
+		pop(val);
+		return *this;
+	}
+
+	inline Reader& Reader::operator>>(std::int16_t& val)
+	{
+		pop(val);
+		return *this;
+	}
+
+	inline Reader& Reader::operator>>(std::int32_t& val)
+	{
+		pop(val);
+		return *this;
+	}
+
+	inline Reader& Reader::operator>>(std::int64_t& val)
+	{
+		pop(val);
+		return *this;
+	}
+
+	inline Reader& Reader::operator>>(std::uint16_t& val)
+	{
+		pop(val);
+		return *this;
+	}
+
+	inline Reader& Reader::operator>>(std::uint32_t& val)
+	{
+		pop(val);
+		return *this;
+	}
+
+	inline Reader& Reader::operator>>(std::uint64_t& val)
+	{
+		pop(val);
+		return *this;
+	}
+
+	inline Reader& Reader::operator>>(ISerializable& val)
+	{
+		val << *this;
+		return *this;
+	}
+
+#ifdef PHX_INT32_EQUAL_LONG
+	inline Reader& Reader::operator>>(long& val)
+	{
+		pop(val);
+		return *this;
+	}
+
+	inline Reader& Reader::operator>>(unsigned long& val)
+	{
+		pop(val);
+		return *this;
+	}
+#endif
+
+	template <typename T>
+	Reader& Reader::operator>>(std::basic_string<T>& val)
+	{
+		// the same layout the Serializer writes, the length followed by
+		// every character.
+		unsigned int size;
+		pop(size);
+
+		// a corrupt length mustn't allocate anything before being rejected.
+		val.clear();
+		if (size > remaining() / minimumSize<T>())
+		{
+			fail();
+			return *this;
+		}
+
+		val.resize(size);
+		read(val.data(), size);
+		return *this;
+	}
+
+	template <typename T>
+	Reader& Reader::operator>>(std::vector<T>& val)
+	{
+		std::size_t count;
+		pop(count);
+
+		val.clear();
+		if (count > remaining() / minimumSize<T>())
+		{
+			fail();
+			return *this;
+		}
+
+		val.resize(count);
+		read(val.data(), count);
+		return *this;
+	}
+
+	inline Serializer& Serializer::operator>>(ISerializable& val)
+	{
+		// deserialize straight from the buffer, then drop everything that
+		// was read in one go rather than a value at a time.
+		Reader reader(m_buffer, m_encoding);
+		val << reader;
+		m_buffer.erase(m_buffer.begin(), m_buffer.begin() + reader.tell());
+		return *this;
+	}
+} // namespace phx
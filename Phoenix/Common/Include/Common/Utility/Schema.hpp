@@ -0,0 +1,282 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <Common/Utility/Serializer.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Lists the fields of a type so it can be serialized without writing
+ * the operators by hand.
+ *
+ * This goes inside the definition of the type, with every field in the order
+ * they should be written. Fields of fields can be listed too. Reading,
+ * writing and working out the size are then generated from that one list, so
+ * they can't drift apart, and none of them are virtual.
+ *
+ * Fields can be numbers, strings, vectors or other types with a schema.
+ *
+ * @code
+ * struct InputState
+ * {
+ *     bool        forward = false;
+ *     math::vec3i rotation;
+ *
+ *     PHX_SERIALIZABLE(InputState, forward, rotation.x, rotation.y);
+ * };
+ *
+ * Serializer ser;
+ * ser << state;
+ * @endcode
+ */
+#define PHX_SERIALIZABLE(Type, ...)                         \
+	auto fields() { return std::tie(__VA_ARGS__); }         \
+	auto fields() const { return std::tie(__VA_ARGS__); }   \
+	using SchemaType = Type
+
+namespace phx::schema
+{
+	/**
+	 * @brief Checks if a type has its own schema.
+	 *
+	 * A type deriving from one with a schema doesn't count, its own fields
+	 * would silently be left out.
+	 */
+	template <typename T, typename = void>
+	struct IsReflected : std::false_type
+	{
+	};
+
+	template <typename T>
+	struct IsReflected<T, std::void_t<typename T::SchemaType>>
+	    : std::is_same<typename T::SchemaType, T>
+	{
+	};
+
+	template <typename T>
+	constexpr bool isReflected = IsReflected<T>::value;
+
+	namespace detail
+	{
+		template <typename T>
+		struct AlwaysFalse : std::false_type
+		{
+		};
+
+		constexpr std::size_t varintSize(std::uint64_t value)
+		{
+			std::size_t size = 1;
+			while (value >= 0x80)
+			{
+				value >>= 7;
+				++size;
+			}
+
+			return size;
+		}
+
+		// compact bools share bytes, so they're counted separately and
+		// rounded up at the end.
+		struct Size
+		{
+			std::size_t bytes = 0;
+			std::size_t bools = 0;
+
+			std::size_t total() const { return bytes + (bools + 7) / 8; }
+		};
+
+		template <typename T>
+		void count(const std::basic_string<T>& value, Encoding encoding,
+		           Size& size);
+
+		template <typename T>
+		void count(const std::vector<T>& value, Encoding encoding, Size& size);
+
+		template <typename T>
+		void count(const T& value, Encoding encoding, Size& size)
+		{
+			if constexpr (isReflected<T>)
+			{
+				std::apply(
+				    [&](const auto&... fields) {
+					    (count(fields, encoding, size), ...);
+				    },
+				    value.fields());
+			}
+			else if constexpr (std::is_same_v<T, bool>)
+			{
+				if (encoding == Encoding::COMPACT)
+				{
+					++size.bools;
+				}
+				else
+				{
+					size.bytes += sizeof(bool);
+				}
+			}
+			else if constexpr (std::is_integral_v<T> && sizeof(T) > 1)
+			{
+				if (encoding == Encoding::COMPACT)
+				{
+					using Unsigned = std::make_unsigned_t<T>;
+
+					auto raw = static_cast<Unsigned>(value);
+					if constexpr (std::is_signed_v<T>)
+					{
+						raw = static_cast<Unsigned>(raw << 1) ^
+						      static_cast<Unsigned>(value >> (sizeof(T) * 8 - 1));
+					}
+
+					size.bytes += varintSize(raw);
+				}
+				else
+				{
+					size.bytes += sizeof(T);
+				}
+			}
+			else if constexpr (std::is_arithmetic_v<T>)
+			{
+				size.bytes += sizeof(T);
+			}
+			else
+			{
+				static_assert(AlwaysFalse<T>::value,
+				              "This type can't be a field of a schema.");
+			}
+		}
+
+		template <typename T>
+		void count(const std::basic_string<T>& value, Encoding encoding,
+		           Size& size)
+		{
+			count(static_cast<unsigned int>(value.length()), encoding, size);
+			size.bytes += value.length() * sizeof(T);
+		}
+
+		template <typename T>
+		void count(const std::vector<T>& value, Encoding encoding, Size& size)
+		{
+			count(value.size(), encoding, size);
+
+			if constexpr (std::is_arithmetic_v<T> && !std::is_same_v<T, bool>)
+			{
+				// everything is the same size, no need to look at each one.
+				if (encoding == Encoding::FIXED ||
+				    std::is_floating_point_v<T> || sizeof(T) == 1)
+				{
+					size.bytes += value.size() * sizeof(T);
+					return;
+				}
+			}
+
+			for (const auto& element : value)
+			{
+				count(element, encoding, size);
+			}
+		}
+	} // namespace detail
+
+	/**
+	 * @brief Works out how many bytes a value is serialized into.
+	 * @param value The value to measure.
+	 * @param encoding The encoding it's going to be written with.
+	 * @return The size in bytes, when written into an empty Serializer.
+	 */
+	template <typename T>
+	std::size_t size(const T& value, Encoding encoding = Encoding::FIXED)
+	{
+		detail::Size size;
+		detail::count(value, encoding, size);
+		return size.total();
+	}
+
+	/**
+	 * @brief Writes every field of a value, after making room for all of
+	 * them so the buffer is grown once at most.
+	 */
+	template <typename T>
+	void encode(Serializer& serializer, const T& value)
+	{
+		serializer.reserve(size(value, serializer.getEncoding()));
+
+		std::apply(
+		    [&](const auto&... fields) { (serializer << ... << fields); },
+		    value.fields());
+	}
+
+	/**
+	 * @brief Reads every field of a value, check the reader afterwards to
+	 * see if it all fit.
+	 */
+	template <typename T>
+	void decode(Reader& reader, T& value)
+	{
+		std::apply([&](auto&... fields) { (reader >> ... >> fields); },
+		           value.fields());
+	}
+} // namespace phx::schema
+
+namespace phx
+{
+	template <typename T>
+	std::enable_if_t<schema::isReflected<T>, Serializer&> operator<<(
+	    Serializer& serializer, const T& value)
+	{
+		schema::encode(serializer, value);
+		return serializer;
+	}
+
+	template <typename T>
+	std::enable_if_t<schema::isReflected<T>, Reader&> operator>>(Reader& reader,
+	                                                              T& value)
+	{
+		schema::decode(reader, value);
+		return reader;
+	}
+
+	template <typename T>
+	std::enable_if_t<schema::isReflected<T>, Serializer&> operator>>(
+	    Serializer& serializer, T& value)
+	{
+		// the same as any other object, read from the buffer and then drop
+		// what was read.
+		Reader reader(serializer.getBuffer(), serializer.getEncoding());
+		schema::decode(reader, value);
+
+		data::Data& buffer = serializer.getBuffer();
+		buffer.erase(buffer.begin(), buffer.begin() + reader.tell());
+		return serializer;
+	}
+} // namespace phx
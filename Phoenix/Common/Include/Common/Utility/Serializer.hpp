@@ -31,6 +31,7 @@
 #include <Common/Utility/Internal/Endian.hpp>
 #include <Common/Utility/Internal/SharedTypes.hpp>
 
+#include <algorithm>
 #include <cstddef>
 #include <vector>
 #include <string>
@@ -45,12 +46,36 @@
 namespace phx
 {
 	class Serializer;
+	class Reader;
+
+	/**
+	 * @brief How numbers are laid out by a Serializer and a Reader.
+	 *
+	 * FIXED writes every value at its full size, which is quick to read and
+	 * write and is what everything on disk uses.
+	 *
+	 * COMPACT trades a little CPU for size, it's meant for small messages
+	 * sent very often: integers are written as LEB128 varints (signed ones
+	 * zigzag encoded first), so small values take a single byte, and bools
+	 * are packed 8 to a byte. String and vector lengths are integers, so
+	 * they shrink too. Single byte values, floats and doubles are written
+	 * the same way in both modes.
+	 *
+	 * The encoding isn't stored in the data, both ends of a message have to
+	 * agree on it.
+	 */
+	enum class Encoding
+	{
+		FIXED,
+		COMPACT
+	};
 
 	/**
 	 * @brief Interface class for helping with data structures.
 	 *
 	 * This function must be overridden, usage for the Serializer can be found
-	 * below.
+	 * below. Objects are written with a Serializer and read back with a
+	 * Reader (see Reader.hpp).
 	 */
 	class ISerializable
 	{
@@ -59,7 +84,7 @@ namespace phx
 		virtual Serializer& operator>>(Serializer& serializer) const = 0;
 
 		// unserialize.
-		virtual Serializer& operator<<(Serializer& serializer) = 0;
+		virtual Reader& operator<<(Reader& reader) = 0;
 	};
 
 	/**
@@ -125,12 +150,23 @@ namespace phx
 	class Serializer
 	{
 	public:
-		Serializer() = default;
+		/**
+		 * @brief Creates an empty serializer.
+		 * @param encoding How numbers are written. Data written with
+		 * Encoding::COMPACT has to be read back with a Reader using the same
+		 * encoding.
+		 */
+		explicit Serializer(Encoding encoding = Encoding::FIXED)
+		    : m_encoding(encoding)
+		{
+		}
+
+		Encoding getEncoding() const { return m_encoding; }
 
 		data::Data& getBuffer() { return m_buffer; }
 		void        setBuffer(std::byte* data, std::size_t dataLength);
-		void        setBuffer(const data::Data& data) { m_buffer = data; }
-		void        setBuffer(data::Data&& data) { m_buffer = std::move(data); }
+		void        setBuffer(const data::Data& data);
+		void        setBuffer(data::Data&& data);
 
 		void appendToBuffer(const std::vector<std::byte>& data)
 		{
@@ -138,6 +174,35 @@ namespace phx
 		}
 
 		bool empty() const { return m_buffer.empty(); }
+
+		/**
+		 * @brief Makes room for more data without reallocating.
+		 * @param bytes The amount of bytes that are going to be written.
+		 *
+		 * The buffer at least doubles when it grows, so reserving before
+		 * every value doesn't copy the buffer every time.
+		 */
+		void reserve(std::size_t bytes)
+		{
+			const std::size_t needed = m_buffer.size() + bytes;
+			if (needed > m_buffer.capacity())
+			{
+				m_buffer.reserve(std::max(needed, 2 * m_buffer.capacity()));
+			}
+		}
+
+		/**
+		 * @brief Writes a run of values in one go.
+		 * @param data The values to write.
+		 * @param count The amount of values.
+		 *
+		 * This writes the same bytes as writing each value one by one, but
+		 * copies them all at once and swaps their byte order in bulk. No
+		 * length is written, the reader needs to know the count. Only
+		 * numbers can be written like this.
+		 */
+		template <typename T>
+		Serializer& write(const T* data, std::size_t count);
 		
 		Serializer& operator<<(const bool& val);
 		Serializer& operator<<(const char& val);
@@ -208,10 +273,24 @@ namespace phx
 		template <typename T>
 		void pop(std::vector<T>& data);
 
+		template <typename T>
+		void pushCompact(const T& data);
+
+		void pushVarint(std::uint64_t value);
+
 	private:
 		data::Data m_buffer;
+		Encoding   m_encoding;
+
+		// where the byte bools are currently packed into is, and how many
+		// of its bits have been used.
+		std::size_t m_bitOffset = 0;
+		int         m_bitCount  = 8;
 	};
 } // namespace phx::data
 
 #include <Common/Utility/Serializer.inl>
+
+// reading objects goes through a Reader.
+#include <Common/Utility/Reader.hpp>
  
\ No newline at end of file
@@ -27,6 +27,8 @@
 // POSSIBILITY OF SUCH DAMAGE.
 
 #include <algorithm>
+#include <cstdint>
+#include <type_traits>
 
 namespace phx
 {
@@ -34,6 +36,19 @@ namespace phx
 	{
 		m_buffer.clear();
 		m_buffer.insert(m_buffer.begin(), data, data + dataLength);
+		m_bitCount = 8;
+	}
+
+	inline void Serializer::setBuffer(const data::Data& data)
+	{
+		m_buffer   = data;
+		m_bitCount = 8;
+	}
+
+	inline void Serializer::setBuffer(data::Data&& data)
+	{
+		m_buffer   = std::move(data);
+		m_bitCount = 8;
 	}
 
 	inline Serializer& Serializer::operator<<(const bool& val)
@@ -202,12 +217,6 @@ namespace phx
 		return *this;
 	}
 
-	inline Serializer& Serializer::operator>>(ISerializable& val)
-	{
-		val << *this;
-		return *this;
-	}
-
 #ifdef PHX_INT32_EQUAL_LONG
 	inline Serializer& Serializer::operator>>(long& val)
 	{
@@ -237,173 +246,197 @@ namespace phx
 	}
 	
 	template <typename T>
-	void Serializer::push(const T& data)
+	Serializer& Serializer::write(const T* data, std::size_t count)
 	{
-		union
-		{
-			std::byte bytes[sizeof(T)];
-			T         value;
-		} value;
-
-		value.value = data::endian::swapForNetwork(data);
+		static_assert(std::is_arithmetic_v<T>,
+		              "only numbers can be copied onto the wire in bulk");
 
-		for (std::size_t i = 0; i < sizeof(T); ++i)
+		if constexpr (std::is_integral_v<T> && sizeof(T) > 1)
 		{
-			m_buffer.push_back(value.bytes[i]);
+			// every compact integer has its own length, they can't be
+			// copied in one go.
+			if (m_encoding == Encoding::COMPACT)
+			{
+				for (std::size_t i = 0; i < count; ++i)
+				{
+					push(data[i]);
+				}
+
+				return *this;
+			}
 		}
+
+		const std::size_t offset = m_buffer.size();
+		m_buffer.resize(offset + count * sizeof(T));
+
+		std::byte* bytes = m_buffer.data() + offset;
+		std::memcpy(bytes, data, count * sizeof(T));
+		data::endian::swapArray<T>(bytes, count);
+
+		return *this;
 	}
 
 	template <typename T>
-	void Serializer::push(const std::vector<T>& data)
+	void Serializer::push(const T& data)
 	{
-		union
+		if constexpr (std::is_integral_v<T> &&
+		              (sizeof(T) > 1 || std::is_same_v<T, bool>))
 		{
-			std::byte bytes[sizeof(T)];
-			T         value;
-		} value;
-
-		// push the number of elements.
-		push(data.size());
+			if (m_encoding == Encoding::COMPACT)
+			{
+				pushCompact(data);
+				return;
+			}
+		}
 
-		// get the number of bytes to reserve
-		const std::size_t totalSize = data.size() * sizeof(T);
+		const T value = data::endian::swapForNetwork(data);
 
-		m_buffer.reserve(totalSize);
+		const std::size_t offset = m_buffer.size();
+		m_buffer.resize(offset + sizeof(T));
+		std::memcpy(m_buffer.data() + offset, &value, sizeof(T));
+	}
 
-		for (const auto& val : data)
+	template <typename T>
+	void Serializer::pushCompact(const T& data)
+	{
+		if constexpr (std::is_same_v<T, bool>)
 		{
-			// don't just call push because we could be calling it a good 1000
-			// times just like this.
-			
-			value.value = data::endian::swapForNetwork(val);
-			for (std::size_t i = 0; i < sizeof(T); ++i)
+			// start a new byte once the current one is full, the next 7
+			// bools written go into the same byte, wherever they are.
+			if (m_bitCount == 8)
 			{
-				m_buffer.push_back(value.bytes[i]);
+				m_bitOffset = m_buffer.size();
+				m_bitCount  = 0;
+				m_buffer.push_back(std::byte {0});
 			}
+
+			if (data)
+			{
+				m_buffer[m_bitOffset] |= std::byte(1u << m_bitCount);
+			}
+
+			++m_bitCount;
+		}
+		else if constexpr (std::is_signed_v<T>)
+		{
+			// zigzag, so small negative numbers stay small:
+			// 0 -> 0, -1 -> 1, 1 -> 2, -2 -> 3...
+			using Unsigned = std::make_unsigned_t<T>;
+			const auto zigzag =
+			    static_cast<Unsigned>(static_cast<Unsigned>(data) << 1) ^
+			    static_cast<Unsigned>(data >> (sizeof(T) * 8 - 1));
+			pushVarint(zigzag);
+		}
+		else
+		{
+			pushVarint(data);
 		}
 	}
 
-	template <typename T>
-	void Serializer::push(const std::basic_string<T>& data)
+	inline void Serializer::pushVarint(std::uint64_t value)
 	{
-		// if T is the same as the number of bits in a char, it's a normal
-		// std::string. This means that there is only 1 byte per character and
-		// so you don't need to factor in any endianness changes.
-		if constexpr (sizeof(T) == CHAR_BIT)
+		// 7 bits at a time, lowest first, the top bit says if another byte
+		// follows.
+		while (value >= 0x80)
 		{
-			// this is faster than iterating through every character and
-			// swapping endianness and essentially doing an unnecessary
-			// endianness swap.
-
-			// push size of string onto data at the end.
-			// specify unsigned int otherwise it will waste space allocating a
-			// 64 bit variable.
-			push(static_cast<unsigned int>(data.length()));
+			m_buffer.push_back(std::byte((value & 0x7f) | 0x80));
+			value >>= 7;
+		}
 
-			// previous end of the array, so we can append onto that - rather
-			// than the new end.
-			const std::size_t prevEnd = m_buffer.size();
+		m_buffer.push_back(std::byte(value));
+	}
 
-			// +1 for null terminator.
-			m_buffer.resize(m_buffer.size() + data.length() + 1);
+	template <typename T>
+	void Serializer::push(const std::vector<T>& data)
+	{
+		// push the number of elements.
+		push(data.size());
 
-			// convert string to array of std::byte and append to data array.
-			std::transform(data.begin(), data.end(), m_buffer.begin() + prevEnd,
-			               [](char c) { return std::byte(c); });
-		}
-		else
+		if constexpr (std::is_same_v<T, bool>)
 		{
-			// push a new value for each character in the string.
-			// the reason this exists is because there are different strings in
-			// the standard library, them being 16bit and 32bit character
-			// strings.
-			push(static_cast<unsigned int>(data.length()));
-			for (auto c : data)
+			// vector<bool> is packed, it can't be copied in one go.
+			for (const bool val : data)
 			{
-				push(c);
+				push(val);
 			}
 		}
+		else
+		{
+			write(data.data(), data.size());
+		}
 	}
-	
+
 	template <typename T>
-	void Serializer::pop(T& data)
+	void Serializer::push(const std::basic_string<T>& data)
 	{
-		union
-		{
-			std::byte bytes[sizeof(T)];
-			T         value;
-		} value;
+		// the length, then every character. a narrow string is copied as is,
+		// wider characters are swapped like any other array.
+		// specify unsigned int otherwise it will waste space allocating a
+		// 64 bit variable.
+		push(static_cast<unsigned int>(data.length()));
+		write(data.data(), data.length());
+	}
 
-		std::memcpy(value.bytes, m_buffer.data(), sizeof(T));
+	template <typename T>
+	void Serializer::pop(T& data)
+	{
+		T value;
+		std::memcpy(&value, m_buffer.data(), sizeof(T));
 
 		// basically pop front for the amount of bytes of data we're taking.
 		m_buffer.erase(m_buffer.begin(), m_buffer.begin() + sizeof(T));
 
-		data = data::endian::swapForHost(value.value);
+		data = data::endian::swapForHost(value);
 	}
 
 	template <typename T>
 	void Serializer::pop(std::vector<T>& data)
 	{
-		union
-		{
-			std::byte bytes[sizeof(T)];
-			T         value;
-		} value;
-
 		std::size_t dataCount;
 		pop(dataCount);
 
-		data.reserve(dataCount);
-		for (std::size_t i = 0; i < dataCount; ++i)
+		if constexpr (std::is_same_v<T, bool>)
 		{
-			std::memcpy(value.bytes, m_buffer.data() + (i * sizeof(T)),
-			            sizeof(T));
+			data.reserve(dataCount);
+			for (std::size_t i = 0; i < dataCount; ++i)
+			{
+				bool val;
+				pop(val);
+				data.push_back(val);
+			}
+		}
+		else
+		{
+			static_assert(std::is_arithmetic_v<T>,
+			              "only numbers can be copied off the wire in bulk");
 
-			value.value = data::endian::swapForHost(value.value);
+			// copy and swap everything at once, then drop it from the buffer
+			// with a single erase.
+			const std::size_t offset = data.size();
+			data.resize(offset + dataCount);
 
-			data.push_back(value.value);
-		}
+			std::byte* bytes = reinterpret_cast<std::byte*>(data.data() + offset);
+			std::memcpy(bytes, m_buffer.data(), dataCount * sizeof(T));
+			data::endian::swapArray<T>(bytes, dataCount);
 
-		m_buffer.erase(m_buffer.begin(),
-		               m_buffer.begin() + (dataCount * sizeof(T)));
+			m_buffer.erase(m_buffer.begin(),
+			               m_buffer.begin() + (dataCount * sizeof(T)));
+		}
 	}
 
 	template <typename T>
 	void Serializer::pop(std::basic_string<T>& data)
 	{
-		if constexpr (sizeof(T) == CHAR_BIT)
-		{
-			unsigned int size;
-			pop(size);
+		unsigned int size;
+		pop(size);
 
-			data.resize(size);
+		data.resize(size);
 
-			std::transform(m_buffer.begin(), m_buffer.begin() + size,
-			               data.begin(),
-			               [](std::byte byte) { return char(byte); });
+		std::byte* bytes = reinterpret_cast<std::byte*>(data.data());
+		std::memcpy(bytes, m_buffer.data(), size * sizeof(T));
+		data::endian::swapArray<T>(bytes, size);
 
-			// basically pop front for the amount of bytes of data we're taking.
-			m_buffer.erase(m_buffer.begin(), m_buffer.begin() + size);
-		}
-		else
-		{
-			union
-			{
-				std::byte bytes[sizeof(T)];
-				T         c;
-			} values;
-
-			unsigned int size;
-			pop(size);
-
-			data.reserve(size);
-
-			for (unsigned int i = 0; i < size; ++i)
-			{
-				pop(values.c);
-				data.push_back(values.c);
-			}
-		}
+		// basically pop front for the amount of bytes of data we're taking.
+		m_buffer.erase(m_buffer.begin(), m_buffer.begin() + size * sizeof(T));
 	}
 } // namespace phx
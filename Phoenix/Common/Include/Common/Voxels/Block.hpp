@@ -112,6 +112,10 @@ namespace phx::voxels
 		/// be true
 		bool rotV = false;
 
+		/// @brief If a SOLID block completely covers the faces of the blocks
+		/// next to it, anything that isn't a full cube should unset this.
+		bool opaque = true;
+
 		/// @brief Callback for when the block is placed.
 		BlockCallback onPlace;
 
@@ -129,11 +133,13 @@ namespace phx::voxels
 	 * @brief Container representing a single instance of a block.
 	 *
 	 * This holds a pointer to the universal type of the block and either the
-	 * metadata for the block or a nullptr if there is none.
+	 * metadata for the block or a nullptr if there is none. The metadata
+	 * can't be changed through the block, a chunk might be sharing it with
+	 * its snapshots (see Chunk::setMetadataAt).
 	 */
 	struct Block
 	{
-		BlockType* type;
-		Metadata*  metadata;
+		BlockType*      type;
+		const Metadata* metadata;
 	};
 } // namespace phx::voxels
@@ -0,0 +1,110 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <Common/Voxels/BlockReferrer.hpp>
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace phx::voxels
+{
+	/**
+	 * @brief Numbers the block types used by a save.
+	 *
+	 * The IDs blocks are given at runtime depend on the order mods register
+	 * them in, so they can't be written to disk. Writing the string ID of a
+	 * block for every run in a chunk is slow to write and even slower to read
+	 * back though. Instead, each save numbers the blocks it uses the first
+	 * time they're written, and keeps the names for those numbers in its
+	 * JSON file (see Save), so chunks can store small integers.
+	 *
+	 * Saving can happen from more than one thread, so every method locks.
+	 */
+	class BlockDictionary
+	{
+	public:
+		using ID = std::uint16_t;
+
+		BlockDictionary() = default;
+
+		BlockDictionary(const BlockDictionary&) = delete;
+		BlockDictionary& operator=(const BlockDictionary&) = delete;
+
+		/**
+		 * @brief Gets the saved ID of a block, numbering it if it's new.
+		 * @param type The block to get the ID of.
+		 * @return The ID the block is saved as.
+		 */
+		ID getID(const BlockType* type);
+
+		/**
+		 * @brief Gets the block a saved ID stands for.
+		 * @param id The saved ID.
+		 * @param referrer The blocks registered in this session.
+		 * @return The block, the unknown block if the ID isn't in the
+		 * dictionary or the block it was isn't registered anymore.
+		 */
+		BlockType* getType(ID id, BlockReferrer* referrer) const;
+
+		/**
+		 * @brief Gets the string ID of every block, in the order of their
+		 * saved IDs.
+		 */
+		std::vector<std::string> getNames() const;
+
+		/**
+		 * @brief Replaces the dictionary with one loaded from a save.
+		 * @param names The string IDs, as returned by getNames.
+		 */
+		void restore(const std::vector<std::string>& names);
+
+		/// @brief The amount of blocks in the dictionary.
+		std::size_t size() const;
+
+	private:
+		mutable std::mutex m_mutex;
+
+		std::vector<std::string>            m_names;
+		std::unordered_map<std::string, ID> m_ids;
+
+		// saved IDs by runtime ID, so saving doesn't hash a string for
+		// every block type it writes. -1 when not known yet.
+		std::vector<std::int32_t> m_byUid;
+
+		// blocks by saved ID, so loading doesn't either. Looked up the first
+		// time an ID is read, nullptr until then. Only valid for the
+		// referrer they were looked up in.
+		mutable std::vector<BlockType*> m_types;
+		mutable BlockReferrer*          m_typesReferrer = nullptr;
+	};
+} // namespace phx::voxels
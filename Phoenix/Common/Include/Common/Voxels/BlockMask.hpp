@@ -0,0 +1,297 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+
+namespace phx::voxels
+{
+	/**
+	 * @brief A single bit for every block in a WIDTH x HEIGHT x DEPTH area.
+	 *
+	 * Bits use the same flattened layout as Chunk::getVectorIndex, packed
+	 * into 64 bit words. Every operation works on whole words, so asking
+	 * something like "which solid blocks have air above them" touches 64
+	 * blocks per instruction rather than dereferencing every block, and the
+	 * plain loops over the words are easy for the compiler to vectorize.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * // every solid block that has no opaque block above it.
+	 * auto top = solid & ~opaque.neighbors(BlockMask::Axis::Y, 1);
+	 * top.forEach([](std::size_t index) { ... });
+	 * @endcode
+	 */
+	template <int WIDTH, int HEIGHT, int DEPTH>
+	class BlockMask
+	{
+	public:
+		/// @brief The amount of bits in the mask.
+		static constexpr std::size_t BIT_COUNT =
+		    static_cast<std::size_t>(WIDTH) * HEIGHT * DEPTH;
+
+		/// @brief The amount of 64 bit words the bits are stored in.
+		static constexpr std::size_t WORD_COUNT = (BIT_COUNT + 63) / 64;
+
+		static_assert(BIT_COUNT % 64 == 0,
+		              "A BlockMask must fill its words completely.");
+
+		using Words = std::array<std::uint64_t, WORD_COUNT>;
+
+		enum class Axis
+		{
+			X,
+			Y,
+			Z
+		};
+
+	public:
+		constexpr BlockMask() : m_words() {}
+
+		bool test(std::size_t index) const
+		{
+			return (m_words[index >> 6] >> (index & 63)) & 1;
+		}
+
+		void set(std::size_t index, bool value = true)
+		{
+			const std::uint64_t bit = std::uint64_t(1) << (index & 63);
+			if (value)
+			{
+				m_words[index >> 6] |= bit;
+			}
+			else
+			{
+				m_words[index >> 6] &= ~bit;
+			}
+		}
+
+		/**
+		 * @brief Sets or clears every bit at once.
+		 * @param value The value every bit should have.
+		 */
+		void fill(bool value) { m_words.fill(value ? ~std::uint64_t(0) : 0); }
+
+		/**
+		 * @brief Checks if no bit is set at all.
+		 * @return true if the mask is empty.
+		 */
+		bool none() const
+		{
+			std::uint64_t any = 0;
+			for (const std::uint64_t word : m_words)
+			{
+				any |= word;
+			}
+
+			return any == 0;
+		}
+
+		/**
+		 * @brief Counts the set bits.
+		 * @return The amount of set bits.
+		 */
+		std::size_t count() const
+		{
+			std::size_t total = 0;
+			for (const std::uint64_t word : m_words)
+			{
+				total += std::bitset<64>(word).count();
+			}
+
+			return total;
+		}
+
+		/**
+		 * @brief Gets the mask of the neighbors of every block.
+		 * @param axis The axis to look along.
+		 * @param direction 1 to look in the positive direction, -1 for the
+		 * negative direction.
+		 * @return A mask where a bit is set if the neighboring bit in this
+		 * mask is set. Neighbors outside of the area count as unset.
+		 */
+		BlockMask neighbors(Axis axis, int direction) const
+		{
+			switch (axis)
+			{
+			case Axis::X:
+				return direction > 0
+				           ? shiftDown<1>() & ~edge(X_MAX)
+				           : shiftUp<1>() & ~edge(X_MIN);
+			case Axis::Y:
+				return direction > 0
+				           ? shiftDown<WIDTH>() & ~edge(Y_MAX)
+				           : shiftUp<WIDTH>() & ~edge(Y_MIN);
+			case Axis::Z:
+			default:
+				// the z edges are the ends of the array, anything shifted
+				// past them is already zero.
+				return direction > 0 ? shiftDown<WIDTH * HEIGHT>()
+				                     : shiftUp<WIDTH * HEIGHT>();
+			}
+		}
+
+		/**
+		 * @brief Calls a function for every set bit, in ascending order.
+		 * @param func The function to call with the index of every set bit.
+		 *
+		 * Empty words are skipped in one go, so sparse masks are cheap.
+		 */
+		template <typename Func>
+		void forEach(Func&& func) const
+		{
+			for (std::size_t w = 0; w < WORD_COUNT; ++w)
+			{
+				std::uint64_t word = m_words[w];
+				while (word != 0)
+				{
+					// isolate the lowest bit, the amount of bits below it is
+					// the offset in the word.
+					const std::uint64_t lowest = word & (~word + 1);
+					func(w * 64 + std::bitset<64>(lowest - 1).count());
+					word ^= lowest;
+				}
+			}
+		}
+
+		const Words& getWords() const { return m_words; }
+		Words&       getWords() { return m_words; }
+
+		BlockMask operator&(const BlockMask& rhs) const
+		{
+			BlockMask out;
+			for (std::size_t w = 0; w < WORD_COUNT; ++w)
+			{
+				out.m_words[w] = m_words[w] & rhs.m_words[w];
+			}
+			return out;
+		}
+
+		BlockMask operator|(const BlockMask& rhs) const
+		{
+			BlockMask out;
+			for (std::size_t w = 0; w < WORD_COUNT; ++w)
+			{
+				out.m_words[w] = m_words[w] | rhs.m_words[w];
+			}
+			return out;
+		}
+
+		BlockMask operator~() const
+		{
+			BlockMask out;
+			for (std::size_t w = 0; w < WORD_COUNT; ++w)
+			{
+				out.m_words[w] = ~m_words[w];
+			}
+			return out;
+		}
+
+		bool operator==(const BlockMask& rhs) const
+		{
+			return m_words == rhs.m_words;
+		}
+
+	private:
+		enum Edge
+		{
+			X_MIN,
+			X_MAX,
+			Y_MIN,
+			Y_MAX
+		};
+
+		// every bit on one of the faces of the area.
+		static const BlockMask& edge(Edge which)
+		{
+			static const std::array<BlockMask, 4> edges = [] {
+				std::array<BlockMask, 4> out;
+				for (std::size_t i = 0; i < BIT_COUNT; ++i)
+				{
+					const std::size_t x = i % WIDTH;
+					const std::size_t y = (i / WIDTH) % HEIGHT;
+
+					out[X_MIN].set(i, x == 0);
+					out[X_MAX].set(i, x == WIDTH - 1);
+					out[Y_MIN].set(i, y == 0);
+					out[Y_MAX].set(i, y == HEIGHT - 1);
+				}
+				return out;
+			}();
+
+			return edges[which];
+		}
+
+		// bit i of the result is bit i + N of this mask.
+		template <std::size_t N>
+		BlockMask shiftDown() const
+		{
+			constexpr std::size_t words = N / 64;
+			constexpr std::size_t bits  = N % 64;
+
+			BlockMask out;
+			for (std::size_t w = 0; w + words < WORD_COUNT; ++w)
+			{
+				std::uint64_t word = m_words[w + words] >> bits;
+				if (bits != 0 && w + words + 1 < WORD_COUNT)
+				{
+					word |= m_words[w + words + 1] << ((64 - bits) % 64);
+				}
+				out.m_words[w] = word;
+			}
+			return out;
+		}
+
+		// bit i of the result is bit i - N of this mask.
+		template <std::size_t N>
+		BlockMask shiftUp() const
+		{
+			constexpr std::size_t words = N / 64;
+			constexpr std::size_t bits  = N % 64;
+
+			BlockMask out;
+			for (std::size_t w = words; w < WORD_COUNT; ++w)
+			{
+				std::uint64_t word = m_words[w - words] << bits;
+				if (bits != 0 && w > words)
+				{
+					word |= m_words[w - words - 1] >> ((64 - bits) % 64);
+				}
+				out.m_words[w] = word;
+			}
+			return out;
+		}
+
+	private:
+		Words m_words;
+	};
+} // namespace phx::voxels
@@ -0,0 +1,129 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <Common/Registry.hpp>
+#include <Common/Voxels/Block.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace phx::voxels
+{
+	/**
+	 * @brief A compact table of the block properties used in hot loops.
+	 *
+	 * BlockType is large, it carries strings and lua callbacks, so reading a
+	 * single field of it for every block in a chunk spends most of its time
+	 * on cache misses. This table copies the small properties into separate
+	 * contiguous lists indexed by UID once every block has been registered,
+	 * so loops over many blocks can look them up by UID instead.
+	 *
+	 * The table is a snapshot, blocks registered after build() is called are
+	 * treated as unknown blocks until it's built again. Before it's built at
+	 * all every block is, BlockReferrer builds it as soon as it has added
+	 * its own blocks so that never lasts long.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * referrer.freeze(); // after mods have been loaded.
+	 * if (referrer.properties.isOpaque(type->uid))
+	 * {
+	 *     // ...
+	 * }
+	 * @endcode
+	 */
+	class BlockProperties
+	{
+	public:
+		/// @brief Bits stored for every block type.
+		enum Flag : std::uint8_t
+		{
+			SOLID       = 1 << 0,
+			OPAQUE      = 1 << 1,
+			ROTATE_H    = 1 << 2,
+			ROTATE_V    = 1 << 3,
+			ON_PLACE    = 1 << 4,
+			ON_BREAK    = 1 << 5,
+			ON_INTERACT = 1 << 6,
+		};
+
+	public:
+		BlockProperties() = default;
+
+		/**
+		 * @brief Builds the table from every registered block.
+		 * @param blocks The registered blocks, by UID.
+		 */
+		void build(const Registry<std::size_t, BlockType>& blocks);
+
+		/**
+		 * @brief Gets the amount of block types in the table.
+		 * @return One past the highest UID in the table.
+		 */
+		std::size_t size() const { return m_categories.size(); }
+
+		BlockCategory getCategory(std::size_t uid) const
+		{
+			return uid < m_categories.size() ? m_categories[uid]
+			                                 : m_unknownCategory;
+		}
+
+		/**
+		 * @brief Checks if a block type has a set of flags.
+		 * @param uid The UID of the block type.
+		 * @param flags The flags to check, combined with |.
+		 * @return true if every flag is set.
+		 */
+		bool has(std::size_t uid, std::uint8_t flags) const
+		{
+			const std::uint8_t set =
+			    uid < m_flags.size() ? m_flags[uid] : m_unknownFlags;
+			return (set & flags) == flags;
+		}
+
+		bool isSolid(std::size_t uid) const { return has(uid, SOLID); }
+		bool isOpaque(std::size_t uid) const
+		{
+			return has(uid, SOLID | OPAQUE);
+		}
+
+		/// @brief Gets the flags of every block type, indexed by UID.
+		const std::vector<std::uint8_t>& getFlags() const { return m_flags; }
+
+	private:
+		std::vector<BlockCategory> m_categories;
+		std::vector<std::uint8_t>  m_flags;
+
+		// what unknown UIDs resolve to, like the registry. Until the table is
+		// built these are the defaults of the unknown block.
+		BlockCategory m_unknownCategory = BlockCategory::SOLID;
+		std::uint8_t  m_unknownFlags    = SOLID | OPAQUE;
+	};
+} // namespace phx::voxels
@@ -29,6 +29,7 @@
 #pragma once
 
 #include <Common/Voxels/Block.hpp>
+#include <Common/Voxels/BlockProperties.hpp>
 #include <Common/Registry.hpp>
 
 #include <string>
@@ -94,6 +95,10 @@ namespace phx::voxels
 			referrer.setUnknownReturnVal(referrer.get("core.unknown"));
 			blocks.setUnknownReturnVal(
 			    blocks.get(voxels::BlockType::UNKNOWN_BLOCK));
+
+			// chunks made before the mods finish loading still need to know
+			// air isn't solid.
+			freeze();
 		}
 
 		/**
@@ -106,9 +111,21 @@ namespace phx::voxels
 			return blocks.get(*referrer.get(id));
 		};
 
+		/**
+		 * @brief Builds the property tables once every block is registered.
+		 *
+		 * This should be called after mods have finished loading, blocks
+		 * registered after this aren't in the tables until it's called
+		 * again.
+		 */
+		void freeze() { properties.build(blocks); }
+
 		// referrer refers a string to int, which in turn is used to get the
 		// blocktype.
 		Registry<std::string, std::size_t> referrer;
 		Registry<std::size_t, BlockType>   blocks;
+
+		/// @brief The hot properties of every block, indexed by UID.
+		BlockProperties properties;
 	};
 } // namespace phx::voxels
@@ -0,0 +1,249 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <Common/CoreIntrinsics.hpp>
+#include <Common/Voxels/Block.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace phx::voxels
+{
+	/**
+	 * @brief Palette compressed storage for a fixed amount of blocks.
+	 *
+	 * Instead of storing a pointer for every single block, every distinct
+	 * block type in the storage is put into a small palette and each block
+	 * only stores an index into that palette. The indices are bit-packed
+	 * into 64 bit words, using the smallest power of two width that can
+	 * address every entry of the palette, so a chunk that is only made of
+	 * dirt and grass costs 1 bit per block rather than 64.
+	 *
+	 * The width grows as soon as a new block type would not fit in the
+	 * palette any more, and shrinks again once enough block types have
+	 * disappeared from the storage. Entries are never split across two words,
+	 * which keeps both reading and writing down to a shift and a mask.
+	 *
+	 * A storage where every block is the same type is uniform, it only keeps
+	 * that single type and no indices at all. It is only expanded to packed
+	 * indices once a different block is written, and collapses back as soon
+	 * as a single type is left.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * BlockStorage storage(4096, air);
+	 * storage.set(10, dirt);
+	 *
+	 * storage.get(10); // dirt
+	 * storage.get(11); // air
+	 * @endcode
+	 */
+	class BlockStorage
+	{
+	public:
+		using Palette = std::vector<BlockType*>;
+
+	public:
+		BlockStorage() = delete;
+
+		/**
+		 * @brief Creates a storage where every block is the same.
+		 * @param size The amount of blocks in the storage.
+		 * @param fill The block type every block starts as.
+		 */
+		BlockStorage(std::size_t size, BlockType* fill);
+
+		/**
+		 * @brief Gets the type of a block.
+		 * @param index The index of the block, must be smaller than size.
+		 * @return The type of the block.
+		 */
+		BlockType* get(std::size_t index) const
+		{
+			return m_palette[getPaletteIndex(index)];
+		}
+
+		/**
+		 * @brief Sets the type of a block.
+		 * @param index The index of the block, must be smaller than size.
+		 * @param type The new type of the block.
+		 */
+		void set(std::size_t index, BlockType* type) { set(index, 1, type); }
+
+		/**
+		 * @brief Sets the type of a consecutive run of blocks.
+		 * @param index The index of the first block in the run.
+		 * @param count The amount of blocks in the run.
+		 * @param type The new type of the blocks.
+		 *
+		 * @note This only looks the type up in the palette once, so prefer it
+		 * over calling set for every block when filling ranges (for example
+		 * while deserializing run-length encoded data).
+		 */
+		void set(std::size_t index, std::size_t count, BlockType* type);
+
+		/**
+		 * @brief Gets the index into the palette of a block.
+		 * @param index The index of the block, must be smaller than size.
+		 * @return The palette index of the block.
+		 *
+		 * @note Two blocks share a palette index if and only if they are of
+		 * the same type, so this can be used to compare blocks without
+		 * touching the types themselves.
+		 */
+		std::size_t getPaletteIndex(std::size_t index) const
+		{
+			if (isUniform())
+			{
+				return 0;
+			}
+
+			const std::uint64_t word = m_data[index >> m_wordShift];
+			const std::size_t   bit  = (index & m_indexMask) << m_bitsShift;
+
+			return static_cast<std::size_t>((word >> bit) & m_valueMask);
+		}
+
+		/**
+		 * @brief Sets every block to the same type, making the storage
+		 * uniform.
+		 * @param type The new type of every block.
+		 */
+		void fill(BlockType* type);
+
+		/**
+		 * @brief Checks whether every block is of the same type.
+		 * @return true if the storage holds a single type and no indices.
+		 */
+		bool isUniform() const { return m_data.empty(); }
+
+		/**
+		 * @brief Decodes every block into a flat list.
+		 * @param out Array of at least size pointers to write the types to.
+		 *
+		 * This works a whole word at a time, so it is considerably faster
+		 * than calling get for every block when every block is needed anyway.
+		 */
+		void unpack(BlockType** out) const;
+
+		/**
+		 * @brief Gets the palette of the storage.
+		 * @return The palette, can contain unused entries (nullptr).
+		 */
+		const Palette& getPalette() const { return m_palette; }
+
+		/**
+		 * @brief Gets the amount of block types currently in use.
+		 * @return The amount of palette entries that are used by a block.
+		 */
+		std::size_t getPaletteSize() const { return m_paletteUsed; }
+
+		/**
+		 * @brief Gets how many bits are used to store each block.
+		 * @return The width of a packed palette index, 0 if uniform.
+		 */
+		std::size_t getBitsPerBlock() const
+		{
+			return isUniform() ? 0 : std::size_t(1) << m_bitsShift;
+		}
+
+		/**
+		 * @brief Gets the amount of blocks in the storage.
+		 * @return The amount of blocks.
+		 */
+		std::size_t size() const { return m_size; }
+
+		/**
+		 * @brief Gets an estimate of the heap memory used by the storage.
+		 * @return The amount of bytes allocated for the storage.
+		 */
+		std::size_t getMemoryUsage() const;
+
+	private:
+		/**
+		 * @brief Finds or adds a palette entry for a block type.
+		 * @param type The block type to find.
+		 * @return The palette index of the block type.
+		 *
+		 * @note This can grow the storage, changing the width of the indices.
+		 */
+		std::size_t findOrAdd(BlockType* type);
+
+		/**
+		 * @brief Repacks every index with a new width.
+		 * @param bitsShift The log2 of the new width in bits.
+		 *
+		 * Unused palette entries are dropped and the indices are remapped to
+		 * the compacted palette.
+		 */
+		void repack(std::size_t bitsShift);
+
+		/**
+		 * @brief Updates the shifts and masks used for a width.
+		 * @param bitsShift The log2 of the width in bits.
+		 */
+		void setWidth(std::size_t bitsShift);
+
+		void write(std::size_t index, std::size_t paletteIndex)
+		{
+			std::uint64_t&    word = m_data[index >> m_wordShift];
+			const std::size_t bit  = (index & m_indexMask) << m_bitsShift;
+
+			word = (word & ~(m_valueMask << bit)) |
+			       (static_cast<std::uint64_t>(paletteIndex) << bit);
+		}
+
+	private:
+		/// @brief The smallest supported width, 1 bit per block.
+		static constexpr std::size_t MIN_BITS_SHIFT = 0;
+
+		/// @brief The biggest supported width, 16 bits per block.
+		static constexpr std::size_t MAX_BITS_SHIFT = 4;
+
+		std::size_t m_size;
+
+		Palette                    m_palette;
+		std::vector<std::uint32_t> m_references;
+		std::size_t                m_paletteUsed = 0;
+		std::size_t                m_lastIndex   = 0;
+
+		std::vector<std::uint64_t> m_data;
+
+		// log2 of the width of an index, in bits.
+		std::size_t   m_bitsShift = MIN_BITS_SHIFT;
+		// log2 of the amount of indices in a word.
+		std::size_t   m_wordShift = 0;
+		// mask for the position of an index inside its word.
+		std::size_t   m_indexMask = 0;
+		// mask for the value of a single index.
+		std::uint64_t m_valueMask = 0;
+	};
+} // namespace phx::voxels
@@ -31,15 +31,27 @@
 #include <Common/CoreIntrinsics.hpp>
 #include <Common/Math/Math.hpp>
 #include <Common/Voxels/Block.hpp>
+#include <Common/Voxels/BlockDictionary.hpp>
+#include <Common/Voxels/BlockMask.hpp>
 #include <Common/Voxels/BlockReferrer.hpp>
+#include <Common/Voxels/BlockStorage.hpp>
+#include <Common/Voxels/ChunkGeometry.hpp>
+#include <Common/Voxels/Coordinates.hpp>
 #include <Common/Registry.hpp>
 #include <Common/Metadata.hpp>
 
 #include <Common/Utility/Serializer.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
 #include <vector>
 
 namespace phx::voxels
 {
+	class Map;
+
 	/**
 	 * @brief Stores the index - english relations for block faces.
 	 */
@@ -53,12 +65,89 @@ namespace phx::voxels
 		BOTTOM = 5,
 	};
 
+	/**
+	 * @brief A box of blocks in a chunk, used to track what has changed.
+	 *
+	 * Both corners are inclusive and relative to the chunk. A default
+	 * constructed region is empty.
+	 */
+	struct DirtyRegion
+	{
+		math::vec3i min = {0, 0, 0};
+		math::vec3i max = {-1, -1, -1};
+
+		bool isEmpty() const { return max.x < min.x; }
+
+		/**
+		 * @brief Grows the region to contain a block.
+		 * @param x The x position of the block in the chunk.
+		 * @param y The y position of the block in the chunk.
+		 * @param z The z position of the block in the chunk.
+		 */
+		void add(int x, int y, int z)
+		{
+			add({{x, y, z}, {x, y, z}});
+		}
+
+		/**
+		 * @brief Grows the region to contain another region.
+		 * @param other The region to contain.
+		 */
+		void add(const DirtyRegion& other)
+		{
+			if (other.isEmpty())
+			{
+				return;
+			}
+
+			if (isEmpty())
+			{
+				*this = other;
+				return;
+			}
+
+			min = {std::min(min.x, other.min.x), std::min(min.y, other.min.y),
+			       std::min(min.z, other.min.z)};
+			max = {std::max(max.x, other.max.x), std::max(max.y, other.max.y),
+			       std::max(max.z, other.max.z)};
+		}
+	};
+
+	class ChunkSnapshot;
+
 	/**
 	 * @brief Represents a collection of blocks in a specific area.
 	 *
 	 * This class represents a 16x16x16 area of blocks, with its own
 	 * position in the world - obviously being a multiple of 16 in all
-	 * directions.
+	 * directions. The size can be changed when building the game, see
+	 * ChunkGeometry.
+	 *
+	 * Blocks are stored palette compressed (see BlockStorage), so a chunk
+	 * only made up of a handful of block types takes a fraction of the
+	 * memory a flat list of pointers would. Use getBlocks() if every block
+	 * is needed, it decodes the whole chunk in one go. Chunks made of a
+	 * single block type (all air, all stone) don't store any per block data
+	 * at all until a different block is placed.
+	 *
+	 * Alongside the blocks, every chunk keeps a bit per block saying whether
+	 * it is solid, and whether it is opaque (solid and a full cube). These
+	 * are kept up to date as blocks change, so questions like "is this
+	 * chunk empty" or "which faces can be seen" can be answered 64 blocks
+	 * at a time without looking at the block types. The bits come from the
+	 * property table of the referrer (see BlockProperties), so blocks have to
+	 * be registered and the referrer frozen before chunks use them.
+	 *
+	 * Every change to a chunk bumps its version and grows a dirty region for
+	 * each consumer of chunks (saving, networking, meshing). A consumer can
+	 * skip a chunk that hasn't changed since it last marked it clean, and
+	 * only redo the part that did change when it has.
+	 *
+	 * The blocks, masks and metadata can be shared with snapshots (see
+	 * ChunkSnapshot), letting other threads read a chunk while the game
+	 * keeps changing it. Taking a snapshot doesn't copy anything, the chunk
+	 * copies its blocks the next time it is changed while a snapshot of it
+	 * is still around.
 	 *
 	 * @paragraph Usage
 	 * @code
@@ -82,11 +171,139 @@ namespace phx::voxels
 	{
 	public:
 		using BlockList = std::vector<BlockType*>;
-		
+
+		/// @brief The metadata of blocks, sorted by block index.
+		using MetadataList = std::vector<std::pair<std::size_t, Metadata>>;
+
+		/// @brief The size of a chunk and the math for indexing into it.
+		using Geometry = ChunkConfig;
+
+		/// @brief How wide a chunk is (x axis).
+		static constexpr int CHUNK_WIDTH = Geometry::WIDTH;
+
+		/// @brief How tall a chunk is (y axis).
+		static constexpr int CHUNK_HEIGHT = Geometry::HEIGHT;
+
+		/// @brief How deep a chunk is (z axis).
+		static constexpr int CHUNK_DEPTH = Geometry::DEPTH;
+
+		/// @brief The amount of blocks in a chunk.
+		static constexpr int CHUNK_MAX_BLOCKS = Geometry::VOLUME;
+
+		/// @brief The version of the format written by save().
+		static constexpr std::uint8_t SAVE_VERSION = 2;
+
+		/// @brief A bit for every block in a chunk.
+		using Mask = BlockMask<CHUNK_WIDTH, CHUNK_HEIGHT, CHUNK_DEPTH>;
+
+		/// @brief The systems that keep track of changes to chunks.
+		enum Consumer : std::size_t
+		{
+			SAVER,
+			NETWORK,
+			MESHER,
+
+			CONSUMER_COUNT
+		};
+
+		/**
+		 * @brief The blocks of a chunk and everything worked out from them.
+		 *
+		 * A chunk shares this with its snapshots, it is never changed while
+		 * it is shared.
+		 */
+		struct Data
+		{
+			BlockStorage blocks;
+			Mask         solid;
+			Mask         opaque;
+			MetadataList metadata;
+
+			/**
+			 * @brief Creates blocks that are all the same type.
+			 * @param fill The type of every block.
+			 * @param properties The properties of the registered blocks.
+			 */
+			Data(BlockType* fill, const BlockProperties& properties);
+
+			/// @brief Finds the metadata of a block, nullptr if it has none.
+			const Metadata* findMetadata(std::size_t index) const;
+
+			/// @brief Rebuilds the solid and opaque masks from the blocks.
+			void rebuildMasks(const BlockProperties& properties);
+
+			/**
+			 * @brief Writes the blocks and their metadata.
+			 * @param keys Numbers the metadata keys, without one they're
+			 * written by name.
+			 */
+			void write(Serializer& ser, MetadataDictionary* keys) const;
+
+			/**
+			 * @brief Reads blocks and metadata written by write.
+			 * @param keys The dictionary they were written with, if any.
+			 * @return false if the data was cut short, the blocks are left
+			 * partially read.
+			 */
+			bool read(Reader& ser, BlockReferrer* referrer,
+			          const MetadataDictionary* keys);
+
+			/**
+			 * @brief Writes the blocks as a palette of saved IDs and a table
+			 * of runs, followed by the metadata.
+			 */
+			void save(Serializer& ser, BlockDictionary& dictionary,
+			          MetadataDictionary& keys) const;
+
+			/**
+			 * @brief Reads blocks and metadata written by save.
+			 * @return false if the data was cut short or is corrupt.
+			 */
+			bool load(Reader& ser, BlockReferrer* referrer,
+			          const BlockDictionary& dictionary,
+			          const MetadataDictionary& keys);
+
+		private:
+			///@brief Utility function for serialization
+			bool canRepeat(std::size_t i) const;
+		};
+
 	public:
 		Chunk() = delete;
 
+		/**
+		 * @brief Creates a chunk filled with air.
+		 * @param chunkPos The position of the chunk.
+		 * @param referrer The BlockReferrer used for this instance of the
+		 * game.
+		 */
 		Chunk(const math::vec3& chunkPos, BlockReferrer* referrer);
+
+		/**
+		 * @brief Creates a chunk filled with a single type of block.
+		 * @param chunkPos The position of the chunk.
+		 * @param referrer The BlockReferrer used for this instance of the
+		 * game.
+		 * @param fill The type of block to fill the chunk with.
+		 */
+		Chunk(const math::vec3& chunkPos, BlockReferrer* referrer,
+		      BlockType* fill);
+
+		/**
+		 * @brief Creates a chunk from a list of every block in it.
+		 * @param chunkPos The position of the chunk.
+		 * @param referrer The BlockReferrer used for this instance of the
+		 * game.
+		 * @param blocks The type of every block, in the order of
+		 * getVectorIndex. A list of any other length than CHUNK_MAX_BLOCKS
+		 * is ignored, leaving the chunk filled with air.
+		 *
+		 * Runs of the same block are stored in one go, so this is a lot
+		 * cheaper than setting blocks one by one for generated terrain.
+		 */
+		Chunk(const math::vec3& chunkPos, BlockReferrer* referrer,
+		      const BlockList& blocks);
+
 		~Chunk()                  = default;
 		Chunk(const Chunk& other) = default;
 		Chunk& operator=(const Chunk& other) = default;
@@ -99,26 +316,234 @@ namespace phx::voxels
 		 */
 		math::vec3 getChunkPos() const;
 
+		/**
+		 * @brief Gets the coordinates of the chunk, counted in chunks rather
+		 * than blocks.
+		 * @return The coordinates, what the Map keys the chunk by.
+		 */
+		math::vec3i getChunkCoords() const;
+
+		/**
+		 * @brief Gets the coordinates of the chunk a chunk position is the
+		 * origin of.
+		 * @param chunkPos The position of the first block of the chunk.
+		 * @return The coordinates of the chunk, counted in chunks.
+		 */
+		static math::vec3i toChunkCoords(const math::vec3& chunkPos);
+
+		/**
+		 * @brief Gets the position of the first block of a chunk.
+		 * @param coords The coordinates of the chunk, counted in chunks.
+		 * @return The position of the chunk, as getChunkPos returns it.
+		 */
+		static math::vec3 toChunkPos(const math::vec3i& coords);
+
+		/// @brief The sides of a chunk, for finding the chunks next to it.
+		enum Side : std::size_t
+		{
+			NEG_X,
+			POS_X,
+			NEG_Y,
+			POS_Y,
+			NEG_Z,
+			POS_Z,
+
+			SIDE_COUNT
+		};
+
+		/// @brief Gets the side facing the other way.
+		static constexpr Side getOpposite(Side side)
+		{
+			return static_cast<Side>(side ^ 1);
+		}
+
+		/// @brief Gets the coordinates of the chunk on a side, relative to
+		/// this one.
+		static math::vec3i getOffset(Side side);
+
+		/**
+		 * @brief Gets the chunk next to this one.
+		 * @param side The side the chunk is on.
+		 * @return The chunk, nullptr if it isn't loaded or this chunk isn't
+		 * in a Map.
+		 *
+		 * The Map links chunks as they're added and unlinks them as they're
+		 * unloaded, so this never points at a chunk that's gone. Like the
+		 * rest of the map it's only for the thread changing the map,
+		 * snapshots don't have neighbours.
+		 */
+		Chunk* getNeighbor(Side side) const
+		{
+			return m_neighbors.chunks[side];
+		}
+
 		/**
 		 * @brief Get a vector of pointers to all the blocks in the chunk.
-		 * @return std::vector<BlockType*>& Vector of pointers to all the
+		 * @return std::vector<BlockType*> Vector of pointers to all the
 		 * blocks in the chunk.
+		 *
+		 * @note This decodes the compressed storage into a new list, changes
+		 * to it are not reflected in the chunk - use setBlockAt for that.
+		 */
+		BlockList getBlocks() const;
+
+		/**
+		 * @brief Get the underlying storage of the blocks.
+		 * @return The palette compressed block storage.
+		 */
+		const BlockStorage& getStorage() const { return m_data->blocks; }
+
+		/**
+		 * @brief Checks whether every block in the chunk is the same type.
+		 * @return true if the chunk is stored as a single block type.
+		 */
+		bool isUniform() const { return m_data->blocks.isUniform(); }
+
+		/**
+		 * @brief Gets an estimate of the heap memory used by the chunk.
+		 * @return The amount of bytes allocated for the blocks, masks and
+		 * metadata of the chunk, whether or not a snapshot shares them.
+		 */
+		std::size_t getMemoryUsage() const
+		{
+			return sizeof(Data) + m_data->blocks.getMemoryUsage() +
+			       m_data->metadata.capacity() *
+			           sizeof(MetadataList::value_type);
+		}
+
+		/**
+		 * @brief Gets the mask of every solid block in the chunk.
+		 * @return A mask with a bit set for every SOLID block.
 		 */
-		BlockList& getBlocks();
+		const Mask& getSolidMask() const { return m_data->solid; }
+
+		/**
+		 * @brief Gets the mask of every opaque block in the chunk.
+		 * @return A mask with a bit set for every SOLID block that is opaque.
+		 */
+		const Mask& getOpaqueMask() const { return m_data->opaque; }
+
+		/**
+		 * @brief Checks if the block at an index is solid.
+		 * @param index flattened location of the block in the chunk.
+		 * @return true if the block is SOLID, false if not or out of bounds.
+		 */
+		bool isSolidAt(std::size_t index) const
+		{
+			return index < CHUNK_MAX_BLOCKS && m_data->solid.test(index);
+		}
+
+		/**
+		 * @brief Checks if the chunk has no solid blocks at all.
+		 * @return true if nothing in the chunk is solid.
+		 */
+		bool isEmpty() const { return m_data->solid.none(); }
+
+		/**
+		 * @brief Counts the solid blocks in the chunk.
+		 * @return The amount of SOLID blocks.
+		 */
+		std::size_t getSolidCount() const { return m_data->solid.count(); }
+
+		/**
+		 * @brief Gets every solid block with a visible face on one side.
+		 * @param axis The axis the face points along.
+		 * @param direction 1 for the face pointing in the positive direction,
+		 * -1 for the negative direction.
+		 * @return A mask of the solid blocks not covered by an opaque block
+		 * on that side. Faces on the edges of the chunk always count as
+		 * visible.
+		 */
+		Mask getVisibleFaces(Mask::Axis axis, int direction) const
+		{
+			return m_data->solid & ~m_data->opaque.neighbors(axis, direction);
+		}
+
+		/**
+		 * @brief Takes a read only copy of the chunk as it is right now.
+		 * @return A snapshot sharing the blocks of the chunk.
+		 *
+		 * This only bumps a reference count, the chunk pays for a copy if
+		 * it is changed while the snapshot is still alive. Snapshots must be
+		 * taken on the thread changing the chunk, but can be handed to and
+		 * read by any thread afterwards.
+		 */
+		ChunkSnapshot snapshot() const;
+
+		/**
+		 * @brief Gets the version of the chunk.
+		 * @return A number that increases every time the chunk changes.
+		 */
+		std::uint64_t getVersion() const { return m_version; }
+
+		/**
+		 * @brief Checks if the chunk changed since a consumer marked it clean.
+		 * @param consumer The system asking.
+		 * @return true if the chunk has changed.
+		 */
+		bool isDirty(Consumer consumer) const
+		{
+			return m_seenVersions[consumer] != m_version;
+		}
+
+		/**
+		 * @brief Gets what changed since a consumer marked the chunk clean.
+		 * @param consumer The system asking.
+		 * @return The box containing every changed block.
+		 */
+		const DirtyRegion& getDirtyRegion(Consumer consumer) const
+		{
+			return m_dirty[consumer];
+		}
+
+		/**
+		 * @brief Marks the chunk as up to date for a consumer.
+		 * @param consumer The system that has caught up with the chunk.
+		 * @return The region that had changed, so the caller can process it.
+		 */
+		DirtyRegion markClean(Consumer consumer);
+
+		/**
+		 * @brief Marks the chunk as up to date for a consumer, as of an
+		 * earlier version.
+		 * @param consumer The system that has caught up with the chunk.
+		 * @param version The version it caught up with, such as the version
+		 * of a snapshot it was working from.
+		 *
+		 * If the chunk has changed since that version it stays dirty, with
+		 * the whole dirty region, as the changes made since can't be told
+		 * apart from the ones before.
+		 */
+		void markClean(Consumer consumer, std::uint64_t version);
+
+		/**
+		 * @brief Marks part of the chunk as changed for every consumer.
+		 * @param region The blocks that changed.
+		 *
+		 * setBlockAt and setMetadataAt already do this, it's only needed for
+		 * changes made some other way.
+		 */
+		void markDirty(const DirtyRegion& region);
 
 		/**
 		 * @brief Gets the Block at the supplied position.
 		 * @param index flattened location of the block in the chunk.
 		 * @return Block The requested block.
+		 *
+		 * @note The metadata pointer is only valid until the chunk is next
+		 * changed.
 		 */
-		Block getBlockAt(std::size_t index);
+		Block getBlockAt(std::size_t index) const;
 
 		/**
 		 * @brief Gets the Block at the supplied position.
 		 * @param position Position of the block relative to the chunk.
 		 * @return Block The requested block.
+		 *
+		 * @note The metadata pointer is only valid until the chunk is next
+		 * changed.
 		 */
-		Block getBlockAt(const math::vec3& position);
+		Block getBlockAt(const math::vec3& position) const;
 
 		/**
 		 * @brief Sets the Block at the supplied position.
@@ -129,6 +554,38 @@ namespace phx::voxels
 		 */
 		void setBlockAt(const math::vec3& position, Block newBlock);
 
+		/**
+		 * @brief Sets the Block at the supplied position.
+		 * @param index flattened location of the block in the chunk.
+		 * @param newBlock The block that now exists at this location.
+		 *
+		 * @note The old block gets destroyed and any metadata will be lost.
+		 */
+		void setBlockAt(std::size_t index, Block newBlock);
+
+		/// @brief A block to place, by its index in the chunk.
+		using BlockEdit = std::pair<std::size_t, BlockType*>;
+
+		/**
+		 * @brief Sets many blocks in one go.
+		 * @param edits The index and new type of every block to set.
+		 *
+		 * Unlike setBlockAt, this doesn't run the onBreak/onPlace callbacks
+		 * of the blocks, and the chunk's version is only bumped once for the
+		 * whole batch. Metadata of replaced blocks is dropped.
+		 */
+		void setBlocks(const std::vector<BlockEdit>& edits);
+
+		/**
+		 * @brief Fills a box of blocks with a single block type.
+		 * @param region The box to fill, relative to the chunk.
+		 * @param type The type of block to fill it with.
+		 *
+		 * Like setBlocks, no callbacks are run. Rows of blocks are written
+		 * to the storage at once, filling the whole chunk makes it uniform.
+		 */
+		void fill(const DirtyRegion& region, BlockType* type);
+
 		/**
 		 * @brief Sets metadata for the Block at the supplied position.
 		 * @param position Position of the block relative to the chunk.
@@ -139,20 +596,14 @@ namespace phx::voxels
 		 * OR if the supplied position is out of bounds for the chunk.
 		 */
 		bool setMetadataAt(const phx::math::vec3& position,
-		                   const std::string& key, std::any* newData);
+		                   const std::string& key,
+		                   const Metadata::Value& newData);
 
-		/// @brief How wide a chunk is (x axis).
-		static constexpr int CHUNK_WIDTH = 16;
-
-		/// @brief How tall a chunk is (y axis).
-		static constexpr int CHUNK_HEIGHT = 16;
-
-		/// @brief How deep a chunk is (z axis).
-		static constexpr int CHUNK_DEPTH = 16;
-
-		/// @brief The amount of blocks in a chunk.
-		static constexpr int CHUNK_MAX_BLOCKS =
-		    CHUNK_WIDTH * CHUNK_HEIGHT * CHUNK_DEPTH;
+		/**
+		 * @brief Gets the metadata of every block that has any.
+		 * @return The metadata of each block, sorted by block index.
+		 */
+		const MetadataList& getMetadata() const { return m_data->metadata; }
 
 		/**
 		 * @brief Get the Index based coordinates in a chunk.
@@ -165,10 +616,11 @@ namespace phx::voxels
 		 * @param z The Z coordinates of the position.
 		 * @return std::size_t The flattened index position in the chunk.
 		 */
-		static std::size_t getVectorIndex(std::size_t x, std::size_t y,
-		                                  std::size_t z)
+		static constexpr std::size_t getVectorIndex(std::size_t x,
+		                                            std::size_t y,
+		                                            std::size_t z)
 		{
-			return x + CHUNK_WIDTH * (y + CHUNK_HEIGHT * z);
+			return Geometry::index(x, y, z);
 		}
 
 		/**
@@ -185,20 +637,233 @@ namespace phx::voxels
 			                      static_cast<std::size_t>(pos.z));
 		}
 
-		// serialize.
+		// serialize, with the names of metadata keys.
 		Serializer& operator>>(Serializer& ser) const override;
 
-		// deserialize.
-		Serializer& operator<<(Serializer& ser) override;
+		// deserialize, interning the metadata keys. Only for trusted data,
+		// chunks from the network are read with receive.
+		Reader& operator<<(Reader& ser) override;
+
+		/**
+		 * @brief Writes the chunk to send it over the network.
+		 * @param ser The serializer to write to.
+		 * @param keys The IDs of metadata keys on the connection, new keys
+		 * are added to it and have to reach the other side first.
+		 *
+		 * This is the format written by operator>>, with metadata keys
+		 * written as IDs rather than names.
+		 */
+		void send(Serializer& ser, MetadataDictionary& keys) const;
+
+		/**
+		 * @brief Reads a chunk written by send.
+		 * @param ser The reader to read from.
+		 * @param keys The IDs of metadata keys on the connection.
+		 * @return false if the data was cut short or is corrupt.
+		 */
+		bool receive(Reader& ser, const MetadataDictionary& keys);
+
+		/**
+		 * @brief Writes the chunk for saving to disk.
+		 * @param ser The serializer to write to, any encoding works but
+		 * Encoding::COMPACT makes for much smaller saves.
+		 * @param dictionary The saved IDs of the blocks, new blocks are
+		 * added to it.
+		 * @param keys The saved IDs of metadata keys, new keys are added to
+		 * it.
+		 *
+		 * Unlike the network format written by operator>>, blocks are
+		 * stored as numbers from the dictionary of the save and runs of the
+		 * same block are stored as a single entry. The format starts with a
+		 * version and the encoding, so the reader doesn't need to know them.
+		 */
+		void save(Serializer& ser, BlockDictionary& dictionary,
+		          MetadataDictionary& keys) const;
+
+		/**
+		 * @brief Reads a chunk written by save.
+		 * @param ser The reader to read from, its encoding is switched to
+		 * the one the chunk was saved with.
+		 * @param dictionary The saved IDs of the blocks.
+		 * @param keys The saved IDs of metadata keys.
+		 * @return false if the data was cut short or is corrupt.
+		 *
+		 * Saves written before the format had a version (with operator>>)
+		 * are read too.
+		 */
+		bool load(Reader& ser, const BlockDictionary& dictionary,
+		          const MetadataDictionary& keys);
 
 	private:
-		///@brief Utility function for serialization
-		bool canRepeat(std::size_t i) const;
+		/**
+		 * @brief Gets the blocks to change them, copying them first if a
+		 * snapshot still shares them.
+		 */
+		Data& edit();
+
+		/// @brief Reads the network format, see operator<< and receive.
+		bool read(Reader& ser, const MetadataDictionary* keys);
+
+		/// @brief Updates the solid and opaque bits of a single block.
+		void updateMasks(Data& data, std::size_t index,
+		                 const BlockType* type) const;
+
+		/// @brief Removes the metadata of every block in a box.
+		static void eraseMetadata(Data& data, const DirtyRegion& region);
+
+		// links chunks to their neighbours and keeps track of changes.
+		friend class Map;
+
+		/**
+		 * @brief The chunks next to a chunk.
+		 *
+		 * A copy of a chunk isn't in the map the original is in, so copies
+		 * start without neighbours and assigning to a chunk keeps its own.
+		 */
+		struct Neighbors
+		{
+			std::array<Chunk*, SIDE_COUNT> chunks {};
+
+			Neighbors() = default;
+			Neighbors(const Neighbors&) {}
+			Neighbors& operator=(const Neighbors&) { return *this; }
+		};
+
+		/**
+		 * @brief The map a chunk is in, told the first time the chunk
+		 * changes since the map last looked at it.
+		 *
+		 * Like neighbours, copies of a chunk aren't in the map.
+		 */
+		struct Owner
+		{
+			Map* map     = nullptr;
+			bool changed = false;
+
+			Owner() = default;
+			Owner(const Owner&) {}
+			Owner& operator=(const Owner&) { return *this; }
+		};
+
+	private:
+		math::vec3            m_pos;
+		std::shared_ptr<Data> m_data;
+		BlockReferrer*        m_referrer;
+		Neighbors             m_neighbors;
+		Owner                 m_owner;
+
+		// new chunks start out dirty for everything.
+		std::uint64_t                               m_version = 0;
+		std::array<std::uint64_t, CONSUMER_COUNT> m_seenVersions {};
+		std::array<DirtyRegion, CONSUMER_COUNT>   m_dirty;
+	};
+
+	/**
+	 * @brief A read only view of a chunk at one point in time.
+	 *
+	 * A snapshot shares the blocks of the chunk it was taken from, so it is
+	 * cheap to take and can be read on another thread (meshing, saving,
+	 * sending over the network) without any locking while the game carries
+	 * on changing the chunk. Changes made to the chunk after the snapshot was
+	 * taken are not seen by it.
+	 *
+	 * A snapshot can also be deserialized into, which reads the chunk into
+	 * new blocks without touching any live chunk.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * ChunkSnapshot snapshot = chunk->snapshot();
+	 * std::thread([snapshot]() {
+	 *     Serializer ser;
+	 *     ser << snapshot;
+	 * }).detach();
+	 * @endcode
+	 */
+	class ChunkSnapshot : public ISerializable
+	{
+	public:
+		/**
+		 * @brief Creates a snapshot of a chunk filled with air, to be
+		 * deserialized into.
+		 * @param referrer The BlockReferrer used for this instance of the
+		 * game.
+		 */
+		explicit ChunkSnapshot(BlockReferrer* referrer);
+
+		/**
+		 * @brief Creates a snapshot from the shared blocks of a chunk.
+		 * @param chunkPos The position of the chunk.
+		 * @param version The version of the chunk when it was taken.
+		 * @param data The blocks of the chunk.
+		 * @param referrer The BlockReferrer used for this instance of the
+		 * game.
+		 */
+		ChunkSnapshot(const math::vec3& chunkPos, std::uint64_t version,
+		              std::shared_ptr<const Chunk::Data> data,
+		              BlockReferrer*                     referrer);
+
+		math::vec3 getChunkPos() const { return m_pos; }
+		math::vec3i getChunkCoords() const
+		{
+			return Chunk::toChunkCoords(m_pos);
+		}
+
+		/**
+		 * @brief Gets the version of the chunk the snapshot was taken at.
+		 * @return The version, 0 for a deserialized snapshot.
+		 */
+		std::uint64_t getVersion() const { return m_version; }
+
+		const BlockStorage& getStorage() const { return m_data->blocks; }
+		bool isUniform() const { return m_data->blocks.isUniform(); }
+
+		const Chunk::Mask& getSolidMask() const { return m_data->solid; }
+		const Chunk::Mask& getOpaqueMask() const { return m_data->opaque; }
+		bool               isEmpty() const { return m_data->solid.none(); }
+
+		/// @brief See Chunk::getVisibleFaces.
+		Chunk::Mask getVisibleFaces(Chunk::Mask::Axis axis,
+		                            int               direction) const
+		{
+			return m_data->solid & ~m_data->opaque.neighbors(axis, direction);
+		}
+
+		/**
+		 * @brief Gets the type of a block.
+		 * @param index flattened location of the block in the chunk.
+		 * @return The type of the block, or the out of bounds block.
+		 */
+		BlockType* getBlockAt(std::size_t index) const;
+
+		/**
+		 * @brief Gets the metadata of a block.
+		 * @param index flattened location of the block in the chunk.
+		 * @return The metadata, nullptr if the block has none.
+		 */
+		const Metadata* getMetadataAt(std::size_t index) const
+		{
+			return m_data->findMetadata(index);
+		}
+
+		const Chunk::MetadataList& getMetadata() const
+		{
+			return m_data->metadata;
+		}
+
+		/// @brief See Chunk::save.
+		void save(Serializer& ser, BlockDictionary& dictionary,
+		          MetadataDictionary& keys) const;
+
+		// serialize.
+		Serializer& operator>>(Serializer& ser) const override;
+
+		// deserialize.
+		Reader& operator<<(Reader& ser) override;
 
 	private:
-		math::vec3                                m_pos;
-		BlockList                                 m_blocks;
-		std::unordered_map<std::size_t, Metadata> m_metadata;
-		BlockReferrer*                            m_referrer;
+		math::vec3                         m_pos;
+		std::uint64_t                      m_version = 0;
+		std::shared_ptr<const Chunk::Data> m_data;
+		BlockReferrer*                     m_referrer;
 	};
 } // namespace phx::voxels
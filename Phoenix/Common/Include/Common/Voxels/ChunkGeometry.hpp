@@ -0,0 +1,200 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <cstddef>
+
+// the size of a chunk can be changed at build time (see PHX_CHUNK_WIDTH and
+// friends in the CMake cache), these are the defaults.
+#ifndef PHX_CHUNK_WIDTH
+#	define PHX_CHUNK_WIDTH 16
+#endif
+
+#ifndef PHX_CHUNK_HEIGHT
+#	define PHX_CHUNK_HEIGHT 16
+#endif
+
+#ifndef PHX_CHUNK_DEPTH
+#	define PHX_CHUNK_DEPTH 16
+#endif
+
+namespace phx::voxels
+{
+	/**
+	 * @brief The size of a chunk and the math for indexing into one.
+	 *
+	 * Every size is a power of two known at compile time, so converting
+	 * between world, chunk and block coordinates is a shift or a mask rather
+	 * than a division. Coordinates are floored, so negative positions land
+	 * in the chunk below them rather than rounding towards zero.
+	 *
+	 * Blocks are laid out x first, then y, then z - a single z layer is a
+	 * contiguous range of blocks.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * using Geometry = ChunkGeometry<32, 256, 32>;
+	 *
+	 * Geometry::index(1, 2, 3);  // 1 + 32 * (2 + 256 * 3)
+	 * Geometry::toChunk<Geometry::X>(-1); // -1
+	 * Geometry::toLocal<Geometry::X>(-1); // 31
+	 * @endcode
+	 */
+	template <int WIDTH_, int HEIGHT_, int DEPTH_>
+	struct ChunkGeometry
+	{
+		static_assert(WIDTH_ > 0 && (WIDTH_ & (WIDTH_ - 1)) == 0,
+		              "The width of a chunk must be a power of two.");
+		static_assert(HEIGHT_ > 0 && (HEIGHT_ & (HEIGHT_ - 1)) == 0,
+		              "The height of a chunk must be a power of two.");
+		static_assert(DEPTH_ > 0 && (DEPTH_ & (DEPTH_ - 1)) == 0,
+		              "The depth of a chunk must be a power of two.");
+
+		/// @brief How wide a chunk is (x axis).
+		static constexpr int WIDTH = WIDTH_;
+
+		/// @brief How tall a chunk is (y axis).
+		static constexpr int HEIGHT = HEIGHT_;
+
+		/// @brief How deep a chunk is (z axis).
+		static constexpr int DEPTH = DEPTH_;
+
+		/// @brief The amount of blocks in a single z layer.
+		static constexpr int LAYER = WIDTH * HEIGHT;
+
+		/// @brief The amount of blocks in a chunk.
+		static constexpr int VOLUME = LAYER * DEPTH;
+
+		enum Axis
+		{
+			X,
+			Y,
+			Z
+		};
+
+		/**
+		 * @brief Gets log2 of a power of two.
+		 * @param value The power of two.
+		 * @return The amount of bits the value is shifted by.
+		 */
+		static constexpr int log2(int value)
+		{
+			return value > 1 ? 1 + log2(value >> 1) : 0;
+		}
+
+		static constexpr int WIDTH_SHIFT  = log2(WIDTH);
+		static constexpr int HEIGHT_SHIFT = log2(HEIGHT);
+		static constexpr int DEPTH_SHIFT  = log2(DEPTH);
+		static constexpr int LAYER_SHIFT  = WIDTH_SHIFT + HEIGHT_SHIFT;
+
+		/**
+		 * @brief Gets the flattened index of a block in a chunk.
+		 * @param x The x position of the block in the chunk.
+		 * @param y The y position of the block in the chunk.
+		 * @param z The z position of the block in the chunk.
+		 * @return The index of the block.
+		 */
+		static constexpr std::size_t index(std::size_t x, std::size_t y,
+		                                   std::size_t z)
+		{
+			return x | (y << WIDTH_SHIFT) | (z << LAYER_SHIFT);
+		}
+
+		/// @brief Gets the x position of a block from its index.
+		static constexpr int xOf(std::size_t index)
+		{
+			return static_cast<int>(index & (WIDTH - 1));
+		}
+
+		/// @brief Gets the y position of a block from its index.
+		static constexpr int yOf(std::size_t index)
+		{
+			return static_cast<int>((index >> WIDTH_SHIFT) & (HEIGHT - 1));
+		}
+
+		/// @brief Gets the z position of a block from its index.
+		static constexpr int zOf(std::size_t index)
+		{
+			return static_cast<int>(index >> LAYER_SHIFT);
+		}
+
+		/// @brief Gets the size of a chunk along an axis.
+		template <Axis AXIS>
+		static constexpr int size()
+		{
+			return AXIS == X ? WIDTH : (AXIS == Y ? HEIGHT : DEPTH);
+		}
+
+		/// @brief Gets the shift for the size of a chunk along an axis.
+		template <Axis AXIS>
+		static constexpr int shift()
+		{
+			return AXIS == X ? WIDTH_SHIFT
+			                 : (AXIS == Y ? HEIGHT_SHIFT : DEPTH_SHIFT);
+		}
+
+		/**
+		 * @brief Gets which chunk a block is in along an axis.
+		 * @param block The world coordinate of the block.
+		 * @return The coordinate of the chunk, counted in chunks.
+		 */
+		template <Axis AXIS>
+		static constexpr int toChunk(int block)
+		{
+			// an arithmetic shift, so this floors negative coordinates.
+			return block >> shift<AXIS>();
+		}
+
+		/**
+		 * @brief Gets where a block is inside its chunk along an axis.
+		 * @param block The world coordinate of the block.
+		 * @return The coordinate of the block relative to its chunk.
+		 */
+		template <Axis AXIS>
+		static constexpr int toLocal(int block)
+		{
+			return block & (size<AXIS>() - 1);
+		}
+
+		/**
+		 * @brief Gets the first block of the chunk a block is in.
+		 * @param block The world coordinate of the block.
+		 * @return The world coordinate of the chunk's origin.
+		 */
+		template <Axis AXIS>
+		static constexpr int toOrigin(int block)
+		{
+			return block & ~(size<AXIS>() - 1);
+		}
+	};
+
+	/// @brief The chunk size the game is built with.
+	using ChunkConfig =
+	    ChunkGeometry<PHX_CHUNK_WIDTH, PHX_CHUNK_HEIGHT, PHX_CHUNK_DEPTH>;
+} // namespace phx::voxels
@@ -0,0 +1,126 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <Common/Voxels/Block.hpp>
+#include <Common/Voxels/Chunk.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace phx::voxels
+{
+	/**
+	 * @brief The blocks of a chunk with a border of one block from the
+	 * chunks around it.
+	 *
+	 * Anything working on a block and the blocks touching it, such as
+	 * culling faces or spreading light, can read the whole neighbourhood
+	 * without checking which chunk a block is in. The blocks are copied out
+	 * of the chunks through their neighbour links (see Chunk::getNeighbor),
+	 * so it has to be built on the thread changing the map, but it can be
+	 * handed to any thread afterwards.
+	 *
+	 * Positions are relative to the chunk in the middle, from -1 to the size
+	 * of a chunk along each axis. Blocks of chunks that aren't loaded are
+	 * nullptr.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * const ChunkNeighborhood blocks(*chunk);
+	 *
+	 * blocks.getBlockAt(0, 0, 0);  // the first block of the chunk.
+	 * blocks.getBlockAt(-1, 0, 0); // the last block along x of the chunk
+	 *                              // on its NEG_X side.
+	 * @endcode
+	 */
+	class ChunkNeighborhood
+	{
+	public:
+		/// @brief How many blocks of the chunks around are included.
+		static constexpr int PADDING = 1;
+
+		/// @brief How wide the neighbourhood is (x axis).
+		static constexpr int WIDTH = Chunk::CHUNK_WIDTH + 2 * PADDING;
+
+		/// @brief How tall the neighbourhood is (y axis).
+		static constexpr int HEIGHT = Chunk::CHUNK_HEIGHT + 2 * PADDING;
+
+		/// @brief How deep the neighbourhood is (z axis).
+		static constexpr int DEPTH = Chunk::CHUNK_DEPTH + 2 * PADDING;
+
+		/// @brief The amount of blocks in the neighbourhood.
+		static constexpr int VOLUME = WIDTH * HEIGHT * DEPTH;
+
+		/**
+		 * @brief Copies the blocks of a chunk and the edges of the chunks
+		 * around it.
+		 * @param centre The chunk in the middle.
+		 *
+		 * Chunks on an edge or a corner are found through whichever chunk
+		 * next to them is loaded.
+		 */
+		explicit ChunkNeighborhood(const Chunk& centre);
+
+		/**
+		 * @brief Gets the index of a block in getBlocks().
+		 * @param x The x position, relative to the chunk in the middle.
+		 * @param y The y position, relative to the chunk in the middle.
+		 * @param z The z position, relative to the chunk in the middle.
+		 * @return The index of the block.
+		 */
+		static constexpr std::size_t getIndex(int x, int y, int z)
+		{
+			return static_cast<std::size_t>(
+			    (x + PADDING) +
+			    WIDTH * ((y + PADDING) + HEIGHT * (z + PADDING)));
+		}
+
+		/// @brief Gets the type of a block, nullptr if its chunk isn't
+		/// loaded.
+		BlockType* getBlockAt(int x, int y, int z) const
+		{
+			return m_blocks[getIndex(x, y, z)];
+		}
+
+		/// @brief Checks if a block is solid, false if its chunk isn't
+		/// loaded.
+		bool isSolidAt(int x, int y, int z) const
+		{
+			const BlockType* type = getBlockAt(x, y, z);
+			return type != nullptr && type->category == BlockCategory::SOLID;
+		}
+
+		/// @brief Gets every block, x first, then y, then z.
+		const std::vector<BlockType*>& getBlocks() const { return m_blocks; }
+
+	private:
+		std::vector<BlockType*> m_blocks;
+	};
+} // namespace phx::voxels
@@ -0,0 +1,214 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <Common/Math/Math.hpp>
+#include <Common/Voxels/ChunkGeometry.hpp>
+
+#include <cstddef>
+
+namespace phx::voxels
+{
+	/**
+	 * @brief Rounds a world coordinate down to the block it's in.
+	 * @param coordinate The coordinate, in blocks.
+	 * @return The coordinate of the block.
+	 *
+	 * Unlike a cast this rounds negative coordinates down as well, -0.5 is
+	 * in block -1 rather than block 0.
+	 */
+	constexpr int floorToBlock(float coordinate)
+	{
+		const int truncated = static_cast<int>(coordinate);
+		return truncated -
+		       static_cast<int>(coordinate < static_cast<float>(truncated));
+	}
+
+	/**
+	 * @brief The position of a block inside its chunk.
+	 *
+	 * Every axis is between 0 and the size of a chunk along it.
+	 */
+	struct LocalPos
+	{
+		int x = 0;
+		int y = 0;
+		int z = 0;
+
+		constexpr LocalPos() = default;
+		constexpr LocalPos(int x, int y, int z) : x(x), y(y), z(z) {}
+
+		/// @brief Gets the position of a block from its index in a chunk.
+		static constexpr LocalPos fromIndex(std::size_t index)
+		{
+			return {ChunkConfig::xOf(index), ChunkConfig::yOf(index),
+			        ChunkConfig::zOf(index)};
+		}
+
+		/// @brief Gets the index of the block in its chunk.
+		constexpr std::size_t getIndex() const
+		{
+			return ChunkConfig::index(static_cast<std::size_t>(x),
+			                          static_cast<std::size_t>(y),
+			                          static_cast<std::size_t>(z));
+		}
+
+		constexpr bool operator==(const LocalPos& other) const
+		{
+			return x == other.x && y == other.y && z == other.z;
+		}
+
+		constexpr bool operator!=(const LocalPos& other) const
+		{
+			return !(*this == other);
+		}
+	};
+
+	struct BlockPos;
+
+	/**
+	 * @brief The position of a chunk, counted in chunks.
+	 *
+	 * This is what the Map keys chunks by, so it converts to and from the
+	 * math::vec3i the map takes.
+	 */
+	struct ChunkPos
+	{
+		int x = 0;
+		int y = 0;
+		int z = 0;
+
+		constexpr ChunkPos() = default;
+		constexpr ChunkPos(int x, int y, int z) : x(x), y(y), z(z) {}
+		constexpr ChunkPos(const math::vec3i& coords)
+		    : x(coords.x), y(coords.y), z(coords.z)
+		{
+		}
+
+		constexpr operator math::vec3i() const { return {x, y, z}; }
+
+		/// @brief Gets the first block of the chunk.
+		constexpr BlockPos getOrigin() const;
+
+		constexpr bool operator==(const ChunkPos& other) const
+		{
+			return x == other.x && y == other.y && z == other.z;
+		}
+
+		constexpr bool operator!=(const ChunkPos& other) const
+		{
+			return !(*this == other);
+		}
+	};
+
+	/**
+	 * @brief The position of a block in the world.
+	 *
+	 * Splitting a position into its chunk and the position inside it is an
+	 * arithmetic shift and a mask, so unlike dividing floats it's cheap and
+	 * floors negative positions the right way.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * const BlockPos block = BlockPos::fromWorld({-0.5f, 17.f, 3.f});
+	 *
+	 * block.getChunk(); // (-1, 1, 0) with 16 wide chunks
+	 * block.getLocal(); // (15, 1, 3)
+	 * @endcode
+	 */
+	struct BlockPos
+	{
+		int x = 0;
+		int y = 0;
+		int z = 0;
+
+		constexpr BlockPos() = default;
+		constexpr BlockPos(int x, int y, int z) : x(x), y(y), z(z) {}
+
+		/// @brief Gets the position of a block from its chunk and where it
+		/// is in it.
+		constexpr BlockPos(const ChunkPos& chunk, const LocalPos& local)
+		    : x(chunk.x * ChunkConfig::WIDTH + local.x),
+		      y(chunk.y * ChunkConfig::HEIGHT + local.y),
+		      z(chunk.z * ChunkConfig::DEPTH + local.z)
+		{
+		}
+
+		/// @brief Gets the block a position in the world is in.
+		static constexpr BlockPos fromWorld(const math::vec3& position)
+		{
+			return {floorToBlock(position.x), floorToBlock(position.y),
+			        floorToBlock(position.z)};
+		}
+
+		/// @brief Gets the chunk the block is in.
+		constexpr ChunkPos getChunk() const
+		{
+			return {ChunkConfig::toChunk<ChunkConfig::X>(x),
+			        ChunkConfig::toChunk<ChunkConfig::Y>(y),
+			        ChunkConfig::toChunk<ChunkConfig::Z>(z)};
+		}
+
+		/// @brief Gets where the block is inside its chunk.
+		constexpr LocalPos getLocal() const
+		{
+			return {ChunkConfig::toLocal<ChunkConfig::X>(x),
+			        ChunkConfig::toLocal<ChunkConfig::Y>(y),
+			        ChunkConfig::toLocal<ChunkConfig::Z>(z)};
+		}
+
+		/// @brief Gets the position of a block relative to this one.
+		constexpr BlockPos offset(int dx, int dy, int dz) const
+		{
+			return {x + dx, y + dy, z + dz};
+		}
+
+		/// @brief Gets the corner of the block as a world position.
+		math::vec3 toWorld() const
+		{
+			return {static_cast<float>(x), static_cast<float>(y),
+			        static_cast<float>(z)};
+		}
+
+		constexpr bool operator==(const BlockPos& other) const
+		{
+			return x == other.x && y == other.y && z == other.z;
+		}
+
+		constexpr bool operator!=(const BlockPos& other) const
+		{
+			return !(*this == other);
+		}
+	};
+
+	constexpr BlockPos ChunkPos::getOrigin() const
+	{
+		return {*this, LocalPos {}};
+	}
+} // namespace phx::voxels
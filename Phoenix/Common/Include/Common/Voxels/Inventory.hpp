@@ -101,7 +101,7 @@ namespace phx::voxels
 		 * OR if the supplied slot is out of bounds for the inventory.
 		 */
 		bool setMetadataAt(std::size_t slot, const std::string& key,
-		                   std::any* newData);
+		                   const Metadata::Value& newData);
 
 		const std::vector<ItemType*>& getItems() const { return m_slots; };
 		std::size_t                   getSize() const { return m_size; };
@@ -110,7 +110,7 @@ namespace phx::voxels
 		Serializer& operator>>(Serializer& ser) const override;
 
 		// deserialize.
-		Serializer& operator<<(Serializer& ser) override;
+		Reader& operator<<(Reader& ser) override;
 
 	private:
 		std::size_t              m_size;
@@ -30,12 +30,29 @@
 
 #include <Common/Math/Math.hpp>
 #include <Common/Utility/BlockingQueue.hpp>
+#include <Common/Utility/Codec.hpp>
+#include <Common/Utility/FlatMap.hpp>
 #include <Common/Voxels/BlockReferrer.hpp>
 #include <Common/Voxels/Chunk.hpp>
+#include <Common/Voxels/Coordinates.hpp>
+#include <Common/Voxels/RegionFile.hpp>
+#include <Common/Voxels/TerrainGenerator.hpp>
 
+#include <array>
+#include <chrono>
+#include <condition_variable>
 #include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <filesystem>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
 #include <string_view>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 
@@ -66,69 +83,716 @@ namespace phx::voxels
 		virtual void onMapEvent(const MapEvent& mapEvent) = 0;
 	};
 
+	/**
+	 * @brief The chunks of a world, loaded from a save or received from a
+	 * server.
+	 *
+	 * Chunks are found by their coordinates counted in chunks (see
+	 * Chunk::getChunkCoords), blocks by their position in the world.
+	 *
+	 * A map that's saved to disk can load chunks in the background with
+	 * request(), rather than stopping the thread calling getChunk while it
+	 * reads or generates them. Saves are read by a couple of workers, and
+	 * chunks that were never saved are passed on to the workers generating
+	 * new ones. Finished chunks are only added to the map by update(), so
+	 * everything else about a map stays on one thread.
+	 *
+	 * Changes aren't written to disk as they're made. update() hands
+	 * snapshots of the changed chunks to a flusher thread every so often (see
+	 * FlushPolicy), so a chunk edited many times between flushes is only
+	 * written once, and never on the thread editing it.
+	 *
+	 * Loaded chunks are linked to the loaded chunks next to them (see
+	 * Chunk::getNeighbor), so code looking across the edge of a chunk
+	 * doesn't need to go back through the map.
+	 *
+	 * Chunks stay loaded while something holds on to them with acquire(),
+	 * such as the view of a player. Once the chunks take up more memory than
+	 * the budget, update() unloads the ones nothing holds on to, least
+	 * recently used first, writing them first if they've changed.
+	 */
 	class Map
 	{
 	public:
+		/// @brief Called with a requested chunk once it's in the map.
+		using ChunkCallback = std::function<void(Chunk*)>;
+
+		/// @brief The amount of workers reading saves.
+		static constexpr std::size_t LOAD_WORKERS = 2;
+
+		/// @brief When changed chunks are written to disk by update().
+		struct FlushPolicy
+		{
+			/// @brief The longest a change waits before it's written.
+			std::chrono::milliseconds interval {5000};
+
+			/// @brief Changed chunks are written sooner once there are this
+			/// many of them.
+			std::size_t maxDirty = 64;
+		};
+
+		/// @brief The memory chunks can take up before unused ones are
+		/// unloaded.
+		static constexpr std::size_t DEFAULT_MEMORY_BUDGET = 256 * 1024 * 1024;
+
+		/// @brief How many chunks are loaded, for keeping an eye on it.
+		struct ResidencyStats
+		{
+			/// @brief The amount of chunks loaded.
+			std::size_t resident = 0;
+
+			/// @brief The amount of loaded chunks something holds on to.
+			std::size_t referenced = 0;
+
+			/// @brief The memory the loaded chunks take up, as of the last
+			/// update().
+			std::size_t bytes = 0;
+
+			/// @brief The amount of chunks unloaded to stay in the budget
+			/// since the map was opened.
+			std::uint64_t evicted = 0;
+		};
+
+		/// @brief What the flusher has been doing, for keeping an eye on it.
+		struct FlushStats
+		{
+			/// @brief The amount of chunks written since the map was opened.
+			std::uint64_t written = 0;
+
+			/// @brief The amount of bytes written, after compression.
+			std::uint64_t bytes = 0;
+
+			/// @brief The amount of writes that failed, those chunks are
+			/// tried again with the next flush.
+			std::uint64_t failed = 0;
+
+			/// @brief The amount of chunks waiting to be written.
+			std::size_t backlog = 0;
+
+			/// @brief The amount of loaded chunks with changes that haven't
+			/// been handed to the flusher yet.
+			std::size_t dirty = 0;
+		};
+
+		/**
+		 * @brief Creates a map that's saved to disk.
+		 * @param savePath The directory of the save.
+		 * @param name The name of the map, its chunks are saved in region
+		 * files in a directory of that name.
+		 * @param referrer The blocks registered in this session.
+		 * @param dictionary The saved IDs of blocks, owned by the save.
+		 * Without one chunks are saved with string IDs, which is a lot
+		 * slower to load.
+		 * @param metadataKeys The saved IDs of metadata keys, owned by the
+		 * save. Needed whenever dictionary is given.
+		 */
 		Map(std::filesystem::path* savePath,
 		    const std::string& name,
-		    voxels::BlockReferrer* referrer);
+		    voxels::BlockReferrer* referrer,
+		    BlockDictionary* dictionary = nullptr,
+		    MetadataDictionary* metadataKeys = nullptr);
+
+		/**
+		 * @brief Creates a map that gets its chunks from the server.
+		 * @param queue The chunks received, see updateChunkQueue.
+		 * @param referrer The blocks registered in this session.
+		 * @param metadataKeys The IDs of metadata keys on the connection.
+		 */
 		Map(BlockingQueue<std::pair<math::vec3, std::vector<std::byte>>>* queue,
-		    voxels::BlockReferrer* referrer);
+		    voxels::BlockReferrer* referrer,
+		    const MetadataDictionary* metadataKeys);
+
+		/// @brief Writes every changed chunk, then stops the workers,
+		/// dropping any requests left.
+		~Map();
+
+		// the workers point back at the map.
+		Map(const Map&) = delete;
+		Map& operator=(const Map&) = delete;
+
+		/**
+		 * @brief Gets a chunk, loading or generating it if it isn't loaded.
+		 * @param coords The coordinates of the chunk.
+		 * @return The chunk, nullptr if the map is networked and the chunk
+		 * hasn't been received.
+		 */
+		Chunk* getChunk(const math::vec3i& coords);
+
+		/**
+		 * @brief Starts reading the saves of chunks that are about to be
+		 * needed.
+		 * @param chunks The coordinates of the chunks.
+		 *
+		 * This doesn't load anything, it asks the OS to read the saves
+		 * into memory in the background so getChunk doesn't have to wait
+		 * on the disk for each of them in turn. Chunks that are already
+		 * loaded or were never saved are skipped.
+		 */
+		void prefetch(const std::vector<math::vec3i>& chunks);
+
+		/**
+		 * @brief Loads or generates a chunk in the background.
+		 * @param coords The coordinates of the chunk.
+		 * @param priority Lower priorities are loaded first, such as the
+		 * distance to the player that needs the chunk.
+		 * @param callback Called from update() once the chunk is in the map,
+		 * or straight away if it already is.
+		 *
+		 * Requesting a chunk that's already on its way doesn't load it
+		 * twice, every callback is called once it's done. Requesting it
+		 * again with a lower priority moves it up the queue.
+		 *
+		 * Networked maps can only hand out chunks that have already been
+		 * received, the callback isn't called for the others.
+		 */
+		void request(const math::vec3i& coords, float priority,
+		             ChunkCallback callback);
+
+		/**
+		 * @brief Adds chunks the workers have finished or the server has
+		 * sent to the map, and hands changed chunks to the flusher if the
+		 * FlushPolicy says so.
+		 * @param budget The most chunks to add, so a burst of requests is
+		 * spread over a few ticks.
+		 * @return The amount of chunks added.
+		 */
+		std::size_t update(std::size_t budget);
+
+		/**
+		 * @brief Keeps a chunk loaded until it's released.
+		 * @param coords The coordinates of the chunk, it doesn't need to be
+		 * loaded yet.
+		 *
+		 * Every acquire needs a matching release, a chunk is kept loaded as
+		 * long as anything holds on to it.
+		 */
+		void acquire(const math::vec3i& coords);
+
+		/**
+		 * @brief Lets a chunk be unloaded again.
+		 * @param coords The coordinates of the chunk.
+		 */
+		void release(const math::vec3i& coords);
 
-		Chunk* getChunk(const math::vec3& pos);
+		/**
+		 * @brief Sets how much memory chunks can take up before unused ones
+		 * are unloaded.
+		 * @param bytes The budget, DEFAULT_MEMORY_BUDGET otherwise.
+		 */
+		void setMemoryBudget(std::size_t bytes) { m_memoryBudget = bytes; }
+
+		/// @brief Gets how many chunks are loaded.
+		ResidencyStats getResidencyStats() const;
+
+		/**
+		 * @brief Removes a chunk from the map, writing it first if it has
+		 * changed.
+		 * @param coords The coordinates of the chunk.
+		 *
+		 * Pointers to the chunk are no longer valid afterwards.
+		 */
+		void unloadChunk(const math::vec3i& coords);
+
+		/// @brief The amount of requested chunks that aren't in the map yet.
+		std::size_t getPendingCount() const { return m_callbacks.size(); }
+
+		/**
+		 * @brief Splits a position in the world into the origin of its chunk
+		 * and its position in the chunk.
+		 * @param position The position, it's floored to the block it's in.
+		 * @return The origin of the chunk and the position in it.
+		 */
 		static std::pair<math::vec3, math::vec3> getBlockPos(
 		    math::vec3 position);
+
+		/**
+		 * @brief Gets the type of a block.
+		 * @param position The position of the block in the world, floored
+		 * to the block it's in.
+		 * @return The type, OUT_OF_BOUNDS_BLOCK if the chunk isn't loaded.
+		 */
 		BlockType* getBlockAt(math::vec3 position);
-		void       setBlockAt(math::vec3 pos, const Block& block);
-		void       save(const math::vec3& pos);
+
+		/// @brief Gets the type of a block, without converting from floats.
+		BlockType* getBlockAt(const BlockPos& position);
+
+		/**
+		 * @brief Checks if the block at a position is solid.
+		 * @param position The position of the block in the world.
+		 * @return true if the block is SOLID.
+		 *
+		 * This only reads the solid mask of the chunk, so it is cheaper than
+		 * looking at the category of getBlockAt for probes like raycasts.
+		 */
+		bool isSolidAt(math::vec3 position);
+
+		/// @brief Checks if a block is solid, without converting from floats.
+		bool isSolidAt(const BlockPos& position);
+
+		void setBlockAt(math::vec3 pos, const Block& block);
+
+		/// @brief Sets a block, without converting from floats.
+		void setBlockAt(const BlockPos& position, const Block& block);
+
+		/**
+		 * @brief A cursor for reading and writing many blocks close to each
+		 * other.
+		 *
+		 * The accessor keeps hold of the chunk it's in and the chunks around
+		 * it, so looking at the next block along a ray or the neighbours of
+		 * a block doesn't look the chunk up in the map again. The chunk is
+		 * only looked up once the position moves into a chunk it hasn't
+		 * seen yet, and not at all if nothing is read there.
+		 *
+		 * Chunks unloaded from the map are forgotten about by the accessor,
+		 * so it can be kept around, but it mustn't outlive the map.
+		 *
+		 * @paragraph Usage
+		 * @code
+		 * Map::Accessor accessor(map, BlockPos::fromWorld(position));
+		 * while (!accessor.isSolid())
+		 * {
+		 *     accessor.offset(0, -1, 0);
+		 * }
+		 * @endcode
+		 */
+		class Accessor
+		{
+		public:
+			explicit Accessor(Map* map, const BlockPos& position = {});
+
+			/// @brief Moves the accessor to a block.
+			void moveTo(const BlockPos& position)
+			{
+				if (position.getChunk() != m_position.getChunk())
+				{
+					m_chunk = nullptr;
+				}
+
+				m_position = position;
+			}
+
+			/// @brief Moves the accessor relative to where it is.
+			Accessor& offset(int dx, int dy, int dz)
+			{
+				moveTo(m_position.offset(dx, dy, dz));
+				return *this;
+			}
+
+			/// @brief Gets the block the accessor is at.
+			const BlockPos& getPosition() const { return m_position; }
+
+			/**
+			 * @brief Gets the chunk the accessor is in, loading or
+			 * generating it like Map::getChunk.
+			 * @return The chunk, nullptr if the map is networked and the
+			 * chunk hasn't been received.
+			 */
+			Chunk* getChunk()
+			{
+				if (m_chunk == nullptr || m_unloads != m_map->m_unloads)
+				{
+					m_chunk = lookup();
+				}
+
+				return m_chunk;
+			}
+
+			/// @brief Gets the type of the block, like Map::getBlockAt.
+			BlockType* getBlock();
+
+			/// @brief Checks if the block is solid, like Map::isSolidAt.
+			bool isSolid();
+
+			/// @brief Sets the block, like Map::setBlockAt.
+			void setBlock(const Block& block);
+
+		private:
+			/// @brief Finds the chunk the accessor is in, in the chunks
+			/// around the last one or in the map.
+			Chunk* lookup();
+
+			// the chunks around m_centre, x first. A chunk isn't looked up
+			// until it's needed, those that haven't been are nullptr.
+			static constexpr int CACHE_WIDTH = 3;
+			std::array<Chunk*, CACHE_WIDTH * CACHE_WIDTH * CACHE_WIDTH>
+			    m_cache {};
+
+			Map*          m_map;
+			BlockPos      m_position;
+			ChunkPos      m_centre;
+			Chunk*        m_chunk   = nullptr;
+			std::uint64_t m_unloads = 0;
+		};
+
+		/// @brief A block to place, by its position in the world.
+		struct BlockEdit
+		{
+			math::vec3 position;
+			BlockType* type;
+		};
+
+		/**
+		 * @brief Sets many blocks at once.
+		 * @param edits The position and type of every block to set.
+		 *
+		 * Edits are grouped by chunk and each chunk is changed in one go,
+		 * with a single CHUNK_UPDATE event per chunk rather than three events
+		 * per block. Block callbacks are not run and nothing is written to
+		 * disk, the changed chunks are saved by the next flush().
+		 */
+		void applyBatch(const std::vector<BlockEdit>& edits);
+
+		/**
+		 * @brief Fills a box of blocks with a single block type.
+		 * @param from One corner of the box.
+		 * @param to The opposite corner of the box, inclusive.
+		 * @param type The type of block to fill the box with.
+		 *
+		 * This behaves like applyBatch, but writes whole rows of blocks at a
+		 * time.
+		 */
+		void fill(math::vec3 from, math::vec3 to, BlockType* type);
+
+		/**
+		 * @brief Sets the blocks in a box from a function.
+		 * @param from One corner of the box.
+		 * @param to The opposite corner of the box, inclusive.
+		 * @param func Called with the world position of every block in the
+		 * box, returns the block to place there or nullptr to leave it.
+		 *
+		 * This behaves like applyBatch.
+		 */
+		void editRegion(math::vec3 from, math::vec3 to,
+		                const std::function<BlockType*(const math::vec3&)>& func);
+
+		/**
+		 * @brief Queues a chunk to be written to its region if it has
+		 * changed.
+		 * @param coords The coordinates of the chunk.
+		 *
+		 * This doesn't wait for the write, the chunk is marked clean by
+		 * update() once it's done.
+		 */
+		void save(const math::vec3i& coords);
+
+		/**
+		 * @brief Writes every chunk that has changed since it was last saved,
+		 * waiting until they're all on disk.
+		 * @return The amount of chunks written.
+		 */
+		std::size_t flush();
+
+		/**
+		 * @brief Sets when update() writes changed chunks.
+		 * @param policy The policy, FlushPolicy's defaults otherwise.
+		 */
+		void setFlushPolicy(const FlushPolicy& policy)
+		{
+			m_flushPolicy = policy;
+		}
+
+		/// @brief Gets what the flusher has been doing.
+		FlushStats getFlushStats();
+
+		/**
+		 * @brief Sets how chunks are compressed when they're saved.
+		 * @param options The compression to use, codec::DISK by default.
+		 *
+		 * Saves say how they were compressed, changing this doesn't stop
+		 * older saves from loading. Saves compressed with a dictionary need
+		 * the same dictionary to be set to load. The workers read this
+		 * without locking, it should be set before any chunk is requested.
+		 */
+		void setCompression(const codec::Options& options)
+		{
+			m_compression = options;
+		}
+
+		/**
+		 * @brief Sets what generates chunks that were never saved.
+		 * @param generator The generator, a flat world of grass below 0 and
+		 * air above if there isn't one. It should be frozen, so its biomes
+		 * and stages can't change while the workers use them.
+		 *
+		 * The workers generate chunks without locking, so this should be
+		 * set before any chunk is requested.
+		 */
+		void setGenerator(std::shared_ptr<const TerrainGenerator> generator)
+		{
+			m_generator = std::move(generator);
+		}
+
+		/**
+		 * @brief Gets every loaded chunk that has changed for a consumer.
+		 * @param consumer The system asking, it should mark each chunk clean
+		 * once it has dealt with it.
+		 * @return The chunks that changed since the consumer last saw them.
+		 */
+		std::vector<Chunk*> getDirtyChunks(Chunk::Consumer consumer);
 
 		void registerEventSubscriber(MapEventSubscriber* subscriber);
 
 	private:
+		/// @brief A hash map keyed by the coordinates of chunks.
+		template <typename Value>
+		using ChunkTable = FlatMap<math::vec3i, Value, math::MortonHasher,
+		                           math::Vector3KeyComparator>;
+
 		void dispatchToSubscriber(const MapEvent& mapEvent) const;
 
+		/// @brief Sets a block in a chunk and tells everyone.
+		void setBlockIn(Chunk* chunk, const LocalPos& position,
+		                const Block& block);
+
+		/**
+		 * @brief Calls a function for every chunk a box of blocks touches.
+		 * @param from One corner of the box.
+		 * @param to The opposite corner of the box, inclusive.
+		 * @param func Called with the position of each chunk and the part of
+		 * the box inside it, relative to the chunk.
+		 */
+		static void forEachChunkIn(
+		    math::vec3 from, math::vec3 to,
+		    const std::function<void(const math::vec3&, const DirtyRegion&)>&
+		        func);
+
+		/// @brief Updates a chunk with a batch of edits and tells everyone.
+		void applyToChunk(const math::vec3i&                   coords,
+		                  const std::vector<Chunk::BlockEdit>& edits);
+
 		/**
 		 * @brief Update the loaded chunks from the queue of incoming chunks.
+		 *
+		 * Chunks that are already loaded are replaced by what was received,
+		 * and a CHUNK_UPDATE event is sent for them.
 		 */
 		void updateChunkQueue();
 
 		/**
 		 * @brief Load a chunk from the save files.
 		 *
-		 * @param chunkPos The coordinates of the chunk.
-		 * @return true if chunk was loaded from save, otherwise false.
+		 * This doesn't touch the loaded chunks, so it can be called from the
+		 * workers.
+		 *
+		 * @param coords The coordinates of the chunk.
+		 * @return The chunk, nothing if it was never saved or is damaged.
+		 */
+		std::optional<Chunk> loadChunk(const math::vec3i& coords);
+
+		/**
+		 * @brief Create a new chunk.
+		 *
+		 * This doesn't touch the loaded chunks, so it can be called from the
+		 * workers.
+		 *
+		 * @param coords The coordinates of the chunk.
+		 */
+		Chunk generateChunk(const math::vec3i& coords) const;
+
+		/// @brief A chunk waiting for a worker.
+		struct Request
+		{
+			math::vec3i   position;
+			float         priority;
+			std::uint64_t order;
+
+			/// @brief Orders the queue so the lowest priority comes first,
+			/// then the oldest request.
+			bool operator<(const Request& other) const
+			{
+				return priority != other.priority ? priority > other.priority
+				                                  : order > other.order;
+			}
+		};
+
+		/// @brief A chunk a worker is done with.
+		struct Finished
+		{
+			math::vec3i position;
+			Chunk       chunk;
+		};
+
+		/// @brief Starts the workers, if they haven't been already.
+		void startWorkers();
+
+		/// @brief Reads saves, passing on chunks that were never saved.
+		void runLoadWorker();
+
+		/// @brief Generates chunks that were never saved.
+		void runGenerateWorker();
+
+		/**
+		 * @brief Hands a snapshot of a chunk to the flusher, unless one from
+		 * the same version already has been.
+		 * @return true if a snapshot was queued.
+		 */
+		bool queueSave(const Chunk& chunk);
+
+		/// @brief Marks the chunks the flusher has written as clean.
+		void collectSaved();
+
+		/// @brief Waits until the flusher has written everything queued.
+		void waitForFlusher();
+
+		/// @brief Gets the changed chunks not already queued to be written.
+		std::vector<Chunk*> getUnsavedChunks();
+
+		// chunks tell the map when they change.
+		friend class Chunk;
+
+		/// @brief Notes that a chunk changed, it's looked at later by
+		/// collectChanges.
+		void onChanged(const Chunk& chunk);
+
+		/// @brief Measures the chunks that changed since the last time and
+		/// notes that they need writing.
+		void collectChanges();
+
+		/// @brief Keeps track of a chunk that was just added to the map.
+		void track(const math::vec3i& coords);
+
+		/// @brief Links a chunk that was just added to the chunks next to
+		/// it, and them to it.
+		void link(const math::vec3i& coords);
+
+		/// @brief Unlinks a chunk from the chunks next to it before it's
+		/// unloaded.
+		void unlink(Chunk& chunk);
+
+		/// @brief Unloads unused chunks until the map is within its budget.
+		void evict();
+
+		/// @brief Writes snapshots to disk, in the order they're queued.
+		void runFlusher();
+
+		/**
+		 * @brief Writes a snapshot to its region.
+		 * @return The amount of bytes written, 0 if the write failed.
 		 */
-		bool loadChunk(const phx::math::vec3& chunkPos);
+		std::size_t write(const ChunkSnapshot& snapshot);
 
 		/**
-		 * @brief Create a new chunk and write a save file for it.
+		 * @brief Gets the region a chunk is saved in, opening it if needed.
 		 *
-		 * @param chunkPos The coordinates of the chunk.
+		 * @param coords The coordinates of the chunk.
+		 * @param index Set to the index of the chunk in the region.
+		 * @return The region, it might not exist on disk yet.
 		 */
-		void generateChunk(const phx::math::vec3& chunkPos);
+		RegionFile& getRegion(const math::vec3i& coords, std::size_t& index);
 
 		/**
-		 * @brief Get the save filepath for a chunk position.
+		 * @brief Moves chunks saved one per file into their regions.
 		 *
-		 * @param chunkPos The integer coordinates of the chunk.
-		 * @return Relative path to the save directory.
+		 * Each file is deleted once its chunk is in a region, so this only
+		 * does anything the first time an older save is opened.
 		 */
-		std::filesystem::path toSavePath(
-		    const phx::math::vec3i& chunkPos) const;
+		void migrateLegacySaves();
 
 	private:
-		std::unordered_map<math::vec3, Chunk, math::Vector3Hasher,
-		                   math::Vector3KeyComparator>
-		    m_chunks;
+		// chunks are handed out by pointer, so they stay put as the table
+		// grows.
+		ChunkTable<std::unique_ptr<Chunk>> m_chunks;
+
+		// how many chunks have been unloaded, so accessors know when the
+		// chunks they hold on to might be gone.
+		std::uint64_t m_unloads = 0;
+
+		std::unordered_map<math::vec3i, std::unique_ptr<RegionFile>,
+		                   math::MortonHasher, math::Vector3KeyComparator>
+		            m_regions;
+		std::mutex m_regionMutex;
 
 		BlockReferrer* m_referrer;
 
         std::filesystem::path* m_savePath = nullptr;
 		std::string m_name;
+		BlockDictionary* m_dictionary = nullptr;
+		codec::Options   m_compression = codec::DISK;
+
+		// written to by saves, only read from on the client.
+		MetadataDictionary*       m_metadataKeys        = nullptr;
+		const MetadataDictionary* m_networkMetadataKeys = nullptr;
+
+		std::shared_ptr<const TerrainGenerator> m_generator;
 
 		BlockingQueue<std::pair<math::vec3, std::vector<std::byte>>>* m_queue =
 		    nullptr;
 
 		std::vector<MapEventSubscriber*> m_subscribers;
+
+		// the callbacks of every requested chunk, only used by the thread
+		// making requests.
+		ChunkTable<std::vector<ChunkCallback>> m_callbacks;
+
+		// everything below is shared with the workers, under m_workMutex.
+		std::mutex                   m_workMutex;
+		std::condition_variable      m_workCondition;
+		std::priority_queue<Request> m_loads;
+		std::priority_queue<Request> m_generations;
+		std::deque<Finished>         m_finished;
+		std::uint64_t                m_requestCount = 0;
+		bool                         m_stopping     = false;
+
+		// the priority of every chunk no worker has picked up yet. A chunk
+		// moved up the queue is queued again, the copy that doesn't match
+		// is skipped.
+		ChunkTable<float> m_queued;
+
+		std::vector<std::thread> m_workers;
+
+		// the version of every chunk handed to the flusher and not yet
+		// marked clean, only used by the thread changing the map.
+		ChunkTable<std::uint64_t> m_saving;
+
+		// chunks that changed since they were last handed to the flusher,
+		// and the ones that changed since collectChanges last ran.
+		ChunkTable<Chunk*>       m_edited;
+		std::vector<math::vec3i> m_changed;
+
+		/// @brief How many things hold on to a chunk.
+		struct Residency
+		{
+			std::size_t references = 0;
+			bool        loaded     = false;
+
+			// the memory the chunk used when it was last measured.
+			std::size_t bytes = 0;
+
+			// where the chunk is in m_unused, if nothing holds on to it.
+			std::list<math::vec3i>::iterator unused;
+		};
+
+		// every chunk that's loaded or held on to, and the loaded chunks
+		// nothing holds on to, least recently used at the back.
+		ChunkTable<Residency>  m_residency;
+		std::list<math::vec3i> m_unused;
+		std::size_t            m_memoryBudget  = DEFAULT_MEMORY_BUDGET;
+		std::size_t            m_residentBytes = 0;
+		std::uint64_t          m_evicted       = 0;
+
+		FlushPolicy                           m_flushPolicy;
+		std::chrono::steady_clock::time_point m_lastFlush =
+		    std::chrono::steady_clock::now();
+
+		/// @brief The outcome of writing a snapshot.
+		struct Saved
+		{
+			math::vec3i   position;
+			std::uint64_t version;
+			bool          written;
+		};
+
+		// everything below is shared with the flusher, under m_flushMutex.
+		std::mutex                m_flushMutex;
+		std::condition_variable   m_flushCondition;
+		std::condition_variable   m_flushIdle;
+		std::deque<ChunkSnapshot> m_unsaved;
+		std::vector<Saved>        m_saved;
+		FlushStats                m_flushStats;
+		bool                      m_writing      = false;
+		bool                      m_flushStopped = false;
+
+		std::thread m_flusher;
 	};
 } // namespace phx::voxels
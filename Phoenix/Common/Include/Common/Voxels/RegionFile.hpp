@@ -0,0 +1,219 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <Common/Math/Math.hpp>
+#include <Common/Utility/Internal/SharedTypes.hpp>
+#include <Common/Utility/MappedFile.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace phx::voxels
+{
+	/**
+	 * @brief Stores the saves of a cube of chunks in a single file.
+	 *
+	 * One file per chunk means a file system entry for every chunk ever
+	 * generated, and a failed open() every time a chunk that was never saved
+	 * is looked up. A region instead keeps a table of where every chunk in
+	 * it is stored, so a missing chunk is a lookup in memory.
+	 *
+	 * @paragraph Layout
+	 * The file is split into sectors of SECTOR_SIZE bytes. The first four
+	 * hold two copies of the table, each with a generation and a checksum.
+	 * Every save is written to free sectors first, and only then is the
+	 * older copy of the table replaced, so if the game stops halfway
+	 * through, the other copy still points at complete data. Sectors freed
+	 * by a save can only be reused once neither copy points at them.
+	 *
+	 * Every method locks, a region can be used from more than one thread.
+	 */
+	class RegionFile
+	{
+	public:
+		/// @brief The amount of chunks along each side of a region.
+		static constexpr int SHIFT = 3;
+		static constexpr int SIZE  = 1 << SHIFT;
+
+		/// @brief The amount of chunks in a region.
+		static constexpr std::size_t CHUNKS = SIZE * SIZE * SIZE;
+
+		/// @brief The unit space in the file is handed out in.
+		static constexpr std::size_t SECTOR_SIZE = 4096;
+
+		/**
+		 * @brief The save of a chunk, read in place where possible.
+		 *
+		 * The view keeps the mapping it points into alive, but the bytes
+		 * are only guaranteed to stay the same until the chunk is saved
+		 * again, it should be read straight away.
+		 */
+		struct View
+		{
+			View() = default;
+			View(View&&) = default;
+			View& operator=(View&&) = default;
+
+			// data points into one of these.
+			View(const View&) = delete;
+			View& operator=(const View&) = delete;
+
+			const std::byte* data = nullptr;
+			std::size_t      size = 0;
+
+			explicit operator bool() const { return data != nullptr; }
+
+		private:
+			friend class RegionFile;
+
+			std::shared_ptr<const MappedFile> m_mapping;
+			data::Data                        m_copy;
+		};
+
+		/**
+		 * @brief Opens a region, the file is only created once something is
+		 * written to it.
+		 * @param path The path of the file.
+		 */
+		explicit RegionFile(std::filesystem::path path);
+
+		RegionFile(const RegionFile&) = delete;
+		RegionFile& operator=(const RegionFile&) = delete;
+
+		/**
+		 * @brief Gets the region a chunk is in.
+		 * @param chunk The coordinates of the chunk, in chunks not blocks.
+		 */
+		static math::vec3i toRegion(const math::vec3i& chunk);
+
+		/**
+		 * @brief Gets the index of a chunk inside its region.
+		 * @param chunk The coordinates of the chunk, in chunks not blocks.
+		 */
+		static std::size_t toIndex(const math::vec3i& chunk);
+
+		/**
+		 * @brief Checks if a chunk has been saved in the region.
+		 * @param index The index of the chunk, from toIndex.
+		 */
+		bool contains(std::size_t index);
+
+		/**
+		 * @brief Reads the save of a chunk.
+		 * @param index The index of the chunk, from toIndex.
+		 * @param out Where to write the save, replacing its contents.
+		 * @return false if the chunk hasn't been saved or couldn't be read.
+		 */
+		bool read(std::size_t index, data::Data& out);
+
+		/**
+		 * @brief Gets the save of a chunk without copying it.
+		 * @param index The index of the chunk, from toIndex.
+		 * @return A view of the save, empty if the chunk hasn't been saved.
+		 *
+		 * The save is read from a memory mapping of the file. If the file
+		 * can't be mapped this falls back to read.
+		 */
+		View view(std::size_t index);
+
+		/**
+		 * @brief Starts reading the save of a chunk from disk in the
+		 * background, so a view of it later doesn't have to wait.
+		 * @param index The index of the chunk, from toIndex.
+		 */
+		void prefetch(std::size_t index);
+
+		/**
+		 * @brief Saves a chunk, replacing its previous save.
+		 * @param index The index of the chunk, from toIndex.
+		 * @param data The save.
+		 * @param size The size of the save.
+		 * @return false if the file couldn't be written, the previous save
+		 * is left as it was.
+		 */
+		bool write(std::size_t index, const std::byte* data, std::size_t size);
+
+		/// @brief The amount of sectors the file takes up.
+		std::size_t getSectorCount() const;
+
+	private:
+		struct Entry
+		{
+			std::uint32_t sector = 0;
+			std::uint32_t length = 0;
+		};
+
+		using Table = std::array<Entry, CHUNKS>;
+
+		/// @brief Opens the file if it exists, reading its table.
+		bool open(bool create);
+
+		/// @brief Reads a copy of the table, false if it isn't valid.
+		bool readTable(std::size_t copy, Table& table,
+		               std::uint64_t& generation);
+
+		/// @brief Writes the table over the older copy.
+		bool commit();
+
+		/**
+		 * @brief Gets a mapping of the file that covers a save, mapping the
+		 * file again if it has grown since.
+		 */
+		std::shared_ptr<const MappedFile> getMapping(const Entry& entry);
+
+		/// @brief Finds space for a save, growing the file if needed.
+		std::size_t allocate(std::size_t sectors);
+
+		static std::size_t toSectors(std::size_t bytes);
+
+	private:
+		mutable std::mutex    m_mutex;
+		std::filesystem::path m_path;
+		std::fstream          m_file;
+		bool                  m_opened = false;
+
+		// shared with the views still reading from it.
+		std::shared_ptr<const MappedFile> m_mapping;
+
+		Table         m_table {};
+		std::uint64_t m_generation = 0;
+
+		// whether every sector is in use, and the sectors freed by the last
+		// commit, which the other copy of the table may still point at.
+		std::vector<bool>                                m_used;
+		std::vector<std::pair<std::size_t, std::size_t>> m_pending;
+	};
+} // namespace phx::voxels
@@ -0,0 +1,346 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <Common/CMS/ModManager.hpp>
+#include <Common/Math/Noise.hpp>
+#include <Common/Utility/FlatMap.hpp>
+#include <Common/Voxels/BlockReferrer.hpp>
+#include <Common/Voxels/Chunk.hpp>
+#include <Common/Voxels/Coordinates.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace phx::voxels
+{
+	/**
+	 * @brief A kind of terrain, picked by the climate of a column of blocks.
+	 */
+	struct Biome
+	{
+		std::string id;
+
+		/// @brief Where the biome is in the climate, from -1 to 1. Columns
+		/// get the biome closest to their temperature and humidity.
+		float temperature = 0.f;
+
+		/// @brief See temperature.
+		float humidity = 0.f;
+
+		/// @brief The average height of the ground, in blocks.
+		float height = 0.f;
+
+		/// @brief How far hills rise above and dip below the height.
+		float variation = 12.f;
+
+		/// @brief The top block of the ground.
+		BlockType* surface = nullptr;
+
+		/// @brief The blocks under the surface.
+		BlockType* filler = nullptr;
+
+		/// @brief How many filler blocks there are under the surface.
+		int fillerDepth = 3;
+
+		/// @brief Everything under the filler.
+		BlockType* stone = nullptr;
+	};
+
+	/**
+	 * @brief Generates the terrain of new chunks from a seed.
+	 *
+	 * Every column of blocks gets a biome from two noise fields (temperature
+	 * and humidity) and a height from a third, blended between the biomes
+	 * around it so biomes don't end in cliffs. The ground is everything
+	 * below the height, bent by 3D noise near the surface into overhangs
+	 * and dips.
+	 *
+	 * A chunk is made by running stages over it in order, starting from a
+	 * chunk of air. The generator comes with "core.terrain", which places
+	 * the ground, and "core.surface", which covers it with the blocks of the
+	 * biome. Mods can add their own stages after them, or replace them.
+	 *
+	 * The 2D values of a column of chunks (heights and biomes) are worked out
+	 * once and shared by every chunk in the column, so generating a stack of
+	 * chunks only samples the 2D noise once.
+	 *
+	 * Generating only depends on the seed, the biomes and the stages, never
+	 * on the order chunks are generated in, so a chunk comes out the same
+	 * whether it's generated alone or alongside others on any amount of
+	 * threads. generate() can be called from several threads at once, once
+	 * the biomes and stages are set up and the generator is frozen.
+	 *
+	 * @paragraph Usage
+	 * @code
+	 * TerrainGenerator generator(referrer, 1234);
+	 * generator.addBiome({"core.plains", 0.f, 0.f, 0.f, 12.f, grass, dirt,
+	 *                     3, stone});
+	 *
+	 * generator.freeze();
+	 *
+	 * Chunk chunk = generator.generate({0, -1, 0});
+	 * @endcode
+	 */
+	class TerrainGenerator
+	{
+	public:
+		/// @brief The amount of columns of chunks kept around.
+		static constexpr std::size_t COLUMN_CACHE_SIZE = 1024;
+
+		/// @brief How far above and below the height the 3D noise can move
+		/// the ground, in blocks.
+		static constexpr int OVERHANG = 8;
+
+		/// @brief The amount of columns of blocks in a column of chunks.
+		static constexpr std::size_t COLUMN_AREA =
+		    Chunk::CHUNK_WIDTH * Chunk::CHUNK_DEPTH;
+
+		/// @brief The 2D values of a column of chunks.
+		struct Column
+		{
+			/// @brief The height of the ground of every column of blocks,
+			/// x first.
+			std::array<float, COLUMN_AREA> height;
+
+			/// @brief The index of the biome of every column of blocks.
+			std::array<std::uint16_t, COLUMN_AREA> biome;
+
+			/// @brief The lowest and highest height in the column.
+			float minHeight = 0.f;
+			float maxHeight = 0.f;
+
+			/// @brief Gets the index of a column of blocks.
+			static constexpr std::size_t getIndex(int x, int z)
+			{
+				return static_cast<std::size_t>(x + z * Chunk::CHUNK_WIDTH);
+			}
+		};
+
+		/**
+		 * @brief What a stage gets to work with.
+		 *
+		 * Stages are called from several threads at once, so they must only
+		 * change the blocks they're given, and only depend on the context
+		 * (and things made from the seed, like noise) so chunks come out
+		 * the same every time.
+		 */
+		struct Context
+		{
+			const TerrainGenerator& generator;
+
+			/// @brief The coordinates of the chunk, counted in chunks.
+			ChunkPos chunk;
+
+			/// @brief The 2D values of the column the chunk is in.
+			const Column& column;
+
+			/// @brief Every block of the chunk, in the order of
+			/// LocalPos::getIndex.
+			Chunk::BlockList& blocks;
+
+			/// @brief Gets the biome of a column of blocks in the chunk.
+			const Biome& getBiome(int x, int z) const
+			{
+				return generator.getBiome(
+				    column.biome[Column::getIndex(x, z)]);
+			}
+		};
+
+		/// @brief A step in generating a chunk.
+		using Stage = std::function<void(Context&)>;
+
+		/// @brief How well the cache of columns is doing.
+		struct ColumnStats
+		{
+			std::uint64_t hits   = 0;
+			std::uint64_t misses = 0;
+		};
+
+	public:
+		/**
+		 * @brief Creates a generator with the core stages.
+		 * @param referrer The blocks registered in this session.
+		 * @param seed The seed of the world.
+		 */
+		TerrainGenerator(BlockReferrer* referrer, std::uint64_t seed);
+
+		// stages are given a reference to the generator.
+		TerrainGenerator(const TerrainGenerator&) = delete;
+		TerrainGenerator& operator=(const TerrainGenerator&) = delete;
+
+		/// @brief Gets the seed of the world.
+		std::uint64_t getSeed() const { return m_seed; }
+
+		/**
+		 * @brief Adds a biome, or replaces the biome with the same ID.
+		 * @param biome The biome. The surface and filler default to the
+		 * block under them, the stone to the unknown block.
+		 * @return false if the generator is frozen, the biome isn't added
+		 * in that case.
+		 *
+		 * Without any biomes every column uses a default biome made of the
+		 * unknown block.
+		 */
+		bool addBiome(const Biome& biome);
+
+		/// @brief Gets a biome by its index in Column::biome.
+		const Biome& getBiome(std::size_t index) const
+		{
+			return m_biomes[index];
+		}
+
+		/// @brief Gets the amount of biomes.
+		std::size_t getBiomeCount() const { return m_biomes.size(); }
+
+		/**
+		 * @brief Adds a stage after the others, or replaces the stage with
+		 * the same ID where it is.
+		 * @param id The ID of the stage, such as "mymod.ores".
+		 * @param stage The function changing the chunk.
+		 * @return false if the generator is frozen, the stage isn't added
+		 * in that case.
+		 */
+		bool addStage(const std::string& id, Stage stage);
+
+		/**
+		 * @brief Removes a stage, if there is one with that ID.
+		 * @return false if the generator is frozen, nothing is removed in
+		 * that case.
+		 */
+		bool removeStage(const std::string& id);
+
+		/**
+		 * @brief Stops the biomes and stages from changing.
+		 *
+		 * Generating reads the biomes and stages without locking, so this
+		 * should be called once every mod has set them up, before the
+		 * generator is shared with anything generating on other threads.
+		 */
+		void freeze() { m_frozen = true; }
+
+		/// @brief Gets whether the biomes and stages can still change.
+		bool isFrozen() const { return m_frozen; }
+
+		/**
+		 * @brief Lets mods register biomes, with
+		 * voxel.terrain.registerBiome.
+		 * @param manager The mod manager to register the API with.
+		 *
+		 * Biomes name their blocks by ID, so the blocks have to be
+		 * registered before the biomes using them.
+		 */
+		void registerAPI(cms::ModManager* manager);
+
+		/// @brief Gets the IDs of the stages, in the order they're run.
+		std::vector<std::string> getStages() const;
+
+		/**
+		 * @brief Generates a chunk.
+		 * @param coords The coordinates of the chunk, counted in chunks.
+		 * @return The chunk, marked dirty for everything.
+		 */
+		Chunk generate(const math::vec3i& coords) const;
+
+		/**
+		 * @brief Generates many chunks on several threads.
+		 * @param coords The coordinates of every chunk.
+		 * @param threads The amount of threads to use, including the one
+		 * calling this.
+		 * @return The chunks, in the order of coords.
+		 */
+		std::vector<Chunk> generate(const std::vector<math::vec3i>& coords,
+		                            std::size_t threads) const;
+
+		/**
+		 * @brief Gets the 2D values of a column of chunks, working them out
+		 * if they aren't cached.
+		 * @param x The x coordinate of the column, counted in chunks.
+		 * @param z The z coordinate of the column, counted in chunks.
+		 */
+		std::shared_ptr<const Column> getColumn(int x, int z) const;
+
+		/**
+		 * @brief Checks if a block is in the ground, as "core.terrain"
+		 * places it.
+		 * @param column The column of chunks the block is in.
+		 * @param position The position of the block in the world.
+		 */
+		bool isGround(const Column& column, const BlockPos& position) const;
+
+		/// @brief Gets how well the cache of columns is doing.
+		ColumnStats getColumnStats() const;
+
+	private:
+		/// @brief Works out the 2D values of a column of chunks.
+		Column makeColumn(int x, int z) const;
+
+		/// @brief Places the ground, the "core.terrain" stage.
+		static void placeTerrain(Context& context);
+
+		/// @brief Covers the ground, the "core.surface" stage.
+		static void placeSurface(Context& context);
+
+	private:
+		BlockReferrer* m_referrer;
+		BlockType*     m_air;
+		std::uint64_t  m_seed;
+
+		math::Noise m_temperature;
+		math::Noise m_humidity;
+		math::Noise m_height;
+		math::Noise m_density;
+
+		// starts out with a default biome, until one is added.
+		std::vector<Biome>                         m_biomes;
+		bool                                       m_defaultBiome = true;
+		std::vector<std::pair<std::string, Stage>> m_stages;
+		bool                                       m_frozen = false;
+
+		// columns are shared by every thread generating, the oldest is
+		// dropped once there are too many.
+		mutable std::mutex m_columnMutex;
+		mutable FlatMap<math::vec3i, std::shared_ptr<const Column>,
+		                math::MortonHasher, math::Vector3KeyComparator>
+		                                m_columns;
+		mutable std::deque<math::vec3i> m_columnOrder;
+
+		mutable std::atomic<std::uint64_t> m_columnHits {0};
+		mutable std::atomic<std::uint64_t> m_columnMisses {0};
+	};
+} // namespace phx::voxels
@@ -33,6 +33,14 @@
 
 using namespace phx;
 
+namespace
+{
+	// interned up front so the rotation of blocks can be read from saves
+	// and the server before anything has been placed.
+	const std::optional<MetadataKeys::Key> ROTATION_KEY =
+	    MetadataKeys::intern("core.rotation");
+} // namespace
+
 entt::entity ActorSystem::registerActor(
     entt::registry* registry,
     voxels::Map*    map,
@@ -93,11 +101,13 @@ math::Ray ActorSystem::getTarget(entt::registry* registry, entt::entity entity)
 
 	math::Ray ray(pos, registry->get<Position>(entity).getDirection());
 
+	// the ray goes through a few blocks per chunk, the accessor only looks
+	// the chunk up when it crosses into another one.
+	voxels::Map::Accessor accessor(map, voxels::BlockPos::fromWorld(pos));
 	while (ray.getLength() < m_reach)
 	{
-		pos.floor();
-
-		if (map->getBlockAt(pos)->category == voxels::BlockCategory::SOLID)
+		accessor.moveTo(voxels::BlockPos::fromWorld(pos));
+		if (accessor.isSolid())
 		{
 			return ray;
 		}
@@ -119,24 +129,23 @@ bool ActorSystem::action1(voxels::BlockReferrer* blockReferrer,
 	Hand         hand = registry->get<Hand>(entity);
 	voxels::Item item = hand.getHand();
 
+	voxels::Map::Accessor accessor(map, voxels::BlockPos::fromWorld(pos));
 	while (ray.getLength() < m_reach)
 	{
-		pos.floor();
-
-		const auto* currentBlock = map->getBlockAt(pos);
-		if (currentBlock->category == voxels::BlockCategory::SOLID)
+		accessor.moveTo(voxels::BlockPos::fromWorld(pos));
+		if (accessor.isSolid())
 		{
 			if (item.type)
 			{
 				if (item.type->onPrimary)
 				{
-					item.type->onPrimary(pos);
+					item.type->onPrimary(accessor.getPosition().toWorld());
 					return true;
 				}
 			}
-			map->setBlockAt(
-			    pos, {blockReferrer->blocks.get(voxels::BlockType::AIR_BLOCK),
-			          nullptr});
+			accessor.setBlock(
+			    {blockReferrer->blocks.get(voxels::BlockType::AIR_BLOCK),
+			     nullptr});
 			return true;
 		}
 
@@ -172,15 +181,14 @@ bool ActorSystem::action2(voxels::BlockReferrer* blockReferrer,
 
 	math::Ray ray(pos, dir);
 
+	voxels::Map::Accessor accessor(map, voxels::BlockPos::fromWorld(pos));
 	while (ray.getLength() < m_reach)
 	{
-		pos.floor();
-
-		const auto currentBlock = map->getBlockAt(pos);
-		if (currentBlock->category == voxels::BlockCategory::SOLID)
+		accessor.moveTo(voxels::BlockPos::fromWorld(pos));
+		if (accessor.isSolid())
 		{
-			math::vec3 back = ray.backtrace(RAY_INCREMENT);
-			back.floor();
+			const voxels::BlockPos back =
+			    voxels::BlockPos::fromWorld(ray.backtrace(RAY_INCREMENT));
 			if (!item.type->places.empty())
 			{
 				if (!m_creative)
@@ -190,7 +198,8 @@ bool ActorSystem::action2(voxels::BlockReferrer* blockReferrer,
 				voxels::Block block {blockReferrer->getByID(item.type->places),
 				                     nullptr};
 				Metadata      data;
-				if (block.type->rotH)
+				if (blockReferrer->properties.has(
+				        block.type->uid, voxels::BlockProperties::ROTATE_H))
 				{
 					math::vec3 rotation;
 					if (dir.x > 0)
@@ -201,9 +210,9 @@ bool ActorSystem::action2(voxels::BlockReferrer* blockReferrer,
 					{
 						rotation.x += 90;
 					}
-					if (rotation.x > 0)
+					if (rotation.x > 0 && ROTATION_KEY)
 					{
-						data.set("core.rotation", rotation);
+						data.set(*ROTATION_KEY, rotation);
 					}
 				}
 				if (data.size() > 0)
@@ -211,11 +220,14 @@ bool ActorSystem::action2(voxels::BlockReferrer* blockReferrer,
 					block.metadata = &data;
 				}
 
-				map->setBlockAt(back, block);
+				// the block before is at most a chunk away, so it's
+				// still cached.
+				accessor.moveTo(back);
+				accessor.setBlock(block);
 			}
 			if (item.type->onSecondary)
 			{
-				item.type->onSecondary(back);
+				item.type->onSecondary(back.toWorld());
 			}
 
 			return true;
@@ -0,0 +1,258 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Common/Math/Noise.hpp>
+
+#include <utility>
+
+using namespace phx::math;
+
+namespace
+{
+	// splitmix64, the same on every platform.
+	std::uint64_t nextRandom(std::uint64_t& state)
+	{
+		std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+		z               = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z               = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+
+	// octaves are moved apart, so the lattices of the octaves don't line
+	// up on the origin.
+	constexpr float OCTAVE_OFFSET = 19.19f;
+
+	// the gradients of 2D noise, and their x and y.
+	constexpr float GRADIENT_X[8] = {1.f,  -1.f, 1.f, -1.f,
+	                                 1.f, -1.f, 0.f, 0.f};
+	constexpr float GRADIENT_Y[8] = {1.f, 1.f, -1.f, -1.f,
+	                                 0.f, 0.f, 1.f,  -1.f};
+
+	// the edges of a cube, Perlin's gradients for 3D noise.
+	constexpr float EDGE_X[16] = {1.f, -1.f, 1.f, -1.f, 1.f, -1.f, 1.f,  -1.f,
+	                              0.f, 0.f,  0.f, 0.f,  1.f, 0.f,  -1.f, 0.f};
+	constexpr float EDGE_Y[16] = {1.f, 1.f,  -1.f, -1.f, 0.f, 0.f,  0.f, 0.f,
+	                              1.f, -1.f, 1.f,  -1.f, 1.f, -1.f, 1.f, -1.f};
+	constexpr float EDGE_Z[16] = {0.f, 0.f, 0.f,  0.f,  1.f, 1.f, -1.f, -1.f,
+	                              1.f, 1.f, -1.f, -1.f, 0.f, 1.f, 0.f,  -1.f};
+
+	inline int floorToInt(float value)
+	{
+		const int truncated = static_cast<int>(value);
+		return truncated -
+		       static_cast<int>(value < static_cast<float>(truncated));
+	}
+
+	// 6t^5 - 15t^4 + 10t^3, smooth in its first and second derivative.
+	inline float fade(float t)
+	{
+		return t * t * t * (t * (t * 6.f - 15.f) + 10.f);
+	}
+
+	inline float lerp(float a, float b, float t) { return a + t * (b - a); }
+
+	inline float gradient(std::uint8_t hash, float x, float y)
+	{
+		return GRADIENT_X[hash & 7] * x + GRADIENT_Y[hash & 7] * y;
+	}
+
+	inline float gradient(std::uint8_t hash, float x, float y, float z)
+	{
+		return EDGE_X[hash & 15] * x + EDGE_Y[hash & 15] * y +
+		       EDGE_Z[hash & 15] * z;
+	}
+
+	inline float sample(const std::uint8_t* p, float x, float y)
+	{
+		const int xi = floorToInt(x);
+		const int yi = floorToInt(y);
+
+		const float xf = x - static_cast<float>(xi);
+		const float yf = y - static_cast<float>(yi);
+
+		const int X = xi & 255;
+		const int Y = yi & 255;
+
+		const int a = p[X] + Y;
+		const int b = p[X + 1] + Y;
+
+		const float u = fade(xf);
+		const float v = fade(yf);
+
+		return lerp(lerp(gradient(p[a], xf, yf), gradient(p[b], xf - 1.f, yf),
+		                 u),
+		            lerp(gradient(p[a + 1], xf, yf - 1.f),
+		                 gradient(p[b + 1], xf - 1.f, yf - 1.f), u),
+		            v);
+	}
+
+	inline float sample(const std::uint8_t* p, float x, float y, float z)
+	{
+		const int xi = floorToInt(x);
+		const int yi = floorToInt(y);
+		const int zi = floorToInt(z);
+
+		const float xf = x - static_cast<float>(xi);
+		const float yf = y - static_cast<float>(yi);
+		const float zf = z - static_cast<float>(zi);
+
+		const int X = xi & 255;
+		const int Y = yi & 255;
+		const int Z = zi & 255;
+
+		const int a  = p[X] + Y;
+		const int aa = p[a] + Z;
+		const int ab = p[a + 1] + Z;
+		const int b  = p[X + 1] + Y;
+		const int ba = p[b] + Z;
+		const int bb = p[b + 1] + Z;
+
+		const float u = fade(xf);
+		const float v = fade(yf);
+		const float w = fade(zf);
+
+		const float near = lerp(
+		    lerp(gradient(p[aa], xf, yf, zf),
+		         gradient(p[ba], xf - 1.f, yf, zf), u),
+		    lerp(gradient(p[ab], xf, yf - 1.f, zf),
+		         gradient(p[bb], xf - 1.f, yf - 1.f, zf), u),
+		    v);
+		const float far = lerp(
+		    lerp(gradient(p[aa + 1], xf, yf, zf - 1.f),
+		         gradient(p[ba + 1], xf - 1.f, yf, zf - 1.f), u),
+		    lerp(gradient(p[ab + 1], xf, yf - 1.f, zf - 1.f),
+		         gradient(p[bb + 1], xf - 1.f, yf - 1.f, zf - 1.f), u),
+		    v);
+
+		return lerp(near, far, w);
+	}
+} // namespace
+
+Noise::Noise(std::uint64_t seed) : m_seed(seed)
+{
+	std::array<std::uint8_t, 256> shuffled;
+	for (std::size_t i = 0; i < shuffled.size(); ++i)
+	{
+		shuffled[i] = static_cast<std::uint8_t>(i);
+	}
+
+	// a Fisher-Yates shuffle.
+	std::uint64_t state = seed;
+	for (std::size_t i = shuffled.size() - 1; i > 0; --i)
+	{
+		const std::size_t j = nextRandom(state) % (i + 1);
+		std::swap(shuffled[i], shuffled[j]);
+	}
+
+	for (std::size_t i = 0; i < m_permutation.size(); ++i)
+	{
+		m_permutation[i] = shuffled[i & 255];
+	}
+}
+
+float Noise::get(float x, float y) const
+{
+	return sample(m_permutation.data(), x, y);
+}
+
+float Noise::get(float x, float y, float z) const
+{
+	return sample(m_permutation.data(), x, y, z);
+}
+
+void Noise::getRow(float* out, std::size_t count, float x, float y,
+                   float step) const
+{
+	const std::uint8_t* permutation = m_permutation.data();
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		out[i] = sample(permutation, x + static_cast<float>(i) * step, y);
+	}
+}
+
+float Noise::getFractal(float x, float y, const Fractal& fractal) const
+{
+	float value;
+	getFractalRow(&value, 1, x, y, 0.f, fractal);
+	return value;
+}
+
+float Noise::getFractal(float x, float y, float z,
+                        const Fractal& fractal) const
+{
+	float sum       = 0.f;
+	float total     = 0.f;
+	float amplitude = 1.f;
+	float frequency = fractal.frequency;
+	for (int octave = 0; octave < fractal.octaves; ++octave)
+	{
+		const float offset = static_cast<float>(octave) * OCTAVE_OFFSET;
+		sum += amplitude * get(x * frequency + offset, y * frequency + offset,
+		                       z * frequency + offset);
+
+		total += amplitude;
+		amplitude *= fractal.gain;
+		frequency *= fractal.lacunarity;
+	}
+
+	return total > 0.f ? sum / total : 0.f;
+}
+
+void Noise::getFractalRow(float* out, std::size_t count, float x, float y,
+                          float step, const Fractal& fractal) const
+{
+	const std::uint8_t* permutation = m_permutation.data();
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		out[i] = 0.f;
+	}
+
+	float total     = 0.f;
+	float amplitude = 1.f;
+	float frequency = fractal.frequency;
+	for (int octave = 0; octave < fractal.octaves; ++octave)
+	{
+		const float offset = static_cast<float>(octave) * OCTAVE_OFFSET;
+		const float row    = y * frequency + offset;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const float column = x + static_cast<float>(i) * step;
+			out[i] += amplitude *
+			          sample(permutation, column * frequency + offset, row);
+		}
+
+		total += amplitude;
+		amplitude *= fractal.gain;
+		frequency *= fractal.lacunarity;
+	}
+
+	for (std::size_t i = 0; i < count && total > 0.f; ++i)
+	{
+		out[i] /= total;
+	}
+}
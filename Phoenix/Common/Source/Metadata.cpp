@@ -27,108 +27,411 @@
 // POSSIBILITY OF SUCH DAMAGE.
 
 #include <Common/Logger.hpp>
-#include <Common/Math/Math.hpp>
 #include <Common/Metadata.hpp>
 
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <mutex>
+
 using namespace phx;
 
-bool Metadata::set(const std::string& key, const std::any& data)
+namespace
 {
-	auto existing = m_data.find(key);
-	if (existing != m_data.end())
+	// the global key table, names are kept in a deque so growing the table
+	// never moves them.
+	struct KeyTable
+	{
+		std::mutex                                         mutex;
+		std::deque<std::string>                            names;
+		std::unordered_map<std::string, MetadataKeys::Key> ids;
+	};
+
+	KeyTable& keyTable()
 	{
-		if (existing->second.type() != data.type())
+		static KeyTable table;
+		return table;
+	}
+
+	// the type tags written before each value.
+	constexpr char TYPE_INT   = 'i';
+	constexpr char TYPE_FLOAT = 'f';
+	constexpr char TYPE_VEC3  = 'v';
+
+	void writeValue(Serializer& ser, const Metadata::Value& value)
+	{
+		if (const int* i = std::get_if<int>(&value))
 		{
-			return false;
+			ser << TYPE_INT << *i;
+		}
+		else if (const float* f = std::get_if<float>(&value))
+		{
+			ser << TYPE_FLOAT << *f;
+		}
+		else
+		{
+			const math::vec3& v = std::get<math::vec3>(value);
+			ser << TYPE_VEC3 << v.x << v.y << v.z;
+		}
+	}
+
+	Metadata::Value readValue(Reader& ser)
+	{
+		char type;
+		ser >> type;
+		if (type == TYPE_INT)
+		{
+			int v;
+			ser >> v;
+			return v;
 		}
+		if (type == TYPE_FLOAT)
+		{
+			float v;
+			ser >> v;
+			return v;
+		}
+		if (type == TYPE_VEC3)
+		{
+			float x, y, z;
+			ser >> x >> y >> z;
+			return math::vec3(x, y, z);
+		}
+
+		// ran out of data or an unknown type, either way the caller checks
+		// the reader.
+		ser.fail();
+		return 0;
+	}
+} // namespace
+
+std::optional<MetadataKeys::Key> MetadataKeys::intern(const std::string& name)
+{
+	KeyTable&                   table = keyTable();
+	std::lock_guard<std::mutex> lock(table.mutex);
+
+	auto existing = table.ids.find(name);
+	if (existing != table.ids.end())
+	{
+		return existing->second;
+	}
+
+	if (table.names.size() > std::numeric_limits<Key>::max())
+	{
+		LOG_WARNING("Metadata") << "Ran out of metadata keys while adding "
+		                        << name;
+		return std::nullopt;
+	}
+
+	const auto key = static_cast<Key>(table.names.size());
+	table.names.push_back(name);
+	table.ids.emplace(name, key);
+	return key;
+}
+
+std::optional<MetadataKeys::Key> MetadataKeys::find(const std::string& name)
+{
+	KeyTable&                   table = keyTable();
+	std::lock_guard<std::mutex> lock(table.mutex);
+
+	auto existing = table.ids.find(name);
+	if (existing == table.ids.end())
+	{
+		return std::nullopt;
 	}
-	if (data.type() == typeid(int) || data.type() == typeid(float) ||
-	    data.type() == typeid(phx::math::vec3))
+	return existing->second;
+}
+
+std::string MetadataKeys::getName(Key key)
+{
+	KeyTable&                   table = keyTable();
+	std::lock_guard<std::mutex> lock(table.mutex);
+
+	if (key >= table.names.size())
+	{
+		return {};
+	}
+	return table.names[key];
+}
+
+std::size_t MetadataKeys::size()
+{
+	KeyTable&                   table = keyTable();
+	std::lock_guard<std::mutex> lock(table.mutex);
+
+	return table.names.size();
+}
+
+bool Metadata::set(Key key, const Value& data)
+{
+	auto it = std::lower_bound(
+	    m_data.begin(), m_data.end(), key,
+	    [](const std::pair<Key, Value>& entry, Key k) { return entry.first < k; });
+
+	if (it != m_data.end() && it->first == key)
 	{
-		m_data[key] = data;
+		if (it->second.index() != data.index())
+		{
+			return false;
+		}
+		it->second = data;
 		return true;
 	}
-	LOG_DEBUG("Metadata") << "Attempted to store unsupported datatype"
-	                      << data.type().name() << "in metadata container";
-	return false;
+
+	m_data.emplace(it, key, data);
+	return true;
 }
 
-const std::any* Metadata::get(const std::string& key) const
+const Metadata::Value* Metadata::get(Key key) const
 {
-	auto existing = m_data.find(key);
-	if (existing != m_data.end())
+	auto it = std::lower_bound(
+	    m_data.begin(), m_data.end(), key,
+	    [](const std::pair<Key, Value>& entry, Key k) { return entry.first < k; });
+
+	if (it != m_data.end() && it->first == key)
 	{
-		return &existing->second;
+		return &it->second;
 	}
 	return nullptr;
 }
 
+const Metadata::Value* Metadata::get(const std::string& key) const
+{
+	// a key that was never interned can't have been set.
+	const std::optional<Key> id = MetadataKeys::find(key);
+	return id ? get(*id) : nullptr;
+}
+
+void Metadata::erase(Key key)
+{
+	m_data.erase(std::remove_if(m_data.begin(), m_data.end(),
+	                            [key](const std::pair<Key, Value>& entry) {
+		                            return entry.first == key;
+	                            }),
+	             m_data.end());
+}
+
 Serializer& Metadata::operator>>(Serializer& ser) const
 {
-	int size = m_data.size();
-	ser << size;
-	for (auto& data : m_data)
+	ser << static_cast<int>(m_data.size());
+	for (const auto& entry : m_data)
 	{
-		ser << data.first;
-		if (data.second.type() == typeid(int))
-		{
-			ser << 'i' << std::any_cast<int>(data.second);
-		}
-		else if (data.second.type() == typeid(float))
-		{
-			ser << 'f' << std::any_cast<float>(data.second);
-		}
-		else if (data.second.type() == typeid(phx::math::vec3))
-		{
-			math::vec3 v = std::any_cast<math::vec3>(data.second);
-			ser << 'v' << v.x << v.y << v.z;
-		}
-		else
-		{
-			LOG_FATAL("Metadata")
-			    << "Attempted to serialize unsupported data type";
-			exit(EXIT_FAILURE);
-		}
+		ser << MetadataKeys::getName(entry.first);
+		writeValue(ser, entry.second);
 	}
 	return ser;
 }
 
-Serializer& Metadata::operator<<(Serializer& ser)
+Reader& Metadata::operator<<(Reader& ser)
 {
+	m_data.clear();
+
 	int size;
 	ser >> size;
-	for (int i = 0; i < size; i++)
+	for (int i = 0; i < size && ser; i++)
 	{
 		std::string key;
 		ser >> key;
-		char type;
-		ser >> type;
-		std::any val;
-		if (type == 'i')
+
+		const std::optional<Key> id    = MetadataKeys::intern(key);
+		const Value              value = readValue(ser);
+		if (ser && id)
 		{
-			int v;
-			ser >> v;
-			set(key, v);
+			set(*id, value);
+		}
+	}
+	return ser;
+}
+
+MetadataDictionary::MetadataDictionary(std::size_t limit)
+    : m_limit(std::min(limit, MAX_KEYS))
+{
+}
+
+std::optional<MetadataDictionary::ID> MetadataDictionary::getID(
+    MetadataKeys::Key key)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (key < m_ids.size() && m_ids[key] >= 0)
+	{
+		return static_cast<ID>(m_ids[key]);
+	}
+
+	if (m_names.size() >= m_limit)
+	{
+		LOG_WARNING("Metadata") << "Ran out of metadata IDs while adding "
+		                        << MetadataKeys::getName(key);
+		return std::nullopt;
+	}
+
+	const auto id = static_cast<ID>(m_names.size());
+	m_names.push_back(MetadataKeys::getName(key));
+	m_keys.emplace_back(key);
+
+	if (key >= m_ids.size())
+	{
+		m_ids.resize(key + std::size_t {1}, -1);
+	}
+	m_ids[key] = id;
+
+	return id;
+}
+
+void MetadataDictionary::write(Serializer& ser, const Metadata& metadata)
+{
+	// keys that can't be numbered are left out, so they're counted first.
+	std::vector<std::pair<ID, const Metadata::Value*>> entries;
+	entries.reserve(metadata.m_data.size());
+	for (const auto& entry : metadata.m_data)
+	{
+		if (const std::optional<ID> id = getID(entry.first))
+		{
+			entries.emplace_back(*id, &entry.second);
 		}
-		else if (type == 'f')
+	}
+
+	ser << static_cast<std::uint16_t>(entries.size());
+	for (const auto& entry : entries)
+	{
+		ser << entry.first;
+		writeValue(ser, *entry.second);
+	}
+}
+
+void MetadataDictionary::read(Reader& ser, Metadata& metadata) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	metadata.m_data.clear();
+
+	std::uint16_t size;
+	ser >> size;
+	for (std::uint16_t i = 0; i < size && ser; i++)
+	{
+		ID id;
+		ser >> id;
+
+		const Metadata::Value value = readValue(ser);
+		if (ser && id < m_keys.size() && m_keys[id])
 		{
-			float v;
-			ser >> v;
-			set(key, v);
+			metadata.set(*m_keys[id], value);
 		}
-		else if (type == 'v')
+	}
+}
+
+std::vector<std::string> MetadataDictionary::getNames(std::size_t first) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (first >= m_names.size())
+	{
+		return {};
+	}
+	return {m_names.begin() + first, m_names.end()};
+}
+
+bool MetadataDictionary::add(std::size_t                     first,
+                             const std::vector<std::string>& names)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return append(first, names);
+}
+
+void MetadataDictionary::restore(const std::vector<std::string>& names)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_names.clear();
+	m_keys.clear();
+	m_ids.clear();
+	append(0, names);
+}
+
+std::size_t MetadataDictionary::writeNames(Serializer& ser,
+                                          std::size_t first) const
+{
+	const std::vector<std::string> names = getNames(first);
+
+	ser << static_cast<std::uint32_t>(first)
+	    << static_cast<std::uint32_t>(names.size());
+	for (const std::string& name : names)
+	{
+		ser << name;
+	}
+	return first + names.size();
+}
+
+bool MetadataDictionary::readNames(Reader& ser)
+{
+	std::uint32_t first;
+	std::uint32_t count;
+	ser >> first >> count;
+
+	// every name takes at least a byte, don't trust a count bigger than that.
+	std::vector<std::string> names;
+	names.reserve(std::min<std::size_t>(count, ser.remaining()));
+	for (std::uint32_t i = 0; i < count && ser; i++)
+	{
+		std::string name;
+		ser >> name;
+		names.push_back(std::move(name));
+	}
+	if (!ser)
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	// names added before the whole dictionary was sent can get here ahead of
+	// it, it has them too.
+	if (first > m_names.size())
+	{
+		return true;
+	}
+	return append(first, names);
+}
+
+std::size_t MetadataDictionary::size() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_names.size();
+}
+
+bool MetadataDictionary::append(std::size_t                     first,
+                                const std::vector<std::string>& names)
+{
+	if (first > m_names.size())
+	{
+		return false;
+	}
+
+	for (std::size_t i = m_names.size() - first; i < names.size(); i++)
+	{
+		if (m_names.size() >= m_limit)
 		{
-			float x, y, z;
-			ser >> x >> y >> z;
-			math::vec3 v(x, y, z);
-			set(key, v);
+			return false;
 		}
-		else
+
+		const std::optional<MetadataKeys::Key> key =
+		    MetadataKeys::intern(names[i]);
+		if (key)
 		{
-			LOG_FATAL("Metadata")
-			    << "Attempted to deserialize unsupported data type";
-			exit(EXIT_FAILURE);
+			if (*key >= m_ids.size())
+			{
+				m_ids.resize(*key + std::size_t {1}, -1);
+			}
+
+			// a key listed twice keeps being written with its first ID.
+			if (m_ids[*key] < 0)
+			{
+				m_ids[*key] = static_cast<std::int32_t>(m_names.size());
+			}
 		}
+
+		m_names.push_back(names[i]);
+		m_keys.push_back(key);
 	}
-	return ser;
+	return true;
 }
@@ -29,67 +29,190 @@
 #include <Common/Logger.hpp>
 #include <Common/PlayerView.hpp>
 
+#include <algorithm>
+#include <cstdlib>
+
 using namespace phx;
 
-std::vector<voxels::Chunk*> PlayerView::update(entt::registry* registry,
-                                               entt::entity    entity)
+math::vec3i PlayerView::getCentre(entt::registry* registry,
+                                 entt::entity    entity)
 {
-	std::vector<voxels::Chunk*> newChunks;
+	return registry->get<Position>(entity).getBlockPos().getChunk();
+}
 
-	PlayerView& view = registry->get<PlayerView>(entity);
+std::vector<math::vec3i> PlayerView::findMissing(entt::registry* registry,
+                                                 entt::entity    entity)
+{
+	const PlayerView& view = registry->get<PlayerView>(entity);
 
-	// this gets the raw player position in voxel-world coordinates.
-	math::vec3 playerPos =
-	    (registry->get<Position>(entity).position / 2.f) + 0.5f;
-	const int posX = static_cast<int>(playerPos.x) / voxels::Chunk::CHUNK_WIDTH;
-	const int posY =
-	    static_cast<int>(playerPos.y) / voxels::Chunk::CHUNK_HEIGHT;
-	const int posZ = static_cast<int>(playerPos.z) / voxels::Chunk::CHUNK_DEPTH;
+	const math::vec3i centre = getCentre(registry, entity);
 
 	// TODO move this to a config or add as a parameter
-	const int viewDistance = 3;
-
-	// TODO remove chunks that are out of view
+	const int viewDistance = VIEW_DISTANCE;
 
+	std::vector<math::vec3i> missing;
 	for (int x = -viewDistance; x <= viewDistance; x++)
 	{
 		for (int y = -viewDistance; y <= viewDistance; y++)
 		{
 			for (int z = -viewDistance; z <= viewDistance; z++)
 			{
-				math::vec3 chunkToCheck = {static_cast<float>(x + posX),
-				                           static_cast<float>(y + posY),
-				                           static_cast<float>(z + posZ)};
-
-				// this will allow it to work if we choose to make chunks non cube.
-				chunkToCheck =
-				    chunkToCheck * math::vec3 {voxels::Chunk::CHUNK_WIDTH,
-				                               voxels::Chunk::CHUNK_HEIGHT,
-				                               voxels::Chunk::CHUNK_DEPTH};
-				
-				bool hasChunk = false;
-				for (const auto chunk : view.chunks)
-				{
-					if (chunk == chunkToCheck)
-					{
-						hasChunk = true;
-						break;
-					}
-				}
+				const math::vec3i chunkToCheck = {centre.x + x, centre.y + y,
+				                                  centre.z + z};
 
-				if (!hasChunk)
+				if (!view.chunks.contains(chunkToCheck) &&
+				    !view.requested.contains(chunkToCheck))
 				{
-					voxels::Chunk* chunk = view.map->getChunk(chunkToCheck);
-					if (chunk != nullptr)
-					{
-						view.chunks.emplace_back(chunkToCheck);
-						newChunks.emplace_back(
-						    view.map->getChunk(chunkToCheck));
-					}
+					missing.emplace_back(chunkToCheck);
 				}
 			}
 		}
 	}
 
+	// nearest first, the player is in the middle of the box.
+	auto distance = [&centre](const math::vec3i& chunk) {
+		const math::vec3i offset = chunk - centre;
+		return offset.x * offset.x + offset.y * offset.y + offset.z * offset.z;
+	};
+	std::stable_sort(missing.begin(), missing.end(),
+	                 [&distance](const math::vec3i& a, const math::vec3i& b) {
+		                 return distance(a) < distance(b);
+	                 });
+
+	return missing;
+}
+
+void PlayerView::dropOutOfView(entt::registry* registry, entt::entity entity,
+                               std::vector<math::vec3i>* dropped)
+{
+	PlayerView& view = registry->get<PlayerView>(entity);
+
+	const math::vec3i centre = getCentre(registry, entity);
+
+	// chunks are kept a little past the view distance, so walking back and
+	// forth over a chunk border doesn't drop and load the same chunks.
+	auto outOfView = [&centre](const math::vec3i& chunk) {
+		return std::abs(chunk.x - centre.x) > VIEW_DISTANCE + 1 ||
+		       std::abs(chunk.y - centre.y) > VIEW_DISTANCE + 1 ||
+		       std::abs(chunk.z - centre.z) > VIEW_DISTANCE + 1;
+	};
+
+	// the sets can't be changed while they're walked through.
+	std::vector<math::vec3i> gone;
+	for (const auto& chunk : view.chunks)
+	{
+		if (outOfView(chunk.first))
+		{
+			gone.push_back(chunk.first);
+		}
+	}
+	for (const math::vec3i& chunk : gone)
+	{
+		view.chunks.erase(chunk);
+		view.map->release(chunk);
+		if (dropped != nullptr)
+		{
+			dropped->push_back(chunk);
+		}
+	}
+
+	// chunks still loading are ignored once they arrive.
+	gone.clear();
+	for (const auto& chunk : view.requested)
+	{
+		if (outOfView(chunk.first))
+		{
+			gone.push_back(chunk.first);
+		}
+	}
+	for (const math::vec3i& chunk : gone)
+	{
+		view.requested.erase(chunk);
+	}
+}
+
+void PlayerView::clear()
+{
+	for (const auto& chunk : chunks)
+	{
+		map->release(chunk.first);
+	}
+	chunks.clear();
+	requested.clear();
+}
+
+std::vector<voxels::Chunk*> PlayerView::update(
+    entt::registry* registry, entt::entity entity,
+    std::vector<math::vec3i>* dropped)
+{
+	std::vector<voxels::Chunk*> newChunks;
+
+	PlayerView& view = registry->get<PlayerView>(entity);
+
+	dropOutOfView(registry, entity, dropped);
+
+	// find every chunk that's come into view first, so their saves can all
+	// be read from disk at once rather than one after the other.
+	const std::vector<math::vec3i> missing = findMissing(registry, entity);
+	if (missing.empty())
+	{
+		return newChunks;
+	}
+
+	view.map->prefetch(missing);
+
+	for (const math::vec3i& chunkToCheck : missing)
+	{
+		voxels::Chunk* chunk = view.map->getChunk(chunkToCheck);
+		if (chunk != nullptr)
+		{
+			view.map->acquire(chunkToCheck);
+			view.chunks.try_emplace(chunkToCheck, true);
+			newChunks.emplace_back(chunk);
+		}
+	}
+
 	return newChunks;
 }
+
+void PlayerView::request(entt::registry* registry, entt::entity entity,
+                         const std::function<void(voxels::Chunk*)>& onLoaded)
+{
+	PlayerView& view = registry->get<PlayerView>(entity);
+
+	dropOutOfView(registry, entity, nullptr);
+
+	const std::vector<math::vec3i> missing = findMissing(registry, entity);
+	for (std::size_t i = 0; i < missing.size(); ++i)
+	{
+		const math::vec3i position = missing[i];
+		view.requested.try_emplace(position, true);
+
+		// missing is sorted by distance, so its order is the priority.
+		view.map->request(
+		    position, static_cast<float>(i),
+		    [registry, entity, position, onLoaded](voxels::Chunk* chunk) {
+			    // the player might have left while the chunk was loading.
+			    if (!registry->valid(entity))
+			    {
+				    return;
+			    }
+
+			    auto* view = registry->try_get<PlayerView>(entity);
+			    if (view == nullptr)
+			    {
+				    return;
+			    }
+
+			    // or moved on, so it's no longer wanted.
+			    if (view->requested.erase(position) == 0)
+			    {
+				    return;
+			    }
+
+			    view->map->acquire(position);
+			    view->chunks.try_emplace(position, true);
+			    onLoaded(chunk);
+		    });
+	}
+}
@@ -31,9 +31,26 @@
 
 #include <fstream>
 #include <iomanip>
+#include <random>
 
 using namespace phx;
 
+namespace
+{
+	bool hasSeed(const nlohmann::json& settings)
+	{
+		return settings.is_object() && settings.contains("seed") &&
+		       settings.at("seed").is_number_integer();
+	}
+
+	// random_device only gives 32 bits at a time.
+	std::uint64_t makeSeed()
+	{
+		std::random_device device;
+		return (static_cast<std::uint64_t>(device()) << 32) | device();
+	}
+} // namespace
+
 Save::Save(const std::string& save, const std::vector<std::string>& mods,
      const nlohmann::json& settings)
 {
@@ -50,21 +67,17 @@ Save::Save(const std::string& save, const std::vector<std::string>& mods,
 		// save doesn't already exist, lets make it.
 		fs::create_directories(m_savePath);
 
-		// we make a new json thing so we don't double the size of the config
-		// struct.
-		nlohmann::json saveSettings;
-
-		saveSettings["name"]     = save;
-		saveSettings["mods"]     = mods;
-		saveSettings["settings"] = settings;
-
-		std::ofstream json(m_savePath / (save + ".json"));
-		json << std::setw(4) << saveSettings;
-		json.close();
-
 		m_name = save;
 		m_mods = mods;
 		m_settings = settings;
+
+		// every new world is different, unless it's given a seed.
+		if (!hasSeed(m_settings))
+		{
+			m_settings["seed"] = makeSeed();
+		}
+
+		writeSettings(m_savePath / (save + ".json"));
 	}
 	else
 	{
@@ -95,6 +108,29 @@ Save::Save(const std::string& save, const std::vector<std::string>& mods,
 		m_name     = saveSettings["name"].get<std::string>();
 		m_mods     = saveSettings["mods"].get<std::vector<std::string>>();
 		m_settings = saveSettings["settings"].get<nlohmann::json>();
+
+		// saves from before seeds were kept get one now, and keep it.
+		if (!hasSeed(m_settings))
+		{
+			m_settings["seed"] = makeSeed();
+			m_settingsChanged  = true;
+		}
+
+		if (saveSettings["blocks"].is_array())
+		{
+			m_blocks.restore(
+			    saveSettings["blocks"].get<std::vector<std::string>>());
+			m_savedBlocks = m_blocks.size();
+		}
+
+		// the keys are interned as they're restored, so nothing saved is
+		// dropped for not having been used yet.
+		if (saveSettings["metadataKeys"].is_array())
+		{
+			m_metadataKeys.restore(saveSettings["metadataKeys"]
+			                           .get<std::vector<std::string>>());
+			m_savedMetadataKeys = m_metadataKeys.size();
+		}
 	}
 }
 
@@ -148,6 +184,11 @@ const std::vector<std::string>& Save::getModList() const
 
 const nlohmann::json& Save::getSettings() const { return m_settings; }
 
+std::uint64_t Save::getSeed() const
+{
+	return m_settings.at("seed").get<std::uint64_t>();
+}
+
 void Save::toFile(const std::string& name)
 {
 	namespace fs = std::filesystem;
@@ -176,14 +217,7 @@ void Save::toFile(const std::string& name)
 			}
 			
 			// write new json file.
-			nlohmann::json saveSettings;
-			saveSettings["name"] = name;
-			saveSettings["mods"] = m_mods;
-			saveSettings["settings"] = m_settings;
-
-			std::ofstream json(m_savePath / (name + ".json"));
-			json << std::setw(4) << saveSettings;
-			json.close();
+			writeSettings(m_savePath / (name + ".json"));
 		}
 		else
 		{
@@ -191,14 +225,7 @@ void Save::toFile(const std::string& name)
 			fs::create_directory(m_savePath);
 
 			// write new json file.
-			nlohmann::json saveSettings;
-			saveSettings["name"]     = m_name;
-			saveSettings["mods"]     = m_mods;
-			saveSettings["settings"] = m_settings;
-
-			std::ofstream json(m_savePath / (m_name + ".json"));
-			json << std::setw(4) << saveSettings;
-			json.close();
+			writeSettings(m_savePath / (m_name + ".json"));
 		}
 	}
 	else
@@ -221,14 +248,7 @@ void Save::toFile(const std::string& name)
 		
 		if (m_settingsChanged)
 		{
-			nlohmann::json saveSettings;
-			saveSettings["name"] = name;
-			saveSettings["mods"] = m_mods;
-			saveSettings["settings"] = m_settings;
-
-			std::ofstream writeSettings(m_savePath);
-			writeSettings << std::setw(4) << saveSettings;
-			writeSettings.close();
+			writeSettings(m_savePath / (m_name + ".json"));
 		}
 	}
 
@@ -239,13 +259,79 @@ void Save::toFile(const std::string& name)
 	// we've already altered all the JSON's and paths, now save all dimensions
 	// (etc...). dimensions will need a function like this where the
 	// save/dimension name is "changeable".
+	for (auto& map : m_maps)
+	{
+		map.second.flush();
+	}
+
+	// the chunks just saved may have numbered new blocks or keys.
+	if (m_blocks.size() != m_savedBlocks ||
+	    m_metadataKeys.size() != m_savedMetadataKeys)
+	{
+		writeSettings(m_savePath / (m_name + ".json"));
+	}
+}
+
+void Save::writeSettings(const std::filesystem::path& path)
+{
+	const std::vector<std::string> blocks       = m_blocks.getNames();
+	const std::vector<std::string> metadataKeys = m_metadataKeys.getNames();
+
+	nlohmann::json saveSettings;
+	saveSettings["name"]         = m_name;
+	saveSettings["mods"]         = m_mods;
+	saveSettings["settings"]     = m_settings;
+	saveSettings["blocks"]       = blocks;
+	saveSettings["metadataKeys"] = metadataKeys;
+
+	std::ofstream json(path);
+	json << std::setw(4) << saveSettings;
+	json.close();
+
+	m_savedBlocks       = blocks.size();
+	m_savedMetadataKeys = metadataKeys.size();
 }
 
 voxels::Map* Save::getOrCreateMap(const std::string& name,
                                   voxels::BlockReferrer* referrer) {
     if (m_maps.find(name) == m_maps.end())
     {
-        m_maps.emplace(name,voxels::Map(&m_savePath, name, referrer));
+        // number every block up front, so chunks are never saved with an
+        // ID the JSON file doesn't have yet. The same goes for the metadata
+        // keys used so far, keys first used later are written out with the
+        // rest of the save.
+        for (const auto& block : referrer->blocks)
+        {
+            m_blocks.getID(&block.second);
+        }
+        for (std::size_t key = 0; key < MetadataKeys::size(); ++key)
+        {
+            m_metadataKeys.getID(static_cast<MetadataKeys::Key>(key));
+        }
+
+        if (m_blocks.size() != m_savedBlocks ||
+            m_metadataKeys.size() != m_savedMetadataKeys)
+        {
+            writeSettings(m_savePath / (m_name + ".json"));
+        }
+
+        // maps can't be moved once they exist, their workers point at them.
+        voxels::Map& map =
+            m_maps
+                .try_emplace(name, &m_savePath, name, referrer, &m_blocks,
+                             &m_metadataKeys)
+                .first->second;
+
+        // saves can trade saving speed for size.
+        codec::Options compression = codec::DISK;
+        if (m_settings.is_object() &&
+            m_settings["compressionLevel"].is_number_integer())
+        {
+            compression.level = m_settings["compressionLevel"].get<int>();
+        }
+        map.setCompression(compression);
     }
     return &m_maps.at(name);
-}
\ No newline at end of file
+}
+
+MetadataDictionary* Save::getMetadataKeys() { return &m_metadataKeys; }
@@ -0,0 +1,644 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Common/Utility/Codec.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <queue>
+#include <utility>
+
+using namespace phx;
+using namespace phx::codec;
+
+namespace
+{
+	// every frame starts with this, then the codec, the flags and the size
+	// of the data before compressing.
+	constexpr char        FRAME_MAGIC[4]  = {'P', 'H', 'X', 'Z'};
+	constexpr std::size_t HEADER_SIZE     = sizeof(FRAME_MAGIC) + 2 + 4;
+	constexpr std::uint8_t FLAG_DICTIONARY = 1;
+
+	// offsets are stored in 2 bytes, anything further back can't be copied.
+	constexpr std::size_t MIN_MATCH  = 4;
+	constexpr std::size_t MAX_OFFSET = 0xFFFF;
+	constexpr int         MAX_HASH_BITS = 15;
+
+	void writeU32(data::Data& out, std::uint32_t value)
+	{
+		for (int shift = 24; shift >= 0; shift -= 8)
+		{
+			out.push_back(std::byte((value >> shift) & 0xFF));
+		}
+	}
+
+	std::uint32_t readU32(const std::byte* in)
+	{
+		std::uint32_t value = 0;
+		for (int i = 0; i < 4; ++i)
+		{
+			value = (value << 8) | static_cast<std::uint8_t>(in[i]);
+		}
+		return value;
+	}
+
+	std::uint32_t load32(const std::byte* in)
+	{
+		std::uint32_t value;
+		std::memcpy(&value, in, sizeof(value));
+		return value;
+	}
+
+	std::uint32_t hash4(std::uint32_t value, int bits)
+	{
+		return (value * 2654435761u) >> (32 - bits);
+	}
+
+	// lengths that don't fit in their half of the token carry on in bytes of
+	// 255 until one is smaller.
+	void writeLength(data::Data& out, std::size_t length)
+	{
+		while (length >= 255)
+		{
+			out.push_back(std::byte {255});
+			length -= 255;
+		}
+		out.push_back(std::byte(length));
+	}
+
+	bool readLength(const std::byte*& in, const std::byte* end,
+	                std::size_t& length)
+	{
+		std::uint8_t byte;
+		do
+		{
+			if (in == end)
+			{
+				return false;
+			}
+			byte = static_cast<std::uint8_t>(*in++);
+			length += byte;
+		} while (byte == 255);
+		return true;
+	}
+
+	void writeSequence(data::Data& out, const std::byte* literals,
+	                   std::size_t literalCount, std::size_t offset,
+	                   std::size_t matchLength)
+	{
+		const std::size_t extra = matchLength - MIN_MATCH;
+		out.push_back(std::byte((std::min<std::size_t>(literalCount, 15) << 4) |
+		                        std::min<std::size_t>(extra, 15)));
+		if (literalCount >= 15)
+		{
+			writeLength(out, literalCount - 15);
+		}
+		out.insert(out.end(), literals, literals + literalCount);
+
+		out.push_back(std::byte(offset & 0xFF));
+		out.push_back(std::byte(offset >> 8));
+		if (extra >= 15)
+		{
+			writeLength(out, extra - 15);
+		}
+	}
+
+	void writeLastLiterals(data::Data& out, const std::byte* literals,
+	                       std::size_t literalCount)
+	{
+		out.push_back(
+		    std::byte(std::min<std::size_t>(literalCount, 15) << 4));
+		if (literalCount >= 15)
+		{
+			writeLength(out, literalCount - 15);
+		}
+		out.insert(out.end(), literals, literals + literalCount);
+	}
+
+	const Codec* findCodec(Type type)
+	{
+		static const StoreCodec store;
+		static const LZCodec    lz;
+
+		switch (type)
+		{
+		case Type::STORE:
+			return &store;
+		case Type::LZ:
+			return &lz;
+		}
+		return nullptr;
+	}
+} // namespace
+
+Dictionary::Dictionary(data::Data content) : m_content(std::move(content))
+{
+	// FNV-1a.
+	std::uint32_t hash = 2166136261u;
+	for (const std::byte byte : m_content)
+	{
+		hash = (hash ^ static_cast<std::uint8_t>(byte)) * 16777619u;
+	}
+	m_id = hash == 0 ? 1 : hash;
+
+	// only the end of the content can be reached from the data.
+	const std::size_t history = std::min(m_content.size(), MAX_OFFSET);
+	const std::byte*  src     = m_content.data() + m_content.size() - history;
+
+	m_head.assign(std::size_t(1) << MAX_HASH_BITS, -1);
+	m_chain.assign(history, -1);
+	for (std::size_t pos = 0; pos + MIN_MATCH <= history; ++pos)
+	{
+		const std::uint32_t h = hash4(load32(src + pos), MAX_HASH_BITS);
+		m_chain[pos]          = m_head[h];
+		m_head[h]             = static_cast<std::int32_t>(pos);
+	}
+}
+
+Dictionary Dictionary::train(const std::vector<data::Data>& samples,
+                             std::size_t                    size)
+{
+	// pieces of the samples are scored by how many samples the 8 byte
+	// strings in them show up in, then the best pieces are taken until the
+	// dictionary is full. strings are only counted once, so the same
+	// content isn't added twice.
+	constexpr std::size_t KMER    = 8;
+	constexpr std::size_t SEGMENT = 64;
+	constexpr std::size_t TABLE   = 1 << 20;
+
+	size = std::min(size, MAX_OFFSET);
+
+	auto kmerHash = [](const std::byte* in) {
+		std::uint64_t value;
+		std::memcpy(&value, in, sizeof(value));
+		return static_cast<std::size_t>((value * 0x9E3779B97F4A7C15ull) >> 44);
+	};
+
+	std::vector<std::uint32_t> counts(TABLE, 0);
+	std::vector<std::uint32_t> lastSample(TABLE, 0);
+	for (std::size_t s = 0; s < samples.size(); ++s)
+	{
+		const data::Data& sample = samples[s];
+		for (std::size_t i = 0; i + KMER <= sample.size(); ++i)
+		{
+			const std::size_t h = kmerHash(sample.data() + i);
+			if (lastSample[h] != s + 1)
+			{
+				lastSample[h] = static_cast<std::uint32_t>(s + 1);
+				++counts[h];
+			}
+		}
+	}
+
+	auto score = [&](const data::Data& sample, std::size_t offset) {
+		std::uint64_t total = 0;
+		const std::size_t end =
+		    std::min(offset + SEGMENT, sample.size()) - KMER + 1;
+		for (std::size_t i = offset; i < end; ++i)
+		{
+			total += counts[kmerHash(sample.data() + i)];
+		}
+		return total;
+	};
+
+	// (score, sample, offset), lazily rescored as strings are taken.
+	using Candidate = std::tuple<std::uint64_t, std::size_t, std::size_t>;
+	std::priority_queue<Candidate> candidates;
+	for (std::size_t s = 0; s < samples.size(); ++s)
+	{
+		for (std::size_t offset = 0; offset + KMER <= samples[s].size();
+		     offset += SEGMENT)
+		{
+			candidates.emplace(score(samples[s], offset), s, offset);
+		}
+	}
+
+	std::vector<std::pair<std::size_t, std::size_t>> chosen;
+	std::size_t                                      used = 0;
+	while (!candidates.empty() && used < size)
+	{
+		auto [oldScore, s, offset] = candidates.top();
+		candidates.pop();
+
+		const std::uint64_t newScore = score(samples[s], offset);
+		if (newScore == 0)
+		{
+			continue;
+		}
+		if (!candidates.empty() &&
+		    newScore < std::get<0>(candidates.top()))
+		{
+			candidates.emplace(newScore, s, offset);
+			continue;
+		}
+
+		const data::Data& sample = samples[s];
+		const std::size_t length =
+		    std::min({SEGMENT, sample.size() - offset, size - used});
+		for (std::size_t i = offset; i + KMER <= offset + length; ++i)
+		{
+			counts[kmerHash(sample.data() + i)] = 0;
+		}
+
+		chosen.emplace_back(s, offset);
+		used += length;
+	}
+
+	// the best pieces go last, closest to the data being compressed.
+	data::Data content;
+	content.reserve(used);
+	for (auto it = chosen.rbegin(); it != chosen.rend(); ++it)
+	{
+		const data::Data& sample = samples[it->first];
+		const std::size_t length = std::min(
+		    {SEGMENT, sample.size() - it->second, size - content.size()});
+		content.insert(content.end(), sample.begin() + it->second,
+		               sample.begin() + it->second + length);
+	}
+
+	return Dictionary(std::move(content));
+}
+
+void StoreCodec::compress(const std::byte* data, std::size_t size,
+                          const Dictionary* /*dictionary*/,
+                          data::Data&       out) const
+{
+	out.insert(out.end(), data, data + size);
+}
+
+bool StoreCodec::decompress(const std::byte* data, std::size_t size,
+                            std::size_t       rawSize,
+                            const Dictionary* /*dictionary*/,
+                            data::Data&       out) const
+{
+	if (size != rawSize)
+	{
+		return false;
+	}
+
+	out.insert(out.end(), data, data + size);
+	return true;
+}
+
+LZCodec::LZCodec(int level)
+    : m_level(std::clamp(level, MIN_LEVEL, MAX_LEVEL))
+{
+}
+
+void LZCodec::compress(const std::byte* data, std::size_t size,
+                       const Dictionary* dictionary, data::Data& out) const
+{
+	// with a dictionary, matches can point into it as if it came right
+	// before the data.
+	data::Data       window;
+	const std::byte* src   = data;
+	std::size_t      begin = 0;
+	if (dictionary != nullptr && !dictionary->getContent().empty())
+	{
+		const data::Data& content = dictionary->getContent();
+		const std::size_t history = std::min(content.size(), MAX_OFFSET);
+
+		window.reserve(history + size);
+		window.insert(window.end(), content.end() - history, content.end());
+		window.insert(window.end(), data, data + size);
+		src   = window.data();
+		begin = history;
+	}
+	const std::size_t end = begin + size;
+
+	if (size < MIN_MATCH)
+	{
+		writeLastLiterals(out, src + begin, size);
+		return;
+	}
+
+	// the last place every 4 bytes were seen, and for higher levels the
+	// place before that, and so on.
+	// the table only needs to be about as big as the data, clearing a big
+	// table would take longer than compressing a small chunk.
+	int hashBits = 10;
+	while (hashBits < MAX_HASH_BITS && (std::size_t(1) << hashBits) < end)
+	{
+		++hashBits;
+	}
+
+	const std::size_t         attempts = std::size_t(1) << (m_level - 1);
+	std::vector<std::int32_t> head;
+	std::vector<std::int32_t> chain(attempts > 1 ? end : 0, -1);
+	if (begin > 0)
+	{
+		// the dictionary has already been through the table.
+		hashBits = MAX_HASH_BITS;
+		head     = dictionary->m_head;
+		if (!chain.empty())
+		{
+			std::copy(dictionary->m_chain.begin(), dictionary->m_chain.end(),
+			          chain.begin());
+		}
+	}
+	else
+	{
+		head.assign(std::size_t(1) << hashBits, -1);
+	}
+
+	auto insert = [&](std::size_t pos) {
+		const std::uint32_t h = hash4(load32(src + pos), hashBits);
+		if (!chain.empty())
+		{
+			chain[pos] = head[h];
+		}
+		head[h] = static_cast<std::int32_t>(pos);
+	};
+
+	const std::size_t last   = end - MIN_MATCH;
+	std::size_t       anchor = begin;
+	std::size_t       pos    = begin;
+	while (pos <= last)
+	{
+		const std::uint32_t current = load32(src + pos);
+
+		std::size_t  bestLength = 0;
+		std::size_t  bestOffset = 0;
+		std::int32_t candidate  = head[hash4(current, hashBits)];
+		for (std::size_t tries = 0; tries < attempts && candidate >= 0 &&
+		                            pos - candidate <= MAX_OFFSET;
+		     ++tries)
+		{
+			if (load32(src + candidate) == current)
+			{
+				std::size_t length = MIN_MATCH;
+				while (pos + length < end &&
+				       src[candidate + length] == src[pos + length])
+				{
+					++length;
+				}
+
+				if (length > bestLength)
+				{
+					bestLength = length;
+					bestOffset = pos - candidate;
+					if (pos + length == end)
+					{
+						break;
+					}
+				}
+			}
+
+			candidate = chain.empty() ? -1 : chain[candidate];
+		}
+
+		insert(pos);
+
+		if (bestLength == 0)
+		{
+			// skip ahead faster the longer nothing has matched, so data
+			// that doesn't compress doesn't take long either.
+			pos += 1 + ((pos - anchor) >> 6);
+			continue;
+		}
+
+		writeSequence(out, src + anchor, pos - anchor, bestOffset,
+		              bestLength);
+
+		// only the end of the match is worth remembering at low levels.
+		const std::size_t matchEnd = pos + bestLength;
+		for (std::size_t i = chain.empty() ? matchEnd - 2 : pos + 1;
+		     i < matchEnd && i <= last; ++i)
+		{
+			insert(i);
+		}
+
+		pos    = matchEnd;
+		anchor = pos;
+	}
+
+	writeLastLiterals(out, src + anchor, end - anchor);
+}
+
+std::size_t LZCodec::getMaxRawSize(std::size_t size) const
+{
+	// a length byte adds at most 255 bytes, nothing else adds more.
+	return size * 255;
+}
+
+bool LZCodec::decompress(const std::byte* data, std::size_t size,
+                         std::size_t rawSize, const Dictionary* dictionary,
+                         data::Data& out) const
+{
+	if (rawSize > getMaxRawSize(size))
+	{
+		return false;
+	}
+
+	// the dictionary goes in front of the output, so copies can reach back
+	// into it, and is cut off at the end.
+	data::Data  window;
+	data::Data* target = &out;
+	std::size_t begin  = out.size();
+	if (dictionary != nullptr && !dictionary->getContent().empty())
+	{
+		const data::Data& content = dictionary->getContent();
+		const std::size_t history = std::min(content.size(), MAX_OFFSET);
+
+		window.reserve(history + rawSize);
+		window.insert(window.end(), content.end() - history, content.end());
+		target = &window;
+		begin  = history;
+	}
+	target->resize(begin + rawSize);
+
+	// copies can't reach back into whatever was in out before.
+	const std::size_t history = target == &window ? begin : 0;
+	std::byte*        base    = target->data() + begin - history;
+	std::byte*        op      = target->data() + begin;
+	std::byte* const  opEnd   = op + rawSize;
+
+	const std::byte*       ip    = data;
+	const std::byte* const ipEnd = data + size;
+	while (ip < ipEnd)
+	{
+		const auto token = static_cast<std::uint8_t>(*ip++);
+
+		std::size_t literals = token >> 4;
+		if (literals == 15 && !readLength(ip, ipEnd, literals))
+		{
+			return false;
+		}
+		if (literals > std::size_t(ipEnd - ip) ||
+		    literals > std::size_t(opEnd - op))
+		{
+			return false;
+		}
+		std::memcpy(op, ip, literals);
+		op += literals;
+		ip += literals;
+
+		// the last sequence is only literals.
+		if (ip == ipEnd)
+		{
+			break;
+		}
+
+		if (ipEnd - ip < 2)
+		{
+			return false;
+		}
+		const std::size_t offset = static_cast<std::uint8_t>(ip[0]) |
+		                           (static_cast<std::uint8_t>(ip[1]) << 8);
+		ip += 2;
+
+		std::size_t length = token & 15;
+		if (length == 15 && !readLength(ip, ipEnd, length))
+		{
+			return false;
+		}
+		length += MIN_MATCH;
+
+		if (offset == 0 || offset > std::size_t(op - base) ||
+		    length > std::size_t(opEnd - op))
+		{
+			return false;
+		}
+
+		const std::byte* match = op - offset;
+		if (offset >= length)
+		{
+			std::memcpy(op, match, length);
+			op += length;
+		}
+		else
+		{
+			// the copy overlaps what it's writing, a run of the last
+			// offset bytes.
+			for (std::size_t i = 0; i < length; ++i)
+			{
+				*op++ = match[i];
+			}
+		}
+	}
+
+	if (op != opEnd)
+	{
+		return false;
+	}
+
+	if (target == &window)
+	{
+		out.insert(out.end(), window.begin() + begin, window.end());
+	}
+	return true;
+}
+
+data::Data codec::compress(const std::byte* data, std::size_t size,
+                           const Options& options)
+{
+	const Dictionary* dictionary = options.dictionary.get();
+
+	data::Data frame;
+	frame.reserve(HEADER_SIZE + 4 + size);
+	for (const char c : FRAME_MAGIC)
+	{
+		frame.push_back(std::byte(c));
+	}
+	frame.push_back(std::byte(options.type));
+	frame.push_back(std::byte(dictionary != nullptr ? FLAG_DICTIONARY : 0));
+	writeU32(frame, static_cast<std::uint32_t>(size));
+	if (dictionary != nullptr)
+	{
+		writeU32(frame, dictionary->getID());
+	}
+
+	const std::size_t payload = frame.size();
+	if (options.type == Type::LZ)
+	{
+		LZCodec(options.level).compress(data, size, dictionary, frame);
+	}
+	else
+	{
+		StoreCodec().compress(data, size, dictionary, frame);
+	}
+
+	if (options.type != Type::STORE && frame.size() - payload >= size)
+	{
+		// it didn't help, store it as it is so reading it back is quick.
+		return compress(data, size, {Type::STORE, 0, nullptr});
+	}
+
+	return frame;
+}
+
+bool codec::isCompressed(const std::byte* data, std::size_t size)
+{
+	return size >= HEADER_SIZE &&
+	       std::memcmp(data, FRAME_MAGIC, sizeof(FRAME_MAGIC)) == 0;
+}
+
+bool codec::decompress(const std::byte* data, std::size_t size,
+                       data::Data& out, const Dictionary* dictionary)
+{
+	out.clear();
+	if (!isCompressed(data, size))
+	{
+		return false;
+	}
+
+	const auto          type    = static_cast<Type>(data[4]);
+	const auto          flags   = static_cast<std::uint8_t>(data[5]);
+	const std::uint32_t rawSize = readU32(data + 6);
+
+	std::size_t offset = HEADER_SIZE;
+	if ((flags & FLAG_DICTIONARY) != 0)
+	{
+		if (size < offset + 4 || dictionary == nullptr ||
+		    dictionary->getID() != readU32(data + offset))
+		{
+			return false;
+		}
+		offset += 4;
+	}
+	else
+	{
+		dictionary = nullptr;
+	}
+
+	const Codec* codec = findCodec(type);
+	if (codec == nullptr)
+	{
+		return false;
+	}
+
+	// the header can't be trusted for how much to allocate.
+	if (rawSize > codec->getMaxRawSize(size - offset))
+	{
+		return false;
+	}
+
+	out.reserve(rawSize);
+	return codec->decompress(data + offset, size - offset, rawSize,
+	                         dictionary, out);
+}
@@ -0,0 +1,248 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Common/CoreIntrinsics.hpp>
+#include <Common/Utility/MappedFile.hpp>
+
+#ifdef ENGINE_PLATFORM_WINDOWS
+#	include <Windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <vector>
+
+using namespace phx;
+
+MappedFile::~MappedFile() { close(); }
+
+bool MappedFile::open(const std::filesystem::path& path)
+{
+	close();
+
+#ifdef ENGINE_PLATFORM_WINDOWS
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ,
+	                          FILE_SHARE_READ | FILE_SHARE_WRITE |
+	                              FILE_SHARE_DELETE,
+	                          nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+	                          nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	m_file   = file;
+	m_size   = static_cast<std::size_t>(size.QuadPart);
+	m_opened = true;
+
+	// empty files can't be mapped, but there's nothing to read anyway.
+	if (m_size == 0)
+	{
+		return true;
+	}
+
+	m_mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0,
+	                               nullptr);
+	if (m_mapping != nullptr)
+	{
+		m_data = static_cast<const std::byte*>(
+		    MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+	}
+#else
+	const int file = ::open(path.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(file, &info) != 0)
+	{
+		::close(file);
+		return false;
+	}
+
+	m_size   = static_cast<std::size_t>(info.st_size);
+	m_opened = true;
+
+	if (m_size != 0)
+	{
+		void* data = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, file, 0);
+		if (data != MAP_FAILED)
+		{
+			m_data = static_cast<const std::byte*>(data);
+		}
+	}
+
+	// the mapping keeps the file open by itself.
+	::close(file);
+#endif
+
+	if (m_size != 0 && m_data == nullptr)
+	{
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void MappedFile::close()
+{
+#ifdef ENGINE_PLATFORM_WINDOWS
+	if (m_data != nullptr)
+	{
+		UnmapViewOfFile(m_data);
+	}
+	if (m_mapping != nullptr)
+	{
+		CloseHandle(m_mapping);
+	}
+	if (m_file != nullptr)
+	{
+		CloseHandle(m_file);
+	}
+#else
+	if (m_data != nullptr)
+	{
+		munmap(const_cast<std::byte*>(m_data), m_size);
+	}
+#endif
+
+	m_data    = nullptr;
+	m_size    = 0;
+	m_opened  = false;
+	m_file    = nullptr;
+	m_mapping = nullptr;
+}
+
+void MappedFile::advise(Access access) const
+{
+#ifndef ENGINE_PLATFORM_WINDOWS
+	if (m_data == nullptr)
+	{
+		return;
+	}
+
+	int advice = MADV_NORMAL;
+	switch (access)
+	{
+	case Access::SEQUENTIAL:
+		advice = MADV_SEQUENTIAL;
+		break;
+	case Access::RANDOM:
+		advice = MADV_RANDOM;
+		break;
+	default:
+		break;
+	}
+
+	madvise(const_cast<std::byte*>(m_data), m_size, advice);
+#else
+	(void) access;
+#endif
+}
+
+void MappedFile::prefetch(std::size_t offset, std::size_t size) const
+{
+#ifndef ENGINE_PLATFORM_WINDOWS
+	if (m_data == nullptr || offset >= m_size)
+	{
+		return;
+	}
+
+	// madvise wants the start to be aligned to a page.
+	const std::size_t page  = getPageSize();
+	const std::size_t start = offset - offset % page;
+	const std::size_t end   = std::min(offset + size, m_size);
+
+	madvise(const_cast<std::byte*>(m_data) + start, end - start,
+	        MADV_WILLNEED);
+#else
+	// PrefetchVirtualMemory isn't available on every version we support.
+	(void) offset;
+	(void) size;
+#endif
+}
+
+std::size_t MappedFile::getResidentPages(std::size_t offset,
+                                         std::size_t size) const
+{
+	if (m_data == nullptr || offset >= m_size)
+	{
+		return 0;
+	}
+
+	const std::size_t page  = getPageSize();
+	const std::size_t start = offset - offset % page;
+	const std::size_t end   = std::min(offset + size, m_size);
+	const std::size_t pages = (end - start + page - 1) / page;
+
+#ifndef ENGINE_PLATFORM_WINDOWS
+#	ifdef ENGINE_PLATFORM_APPLE
+	std::vector<char> resident(pages);
+#	else
+	std::vector<unsigned char> resident(pages);
+#	endif
+	if (mincore(const_cast<std::byte*>(m_data) + start, end - start,
+	            resident.data()) != 0)
+	{
+		return pages;
+	}
+
+	return static_cast<std::size_t>(
+	    std::count_if(resident.begin(), resident.end(),
+	                  [](auto flags) { return (flags & 1) != 0; }));
+#else
+	return pages;
+#endif
+}
+
+std::size_t MappedFile::getPageSize()
+{
+#ifdef ENGINE_PLATFORM_WINDOWS
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return static_cast<std::size_t>(info.dwPageSize);
+#else
+	static const std::size_t size =
+	    static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+	return size;
+#endif
+}
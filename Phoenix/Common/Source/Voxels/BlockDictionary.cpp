@@ -0,0 +1,114 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Common/Voxels/BlockDictionary.hpp>
+
+using namespace phx::voxels;
+
+BlockDictionary::ID BlockDictionary::getID(const BlockType* type)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (type->uid < m_byUid.size() && m_byUid[type->uid] >= 0)
+	{
+		return static_cast<ID>(m_byUid[type->uid]);
+	}
+
+	ID   id;
+	auto it = m_ids.find(type->id);
+	if (it != m_ids.end())
+	{
+		id = it->second;
+	}
+	else
+	{
+		id = static_cast<ID>(m_names.size());
+		m_names.push_back(type->id);
+		m_ids.emplace(type->id, id);
+	}
+
+	if (type->uid >= m_byUid.size())
+	{
+		m_byUid.resize(type->uid + 1, -1);
+	}
+	m_byUid[type->uid] = id;
+
+	return id;
+}
+
+BlockType* BlockDictionary::getType(ID id, BlockReferrer* referrer) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (id >= m_names.size())
+	{
+		return referrer->blocks.get(BlockType::UNKNOWN_BLOCK);
+	}
+
+	if (referrer != m_typesReferrer)
+	{
+		m_types.clear();
+		m_typesReferrer = referrer;
+	}
+	if (id >= m_types.size())
+	{
+		m_types.resize(m_names.size(), nullptr);
+	}
+
+	BlockType*& type = m_types[id];
+	if (type == nullptr)
+	{
+		type = referrer->getByID(m_names[id]);
+	}
+	return type;
+}
+
+std::vector<std::string> BlockDictionary::getNames() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_names;
+}
+
+void BlockDictionary::restore(const std::vector<std::string>& names)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_names = names;
+	m_ids.clear();
+	m_byUid.clear();
+	m_types.clear();
+	for (std::size_t i = 0; i < m_names.size(); ++i)
+	{
+		m_ids.emplace(m_names[i], static_cast<ID>(i));
+	}
+}
+
+std::size_t BlockDictionary::size() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_names.size();
+}
@@ -26,16 +26,60 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
-#include <Common/Input.hpp>
+#include <Common/Voxels/BlockProperties.hpp>
 
-phx::Serializer& phx::InputState::operator>>(Serializer& serializer) const
-{
-	return serializer << forward << backward << left << right << up << down
-	                  << rotation.x << rotation.y << sequence;
-}
+#include <algorithm>
+
+using namespace phx::voxels;
 
-phx::Serializer& phx::InputState::operator<<(Serializer& serializer)
+void BlockProperties::build(const Registry<std::size_t, BlockType>& blocks)
 {
-	return serializer >> forward >> backward >> left >> right >> up >> down >>
-	       rotation.x >> rotation.y >> sequence;
+	std::size_t count = BlockType::UNKNOWN_BLOCK + 1;
+	for (const auto entry : blocks)
+	{
+		count = std::max(count, entry.first + 1);
+	}
+
+	const BlockType* unknown = blocks.get(BlockType::UNKNOWN_BLOCK);
+
+	m_categories.assign(count, BlockCategory::AIR);
+	m_flags.assign(count, 0);
+	for (std::size_t uid = 0; uid < count; ++uid)
+	{
+		// gaps in the UIDs act like the unknown block.
+		const BlockType* type = blocks.get(uid);
+		if (type == nullptr)
+		{
+			type = unknown;
+		}
+
+		if (type == nullptr)
+		{
+			continue;
+		}
+
+		std::uint8_t flags = 0;
+		if (type->category == BlockCategory::SOLID)
+		{
+			flags |= SOLID;
+			if (type->opaque)
+				flags |= OPAQUE;
+		}
+		if (type->rotH)
+			flags |= ROTATE_H;
+		if (type->rotV)
+			flags |= ROTATE_V;
+		if (type->onPlace)
+			flags |= ON_PLACE;
+		if (type->onBreak)
+			flags |= ON_BREAK;
+		if (type->onInteract)
+			flags |= ON_INTERACT;
+
+		m_categories[uid] = type->category;
+		m_flags[uid]      = flags;
+	}
+
+	m_unknownCategory = m_categories[BlockType::UNKNOWN_BLOCK];
+	m_unknownFlags    = m_flags[BlockType::UNKNOWN_BLOCK];
 }
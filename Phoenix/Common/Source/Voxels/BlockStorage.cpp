@@ -0,0 +1,280 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Common/Voxels/BlockStorage.hpp>
+
+#include <algorithm>
+
+using namespace phx::voxels;
+
+namespace
+{
+	// the amount of palette entries an index of a given width can address.
+	std::size_t capacityOf(std::size_t bitsShift)
+	{
+		return std::size_t(1) << (std::size_t(1) << bitsShift);
+	}
+
+	// the amount of palette entries a storage can hold without having to
+	// repack it.
+	std::size_t capacityOf(std::size_t bitsShift, bool uniform)
+	{
+		return uniform ? 1 : capacityOf(bitsShift);
+	}
+
+	// the smallest width (as log2 of bits) that can address an amount of
+	// palette entries.
+	std::size_t requiredShift(std::size_t paletteSize)
+	{
+		std::size_t shift = 0;
+		while (capacityOf(shift) < paletteSize)
+		{
+			++shift;
+		}
+
+		return shift;
+	}
+} // namespace
+
+BlockStorage::BlockStorage(std::size_t size, BlockType* fill)
+    : m_size(size), m_palette {fill},
+      m_references {static_cast<std::uint32_t>(size)}, m_paletteUsed(1)
+{
+	setWidth(MIN_BITS_SHIFT);
+}
+
+void BlockStorage::set(std::size_t index, std::size_t count, BlockType* type)
+{
+	if (count == 0 || (isUniform() && m_palette.front() == type))
+	{
+		return;
+	}
+
+	if (index == 0 && count >= m_size)
+	{
+		fill(type);
+		return;
+	}
+
+	const std::size_t paletteIndex = findOrAdd(type);
+
+	bool freedEntry = false;
+	for (std::size_t i = index; i < index + count; ++i)
+	{
+		const std::size_t old = getPaletteIndex(i);
+		if (old == paletteIndex)
+		{
+			continue;
+		}
+
+		write(i, paletteIndex);
+		++m_references[paletteIndex];
+
+		if (--m_references[old] == 0)
+		{
+			// nothing uses this type anymore, free up the entry so it can be
+			// reused.
+			m_palette[old] = nullptr;
+			--m_paletteUsed;
+			freedEntry     = true;
+		}
+	}
+
+	if (!freedEntry)
+	{
+		return;
+	}
+
+	if (m_paletteUsed == 1)
+	{
+		// only one type left, drop the indices completely.
+		const auto last = std::find_if(
+		    m_palette.begin(), m_palette.end(),
+		    [](const BlockType* entry) { return entry != nullptr; });
+
+		fill(*last);
+	}
+	else if (requiredShift(m_paletteUsed * 2) < m_bitsShift)
+	{
+		// only shrink if the palette would still have room to double after
+		// shrinking, otherwise a block being placed and broken repeatedly on
+		// the boundary would repack the storage every single time.
+		repack(std::max(requiredShift(m_paletteUsed), MIN_BITS_SHIFT));
+	}
+}
+
+void BlockStorage::fill(BlockType* type)
+{
+	m_palette.assign(1, type);
+	m_references.assign(1, static_cast<std::uint32_t>(m_size));
+	m_paletteUsed = 1;
+	m_lastIndex   = 0;
+
+	m_data.clear();
+	m_data.shrink_to_fit();
+	setWidth(MIN_BITS_SHIFT);
+}
+
+void BlockStorage::unpack(BlockType** out) const
+{
+	if (isUniform())
+	{
+		std::fill(out, out + m_size, m_palette.front());
+		return;
+	}
+
+	const std::size_t perWord = m_indexMask + 1;
+	const std::size_t bits    = getBitsPerBlock();
+
+	for (std::size_t w = 0; w < m_data.size(); ++w)
+	{
+		std::uint64_t     word  = m_data[w];
+		const std::size_t begin = w * perWord;
+		const std::size_t end   = std::min(begin + perWord, m_size);
+
+		for (std::size_t i = begin; i < end; ++i)
+		{
+			out[i] = m_palette[static_cast<std::size_t>(word & m_valueMask)];
+			word >>= bits;
+		}
+	}
+}
+
+std::size_t BlockStorage::getMemoryUsage() const
+{
+	return m_data.capacity() * sizeof(std::uint64_t) +
+	       m_palette.capacity() * sizeof(BlockType*) +
+	       m_references.capacity() * sizeof(std::uint32_t);
+}
+
+std::size_t BlockStorage::findOrAdd(BlockType* type)
+{
+	// blocks tend to be set in batches of the same type, so check the last
+	// type we looked up before searching the whole palette.
+	if (m_lastIndex < m_palette.size() && m_palette[m_lastIndex] == type)
+	{
+		return m_lastIndex;
+	}
+
+	std::size_t freeEntry = m_palette.size();
+	for (std::size_t i = 0; i < m_palette.size(); ++i)
+	{
+		if (m_palette[i] == type)
+		{
+			m_lastIndex = i;
+			return i;
+		}
+
+		if (m_palette[i] == nullptr && freeEntry == m_palette.size())
+		{
+			freeEntry = i;
+		}
+	}
+
+	++m_paletteUsed;
+
+	if (freeEntry != m_palette.size())
+	{
+		m_palette[freeEntry] = type;
+		m_lastIndex          = freeEntry;
+		return freeEntry;
+	}
+
+	if (m_palette.size() == capacityOf(m_bitsShift, isUniform()))
+	{
+		// repacking compacts the palette, but since there were no free
+		// entries the palette still stays full and we can just append. A
+		// uniform storage gets its indices for the first time.
+		repack(isUniform() ? MIN_BITS_SHIFT : m_bitsShift + 1);
+	}
+
+	m_palette.push_back(type);
+	m_references.push_back(0);
+
+	m_lastIndex = m_palette.size() - 1;
+	return m_lastIndex;
+}
+
+void BlockStorage::repack(std::size_t bitsShift)
+{
+	bitsShift = std::min(bitsShift, MAX_BITS_SHIFT);
+
+	// compact the palette, dropping every entry that isn't used anymore.
+	std::vector<std::size_t> remap(m_palette.size(), 0);
+
+	Palette                    palette;
+	std::vector<std::uint32_t> references;
+	palette.reserve(m_paletteUsed);
+	references.reserve(m_paletteUsed);
+
+	for (std::size_t i = 0; i < m_palette.size(); ++i)
+	{
+		if (m_references[i] != 0)
+		{
+			remap[i] = palette.size();
+			palette.push_back(m_palette[i]);
+			references.push_back(m_references[i]);
+		}
+	}
+
+	std::vector<std::uint64_t> oldData      = std::move(m_data);
+	const std::size_t          oldBitsShift = m_bitsShift;
+	const std::size_t          oldWordShift = m_wordShift;
+	const std::size_t          oldIndexMask = m_indexMask;
+	const std::uint64_t        oldValueMask = m_valueMask;
+
+	setWidth(bitsShift);
+	m_data.assign((m_size + m_indexMask) >> m_wordShift, 0);
+
+	// a uniform storage has no indices, every block was the first entry.
+	if (!oldData.empty())
+	{
+		for (std::size_t i = 0; i < m_size; ++i)
+		{
+			const std::uint64_t word = oldData[i >> oldWordShift];
+			const std::size_t   bit  = (i & oldIndexMask) << oldBitsShift;
+
+			write(i, remap[static_cast<std::size_t>((word >> bit) &
+			                                        oldValueMask)]);
+		}
+	}
+
+	m_palette    = std::move(palette);
+	m_references = std::move(references);
+	m_lastIndex  = 0;
+}
+
+void BlockStorage::setWidth(std::size_t bitsShift)
+{
+	const std::size_t bits = std::size_t(1) << bitsShift;
+
+	m_bitsShift = bitsShift;
+	m_wordShift = 6 - bitsShift;
+	m_indexMask = (std::size_t(64) >> bitsShift) - 1;
+	m_valueMask = (std::uint64_t(1) << bits) - 1;
+}
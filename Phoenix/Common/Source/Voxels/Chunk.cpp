@@ -28,97 +28,116 @@
 
 #include <Common/Logger.hpp>
 #include <Common/Voxels/Chunk.hpp>
+#include <Common/Voxels/Map.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <utility>
 
 using namespace phx::voxels;
 
-Chunk::Chunk(const phx::math::vec3& chunkPos, BlockReferrer* referrer)
-    : m_pos(chunkPos), m_referrer(referrer)
+namespace
 {
-	m_blocks.reserve(CHUNK_WIDTH * CHUNK_HEIGHT * CHUNK_DEPTH);
-}
+	// starts every chunk written by Chunk::save. Older saves start with the
+	// position of the chunk instead, a float that can't have these bytes.
+	constexpr char SAVE_MAGIC[4] = {'P', 'H', 'X', 'C'};
+} // namespace
 
-phx::math::vec3   Chunk::getChunkPos() const { return m_pos; }
-Chunk::BlockList& Chunk::getBlocks() { return m_blocks; }
+Chunk::Data::Data(BlockType* fill, const BlockProperties& properties)
+    : blocks(CHUNK_MAX_BLOCKS, fill)
+{
+	solid.fill(properties.isSolid(fill->uid));
+	opaque.fill(properties.isOpaque(fill->uid));
+}
 
-Block Chunk::getBlockAt(std::size_t index)
+const phx::Metadata* Chunk::Data::findMetadata(std::size_t index) const
 {
-	if (index < CHUNK_MAX_BLOCKS)
+	auto it = std::lower_bound(
+	    metadata.begin(), metadata.end(), index,
+	    [](const auto& entry, std::size_t i) { return entry.first < i; });
+	if (it != metadata.end() && it->first == index)
 	{
-		if (m_metadata.find(index) != m_metadata.end())
-		{
-			return {m_blocks[index], &m_metadata.at(index)};
-		}
-		return {m_blocks[index], nullptr};
+		return &it->second;
 	}
-
-	return {m_referrer->blocks.get(BlockType::OUT_OF_BOUNDS_BLOCK), nullptr};
+	return nullptr;
 }
 
-Block Chunk::getBlockAt(const phx::math::vec3& position)
+void Chunk::Data::rebuildMasks(const BlockProperties& properties)
 {
-	return getBlockAt(getVectorIndex(position));
-}
+	if (blocks.isUniform())
+	{
+		const std::size_t uid = blocks.get(0)->uid;
+		solid.fill(properties.isSolid(uid));
+		opaque.fill(properties.isOpaque(uid));
+		return;
+	}
 
-void Chunk::setBlockAt(const phx::math::vec3& position, Block newBlock)
-{
-	if (position.x < CHUNK_WIDTH && position.y < CHUNK_HEIGHT &&
-	    position.z < CHUNK_DEPTH)
+	// work out the bits once per palette entry rather than once per block.
+	const BlockStorage::Palette& palette = blocks.getPalette();
+	std::vector<std::uint8_t>    flags(palette.size(), 0);
+	for (std::size_t p = 0; p < palette.size(); ++p)
 	{
-		Block oldBlock = getBlockAt(position);
-		if (oldBlock.type->onBreak)
-		{
-			oldBlock.type->onBreak(position);
-		}
-		m_blocks[getVectorIndex(position)] = newBlock.type;
-		if (newBlock.metadata != nullptr)
-		{
-			m_metadata[getVectorIndex(position)] = *newBlock.metadata;
-		}
-		if (newBlock.type->onPlace)
+		if (palette[p] != nullptr && properties.isSolid(palette[p]->uid))
 		{
-			newBlock.type->onPlace(position);
+			flags[p] = properties.isOpaque(palette[p]->uid) ? 3 : 1;
 		}
 	}
-}
 
-/**
- * @TODO Should we return a tuple with an error type here? There are two things
- * that could go wrong either the block is OOB or the metadata type is invalid.
- * Or should we just assert on the second error?
- */
-bool Chunk::setMetadataAt(const phx::math::vec3& position,
-                          const std::string& key, std::any* newData)
-{
-	if (position.x < CHUNK_WIDTH && position.y < CHUNK_HEIGHT &&
-	    position.z < CHUNK_DEPTH)
+	Mask::Words& solidWords  = solid.getWords();
+	Mask::Words& opaqueWords = opaque.getWords();
+	for (std::size_t w = 0; w < solidWords.size(); ++w)
 	{
-		return m_metadata[getVectorIndex(position)].set(key, newData);
+		std::uint64_t solidWord  = 0;
+		std::uint64_t opaqueWord = 0;
+		for (std::size_t b = 0; b < 64; ++b)
+		{
+			const std::uint8_t f = flags[blocks.getPaletteIndex(w * 64 + b)];
+			solidWord |= std::uint64_t(f & 1) << b;
+			opaqueWord |= std::uint64_t(f >> 1) << b;
+		}
+		solidWords[w]  = solidWord;
+		opaqueWords[w] = opaqueWord;
 	}
-	return false;
 }
 
-bool Chunk::canRepeat(std::size_t i) const
+bool Chunk::Data::canRepeat(std::size_t i) const
 {
 	if (i + 1 >= CHUNK_MAX_BLOCKS)
 		return false;
-	if (m_blocks[i + 1]->id != m_blocks[i]->id)
+	// blocks of the same type always share a palette index.
+	if (blocks.getPaletteIndex(i + 1) != blocks.getPaletteIndex(i))
 		return false;
-	if (m_metadata.find(i + 1) != m_metadata.end())
+	if (findMetadata(i + 1) != nullptr)
 		return false;
 	return true;
 };
 
-phx::Serializer& Chunk::operator>>(phx::Serializer& ser) const
+void Chunk::Data::write(phx::Serializer& ser, MetadataDictionary* keys) const
 {
+	if (blocks.isUniform() && metadata.empty())
+	{
+		// this is the same as what the loop below would write, a single run
+		// covering the whole chunk, without checking every block.
+		ser << blocks.get(0)->id << '*'
+		    << static_cast<std::size_t>(CHUNK_MAX_BLOCKS - 1);
+		return;
+	}
 
-	ser << m_pos.x << m_pos.y << m_pos.z;
-	for (int i = 0; i < CHUNK_MAX_BLOCKS; i++)
-	// for (const BlockType* block : m_blocks)
+	for (std::size_t i = 0; i < CHUNK_MAX_BLOCKS; i++)
 	{
-		ser << m_blocks[i]->id;
-		if (m_metadata.find(i) != m_metadata.end())
+		ser << blocks.get(i)->id;
+		if (const Metadata* data = findMetadata(i))
 		{
-			ser << '+' << m_metadata.at(i);
+			if (keys != nullptr)
+			{
+				ser << '#';
+				keys->write(ser, *data);
+			}
+			else
+			{
+				ser << '+' << *data;
+			}
 		}
 		else if (canRepeat(i))
 		{
@@ -134,44 +153,672 @@ phx::Serializer& Chunk::operator>>(phx::Serializer& ser) const
 			ser << ';';
 		}
 	}
-	return ser;
 }
 
-phx::Serializer& Chunk::operator<<(phx::Serializer& ser)
+bool Chunk::Data::read(phx::Reader& ser, BlockReferrer* referrer,
+                       const MetadataDictionary* keys)
 {
-	m_blocks.clear();
-	m_blocks.reserve(4096);
+	blocks =
+	    BlockStorage(CHUNK_MAX_BLOCKS, referrer->blocks.get(BlockType::AIR_BLOCK));
+	metadata.clear();
 
-	ser >> m_pos.x >> m_pos.y >> m_pos.z;
-	for (int i = 0; i < CHUNK_MAX_BLOCKS; i++)
+	for (std::size_t i = 0; i < CHUNK_MAX_BLOCKS;)
 	{
 		std::string id;
 		ser >> id;
-		m_blocks.push_back(
-		    m_referrer->blocks.get(*m_referrer->referrer.get(id)));
+		if (!ser)
+		{
+			rebuildMasks(referrer->properties);
+			return false;
+		}
+
+		BlockType* type = referrer->blocks.get(*referrer->referrer.get(id));
+
+		// the amount of blocks this entry covers.
+		std::size_t count = 1;
+
 		char c;
 		ser >> c;
 		if (c == ';')
 		{
 		}
-		else if (c == '+')
+		else if (c == '+' && keys == nullptr)
 		{
 			Metadata data;
 			ser >> data;
-			m_metadata[i] = data;
+			metadata.emplace_back(i, std::move(data));
+		}
+		else if (c == '#' && keys != nullptr)
+		{
+			Metadata data;
+			keys->read(ser, data);
+			metadata.emplace_back(i, std::move(data));
+		}
+		else if (c == '+' || c == '#')
+		{
+			// names where IDs were expected would intern whatever was sent,
+			// IDs where names were expected mean nothing.
+			ser.fail();
 		}
 		else if (c == '*')
 		{
 			std::size_t rep;
 			ser >> rep;
-			for (std::size_t j = 0; j < rep; j++)
+			count += std::min(rep, CHUNK_MAX_BLOCKS - i - 1);
+		}
+
+		// the whole run is written at once rather than looking the type up
+		// for every repeated block.
+		blocks.set(i, count, type);
+		i += count;
+	}
+
+	rebuildMasks(referrer->properties);
+	return static_cast<bool>(ser);
+}
+
+void Chunk::Data::save(phx::Serializer& ser, BlockDictionary& dictionary,
+                       MetadataDictionary& keys) const
+{
+	// only the types actually used are listed, in the order they're first
+	// seen, so the saved palette has no holes.
+	const BlockStorage::Palette&     palette = blocks.getPalette();
+	std::vector<std::int32_t>        local(palette.size(), -1);
+	std::vector<BlockDictionary::ID> ids;
+
+	std::vector<std::pair<std::uint16_t, std::uint32_t>> runs;
+	for (std::size_t i = 0; i < CHUNK_MAX_BLOCKS;)
+	{
+		const std::size_t index = blocks.getPaletteIndex(i);
+
+		std::size_t end = i + 1;
+		if (blocks.isUniform())
+		{
+			end = CHUNK_MAX_BLOCKS;
+		}
+		while (end < CHUNK_MAX_BLOCKS && blocks.getPaletteIndex(end) == index)
+		{
+			++end;
+		}
+
+		if (local[index] < 0)
+		{
+			local[index] = static_cast<std::int32_t>(ids.size());
+			ids.push_back(dictionary.getID(palette[index]));
+		}
+
+		runs.emplace_back(static_cast<std::uint16_t>(local[index]),
+		                  static_cast<std::uint32_t>(end - i));
+		i = end;
+	}
+
+	ser << static_cast<std::uint16_t>(ids.size());
+	ser.write(ids.data(), ids.size());
+
+	ser << static_cast<std::uint32_t>(runs.size());
+	for (const auto& run : runs)
+	{
+		ser << run.first << run.second;
+	}
+
+	// metadata is kept apart from the runs, so it doesn't break them up.
+	ser << static_cast<std::uint32_t>(metadata.size());
+	for (const auto& entry : metadata)
+	{
+		ser << static_cast<std::uint32_t>(entry.first);
+		keys.write(ser, entry.second);
+	}
+}
+
+bool Chunk::Data::load(phx::Reader& ser, BlockReferrer* referrer,
+                       const BlockDictionary&    dictionary,
+                       const MetadataDictionary& keys)
+{
+	blocks =
+	    BlockStorage(CHUNK_MAX_BLOCKS, referrer->blocks.get(BlockType::AIR_BLOCK));
+	metadata.clear();
+
+	// every saved ID is resolved once, the runs only index into this.
+	std::uint16_t paletteSize;
+	ser >> paletteSize;
+
+	std::vector<BlockType*> types;
+	for (std::size_t p = 0; p < paletteSize && ser; ++p)
+	{
+		BlockDictionary::ID id;
+		ser >> id;
+		types.push_back(dictionary.getType(id, referrer));
+	}
+
+	std::uint32_t runCount;
+	ser >> runCount;
+
+	bool        valid = true;
+	std::size_t i     = 0;
+	for (std::uint32_t r = 0; r < runCount && ser && valid; ++r)
+	{
+		std::uint16_t index;
+		std::uint32_t length;
+		ser >> index >> length;
+
+		valid = ser && index < types.size() && length <= CHUNK_MAX_BLOCKS - i;
+		if (valid)
+		{
+			blocks.set(i, length, types[index]);
+			i += length;
+		}
+	}
+
+	// a chunk missing its last runs would be saved back without them.
+	valid = valid && i == CHUNK_MAX_BLOCKS;
+
+	std::uint32_t metadataCount;
+	ser >> metadataCount;
+	for (std::uint32_t m = 0; m < metadataCount && ser && valid; ++m)
+	{
+		std::uint32_t index;
+		Metadata      data;
+		ser >> index;
+		keys.read(ser, data);
+
+		// written in order, one entry per block.
+		valid = index < CHUNK_MAX_BLOCKS &&
+		        (metadata.empty() || metadata.back().first < index);
+		if (valid)
+		{
+			metadata.emplace_back(index, std::move(data));
+		}
+	}
+
+	rebuildMasks(referrer->properties);
+	return valid && static_cast<bool>(ser);
+}
+
+Chunk::Chunk(const phx::math::vec3& chunkPos, BlockReferrer* referrer)
+    : Chunk(chunkPos, referrer, referrer->blocks.get(BlockType::AIR_BLOCK))
+{
+}
+
+Chunk::Chunk(const phx::math::vec3& chunkPos, BlockReferrer* referrer,
+             BlockType* fill)
+    : m_pos(chunkPos),
+      m_data(std::make_shared<Data>(fill, referrer->properties)),
+      m_referrer(referrer)
+{
+	markDirty(
+	    {{0, 0, 0}, {CHUNK_WIDTH - 1, CHUNK_HEIGHT - 1, CHUNK_DEPTH - 1}});
+}
+
+Chunk::Chunk(const phx::math::vec3& chunkPos, BlockReferrer* referrer,
+             const BlockList& blocks)
+    : Chunk(chunkPos, referrer,
+            blocks.size() == CHUNK_MAX_BLOCKS
+                ? blocks.front()
+                : referrer->blocks.get(BlockType::AIR_BLOCK))
+{
+	if (blocks.size() != CHUNK_MAX_BLOCKS)
+	{
+		LOG_WARNING("CHUNK") << "Tried to create a chunk from "
+		                     << blocks.size() << " blocks rather than "
+		                     << CHUNK_MAX_BLOCKS << ", leaving it empty";
+		return;
+	}
+
+	// the chunk starts out as the first block, only the runs of anything
+	// else need writing.
+	Data&       data = *m_data;
+	std::size_t run  = 0;
+	for (std::size_t i = 1; i <= blocks.size(); ++i)
+	{
+		if (i < blocks.size() && blocks[i] == blocks[run])
+		{
+			continue;
+		}
+
+		if (blocks[run] != blocks.front())
+		{
+			data.blocks.set(run, i - run, blocks[run]);
+		}
+		run = i;
+	}
+
+	data.rebuildMasks(m_referrer->properties);
+}
+
+phx::math::vec3 Chunk::getChunkPos() const { return m_pos; }
+
+phx::math::vec3i Chunk::getChunkCoords() const { return toChunkCoords(m_pos); }
+
+phx::math::vec3i Chunk::toChunkCoords(const math::vec3& chunkPos)
+{
+	return BlockPos::fromWorld(chunkPos).getChunk();
+}
+
+phx::math::vec3 Chunk::toChunkPos(const math::vec3i& coords)
+{
+	return ChunkPos(coords).getOrigin().toWorld();
+}
+
+phx::math::vec3i Chunk::getOffset(Side side)
+{
+	static const std::array<math::vec3i, SIDE_COUNT> offsets = {
+	    math::vec3i {-1, 0, 0}, math::vec3i {1, 0, 0},
+	    math::vec3i {0, -1, 0}, math::vec3i {0, 1, 0},
+	    math::vec3i {0, 0, -1}, math::vec3i {0, 0, 1}};
+
+	return offsets[side];
+}
+
+Chunk::BlockList Chunk::getBlocks() const
+{
+	BlockList blocks(CHUNK_MAX_BLOCKS);
+	m_data->blocks.unpack(blocks.data());
+	return blocks;
+}
+
+ChunkSnapshot Chunk::snapshot() const
+{
+	return {m_pos, m_version, m_data, m_referrer};
+}
+
+Block Chunk::getBlockAt(std::size_t index) const
+{
+	if (index < CHUNK_MAX_BLOCKS)
+	{
+		return {m_data->blocks.get(index), m_data->findMetadata(index)};
+	}
+
+	return {m_referrer->blocks.get(BlockType::OUT_OF_BOUNDS_BLOCK), nullptr};
+}
+
+Block Chunk::getBlockAt(const phx::math::vec3& position) const
+{
+	return getBlockAt(getVectorIndex(position));
+}
+
+void Chunk::setBlockAt(const phx::math::vec3& position, Block newBlock)
+{
+	if (position.x < CHUNK_WIDTH && position.y < CHUNK_HEIGHT &&
+	    position.z < CHUNK_DEPTH)
+	{
+		setBlockAt(getVectorIndex(position), newBlock);
+	}
+}
+
+void Chunk::setBlockAt(std::size_t index, Block newBlock)
+{
+	if (index >= CHUNK_MAX_BLOCKS)
+	{
+		return;
+	}
+
+	const math::vec3i block = {Geometry::xOf(index), Geometry::yOf(index),
+	                           Geometry::zOf(index)};
+	const auto        position = static_cast<math::vec3>(block);
+
+	const BlockProperties& properties = m_referrer->properties;
+
+	Block oldBlock = getBlockAt(index);
+	if (properties.has(oldBlock.type->uid, BlockProperties::ON_BREAK))
+	{
+		oldBlock.type->onBreak(position);
+	}
+	Data& data = edit();
+	data.blocks.set(index, newBlock.type);
+	updateMasks(data, index, newBlock.type);
+
+	// the metadata of the old block goes with it.
+	auto it = std::lower_bound(
+	    data.metadata.begin(), data.metadata.end(), index,
+	    [](const auto& entry, std::size_t i) { return entry.first < i; });
+	const bool exists = it != data.metadata.end() && it->first == index;
+	if (newBlock.metadata != nullptr && !newBlock.metadata->empty())
+	{
+		if (exists)
+		{
+			it->second = *newBlock.metadata;
+		}
+		else
+		{
+			data.metadata.emplace(it, index, *newBlock.metadata);
+		}
+	}
+	else if (exists)
+	{
+		data.metadata.erase(it);
+	}
+
+	markDirty({block, block});
+	if (properties.has(newBlock.type->uid, BlockProperties::ON_PLACE))
+	{
+		newBlock.type->onPlace(position);
+	}
+}
+
+void Chunk::setBlocks(const std::vector<BlockEdit>& edits)
+{
+	Data&       data = edit();
+	DirtyRegion region;
+	for (const BlockEdit& edit : edits)
+	{
+		const std::size_t index = edit.first;
+		if (index >= CHUNK_MAX_BLOCKS)
+		{
+			continue;
+		}
+
+		data.blocks.set(index, edit.second);
+		updateMasks(data, index, edit.second);
+
+		region.add(Geometry::xOf(index), Geometry::yOf(index),
+		           Geometry::zOf(index));
+	}
+
+	if (region.isEmpty())
+	{
+		return;
+	}
+
+	if (!data.metadata.empty())
+	{
+		for (const BlockEdit& edit : edits)
+		{
+			auto it = std::lower_bound(
+			    data.metadata.begin(), data.metadata.end(), edit.first,
+			    [](const auto& entry, std::size_t i) { return entry.first < i; });
+			if (it != data.metadata.end() && it->first == edit.first)
 			{
-				m_blocks.push_back(
-				    m_referrer->blocks.get(*m_referrer->referrer.get(id)));
-				i++;
+				data.metadata.erase(it);
 			}
 		}
 	}
 
+	markDirty(region);
+}
+
+void Chunk::fill(const DirtyRegion& region, BlockType* type)
+{
+	// clamp the box to the chunk.
+	DirtyRegion box;
+	box.min = {std::max(region.min.x, 0), std::max(region.min.y, 0),
+	           std::max(region.min.z, 0)};
+	box.max = {std::min(region.max.x, CHUNK_WIDTH - 1),
+	           std::min(region.max.y, CHUNK_HEIGHT - 1),
+	           std::min(region.max.z, CHUNK_DEPTH - 1)};
+	if (box.isEmpty() || box.max.y < box.min.y || box.max.z < box.min.z)
+	{
+		return;
+	}
+
+	Data&             data   = edit();
+	const bool        solid  = m_referrer->properties.isSolid(type->uid);
+	const bool        opaque = m_referrer->properties.isOpaque(type->uid);
+	const std::size_t row    = box.max.x - box.min.x + 1;
+	for (int z = box.min.z; z <= box.max.z; ++z)
+	{
+		for (int y = box.min.y; y <= box.max.y; ++y)
+		{
+			const std::size_t start = getVectorIndex(box.min.x, y, z);
+			data.blocks.set(start, row, type);
+			for (std::size_t i = start; i < start + row; ++i)
+			{
+				data.solid.set(i, solid);
+				data.opaque.set(i, opaque);
+			}
+		}
+	}
+
+	eraseMetadata(data, box);
+	markDirty(box);
+}
+
+/**
+ * @TODO Should we return a tuple with an error type here? There are two things
+ * that could go wrong either the block is OOB or the metadata type is invalid.
+ * Or should we just assert on the second error?
+ */
+bool Chunk::setMetadataAt(const phx::math::vec3& position,
+                          const std::string&     key,
+                          const Metadata::Value& newData)
+{
+	if (position.x < CHUNK_WIDTH && position.y < CHUNK_HEIGHT &&
+	    position.z < CHUNK_DEPTH)
+	{
+		const std::size_t index    = getVectorIndex(position);
+		MetadataList&     metadata = edit().metadata;
+
+		auto it = std::lower_bound(
+		    metadata.begin(), metadata.end(), index,
+		    [](const auto& entry, std::size_t i) { return entry.first < i; });
+		if (it == metadata.end() || it->first != index)
+		{
+			it = metadata.emplace(it, index, Metadata {});
+		}
+
+		if (!it->second.set(key, newData))
+		{
+			return false;
+		}
+
+		const auto block = static_cast<math::vec3i>(position);
+		markDirty({block, block});
+		return true;
+	}
+	return false;
+}
+
+DirtyRegion Chunk::markClean(Consumer consumer)
+{
+	DirtyRegion region       = m_dirty[consumer];
+	m_dirty[consumer]        = {};
+	m_seenVersions[consumer] = m_version;
+	return region;
+}
+
+void Chunk::markClean(Consumer consumer, std::uint64_t version)
+{
+	if (version == m_version)
+	{
+		markClean(consumer);
+		return;
+	}
+
+	m_seenVersions[consumer] = std::max(m_seenVersions[consumer], version);
+}
+
+void Chunk::markDirty(const DirtyRegion& region)
+{
+	++m_version;
+	for (DirtyRegion& dirty : m_dirty)
+	{
+		dirty.add(region);
+	}
+
+	// the map only needs telling once until it's caught up.
+	if (m_owner.map != nullptr && !m_owner.changed)
+	{
+		m_owner.changed = true;
+		m_owner.map->onChanged(*this);
+	}
+}
+
+Chunk::Data& Chunk::edit()
+{
+	if (m_data.use_count() > 1)
+	{
+		m_data = std::make_shared<Data>(*m_data);
+	}
+	else
+	{
+		// a snapshot may have just been dropped on another thread, make sure
+		// its reads are done before we start writing.
+		std::atomic_thread_fence(std::memory_order_acquire);
+	}
+
+	return *m_data;
+}
+
+void Chunk::updateMasks(Data& data, std::size_t index,
+                        const BlockType* type) const
+{
+	data.solid.set(index, m_referrer->properties.isSolid(type->uid));
+	data.opaque.set(index, m_referrer->properties.isOpaque(type->uid));
+}
+
+void Chunk::eraseMetadata(Data& data, const DirtyRegion& region)
+{
+	data.metadata.erase(
+	    std::remove_if(data.metadata.begin(), data.metadata.end(),
+	                   [&region](const auto& entry) {
+		                   const int x = Geometry::xOf(entry.first);
+		                   const int y = Geometry::yOf(entry.first);
+		                   const int z = Geometry::zOf(entry.first);
+		                   return x >= region.min.x && x <= region.max.x &&
+		                          y >= region.min.y && y <= region.max.y &&
+		                          z >= region.min.z && z <= region.max.z;
+	                   }),
+	    data.metadata.end());
+}
+
+phx::Serializer& Chunk::operator>>(phx::Serializer& ser) const
+{
+	ser << m_pos.x << m_pos.y << m_pos.z;
+	m_data->write(ser, nullptr);
+	return ser;
+}
+
+phx::Reader& Chunk::operator<<(phx::Reader& ser)
+{
+	read(ser, nullptr);
+	return ser;
+}
+
+void Chunk::send(phx::Serializer& ser, MetadataDictionary& keys) const
+{
+	ser << m_pos.x << m_pos.y << m_pos.z;
+	m_data->write(ser, &keys);
+}
+
+bool Chunk::receive(phx::Reader& ser, const MetadataDictionary& keys)
+{
+	return read(ser, &keys);
+}
+
+bool Chunk::read(phx::Reader& ser, const MetadataDictionary* keys)
+{
+	// read into new blocks, snapshots keep the old ones.
+	auto data = std::make_shared<Data>(
+	    m_referrer->blocks.get(BlockType::AIR_BLOCK), m_referrer->properties);
+
+	ser >> m_pos.x >> m_pos.y >> m_pos.z;
+	const bool valid = data->read(ser, m_referrer, keys);
+	m_data           = std::move(data);
+
+	markDirty(
+	    {{0, 0, 0}, {CHUNK_WIDTH - 1, CHUNK_HEIGHT - 1, CHUNK_DEPTH - 1}});
+
+	return valid;
+}
+
+void Chunk::save(phx::Serializer& ser, BlockDictionary& dictionary,
+                 MetadataDictionary& keys) const
+{
+	snapshot().save(ser, dictionary, keys);
+}
+
+bool Chunk::load(phx::Reader& ser, const BlockDictionary& dictionary,
+                 const MetadataDictionary& keys)
+{
+	const std::byte* magic = ser.peekBytes(sizeof(SAVE_MAGIC));
+	if (magic == nullptr || std::memcmp(magic, SAVE_MAGIC, sizeof(SAVE_MAGIC)))
+	{
+		// saved before the format had a version, with a string ID for
+		// every run.
+		ser >> *this;
+		return static_cast<bool>(ser);
+	}
+
+	std::uint8_t version;
+	std::uint8_t encoding;
+	ser.skip(sizeof(SAVE_MAGIC));
+	ser >> version >> encoding;
+	if (!ser || version != SAVE_VERSION ||
+	    encoding > static_cast<std::uint8_t>(Encoding::COMPACT))
+	{
+		return false;
+	}
+	ser.setEncoding(static_cast<Encoding>(encoding));
+
+	auto data = std::make_shared<Data>(
+	    m_referrer->blocks.get(BlockType::AIR_BLOCK), m_referrer->properties);
+
+	ser >> m_pos.x >> m_pos.y >> m_pos.z;
+	const bool valid = data->load(ser, m_referrer, dictionary, keys);
+	m_data           = std::move(data);
+
+	markDirty(
+	    {{0, 0, 0}, {CHUNK_WIDTH - 1, CHUNK_HEIGHT - 1, CHUNK_DEPTH - 1}});
+
+	return valid;
+}
+
+ChunkSnapshot::ChunkSnapshot(BlockReferrer* referrer)
+    : m_pos(0, 0, 0), m_data(std::make_shared<Chunk::Data>(
+                          referrer->blocks.get(BlockType::AIR_BLOCK),
+                          referrer->properties)),
+      m_referrer(referrer)
+{
+}
+
+ChunkSnapshot::ChunkSnapshot(const phx::math::vec3&             chunkPos,
+                             std::uint64_t                      version,
+                             std::shared_ptr<const Chunk::Data> data,
+                             BlockReferrer*                     referrer)
+    : m_pos(chunkPos), m_version(version), m_data(std::move(data)),
+      m_referrer(referrer)
+{
+}
+
+BlockType* ChunkSnapshot::getBlockAt(std::size_t index) const
+{
+	if (index < Chunk::CHUNK_MAX_BLOCKS)
+	{
+		return m_data->blocks.get(index);
+	}
+
+	return m_referrer->blocks.get(BlockType::OUT_OF_BOUNDS_BLOCK);
+}
+
+void ChunkSnapshot::save(phx::Serializer& ser, BlockDictionary& dictionary,
+                         MetadataDictionary& keys) const
+{
+	for (const char c : SAVE_MAGIC)
+	{
+		ser << c;
+	}
+	ser << Chunk::SAVE_VERSION
+	    << static_cast<std::uint8_t>(ser.getEncoding());
+
+	ser << m_pos.x << m_pos.y << m_pos.z;
+	m_data->save(ser, dictionary, keys);
+}
+
+phx::Serializer& ChunkSnapshot::operator>>(phx::Serializer& ser) const
+{
+	ser << m_pos.x << m_pos.y << m_pos.z;
+	m_data->write(ser, nullptr);
+	return ser;
+}
+
+phx::Reader& ChunkSnapshot::operator<<(phx::Reader& ser)
+{
+	auto data = std::make_shared<Chunk::Data>(
+	    m_referrer->blocks.get(BlockType::AIR_BLOCK), m_referrer->properties);
+
+	ser >> m_pos.x >> m_pos.y >> m_pos.z;
+	data->read(ser, m_referrer, nullptr);
+
+	m_data    = std::move(data);
+	m_version = 0;
 	return ser;
 }
@@ -0,0 +1,148 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Common/Voxels/ChunkNeighborhood.hpp>
+
+#include <algorithm>
+
+using namespace phx::voxels;
+
+namespace
+{
+	// the blocks of a chunk that are in the neighbourhood along one axis.
+	struct Span
+	{
+		int begin;
+		int end;
+		int local;
+	};
+
+	// offset is -1, 0 or 1 for the chunk before, the centre or the chunk
+	// after, size is the size of a chunk along the axis.
+	constexpr Span getSpan(int offset, int size)
+	{
+		if (offset < 0)
+		{
+			return {-ChunkNeighborhood::PADDING, 0,
+			        size - ChunkNeighborhood::PADDING};
+		}
+
+		if (offset > 0)
+		{
+			return {size, size + ChunkNeighborhood::PADDING, 0};
+		}
+
+		return {0, size, 0};
+	}
+
+	// chunks on an edge or corner aren't linked to the centre, so they're
+	// reached one side at a time, through whichever chunk is loaded.
+	const Chunk* findChunk(const Chunk* from, int dx, int dy, int dz)
+	{
+		if (dx == 0 && dy == 0 && dz == 0)
+		{
+			return from;
+		}
+
+		const Chunk* found = nullptr;
+		if (dx != 0)
+		{
+			const Chunk* next =
+			    from->getNeighbor(dx < 0 ? Chunk::NEG_X : Chunk::POS_X);
+			found = next ? findChunk(next, 0, dy, dz) : nullptr;
+		}
+
+		if (found == nullptr && dy != 0)
+		{
+			const Chunk* next =
+			    from->getNeighbor(dy < 0 ? Chunk::NEG_Y : Chunk::POS_Y);
+			found = next ? findChunk(next, dx, 0, dz) : nullptr;
+		}
+
+		if (found == nullptr && dz != 0)
+		{
+			const Chunk* next =
+			    from->getNeighbor(dz < 0 ? Chunk::NEG_Z : Chunk::POS_Z);
+			found = next ? findChunk(next, dx, dy, 0) : nullptr;
+		}
+
+		return found;
+	}
+} // namespace
+
+ChunkNeighborhood::ChunkNeighborhood(const Chunk& centre)
+    : m_blocks(VOLUME, nullptr)
+{
+	// the middle is most of the neighbourhood, so it's unpacked in one go
+	// and copied a row at a time.
+	const Chunk::BlockList blocks = centre.getBlocks();
+	for (int z = 0; z < Chunk::CHUNK_DEPTH; ++z)
+	{
+		for (int y = 0; y < Chunk::CHUNK_HEIGHT; ++y)
+		{
+			std::copy_n(blocks.data() + Chunk::getVectorIndex(0, y, z),
+			            Chunk::CHUNK_WIDTH,
+			            m_blocks.data() + getIndex(0, y, z));
+		}
+	}
+
+	for (int dz = -1; dz <= 1; ++dz)
+	{
+		for (int dy = -1; dy <= 1; ++dy)
+		{
+			for (int dx = -1; dx <= 1; ++dx)
+			{
+				const Chunk* chunk = findChunk(&centre, dx, dy, dz);
+				if (chunk == nullptr || chunk == &centre)
+				{
+					continue;
+				}
+
+				const Span xs = getSpan(dx, Chunk::CHUNK_WIDTH);
+				const Span ys = getSpan(dy, Chunk::CHUNK_HEIGHT);
+				const Span zs = getSpan(dz, Chunk::CHUNK_DEPTH);
+
+				const BlockStorage& storage = chunk->getStorage();
+				for (int z = 0; z < zs.end - zs.begin; ++z)
+				{
+					for (int y = 0; y < ys.end - ys.begin; ++y)
+					{
+						for (int x = 0; x < xs.end - xs.begin; ++x)
+						{
+							const LocalPos local(xs.local + x, ys.local + y,
+							                     zs.local + z);
+							m_blocks[getIndex(xs.begin + x, ys.begin + y,
+							                  zs.begin + z)] =
+							    storage.get(local.getIndex());
+						}
+					}
+				}
+			}
+		}
+	}
+}
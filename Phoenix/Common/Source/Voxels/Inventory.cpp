@@ -29,6 +29,8 @@
 #include <Common/Logger.hpp>
 #include <Common/Voxels/Inventory.hpp>
 
+#include <algorithm>
+
 using namespace phx::voxels;
 
 Inventory::Inventory(std::size_t size, ItemReferrer* referrer)
@@ -149,7 +151,7 @@ Item Inventory::removeItem(std::size_t slot, bool all)
  * Or should we just assert on the second error?
  */
 bool Inventory::setMetadataAt(std::size_t slot, const std::string& key,
-                              std::any* newData)
+                              const Metadata::Value& newData)
 {
 	if (m_size <= slot)
 	{
@@ -168,7 +170,12 @@ bool Inventory::setMetadataAt(std::size_t slot, const std::string& key,
 		LOG_DEBUG("Inventory") << "Attempted to set metadata a stack of items";
 		return false;
 	}
-	return m_metadata[slot]->set(key, newData);
+	std::shared_ptr<Metadata>& data = m_metadata[slot];
+	if (data == nullptr)
+	{
+		data = std::make_shared<Metadata>();
+	}
+	return data->set(key, newData);
 }
 
 phx::Serializer& Inventory::operator>>(phx::Serializer& ser) const
@@ -193,16 +200,22 @@ phx::Serializer& Inventory::operator>>(phx::Serializer& ser) const
 	return ser;
 }
 
-phx::Serializer& Inventory::operator<<(phx::Serializer& ser)
+phx::Reader& Inventory::operator<<(phx::Reader& ser)
 {
 	ser >> m_size;
-	m_slots.reserve(m_size);
-	for (std::size_t i = 0; i < m_size; i++)
+	m_slots.clear();
+	m_stacks.clear();
+	m_metadata.clear();
+
+	// every slot takes at least a byte, don't trust a size bigger than that.
+	m_slots.reserve(std::min(m_size, ser.remaining()));
+	m_stacks.reserve(std::min(m_size, ser.remaining()));
+	for (std::size_t i = 0; i < m_size && ser; i++)
 	{
 		std::size_t id = 0;
 		ser >> id;
 		m_slots.push_back(m_referrer->items.get(id));
-		m_stacks.at(i) = 1;
+		m_stacks.push_back(1);
 		char c;
 		ser >> c;
 		if (c == ';')
@@ -210,7 +223,7 @@ phx::Serializer& Inventory::operator<<(phx::Serializer& ser)
 		}
 		else if (c == '+')
 		{
-			std::shared_ptr<Metadata> data;
+			auto data = std::make_shared<Metadata>();
 			ser >> *data;
 			m_metadata.emplace(i, data);
 		}
@@ -26,6 +26,7 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include <Common/Logger.hpp>
 #include <Common/Voxels/InventoryManager.hpp>
 
 #include <fstream>
@@ -106,13 +107,19 @@ bool InventoryManager::load(std::size_t index)
 	int length = saveFile.tellg();
 	saveFile.seekg(0, std::ifstream::beg);
 
-	Serializer ser;
 	data::Data data(length);
 	saveFile.read((char*) &data[0], length);
-	ser.setBuffer(data);
 
 	Inventory inventory = Inventory(0, m_referrer);
-	ser >> inventory;
+	Reader    reader(data);
+	reader >> inventory;
+	if (!reader)
+	{
+		LOG_WARNING("INVENTORY")
+		    << "The save of inventory " << index << " is truncated";
+		return false;
+	}
+
 	m_inventories.emplace(index, std::move(inventory));
 	return true;
 }
@@ -32,7 +32,10 @@
 #include <Common/Utility/Serializer.hpp>
 #include <Common/Voxels/Map.hpp>
 
+#include <algorithm>
+#include <charconv>
 #include <cstddef>
+#include <cstdlib>
 #include <filesystem>
 #include <iostream>
 #include <string>
@@ -41,131 +44,536 @@
 
 using namespace phx::voxels;
 
+namespace
+{
+	// what a chunk costs the map, the table entry as well as the blocks.
+	std::size_t measure(const Chunk& chunk)
+	{
+		return sizeof(std::pair<phx::math::vec3i, std::unique_ptr<Chunk>>) +
+		       sizeof(Chunk) + chunk.getMemoryUsage();
+	}
+} // namespace
+
 Map::Map(std::filesystem::path* savePath,
          const std::string& name,
-         BlockReferrer* referrer)
-    : m_referrer(referrer), m_savePath(savePath), m_name(name)
+         BlockReferrer* referrer,
+         BlockDictionary* dictionary,
+         MetadataDictionary* metadataKeys)
+    : m_referrer(referrer), m_savePath(savePath), m_name(name),
+      m_dictionary(dictionary), m_metadataKeys(metadataKeys)
 {
 	if (!std::filesystem::exists(*m_savePath / m_name))
 	{
         std::filesystem::create_directory(*m_savePath / m_name);
 	}
+
+	migrateLegacySaves();
 }
 
 Map::Map(phx::BlockingQueue<std::pair<phx::math::vec3, std::vector<std::byte>>>*
                         queue,
-         BlockReferrer* referrer)
-    : m_referrer(referrer), m_queue(queue) {}
+         BlockReferrer* referrer,
+         const MetadataDictionary* metadataKeys)
+    : m_referrer(referrer), m_networkMetadataKeys(metadataKeys),
+      m_queue(queue)
+{
+}
+
+Map::~Map()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_workMutex);
+		m_stopping = true;
+	}
+	m_workCondition.notify_all();
+
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+
+	flush();
+
+	{
+		std::lock_guard<std::mutex> lock(m_flushMutex);
+		m_flushStopped = true;
+	}
+	m_flushCondition.notify_all();
+
+	if (m_flusher.joinable())
+	{
+		m_flusher.join();
+	}
+}
 
 /*
-    Chunks are kept in an unordered map of vec3 : Chunk. The algorithm looks
+    Chunks are kept in a flat map of coordinates : Chunk. The algorithm looks
     first in the map. The next behavior depends on whether we are in online or
     offline mode. If we are networked, it updates the map from the queue of
     chunks from the server, then if it still isn't found, nullptr is returned.
     If we are not networked, the chunk is loaded from the save files. If the
     save file does not exist yet or is damaged, a new chunk will be generated.
 */
-Chunk* Map::getChunk(const phx::math::vec3& pos)
+Chunk* Map::getChunk(const phx::math::vec3i& coords)
 {
-	if (m_chunks.find(pos) != m_chunks.end())
+	auto loaded = m_chunks.find(coords);
+	if (loaded != m_chunks.end())
 	{
-		return &m_chunks.at(pos);
+		return loaded->second.get();
 	}
 
 	if (m_queue)
 	{
 		updateChunkQueue();
-		if (m_chunks.find(pos) != m_chunks.end())
+		loaded = m_chunks.find(coords);
+		if (loaded != m_chunks.end())
 		{
-			return &m_chunks.at(pos);
+			return loaded->second.get();
 		}
 
 		return nullptr;
 	}
 
-	// Chunk isn't in memory and we aren't networked, so lets create one
-	if (!loadChunk(pos))
+	// Chunk isn't in memory and we aren't networked, so lets create one.
+	// If it was only just unloaded its save might not be written yet.
+	if (m_saving.contains(coords))
 	{
-		// save doesn't exist, generate it.
-		generateChunk(pos);
+		waitForFlusher();
+		collectSaved();
 	}
 
-	return &m_chunks.at(pos);
+	if (std::optional<Chunk> chunk = loadChunk(coords))
+	{
+		// nobody has been sent it yet, whoever wants it asks for it.
+		Chunk* added =
+		    m_chunks.emplace(coords, std::make_unique<Chunk>(std::move(*chunk)))
+		        .first->second.get();
+		added->markClean(Chunk::NETWORK);
+		track(coords);
+		return added;
+	}
+
+	// save doesn't exist, generate it.
+	Chunk* generated =
+	    m_chunks.emplace(coords, std::make_unique<Chunk>(generateChunk(coords)))
+	        .first->second.get();
+	generated->markClean(Chunk::NETWORK);
+	track(coords);
+	save(coords);
+
+	return generated;
 }
 
-std::pair<phx::math::vec3, phx::math::vec3> Map::getBlockPos(
-    phx::math::vec3 position)
+void Map::request(const math::vec3i& coords, float priority,
+                  ChunkCallback callback)
+{
+	if (m_queue != nullptr || m_chunks.contains(coords))
+	{
+		if (Chunk* chunk = getChunk(coords))
+		{
+			callback(chunk);
+		}
+		return;
+	}
+
+	if (m_saving.contains(coords))
+	{
+		waitForFlusher();
+		collectSaved();
+	}
+
+	std::vector<ChunkCallback>& callbacks = m_callbacks[coords];
+	const bool                  pending   = !callbacks.empty();
+	callbacks.push_back(std::move(callback));
+
+	startWorkers();
+
+	{
+		std::lock_guard<std::mutex> lock(m_workMutex);
+
+		// a chunk already on its way is only queued again if it's now
+		// needed sooner and no worker has started on it.
+		auto queued = m_queued.find(coords);
+		if (pending &&
+		    (queued == m_queued.end() || queued->second <= priority))
+		{
+			return;
+		}
+
+		m_queued[coords] = priority;
+		m_loads.push({coords, priority, m_requestCount++});
+	}
+	m_workCondition.notify_all();
+}
+
+std::size_t Map::update(std::size_t budget)
 {
-	// This mess converts position types between world and inner chunk
-	// positioning
-	int posX = static_cast<int>(position.x / Chunk::CHUNK_WIDTH);
-	int posY = static_cast<int>(position.y / Chunk::CHUNK_HEIGHT);
-	int posZ = static_cast<int>(position.z / Chunk::CHUNK_DEPTH);
+	// networked maps get their chunks from the server, including ones
+	// already loaded that have changed since.
+	updateChunkQueue();
+
+	if (m_queue == nullptr)
+	{
+		collectSaved();
+
+		// changes are written every so often, or sooner if a lot of chunks
+		// have changed.
+		const auto now = std::chrono::steady_clock::now();
+		const std::vector<Chunk*> unsaved = getUnsavedChunks();
+		if (!unsaved.empty() &&
+		    (now - m_lastFlush >= m_flushPolicy.interval ||
+		     unsaved.size() >= m_flushPolicy.maxDirty))
+		{
+			for (Chunk* chunk : unsaved)
+			{
+				queueSave(*chunk);
+			}
+			m_lastFlush = now;
+		}
+	}
+
+	std::vector<Finished> finished;
+	{
+		std::lock_guard<std::mutex> lock(m_workMutex);
+		while (!m_finished.empty() && finished.size() < budget)
+		{
+			finished.push_back(std::move(m_finished.front()));
+			m_finished.pop_front();
+		}
+	}
 
-	position.x =
-	    static_cast<float>(static_cast<int>(position.x) % Chunk::CHUNK_WIDTH);
-	if (position.x < 0)
+	for (Finished& done : finished)
 	{
-		posX -= 1;
-		position.x += Chunk::CHUNK_WIDTH;
+		// getChunk might have loaded it in the meantime, that copy wins.
+		auto result = m_chunks.emplace(
+		    done.position, std::make_unique<Chunk>(std::move(done.chunk)));
+		if (result.second)
+		{
+			// whoever wants it is sent it by their callback below, it hasn't
+			// changed since.
+			result.first->second->markClean(Chunk::NETWORK);
+			track(done.position);
+		}
+		else
+		{
+			LOG_DEBUG("MAP") << "Dropping a chunk loaded twice at "
+			                 << done.position.x << ", " << done.position.y
+			                 << ", " << done.position.z;
+		}
+
+		// generated chunks are left dirty and written by the next flush,
+		// rather than saving them on this thread.
+
+		auto callbacks = m_callbacks.find(done.position);
+		if (callbacks != m_callbacks.end())
+		{
+			std::vector<ChunkCallback> waiting = std::move(callbacks->second);
+			m_callbacks.erase(callbacks);
+
+			// the callbacks might add chunks, moving the entry around.
+			Chunk* chunk = result.first->second.get();
+			for (ChunkCallback& callback : waiting)
+			{
+				callback(chunk);
+			}
+		}
 	}
 
-	position.y =
-	    static_cast<float>(static_cast<int>(position.y) % Chunk::CHUNK_HEIGHT);
-	if (position.y < 0)
+	// chunks that were just added have had their callbacks, so anything
+	// that wanted them holds on to them by now.
+	evict();
+
+	return finished.size();
+}
+
+void Map::prefetch(const std::vector<math::vec3i>& chunks)
+{
+	if (m_queue != nullptr)
 	{
-		posY -= 1;
-		position.y += Chunk::CHUNK_HEIGHT;
+		return;
 	}
 
-	position.z =
-	    static_cast<float>(static_cast<int>(position.z) % Chunk::CHUNK_DEPTH);
-	if (position.z < 0)
+	for (const math::vec3i& coords : chunks)
 	{
-		posZ -= 1;
-		position.z += Chunk::CHUNK_DEPTH;
+		if (!m_chunks.contains(coords))
+		{
+			std::size_t index;
+			getRegion(coords, index).prefetch(index);
+		}
 	}
+}
 
-	const math::vec3 chunkPosition =
-	    math::vec3(static_cast<float>(posX * Chunk::CHUNK_WIDTH),
-	               static_cast<float>(posY * Chunk::CHUNK_HEIGHT),
-	               static_cast<float>(posZ * Chunk::CHUNK_DEPTH));
+std::pair<phx::math::vec3, phx::math::vec3> Map::getBlockPos(
+    phx::math::vec3 position)
+{
+	const BlockPos block = BlockPos::fromWorld(position);
+	const LocalPos local = block.getLocal();
 
-	return {chunkPosition, position};
+	return {block.getChunk().getOrigin().toWorld(),
+	        math::vec3(static_cast<float>(local.x), static_cast<float>(local.y),
+	                   static_cast<float>(local.z))};
 }
 
 BlockType* Map::getBlockAt(phx::math::vec3 position)
 {
-	const auto& pos   = getBlockPos(position);
-	Chunk*      chunk = getChunk(pos.first);
+	return getBlockAt(BlockPos::fromWorld(position));
+}
+
+BlockType* Map::getBlockAt(const BlockPos& position)
+{
+	Chunk* chunk = getChunk(position.getChunk());
 	if (chunk == nullptr)
 	{
 		return m_referrer->blocks.get(BlockType::OUT_OF_BOUNDS_BLOCK);
 	}
 
-	return chunk->getBlockAt(pos.second).type;
+	return chunk->getBlockAt(position.getLocal().getIndex()).type;
+}
+
+bool Map::isSolidAt(phx::math::vec3 position)
+{
+	return isSolidAt(BlockPos::fromWorld(position));
+}
+
+bool Map::isSolidAt(const BlockPos& position)
+{
+	Chunk* chunk = getChunk(position.getChunk());
+	if (chunk == nullptr)
+	{
+		return false;
+	}
+
+	return chunk->isSolidAt(position.getLocal().getIndex());
 }
 
 void Map::setBlockAt(phx::math::vec3 position, const Block& block)
 {
-	const auto& pos   = getBlockPos(position);
-	Chunk*      chunk = getChunk(pos.first);
+	setBlockAt(BlockPos::fromWorld(position), block);
+}
+
+void Map::setBlockAt(const BlockPos& position, const Block& block)
+{
+	Chunk* chunk = getChunk(position.getChunk());
+	if (chunk == nullptr)
+	{
+		return;
+	}
 
+	setBlockIn(chunk, position.getLocal(), block);
+}
+
+void Map::setBlockIn(Chunk* chunk, const LocalPos& position,
+                     const Block& block)
+{
 	dispatchToSubscriber(
-	    {MapEvent::BLOCK_BREAK, chunk->getBlockAt(pos.second).type});
+	    {MapEvent::BLOCK_BREAK, chunk->getBlockAt(position.getIndex()).type});
 
-	chunk->setBlockAt(pos.second, block);
+	chunk->setBlockAt(position.getIndex(), block);
 
-	if (m_queue == nullptr)
+	// the chunk is written by the flusher, along with any other changes made
+	// to it until then.
+
+	dispatchToSubscriber({MapEvent::CHUNK_UPDATE, chunk});
+	dispatchToSubscriber({MapEvent::BLOCK_PLACE, block.type});
+}
+
+Map::Accessor::Accessor(Map* map, const BlockPos& position)
+    : m_map(map), m_position(position), m_centre(position.getChunk()),
+      m_unloads(map->m_unloads)
+{
+}
+
+BlockType* Map::Accessor::getBlock()
+{
+	Chunk* chunk = getChunk();
+	if (chunk == nullptr)
 	{
-		save(pos.first);
+		return m_map->m_referrer->blocks.get(BlockType::OUT_OF_BOUNDS_BLOCK);
 	}
 
+	return chunk->getBlockAt(m_position.getLocal().getIndex()).type;
+}
+
+bool Map::Accessor::isSolid()
+{
+	Chunk* chunk = getChunk();
+	return chunk != nullptr &&
+	       chunk->isSolidAt(m_position.getLocal().getIndex());
+}
+
+void Map::Accessor::setBlock(const Block& block)
+{
+	Chunk* chunk = getChunk();
+	if (chunk != nullptr)
+	{
+		m_map->setBlockIn(chunk, m_position.getLocal(), block);
+	}
+}
+
+Chunk* Map::Accessor::lookup()
+{
+	// anything cached might have been unloaded since.
+	if (m_unloads != m_map->m_unloads)
+	{
+		m_cache.fill(nullptr);
+		m_unloads = m_map->m_unloads;
+	}
+
+	const ChunkPos chunk = m_position.getChunk();
+
+	int dx = chunk.x - m_centre.x;
+	int dy = chunk.y - m_centre.y;
+	int dz = chunk.z - m_centre.z;
+
+	// the accessor has left the chunks around the last centre, so they're
+	// swapped for the ones around the chunk it's in now.
+	if (std::abs(dx) > 1 || std::abs(dy) > 1 || std::abs(dz) > 1)
+	{
+		m_cache.fill(nullptr);
+		m_centre = chunk;
+		dx = dy = dz = 0;
+	}
+
+	Chunk*& cached =
+	    m_cache[static_cast<std::size_t>(
+	        (dx + 1) + CACHE_WIDTH * ((dy + 1) + CACHE_WIDTH * (dz + 1)))];
+
+	// chunks that don't exist yet on a networked map are asked for again
+	// every time, they might have been received since.
+	if (cached == nullptr)
+	{
+		cached = m_map->getChunk(chunk);
+	}
+
+	return cached;
+}
+
+void Map::applyBatch(const std::vector<BlockEdit>& edits)
+{
+	ChunkTable<std::vector<Chunk::BlockEdit>> chunks;
+
+	for (const BlockEdit& edit : edits)
+	{
+		const BlockPos block = BlockPos::fromWorld(edit.position);
+		chunks[block.getChunk()].emplace_back(block.getLocal().getIndex(),
+		                                      edit.type);
+	}
+
+	for (const auto& chunk : chunks)
+	{
+		applyToChunk(chunk.first, chunk.second);
+	}
+}
+
+void Map::fill(math::vec3 from, math::vec3 to, BlockType* type)
+{
+	forEachChunkIn(from, to,
+	               [this, type](const math::vec3&  chunkPos,
+	                            const DirtyRegion& region) {
+		               Chunk* chunk = getChunk(Chunk::toChunkCoords(chunkPos));
+		               if (chunk == nullptr)
+		               {
+			               return;
+		               }
+
+		               chunk->fill(region, type);
+		               dispatchToSubscriber({MapEvent::CHUNK_UPDATE, chunk});
+	               });
+}
+
+void Map::editRegion(
+    math::vec3 from, math::vec3 to,
+    const std::function<BlockType*(const math::vec3&)>& func)
+{
+	forEachChunkIn(from, to,
+	               [this, &func](const math::vec3&  chunkPos,
+	                             const DirtyRegion& region) {
+		               // ask for every block before touching the chunk, the
+		               // function might load other chunks.
+		               std::vector<Chunk::BlockEdit> edits;
+		               for (int z = region.min.z; z <= region.max.z; ++z)
+		               {
+			               for (int y = region.min.y; y <= region.max.y; ++y)
+			               {
+				               for (int x = region.min.x; x <= region.max.x; ++x)
+				               {
+					               const math::vec3 local(x, y, z);
+					               BlockType* type = func(chunkPos + local);
+					               if (type != nullptr)
+					               {
+						               edits.emplace_back(
+						                   Chunk::getVectorIndex(x, y, z), type);
+					               }
+				               }
+			               }
+		               }
+
+		               applyToChunk(Chunk::toChunkCoords(chunkPos), edits);
+	               });
+}
+
+void Map::applyToChunk(const math::vec3i&                   coords,
+                       const std::vector<Chunk::BlockEdit>& edits)
+{
+	if (edits.empty())
+	{
+		return;
+	}
+
+	Chunk* chunk = getChunk(coords);
+	if (chunk == nullptr)
+	{
+		return;
+	}
+
+	chunk->setBlocks(edits);
 	dispatchToSubscriber({MapEvent::CHUNK_UPDATE, chunk});
-	dispatchToSubscriber({MapEvent::BLOCK_PLACE, block.type});
 }
 
-void Map::save(const phx::math::vec3& pos)
+void Map::forEachChunkIn(
+    math::vec3 from, math::vec3 to,
+    const std::function<void(const math::vec3&, const DirtyRegion&)>& func)
+{
+	from.floor();
+	to.floor();
+
+	const math::vec3 low  = {std::min(from.x, to.x), std::min(from.y, to.y),
+	                         std::min(from.z, to.z)};
+	const math::vec3 high = {std::max(from.x, to.x), std::max(from.y, to.y),
+	                         std::max(from.z, to.z)};
+
+	const math::vec3 first = getBlockPos(low).first;
+	const math::vec3 last  = getBlockPos(high).first;
+
+	for (float z = first.z; z <= last.z; z += Chunk::CHUNK_DEPTH)
+	{
+		for (float y = first.y; y <= last.y; y += Chunk::CHUNK_HEIGHT)
+		{
+			for (float x = first.x; x <= last.x; x += Chunk::CHUNK_WIDTH)
+			{
+				const math::vec3 chunkPos(x, y, z);
+
+				// the part of the box inside this chunk.
+				DirtyRegion region;
+				region.min = {
+				    std::max(static_cast<int>(low.x - x), 0),
+				    std::max(static_cast<int>(low.y - y), 0),
+				    std::max(static_cast<int>(low.z - z), 0)};
+				region.max = {
+				    std::min(static_cast<int>(high.x - x),
+				             Chunk::CHUNK_WIDTH - 1),
+				    std::min(static_cast<int>(high.y - y),
+				             Chunk::CHUNK_HEIGHT - 1),
+				    std::min(static_cast<int>(high.z - z),
+				             Chunk::CHUNK_DEPTH - 1)};
+
+				func(chunkPos, region);
+			}
+		}
+	}
+}
+
+void Map::save(const phx::math::vec3i& coords)
 {
 	if (m_queue != nullptr)
 	{
@@ -173,14 +581,139 @@ void Map::save(const phx::math::vec3& pos)
 		return;
 	}
 
-	std::ofstream saveFile(toSavePath(static_cast<phx::math::vec3i>(pos)),
-	                       std::ofstream::binary);
+	queueSave(*m_chunks.at(coords));
+}
+
+std::size_t Map::flush()
+{
+	if (m_queue != nullptr)
+	{
+		return 0;
+	}
+
+	collectSaved();
+
+	std::size_t saved = 0;
+	for (Chunk* chunk : getUnsavedChunks())
+	{
+		saved += queueSave(*chunk) ? 1 : 0;
+	}
+
+	waitForFlusher();
+	collectSaved();
+
+	m_lastFlush = std::chrono::steady_clock::now();
+	return saved;
+}
+
+void Map::unloadChunk(const math::vec3i& coords)
+{
+	auto chunk = m_chunks.find(coords);
+	if (chunk == m_chunks.end())
+	{
+		return;
+	}
+
+	if (m_queue == nullptr)
+	{
+		// the snapshot keeps the blocks alive until they're written.
+		queueSave(*chunk->second);
+	}
 
-	Serializer ser;
-	ser << m_chunks.at(pos);
-	saveFile.write((char*) &ser.getBuffer()[0], ser.getBuffer().size());
+	unlink(*chunk->second);
+	m_chunks.erase(chunk);
+	m_edited.erase(coords);
+	++m_unloads;
 
-	saveFile.close();
+	auto residency = m_residency.find(coords);
+	if (residency != m_residency.end())
+	{
+		m_residentBytes -= residency->second.bytes;
+		residency->second.bytes = 0;
+
+		if (residency->second.references == 0)
+		{
+			m_unused.erase(residency->second.unused);
+			m_residency.erase(residency);
+		}
+		else
+		{
+			// it's loaded again if it's asked for.
+			residency->second.loaded = false;
+		}
+	}
+}
+
+void Map::acquire(const math::vec3i& coords)
+{
+	Residency& residency = m_residency[coords];
+	if (residency.references++ == 0 && residency.loaded)
+	{
+		m_unused.erase(residency.unused);
+	}
+}
+
+void Map::release(const math::vec3i& coords)
+{
+	auto residency = m_residency.find(coords);
+	if (residency == m_residency.end() || residency->second.references == 0)
+	{
+		LOG_WARNING("MAP") << "Released the chunk at " << coords.x << ", "
+		                   << coords.y << ", " << coords.z
+		                   << " more times than it was acquired";
+		return;
+	}
+
+	if (--residency->second.references != 0)
+	{
+		return;
+	}
+
+	if (residency->second.loaded)
+	{
+		m_unused.push_front(coords);
+		residency->second.unused = m_unused.begin();
+	}
+	else
+	{
+		m_residency.erase(residency);
+	}
+}
+
+Map::ResidencyStats Map::getResidencyStats() const
+{
+	ResidencyStats stats;
+	stats.resident   = m_chunks.size();
+	stats.referenced = m_chunks.size() - m_unused.size();
+	stats.bytes      = m_residentBytes;
+	stats.evicted    = m_evicted;
+	return stats;
+}
+
+Map::FlushStats Map::getFlushStats()
+{
+	FlushStats stats;
+	{
+		std::lock_guard<std::mutex> lock(m_flushMutex);
+		stats         = m_flushStats;
+		stats.backlog = m_unsaved.size() + (m_writing ? 1 : 0);
+	}
+
+	stats.dirty = getUnsavedChunks().size();
+	return stats;
+}
+
+std::vector<Chunk*> Map::getDirtyChunks(Chunk::Consumer consumer)
+{
+	std::vector<Chunk*> dirty;
+	for (auto& chunk : m_chunks)
+	{
+		if (chunk.second->isDirty(consumer))
+		{
+			dirty.push_back(chunk.second.get());
+		}
+	}
+	return dirty;
 }
 
 void Map::registerEventSubscriber(MapEventSubscriber* subscriber)
@@ -221,52 +754,111 @@ void Map::updateChunkQueue()
 		}
 
 		// We have chunk data.
-		Chunk           chunk {data.first, m_referrer};
-		phx::Serializer ser;
-		ser.setBuffer(data.second);
-		ser << chunk;
+		Chunk       chunk {data.first, m_referrer};
+		phx::Reader reader(data.second);
+		if (!chunk.receive(reader, *m_networkMetadataKeys))
+		{
+			LOG_WARNING("CHUNK_VIEW") << "Received a damaged chunk";
+			continue;
+		}
+
+		// this came from the network, there's no need to send it back.
+		chunk.markClean(Chunk::NETWORK);
+
+		const math::vec3i coords = chunk.getChunkCoords();
+		auto              loaded = m_chunks.find(coords);
+		if (loaded == m_chunks.end())
+		{
+			m_chunks.emplace(coords, std::make_unique<Chunk>(std::move(chunk)));
+			track(coords);
+			continue;
+		}
 
-		m_chunks.emplace(chunk.getChunkPos(), chunk);
+		// the server sent it again because it changed. The blocks are
+		// swapped in place, so the chunk keeps its neighbours and anything
+		// pointing at it, and is measured again like any other change.
+		Chunk& existing = *loaded->second;
+		existing.m_data = std::move(chunk.m_data);
+		existing.markDirty({{0, 0, 0},
+		                    {Chunk::CHUNK_WIDTH - 1, Chunk::CHUNK_HEIGHT - 1,
+		                     Chunk::CHUNK_DEPTH - 1}});
+		existing.markClean(Chunk::NETWORK);
+
+		dispatchToSubscriber({MapEvent::CHUNK_UPDATE, &existing});
 	}
 }
 
-bool Map::loadChunk(const phx::math::vec3& chunkPos)
+std::optional<Chunk> Map::loadChunk(const phx::math::vec3i& coords)
 {
-	std::ifstream saveFile(toSavePath(static_cast<phx::math::vec3i>(chunkPos)),
-	                       std::ifstream::binary);
+	// the save is read in place, straight out of the mapped region.
+	std::size_t            index;
+	const RegionFile::View save = getRegion(coords, index).view(index);
+	if (!save)
+	{
+		// the chunk has never been saved.
+		return std::nullopt;
+	}
+
+	const std::byte* data = save.data;
+	std::size_t      size = save.size;
 
-	if (!saveFile)
+	// saves from before compression are read as they are.
+	data::Data decompressed;
+	if (codec::isCompressed(data, size))
 	{
-		// File could not be opened.
-		return false;
+		if (!codec::decompress(data, size, decompressed,
+		                       m_compression.dictionary.get()))
+		{
+			LOG_WARNING("MAP") << "The save of the chunk at " << coords.x
+			                   << ", " << coords.y << ", " << coords.z
+			                   << " can't be decompressed, ignoring it";
+			return std::nullopt;
+		}
+		data = decompressed.data();
+		size = decompressed.size();
 	}
 
-	saveFile.seekg(0, std::ifstream::end);
-	int length = saveFile.tellg();
-	saveFile.seekg(0, std::ifstream::beg);
+	Chunk  chunk {Chunk::toChunkPos(coords), m_referrer};
+	Reader reader(data, size);
+	bool   loaded;
+	if (m_dictionary != nullptr)
+	{
+		loaded = chunk.load(reader, *m_dictionary, *m_metadataKeys);
+	}
+	else
+	{
+		reader >> chunk;
+		loaded = static_cast<bool>(reader);
+	}
 
-	Serializer ser;
-	// auto data = ser.getBuffer().data();
-	data::Data data(length);
-	// char* data = new char [length];
-	saveFile.read((char*) &data[0], length);
-	ser.setBuffer(data);
+	if (!loaded)
+	{
+		LOG_WARNING("MAP") << "The save of the chunk at " << coords.x << ", "
+		                   << coords.y << ", " << coords.z
+		                   << " is damaged, ignoring it";
+		return std::nullopt;
+	}
 
-	Chunk chunk {chunkPos, m_referrer};
-	ser >> chunk;
+	// the chunk is exactly what's on disk.
+	chunk.markClean(Chunk::SAVER);
 
-	m_chunks.emplace(chunkPos, std::move(chunk));
-	return true;
+	return chunk;
 }
 
 // Creates a new chunk and fills it with either grass or air, depending on its
 // position on the y axis. If it is below y = 0, it will be grass. Otherwise
 // air will be generated.
-void Map::generateChunk(const phx::math::vec3& chunkPos)
+// Either way the chunk is uniform, so it is stored as a single block type and
+// its save file is a single run.
+Chunk Map::generateChunk(const phx::math::vec3i& coords) const
 {
+	if (m_generator)
+	{
+		return m_generator->generate(coords);
+	}
+
 	BlockType* fillBlock {};
-	// Position type needs to be converted.
-	if (chunkPos.y >= 0)
+	if (coords.y >= 0)
 	{
 		fillBlock =
 		    m_referrer->blocks.get(*m_referrer->referrer.get("core.air"));
@@ -277,26 +869,471 @@ void Map::generateChunk(const phx::math::vec3& chunkPos)
 		    m_referrer->blocks.get(*m_referrer->referrer.get("core.grass"));
 	}
 
-	Chunk             chunk {chunkPos, m_referrer};
-	Chunk::BlockList& blocks = chunk.getBlocks();
-	for (std::size_t i = 0; i < Chunk::CHUNK_MAX_BLOCKS; ++i)
+	return Chunk {Chunk::toChunkPos(coords), m_referrer, fillBlock};
+}
+
+void Map::startWorkers()
+{
+	if (!m_workers.empty())
+	{
+		return;
+	}
+
+	// reading saves mostly waits on the disk, generating them keeps a core
+	// busy, so most of the cores go to generating.
+	const std::size_t cores = std::thread::hardware_concurrency();
+	const std::size_t generators =
+	    std::max<std::size_t>(1, cores > 2 ? cores - 2 : 1);
+
+	for (std::size_t i = 0; i < LOAD_WORKERS; ++i)
+	{
+		m_workers.emplace_back(&Map::runLoadWorker, this);
+	}
+	for (std::size_t i = 0; i < generators; ++i)
+	{
+		m_workers.emplace_back(&Map::runGenerateWorker, this);
+	}
+}
+
+void Map::runLoadWorker()
+{
+	while (true)
+	{
+		Request request;
+		{
+			std::unique_lock<std::mutex> lock(m_workMutex);
+			m_workCondition.wait(
+			    lock, [this]() { return m_stopping || !m_loads.empty(); });
+			if (m_stopping)
+			{
+				return;
+			}
+
+			request = m_loads.top();
+			m_loads.pop();
+
+			// skip copies of requests that were moved up the queue, or that
+			// another worker already has.
+			auto queued = m_queued.find(request.position);
+			if (queued == m_queued.end() ||
+			    queued->second != request.priority)
+			{
+				continue;
+			}
+			m_queued.erase(queued);
+		}
+
+		std::optional<Chunk> chunk = loadChunk(request.position);
+
+		{
+			std::lock_guard<std::mutex> lock(m_workMutex);
+			if (chunk)
+			{
+				m_finished.push_back({request.position, std::move(*chunk)});
+			}
+			else
+			{
+				m_generations.push(request);
+			}
+		}
+
+		if (!chunk)
+		{
+			m_workCondition.notify_all();
+		}
+	}
+}
+
+void Map::runGenerateWorker()
+{
+	while (true)
+	{
+		Request request;
+		{
+			std::unique_lock<std::mutex> lock(m_workMutex);
+			m_workCondition.wait(lock, [this]() {
+				return m_stopping || !m_generations.empty();
+			});
+			if (m_stopping)
+			{
+				return;
+			}
+
+			request = m_generations.top();
+			m_generations.pop();
+		}
+
+		Chunk chunk = generateChunk(request.position);
+
+		std::lock_guard<std::mutex> lock(m_workMutex);
+		m_finished.push_back({request.position, std::move(chunk)});
+	}
+}
+
+std::vector<Chunk*> Map::getUnsavedChunks()
+{
+	collectChanges();
+
+	std::vector<Chunk*>      unsaved;
+	std::vector<math::vec3i> done;
+	for (const auto& edited : m_edited)
+	{
+		Chunk* chunk  = edited.second;
+		auto   saving = m_saving.find(edited.first);
+		if (chunk->isDirty(Chunk::SAVER) &&
+		    (saving == m_saving.end() ||
+		     saving->second != chunk->getVersion()))
+		{
+			unsaved.push_back(chunk);
+		}
+		else
+		{
+			// it's noted again when it next changes, or if the write fails.
+			done.push_back(edited.first);
+		}
+	}
+
+	for (const math::vec3i& coords : done)
+	{
+		m_edited.erase(coords);
+	}
+	return unsaved;
+}
+
+void Map::onChanged(const Chunk& chunk)
+{
+	m_changed.push_back(chunk.getChunkCoords());
+}
+
+void Map::collectChanges()
+{
+	for (const math::vec3i& coords : m_changed)
+	{
+		// it might have been unloaded since.
+		auto chunk = m_chunks.find(coords);
+		if (chunk == m_chunks.end())
+		{
+			continue;
+		}
+
+		Chunk& changed          = *chunk->second;
+		changed.m_owner.changed = false;
+
+		Residency&        residency = m_residency.at(coords);
+		const std::size_t bytes     = measure(changed);
+		m_residentBytes             = m_residentBytes - residency.bytes + bytes;
+		residency.bytes             = bytes;
+
+		// networked maps don't save.
+		if (m_queue == nullptr)
+		{
+			m_edited[coords] = &changed;
+		}
+	}
+	m_changed.clear();
+}
+
+bool Map::queueSave(const Chunk& chunk)
+{
+	if (!chunk.isDirty(Chunk::SAVER))
+	{
+		// the file already matches the chunk.
+		return false;
+	}
+
+	const math::vec3i coords = chunk.getChunkCoords();
+	auto              saving = m_saving.find(coords);
+	if (saving != m_saving.end() && saving->second == chunk.getVersion())
+	{
+		// this version is already on its way.
+		return false;
+	}
+	m_saving[coords] = chunk.getVersion();
+
+	if (!m_flusher.joinable())
+	{
+		m_flusher = std::thread(&Map::runFlusher, this);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_flushMutex);
+		m_unsaved.push_back(chunk.snapshot());
+	}
+	m_flushCondition.notify_one();
+	return true;
+}
+
+void Map::collectSaved()
+{
+	std::vector<Saved> saved;
+	{
+		std::lock_guard<std::mutex> lock(m_flushMutex);
+		saved.swap(m_saved);
+	}
+
+	for (const Saved& done : saved)
+	{
+		// a newer snapshot might have been queued since, it's still on
+		// its way.
+		auto saving = m_saving.find(done.position);
+		if (saving != m_saving.end() && saving->second == done.version)
+		{
+			m_saving.erase(saving);
+		}
+
+		// chunks that failed stay dirty and are tried again.
+		auto chunk = m_chunks.find(done.position);
+		if (chunk == m_chunks.end())
+		{
+			continue;
+		}
+
+		if (done.written)
+		{
+			chunk->second->markClean(Chunk::SAVER, done.version);
+		}
+		else
+		{
+			m_edited[done.position] = chunk->second.get();
+		}
+	}
+}
+
+void Map::waitForFlusher()
+{
+	std::unique_lock<std::mutex> lock(m_flushMutex);
+	m_flushIdle.wait(lock,
+	                 [this]() { return m_unsaved.empty() && !m_writing; });
+}
+
+void Map::runFlusher()
+{
+	std::unique_lock<std::mutex> lock(m_flushMutex);
+	while (true)
+	{
+		m_flushCondition.wait(
+		    lock, [this]() { return m_flushStopped || !m_unsaved.empty(); });
+		if (m_unsaved.empty())
+		{
+			// only stops once everything is written.
+			return;
+		}
+
+		const ChunkSnapshot snapshot = m_unsaved.front();
+		m_unsaved.pop_front();
+		m_writing = true;
+
+		lock.unlock();
+		const std::size_t bytes = write(snapshot);
+		lock.lock();
+
+		m_writing = false;
+		m_saved.push_back(
+		    {snapshot.getChunkCoords(), snapshot.getVersion(), bytes != 0});
+		if (bytes != 0)
+		{
+			++m_flushStats.written;
+			m_flushStats.bytes += bytes;
+		}
+		else
+		{
+			++m_flushStats.failed;
+		}
+
+		if (m_unsaved.empty())
+		{
+			m_flushIdle.notify_all();
+		}
+	}
+}
+
+std::size_t Map::write(const ChunkSnapshot& snapshot)
+{
+	const math::vec3i coords = snapshot.getChunkCoords();
+
+	// without a dictionary the chunk is saved in the network format, which
+	// is only ever read with the fixed encoding.
+	Serializer ser(m_dictionary != nullptr ? Encoding::COMPACT
+	                                       : Encoding::FIXED);
+	if (m_dictionary != nullptr)
+	{
+		snapshot.save(ser, *m_dictionary, *m_metadataKeys);
+	}
+	else
 	{
-		blocks.push_back(fillBlock);
+		ser << snapshot;
 	}
 
-	m_chunks.emplace(chunkPos, std::move(chunk));
+	const data::Data compressed = codec::compress(
+	    ser.getBuffer().data(), ser.getBuffer().size(), m_compression);
 
-	save(chunkPos);
+	// regions write the save somewhere new before pointing at it, a crash
+	// part way through leaves the previous save in place.
+	std::size_t index;
+	RegionFile& region = getRegion(coords, index);
+	if (!region.write(index, compressed.data(), compressed.size()))
+	{
+		LOG_WARNING("MAP") << "Couldn't save the chunk at " << coords.x << ", "
+		                   << coords.y << ", " << coords.z;
+		return 0;
+	}
+
+	return compressed.size();
 }
 
-std::filesystem::path Map::toSavePath(const phx::math::vec3i& chunkPos) const
+void Map::track(const math::vec3i& coords)
 {
-	const std::string posString = std::to_string(chunkPos.x) + '_' +
-	                              std::to_string(chunkPos.y) + '_' +
-	                              std::to_string(chunkPos.z) + ".save";
+	link(coords);
 
-	const std::filesystem::path savePath
-	    = *m_savePath / m_name / posString;
+	Chunk* chunk         = m_chunks.at(coords).get();
+	chunk->m_owner.map   = this;
+	Residency& residency = m_residency[coords];
+	residency.loaded     = true;
+	residency.bytes      = measure(*chunk);
+	m_residentBytes += residency.bytes;
 
-	return savePath;
+	// generated chunks haven't been written yet.
+	if (m_queue == nullptr && chunk->isDirty(Chunk::SAVER))
+	{
+		m_edited[coords] = chunk;
+	}
+
+	// nothing holds on to it yet, so it's the most recently used of the
+	// chunks that could be unloaded.
+	if (residency.references == 0)
+	{
+		m_unused.push_front(coords);
+		residency.unused = m_unused.begin();
+	}
+}
+
+void Map::link(const math::vec3i& coords)
+{
+	Chunk* chunk = m_chunks.at(coords).get();
+	for (std::size_t i = 0; i < Chunk::SIDE_COUNT; ++i)
+	{
+		const auto side     = static_cast<Chunk::Side>(i);
+		auto       neighbor = m_chunks.find(coords + Chunk::getOffset(side));
+		if (neighbor == m_chunks.end())
+		{
+			continue;
+		}
+
+		chunk->m_neighbors.chunks[side] = neighbor->second.get();
+		neighbor->second->m_neighbors.chunks[Chunk::getOpposite(side)] = chunk;
+	}
+}
+
+void Map::unlink(Chunk& chunk)
+{
+	for (std::size_t i = 0; i < Chunk::SIDE_COUNT; ++i)
+	{
+		const auto side     = static_cast<Chunk::Side>(i);
+		Chunk*     neighbor = chunk.m_neighbors.chunks[side];
+		if (neighbor != nullptr)
+		{
+			neighbor->m_neighbors.chunks[Chunk::getOpposite(side)] = nullptr;
+			chunk.m_neighbors.chunks[side]                         = nullptr;
+		}
+	}
+}
+
+void Map::evict()
+{
+	// chunks change size as they're edited, the ones that changed are
+	// measured again.
+	collectChanges();
+
+	while (m_residentBytes > m_memoryBudget && !m_unused.empty())
+	{
+		const math::vec3i coords = m_unused.back();
+		unloadChunk(coords);
+		++m_evicted;
+	}
+}
+
+RegionFile& Map::getRegion(const phx::math::vec3i& coords, std::size_t& index)
+{
+	index                      = RegionFile::toIndex(coords);
+	const math::vec3i position = RegionFile::toRegion(coords);
+
+	// the workers open regions too.
+	std::lock_guard<std::mutex> lock(m_regionMutex);
+
+	std::unique_ptr<RegionFile>& region = m_regions[position];
+	if (region == nullptr)
+	{
+		const std::string name = "r." + std::to_string(position.x) + '.' +
+		                         std::to_string(position.y) + '.' +
+		                         std::to_string(position.z) + ".region";
+
+		region = std::make_unique<RegionFile>(*m_savePath / m_name / name);
+	}
+
+	return *region;
+}
+
+void Map::migrateLegacySaves()
+{
+	namespace fs = std::filesystem;
+
+	std::size_t migrated = 0;
+	std::error_code error;
+	for (const fs::directory_entry& entry :
+	     fs::directory_iterator(*m_savePath / m_name, error))
+	{
+		if (!entry.is_regular_file() || entry.path().extension() != ".save")
+		{
+			continue;
+		}
+
+		// chunks were saved as "x_y_z.save", by the position of their origin.
+		const std::string stem  = entry.path().stem().string();
+		const char*       begin = stem.data();
+		const char*       end   = stem.data() + stem.size();
+
+		int  position[3];
+		bool valid = true;
+		for (int i = 0; i < 3 && valid; ++i)
+		{
+			const auto result = std::from_chars(begin, end, position[i]);
+			valid = result.ec == std::errc() &&
+			        (i == 2 ? result.ptr == end : *result.ptr == '_');
+			begin = result.ptr + 1;
+		}
+
+		if (!valid)
+		{
+			continue;
+		}
+
+		std::ifstream file(entry.path(), std::ifstream::binary);
+		data::Data    data(static_cast<std::size_t>(entry.file_size()));
+		file.read(reinterpret_cast<char*>(data.data()), data.size());
+		if (!file)
+		{
+			continue;
+		}
+		file.close();
+
+		// saves are read the same way wherever they're stored, so they're
+		// moved over as they are.
+		std::size_t index;
+		RegionFile& region = getRegion(
+		    Chunk::toChunkCoords(math::vec3(static_cast<float>(position[0]),
+		                                    static_cast<float>(position[1]),
+		                                    static_cast<float>(position[2]))),
+		    index);
+		if (region.write(index, data.data(), data.size()))
+		{
+			fs::remove(entry.path(), error);
+			++migrated;
+		}
+	}
+
+	if (migrated > 0)
+	{
+		LOG_INFO("MAP") << "Moved " << migrated << " chunks of " << m_name
+		                << " into region files";
+	}
 }
@@ -0,0 +1,451 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Common/Logger.hpp>
+#include <Common/Voxels/RegionFile.hpp>
+
+#include <algorithm>
+
+using namespace phx::voxels;
+
+namespace
+{
+	constexpr char          REGION_MAGIC[4] = {'P', 'H', 'X', 'R'};
+	constexpr std::uint32_t REGION_VERSION  = 1;
+
+	// the magic, the version, the generation, the checksum, then where
+	// every chunk is and how long it is.
+	constexpr std::size_t TABLE_BYTES =
+	    sizeof(REGION_MAGIC) + 4 + 8 + 4 + RegionFile::CHUNKS * 8;
+	constexpr std::size_t TABLE_SECTORS =
+	    (TABLE_BYTES + RegionFile::SECTOR_SIZE - 1) / RegionFile::SECTOR_SIZE;
+	constexpr std::size_t FIRST_DATA_SECTOR = 2 * TABLE_SECTORS;
+
+	void put(std::byte* out, std::uint64_t value, std::size_t bytes)
+	{
+		for (std::size_t i = 0; i < bytes; ++i)
+		{
+			out[i] = std::byte((value >> (8 * (bytes - 1 - i))) & 0xFF);
+		}
+	}
+
+	std::uint64_t get(const std::byte* in, std::size_t bytes)
+	{
+		std::uint64_t value = 0;
+		for (std::size_t i = 0; i < bytes; ++i)
+		{
+			value = (value << 8) | static_cast<std::uint8_t>(in[i]);
+		}
+		return value;
+	}
+
+	// FNV-1a over the generation and the entries.
+	std::uint32_t checksum(const std::byte* begin, const std::byte* end)
+	{
+		std::uint32_t hash = 2166136261u;
+		for (const std::byte* it = begin; it != end; ++it)
+		{
+			hash = (hash ^ static_cast<std::uint8_t>(*it)) * 16777619u;
+		}
+		return hash;
+	}
+} // namespace
+
+RegionFile::RegionFile(std::filesystem::path path) : m_path(std::move(path))
+{
+}
+
+phx::math::vec3i RegionFile::toRegion(const math::vec3i& chunk)
+{
+	return {chunk.x >> SHIFT, chunk.y >> SHIFT, chunk.z >> SHIFT};
+}
+
+std::size_t RegionFile::toIndex(const math::vec3i& chunk)
+{
+	const int x = chunk.x & (SIZE - 1);
+	const int y = chunk.y & (SIZE - 1);
+	const int z = chunk.z & (SIZE - 1);
+	return static_cast<std::size_t>((z * SIZE + y) * SIZE + x);
+}
+
+bool RegionFile::contains(std::size_t index)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return open(false) && m_table[index].sector != 0;
+}
+
+bool RegionFile::read(std::size_t index, data::Data& out)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	out.clear();
+	if (!open(false) || m_table[index].sector == 0)
+	{
+		return false;
+	}
+
+	const Entry entry = m_table[index];
+	out.resize(entry.length);
+	m_file.seekg(static_cast<std::streamoff>(entry.sector * SECTOR_SIZE));
+	m_file.read(reinterpret_cast<char*>(out.data()), entry.length);
+	if (!m_file)
+	{
+		m_file.clear();
+		out.clear();
+		return false;
+	}
+
+	return true;
+}
+
+bool RegionFile::write(std::size_t index, const std::byte* data,
+                       std::size_t size)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (!open(true))
+	{
+		return false;
+	}
+
+	// the data always goes somewhere new, the table still points at the
+	// old save until it's written.
+	const std::size_t sectors = std::max<std::size_t>(1, toSectors(size));
+	const std::size_t start   = allocate(sectors);
+
+	const std::vector<char> padding(sectors * SECTOR_SIZE - size, 0);
+	m_file.seekp(static_cast<std::streamoff>(start * SECTOR_SIZE));
+	m_file.write(reinterpret_cast<const char*>(data), size);
+	m_file.write(padding.data(), padding.size());
+	m_file.flush();
+
+	const Entry old = m_table[index];
+	m_table[index]  = {static_cast<std::uint32_t>(start),
+                      static_cast<std::uint32_t>(size)};
+
+	if (!m_file || !commit())
+	{
+		m_file.clear();
+		m_table[index] = old;
+		std::fill(m_used.begin() + start, m_used.begin() + start + sectors,
+		          false);
+		return false;
+	}
+
+	// the copy that was just overwritten was the last one pointing at what
+	// the commit before freed.
+	for (const auto& [first, count] : m_pending)
+	{
+		std::fill(m_used.begin() + first, m_used.begin() + first + count,
+		          false);
+	}
+	m_pending.clear();
+
+	if (old.sector != 0)
+	{
+		m_pending.emplace_back(old.sector, toSectors(old.length));
+	}
+
+	return true;
+}
+
+RegionFile::View RegionFile::view(std::size_t index)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	View view;
+	if (!open(false) || m_table[index].sector == 0)
+	{
+		return view;
+	}
+
+	const Entry entry = m_table[index];
+	view.m_mapping    = getMapping(entry);
+	if (view.m_mapping == nullptr)
+	{
+		lock.unlock();
+		if (read(index, view.m_copy))
+		{
+			view.data = view.m_copy.data();
+			view.size = view.m_copy.size();
+		}
+		return view;
+	}
+
+	view.data = view.m_mapping->data() + entry.sector * SECTOR_SIZE;
+	view.size = entry.length;
+	return view;
+}
+
+void RegionFile::prefetch(std::size_t index)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (!open(false) || m_table[index].sector == 0)
+	{
+		return;
+	}
+
+	const Entry entry = m_table[index];
+	if (const auto mapping = getMapping(entry))
+	{
+		mapping->prefetch(entry.sector * SECTOR_SIZE, entry.length);
+	}
+}
+
+std::size_t RegionFile::getSectorCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_used.size();
+}
+
+bool RegionFile::open(bool create)
+{
+	namespace fs = std::filesystem;
+
+	if (m_opened)
+	{
+		return true;
+	}
+
+	if (!fs::exists(m_path))
+	{
+		if (!create)
+		{
+			return false;
+		}
+
+		// an empty region, with both copies of the table written so it's
+		// valid from the start.
+		std::ofstream(m_path, std::ios::binary).close();
+		m_file.open(m_path, std::ios::in | std::ios::out | std::ios::binary);
+
+		m_table      = {};
+		m_generation = 0;
+		m_used.assign(FIRST_DATA_SECTOR, true);
+		m_opened = m_file.is_open() && commit() && commit();
+		return m_opened;
+	}
+
+	m_file.open(m_path, std::ios::in | std::ios::out | std::ios::binary);
+	if (!m_file.is_open())
+	{
+		return false;
+	}
+
+	Table         tables[2];
+	std::uint64_t generations[2];
+	const bool    valid[2] = {readTable(0, tables[0], generations[0]),
+                           readTable(1, tables[1], generations[1])};
+
+	if (!valid[0] && !valid[1])
+	{
+		// nothing in the file can be trusted, keep it around for anyone
+		// wanting to recover it and start again.
+		LOG_WARNING("MAP") << "The region " << m_path.string()
+		                   << " is damaged, moving it out of the way";
+
+		m_file.close();
+		std::error_code error;
+		fs::rename(m_path, fs::path(m_path).concat(".damaged"), error);
+		if (error)
+		{
+			return false;
+		}
+		return open(create);
+	}
+
+	const std::size_t newest =
+	    !valid[1] || (valid[0] && generations[0] > generations[1]) ? 0 : 1;
+	m_table      = tables[newest];
+	m_generation = generations[newest];
+
+	const std::size_t fileSectors =
+	    toSectors(static_cast<std::size_t>(fs::file_size(m_path)));
+	m_used.assign(std::max(fileSectors, FIRST_DATA_SECTOR), false);
+	std::fill(m_used.begin(), m_used.begin() + FIRST_DATA_SECTOR, true);
+
+	auto markUsed = [this](const Entry& entry) {
+		const std::size_t end = entry.sector + toSectors(entry.length);
+		if (entry.sector != 0 && end <= m_used.size())
+		{
+			std::fill(m_used.begin() + entry.sector, m_used.begin() + end,
+			          true);
+		}
+	};
+
+	for (const Entry& entry : m_table)
+	{
+		markUsed(entry);
+	}
+
+	// the older copy might still point at saves the newer one has
+	// replaced, they can't be reused until it's overwritten.
+	const std::size_t older = 1 - newest;
+	if (valid[older])
+	{
+		for (std::size_t i = 0; i < CHUNKS; ++i)
+		{
+			const Entry& entry = tables[older][i];
+			if (entry.sector != 0 && entry.sector != m_table[i].sector)
+			{
+				markUsed(entry);
+				m_pending.emplace_back(entry.sector, toSectors(entry.length));
+			}
+		}
+	}
+
+	m_opened = true;
+	return true;
+}
+
+bool RegionFile::readTable(std::size_t copy, Table& table,
+                           std::uint64_t& generation)
+{
+	std::vector<std::byte> bytes(TABLE_BYTES);
+	m_file.seekg(static_cast<std::streamoff>(copy * TABLE_SECTORS *
+	                                         SECTOR_SIZE));
+	m_file.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+	if (!m_file)
+	{
+		m_file.clear();
+		return false;
+	}
+
+	const std::byte* in = bytes.data();
+	if (!std::equal(std::begin(REGION_MAGIC), std::end(REGION_MAGIC), in,
+	                [](char c, std::byte b) { return std::byte(c) == b; }) ||
+	    get(in + 4, 4) != REGION_VERSION)
+	{
+		return false;
+	}
+
+	generation = get(in + 8, 8);
+	if (get(in + 16, 4) !=
+	    (checksum(in + 8, in + 16) ^ checksum(in + 20, in + TABLE_BYTES)))
+	{
+		return false;
+	}
+
+	for (std::size_t i = 0; i < CHUNKS; ++i)
+	{
+		table[i].sector = static_cast<std::uint32_t>(get(in + 20 + i * 8, 4));
+		table[i].length =
+		    static_cast<std::uint32_t>(get(in + 24 + i * 8, 4));
+	}
+	return true;
+}
+
+bool RegionFile::commit()
+{
+	std::vector<std::byte> bytes(TABLE_SECTORS * SECTOR_SIZE);
+	std::byte*             out = bytes.data();
+
+	const std::uint64_t generation = m_generation + 1;
+
+	for (std::size_t i = 0; i < sizeof(REGION_MAGIC); ++i)
+	{
+		out[i] = std::byte(REGION_MAGIC[i]);
+	}
+	put(out + 4, REGION_VERSION, 4);
+	put(out + 8, generation, 8);
+	for (std::size_t i = 0; i < CHUNKS; ++i)
+	{
+		put(out + 20 + i * 8, m_table[i].sector, 4);
+		put(out + 24 + i * 8, m_table[i].length, 4);
+	}
+	put(out + 16,
+	    checksum(out + 8, out + 16) ^ checksum(out + 20, out + TABLE_BYTES), 4);
+
+	// generations alternate between the two copies, so this always
+	// replaces the older one.
+	m_file.seekp(static_cast<std::streamoff>((generation % 2) * TABLE_SECTORS *
+	                                         SECTOR_SIZE));
+	m_file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+	m_file.flush();
+	if (!m_file)
+	{
+		m_file.clear();
+		return false;
+	}
+
+	m_generation = generation;
+	return true;
+}
+
+std::shared_ptr<const phx::MappedFile> RegionFile::getMapping(const Entry& entry)
+{
+	const std::size_t end = entry.sector * SECTOR_SIZE + entry.length;
+	if (m_mapping != nullptr && end <= m_mapping->size())
+	{
+		return m_mapping;
+	}
+
+	// the save is past the end of the old mapping, views still using it
+	// keep it alive.
+	auto mapping = std::make_shared<phx::MappedFile>();
+	if (!mapping->open(m_path) || end > mapping->size())
+	{
+		m_mapping = nullptr;
+		return nullptr;
+	}
+
+	// saves are scattered around the file, reading ahead of one is unlikely
+	// to help with the next.
+	mapping->advise(phx::MappedFile::Access::RANDOM);
+
+	m_mapping = std::move(mapping);
+	return m_mapping;
+}
+
+std::size_t RegionFile::allocate(std::size_t sectors)
+{
+	// the first gap big enough, or the end of the file.
+	std::size_t run = 0;
+	for (std::size_t s = FIRST_DATA_SECTOR; s < m_used.size(); ++s)
+	{
+		run = m_used[s] ? 0 : run + 1;
+		if (run == sectors)
+		{
+			const std::size_t start = s + 1 - sectors;
+			std::fill(m_used.begin() + start, m_used.begin() + s + 1, true);
+			return start;
+		}
+	}
+
+	// a gap at the very end can be grown into.
+	const std::size_t start = m_used.size() - run;
+	m_used.resize(start + sectors, false);
+	std::fill(m_used.begin() + start, m_used.end(), true);
+	return start;
+}
+
+std::size_t RegionFile::toSectors(std::size_t bytes)
+{
+	return (bytes + SECTOR_SIZE - 1) / SECTOR_SIZE;
+}
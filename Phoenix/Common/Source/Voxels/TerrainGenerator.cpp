@@ -0,0 +1,477 @@
+// Copyright 2019-20 Genten Studios
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors
+// may be used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include <Common/Logger.hpp>
+#include <Common/Voxels/TerrainGenerator.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <thread>
+
+using namespace phx::voxels;
+
+namespace
+{
+	// the climate changes slowly, biomes are a few hundred blocks across.
+	const phx::math::Noise::Fractal CLIMATE = {2, 1.f / 512.f, 2.f, .5f};
+
+	// hills are a hundred or so blocks across, with smaller bumps on them.
+	const phx::math::Noise::Fractal HILLS = {4, 1.f / 128.f, 2.f, .5f};
+
+	// the scale of overhangs and dips, and how much they move the ground.
+	constexpr float DENSITY_FREQUENCY = 1.f / 16.f;
+	constexpr float DENSITY_STRENGTH  = .6f;
+
+	// how quickly a biome stops counting towards the height of the columns
+	// around it. Smaller values make for sharper edges between biomes.
+	constexpr float BIOME_BLEND = .05f;
+
+	// every noise field gets its own seed from the seed of the world.
+	std::uint64_t deriveSeed(std::uint64_t seed, std::uint64_t field)
+	{
+		std::uint64_t z = seed + field * 0x9E3779B97F4A7C15ull;
+		z               = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z               = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+} // namespace
+
+TerrainGenerator::TerrainGenerator(BlockReferrer* referrer, std::uint64_t seed)
+    : m_referrer(referrer),
+      m_air(referrer->blocks.get(BlockType::AIR_BLOCK)), m_seed(seed),
+      m_temperature(deriveSeed(seed, 1)), m_humidity(deriveSeed(seed, 2)),
+      m_height(deriveSeed(seed, 3)), m_density(deriveSeed(seed, 4))
+{
+	BlockType* unknown = referrer->blocks.get(BlockType::UNKNOWN_BLOCK);
+
+	Biome fallback;
+	fallback.id      = "core.default";
+	fallback.surface = unknown;
+	fallback.filler  = unknown;
+	fallback.stone   = unknown;
+	m_biomes.push_back(fallback);
+
+	addStage("core.terrain", &TerrainGenerator::placeTerrain);
+	addStage("core.surface", &TerrainGenerator::placeSurface);
+}
+
+bool TerrainGenerator::addBiome(const Biome& biome)
+{
+	if (m_frozen)
+	{
+		LOG_WARNING("TERRAIN") << "The biome " << biome.id
+		                       << " was added after the terrain generator "
+		                          "was frozen, it won't be used";
+		return false;
+	}
+
+	Biome added = biome;
+	if (added.stone == nullptr)
+	{
+		added.stone = m_referrer->blocks.get(BlockType::UNKNOWN_BLOCK);
+	}
+	if (added.filler == nullptr)
+	{
+		added.filler = added.stone;
+	}
+	if (added.surface == nullptr)
+	{
+		added.surface = added.filler;
+	}
+
+	if (m_defaultBiome)
+	{
+		m_biomes.clear();
+		m_defaultBiome = false;
+	}
+
+	auto existing =
+	    std::find_if(m_biomes.begin(), m_biomes.end(),
+	                 [&added](const Biome& b) { return b.id == added.id; });
+	if (existing != m_biomes.end())
+	{
+		*existing = added;
+	}
+	else
+	{
+		m_biomes.push_back(added);
+	}
+
+	// columns worked out with the old biomes are no good anymore.
+	std::lock_guard<std::mutex> lock(m_columnMutex);
+	m_columns.clear();
+	m_columnOrder.clear();
+	return true;
+}
+
+void TerrainGenerator::registerAPI(cms::ModManager* manager)
+{
+	manager->registerFunction(
+	    "voxel.terrain.registerBiome", [this](sol::table luaBiome) {
+		    Biome biome;
+		    biome.id          = luaBiome.get<std::string>("id");
+		    biome.temperature = luaBiome.get_or("temperature", 0.f);
+		    biome.humidity    = luaBiome.get_or("humidity", 0.f);
+		    biome.height      = luaBiome.get_or("height", 0.f);
+		    biome.variation   = luaBiome.get_or("variation", 12.f);
+		    biome.fillerDepth = luaBiome.get_or("fillerDepth", 3);
+
+		    // the filler defaults to the surface and the stone to the filler.
+		    const std::string surface = luaBiome.get<std::string>("surface");
+		    const std::string filler =
+		        luaBiome.get_or<std::string>("filler", surface);
+		    const std::string stone =
+		        luaBiome.get_or<std::string>("stone", filler);
+		    biome.surface = m_referrer->getByID(surface);
+		    biome.filler  = m_referrer->getByID(filler);
+		    biome.stone   = m_referrer->getByID(stone);
+
+		    addBiome(biome);
+	    });
+}
+
+bool TerrainGenerator::addStage(const std::string& id, Stage stage)
+{
+	if (m_frozen)
+	{
+		LOG_WARNING("TERRAIN") << "The stage " << id
+		                       << " was added after the terrain generator "
+		                          "was frozen, it won't be run";
+		return false;
+	}
+
+	const auto matches = [&id](const std::pair<std::string, Stage>& s) {
+		return s.first == id;
+	};
+	auto existing = std::find_if(m_stages.begin(), m_stages.end(), matches);
+	if (existing != m_stages.end())
+	{
+		existing->second = std::move(stage);
+		return true;
+	}
+
+	m_stages.emplace_back(id, std::move(stage));
+	return true;
+}
+
+bool TerrainGenerator::removeStage(const std::string& id)
+{
+	if (m_frozen)
+	{
+		LOG_WARNING("TERRAIN") << "The stage " << id
+		                       << " was removed after the terrain generator "
+		                          "was frozen, it will still be run";
+		return false;
+	}
+
+	const auto matches = [&id](const std::pair<std::string, Stage>& s) {
+		return s.first == id;
+	};
+	m_stages.erase(std::remove_if(m_stages.begin(), m_stages.end(), matches),
+	               m_stages.end());
+	return true;
+}
+
+std::vector<std::string> TerrainGenerator::getStages() const
+{
+	std::vector<std::string> stages;
+	stages.reserve(m_stages.size());
+	for (const auto& stage : m_stages)
+	{
+		stages.push_back(stage.first);
+	}
+	return stages;
+}
+
+Chunk TerrainGenerator::generate(const math::vec3i& coords) const
+{
+	Chunk::BlockList blocks(Chunk::CHUNK_MAX_BLOCKS, m_air);
+
+	const std::shared_ptr<const Column> column = getColumn(coords.x, coords.z);
+
+	Context context {*this, coords, *column, blocks};
+	for (const auto& stage : m_stages)
+	{
+		stage.second(context);
+	}
+
+	return Chunk(Chunk::toChunkPos(coords), m_referrer, blocks);
+}
+
+std::vector<Chunk> TerrainGenerator::generate(
+    const std::vector<math::vec3i>& coords, std::size_t threads) const
+{
+	// every thread takes the next chunk until there are none left, each
+	// chunk goes in its own slot so the order threads finish in doesn't
+	// matter.
+	std::vector<std::optional<Chunk>> generated(coords.size());
+	std::atomic<std::size_t>          next {0};
+
+	const auto work = [this, &coords, &generated, &next]() {
+		for (std::size_t i = next++; i < coords.size(); i = next++)
+		{
+			generated[i].emplace(generate(coords[i]));
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (std::size_t i = 1; i < threads; ++i)
+	{
+		workers.emplace_back(work);
+	}
+	work();
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+
+	std::vector<Chunk> chunks;
+	chunks.reserve(generated.size());
+	for (std::optional<Chunk>& chunk : generated)
+	{
+		chunks.push_back(std::move(*chunk));
+	}
+	return chunks;
+}
+
+std::shared_ptr<const TerrainGenerator::Column> TerrainGenerator::getColumn(
+    int x, int z) const
+{
+	const math::vec3i key {x, 0, z};
+	{
+		std::lock_guard<std::mutex> lock(m_columnMutex);
+		auto                        cached = m_columns.find(key);
+		if (cached != m_columns.end())
+		{
+			++m_columnHits;
+			return cached->second;
+		}
+	}
+
+	// worked out without the lock, so other columns aren't held up.
+	++m_columnMisses;
+	auto column = std::make_shared<const Column>(makeColumn(x, z));
+
+	std::lock_guard<std::mutex> lock(m_columnMutex);
+
+	// another thread might have beaten us to it, both are the same anyway.
+	auto inserted = m_columns.try_emplace(key, column);
+	if (!inserted.second)
+	{
+		return inserted.first->second;
+	}
+
+	m_columnOrder.push_back(key);
+	if (m_columnOrder.size() > COLUMN_CACHE_SIZE)
+	{
+		m_columns.erase(m_columnOrder.front());
+		m_columnOrder.pop_front();
+	}
+
+	return column;
+}
+
+TerrainGenerator::ColumnStats TerrainGenerator::getColumnStats() const
+{
+	return {m_columnHits.load(), m_columnMisses.load()};
+}
+
+TerrainGenerator::Column TerrainGenerator::makeColumn(int x, int z) const
+{
+	Column column;
+
+	const BlockPos origin = ChunkPos(x, 0, z).getOrigin();
+
+	std::array<float, Chunk::CHUNK_WIDTH> temperature;
+	std::array<float, Chunk::CHUNK_WIDTH> humidity;
+	std::array<float, Chunk::CHUNK_WIDTH> hills;
+
+	column.minHeight = std::numeric_limits<float>::max();
+	column.maxHeight = std::numeric_limits<float>::lowest();
+
+	for (int bz = 0; bz < Chunk::CHUNK_DEPTH; ++bz)
+	{
+		const float wx = static_cast<float>(origin.x);
+		const float wz = static_cast<float>(origin.z + bz);
+
+		// a row at a time, so the noise can be sampled without branching
+		// on anything but the position.
+		m_temperature.getFractalRow(temperature.data(), temperature.size(), wx,
+		                            wz, 1.f, CLIMATE);
+		m_humidity.getFractalRow(humidity.data(), humidity.size(), wx, wz,
+		                         1.f, CLIMATE);
+		m_height.getFractalRow(hills.data(), hills.size(), wx, wz, 1.f,
+		                       HILLS);
+
+		for (int bx = 0; bx < Chunk::CHUNK_WIDTH; ++bx)
+		{
+			// the closest biome is picked, the height is blended from all
+			// of them weighted by how close they are.
+			std::size_t nearest         = 0;
+			float       nearestDistance = std::numeric_limits<float>::max();
+			float       weights         = 0.f;
+			float       height          = 0.f;
+			for (std::size_t b = 0; b < m_biomes.size(); ++b)
+			{
+				const Biome& biome = m_biomes[b];
+				const float  dt    = temperature[bx] - biome.temperature;
+				const float  dh    = humidity[bx] - biome.humidity;
+				const float  d     = dt * dt + dh * dh;
+				if (d < nearestDistance)
+				{
+					nearest         = b;
+					nearestDistance = d;
+				}
+
+				const float weight =
+				    1.f / ((d + BIOME_BLEND) * (d + BIOME_BLEND));
+				weights += weight;
+				height += weight * (biome.height + biome.variation * hills[bx]);
+			}
+
+			const std::size_t i = Column::getIndex(bx, bz);
+			column.biome[i]     = static_cast<std::uint16_t>(nearest);
+			column.height[i]    = height / weights;
+
+			column.minHeight = std::min(column.minHeight, column.height[i]);
+			column.maxHeight = std::max(column.maxHeight, column.height[i]);
+		}
+	}
+
+	return column;
+}
+
+bool TerrainGenerator::isGround(const Column&   column,
+                                const BlockPos& position) const
+{
+	const LocalPos local = position.getLocal();
+	const float    above = static_cast<float>(position.y) -
+	                    column.height[Column::getIndex(local.x, local.z)];
+
+	// the noise can't move the ground this far.
+	if (above >= static_cast<float>(OVERHANG))
+	{
+		return false;
+	}
+	if (above <= -static_cast<float>(OVERHANG))
+	{
+		return true;
+	}
+
+	const float noise = m_density.get(
+	    static_cast<float>(position.x) * DENSITY_FREQUENCY,
+	    static_cast<float>(position.y) * DENSITY_FREQUENCY,
+	    static_cast<float>(position.z) * DENSITY_FREQUENCY);
+
+	return -above / static_cast<float>(OVERHANG) + DENSITY_STRENGTH * noise >
+	       0.f;
+}
+
+void TerrainGenerator::placeTerrain(Context& context)
+{
+	const BlockPos origin = context.chunk.getOrigin();
+
+	// chunks above the highest hill are left as air.
+	if (static_cast<float>(origin.y) >=
+	    context.column.maxHeight + static_cast<float>(OVERHANG))
+	{
+		return;
+	}
+
+	for (int z = 0; z < Chunk::CHUNK_DEPTH; ++z)
+	{
+		for (int x = 0; x < Chunk::CHUNK_WIDTH; ++x)
+		{
+			BlockType* stone = context.getBiome(x, z).stone;
+			for (int y = 0; y < Chunk::CHUNK_HEIGHT; ++y)
+			{
+				if (context.generator.isGround(context.column,
+				                               origin.offset(x, y, z)))
+				{
+					context.blocks[LocalPos(x, y, z).getIndex()] = stone;
+				}
+			}
+		}
+	}
+}
+
+void TerrainGenerator::placeSurface(Context& context)
+{
+	const BlockPos origin = context.chunk.getOrigin();
+	if (static_cast<float>(origin.y) >=
+	    context.column.maxHeight + static_cast<float>(OVERHANG))
+	{
+		return;
+	}
+
+	const BlockType* air = context.generator.m_air;
+	for (int z = 0; z < Chunk::CHUNK_DEPTH; ++z)
+	{
+		for (int x = 0; x < Chunk::CHUNK_WIDTH; ++x)
+		{
+			const Biome& biome = context.getBiome(x, z);
+
+			// the ground above the chunk counts too, so the layers line up
+			// with the chunk above.
+			int depth = 0;
+			while (depth <= biome.fillerDepth &&
+			       context.generator.isGround(
+			           context.column,
+			           origin.offset(x, Chunk::CHUNK_HEIGHT + depth, z)))
+			{
+				++depth;
+			}
+
+			for (int y = Chunk::CHUNK_HEIGHT - 1; y >= 0; --y)
+			{
+				BlockType*& block =
+				    context.blocks[LocalPos(x, y, z).getIndex()];
+				if (block == air)
+				{
+					depth = 0;
+					continue;
+				}
+
+				if (block == biome.stone)
+				{
+					if (depth == 0)
+					{
+						block = biome.surface;
+					}
+					else if (depth <= biome.fillerDepth)
+					{
+						block = biome.filler;
+					}
+				}
+
+				++depth;
+			}
+		}
+	}
+}
@@ -1,2 +1,9 @@
 #define CATCH_CONFIG_MAIN
+
+// the benchmark runner is compiled along with main, the test target defines
+// this for every other test file.
+#ifndef CATCH_CONFIG_ENABLE_BENCHMARKING
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#endif
+
 #include <catch2/catch.hpp>
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include <catch2/catch.hpp>
+
+#include <Common/Math/Noise.hpp>
+
+#include <array>
+#include <cmath>
+
+using namespace phx::math;
+
+TEST_CASE("Gradient Noise", "[Noise]")
+{
+	const Noise noise(1234);
+
+	SECTION("The same seed gives the same noise")
+	{
+		const Noise same(1234);
+		const Noise other(4321);
+
+		bool differs = false;
+		for (int i = 0; i < 1000; ++i)
+		{
+			const float x = static_cast<float>(i) * 0.37f;
+			const float y = static_cast<float>(i) * -0.19f;
+			REQUIRE(noise.get(x, y) == same.get(x, y));
+			REQUIRE(noise.get(x, y, x) == same.get(x, y, x));
+			differs = differs || noise.get(x, y) != other.get(x, y);
+		}
+		REQUIRE(differs);
+	}
+
+	SECTION("Noise stays between -1 and 1")
+	{
+		float lowest  = 0.f;
+		float highest = 0.f;
+		for (int i = 0; i < 100000; ++i)
+		{
+			const float x = static_cast<float>(i % 313) * 0.173f - 20.f;
+			const float y = static_cast<float>(i / 313) * 0.211f - 30.f;
+			const float z = static_cast<float>(i % 29) * 0.731f;
+
+			for (float value : {noise.get(x, y), noise.get(x, y, z)})
+			{
+				lowest  = std::min(lowest, value);
+				highest = std::max(highest, value);
+			}
+		}
+
+		REQUIRE(lowest >= -1.f);
+		REQUIRE(highest <= 1.f);
+
+		// and uses most of that range.
+		REQUIRE(lowest < -0.5f);
+		REQUIRE(highest > 0.5f);
+	}
+
+	SECTION("Noise is zero on the lattice and smooth in between")
+	{
+		REQUIRE(noise.get(3.f, -7.f) == 0.f);
+		REQUIRE(noise.get(3.f, -7.f, 12.f) == 0.f);
+
+		for (int i = 0; i < 1000; ++i)
+		{
+			const float x = static_cast<float>(i) * 0.01f;
+			REQUIRE(std::abs(noise.get(x, 0.5f) - noise.get(x + 0.001f, 0.5f)) <
+			        0.01f);
+		}
+	}
+
+	SECTION("Rows are the same as sampling one at a time")
+	{
+		std::array<float, 37> row;
+		noise.getRow(row.data(), row.size(), -5.25f, 3.5f, 0.125f);
+		for (std::size_t i = 0; i < row.size(); ++i)
+		{
+			REQUIRE(row[i] ==
+			        noise.get(-5.25f + static_cast<float>(i) * 0.125f, 3.5f));
+		}
+
+		const Noise::Fractal fractal;
+		noise.getFractalRow(row.data(), row.size(), 100.f, -40.f, 1.f,
+		                    fractal);
+		for (std::size_t i = 0; i < row.size(); ++i)
+		{
+			const float x = 100.f + static_cast<float>(i);
+			REQUIRE(row[i] == noise.getFractal(x, -40.f, fractal));
+		}
+	}
+}
@@ -8,4 +8,27 @@ TEST_CASE("Vec3 Addition", "[Vec3]")
 {
 	REQUIRE(Vector3<int> {1, 1, 1} + Vector3<int> {1, 1, 1} ==
 	        Vector3<int> {2, 2, 2});
-}
\ No newline at end of file
+}
+
+TEST_CASE("Vec3 Morton Hashing", "[Vec3]")
+{
+	using phx::math::MortonHasher;
+
+	// the axes are interleaved x first.
+	REQUIRE(MortonHasher::morton(Vector3<int> {1, 0, 0}) == 1);
+	REQUIRE(MortonHasher::morton(Vector3<int> {0, 1, 0}) == 2);
+	REQUIRE(MortonHasher::morton(Vector3<int> {0, 0, 1}) == 4);
+	REQUIRE(MortonHasher::morton(Vector3<int> {3, 0, 0}) == 9);
+	REQUIRE(MortonHasher::morton(Vector3<int> {-1, -1, -1}) ==
+	        (std::uint64_t(1) << 63) - 1);
+
+	// swapping axes around doesn't collide.
+	MortonHasher hasher;
+	REQUIRE(hasher(Vector3<int> {16, 0, 0}) != hasher(Vector3<int> {0, 16, 0}));
+	REQUIRE(hasher(Vector3<int> {16, 0, 0}) != hasher(Vector3<int> {0, 0, 16}));
+	REQUIRE(hasher(Vector3<int> {1, 2, 3}) != hasher(Vector3<int> {3, 2, 1}));
+
+	phx::math::Vector3Hasher floatHasher;
+	REQUIRE(floatHasher(Vector3<float> {16, 0, 0}) !=
+	        floatHasher(Vector3<float> {0, 16, 0}));
+}
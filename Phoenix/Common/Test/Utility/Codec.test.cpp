@@ -0,0 +1,261 @@
+#include <catch2/catch.hpp>
+
+#include <Common/Utility/Codec.hpp>
+#include <Common/Voxels/Chunk.hpp>
+#include <Common/Voxels/RegionFile.hpp>
+
+#include "../Voxels/TestBlocks.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <random>
+
+using namespace phx;
+
+namespace
+{
+	data::Data randomBytes(std::size_t size, std::uint32_t seed)
+	{
+		std::mt19937 rng(seed);
+		data::Data   data(size);
+		for (std::byte& byte : data)
+		{
+			byte = std::byte(rng() & 0xFF);
+		}
+		return data;
+	}
+
+	// chunk saves the way Map writes them, terrain with a few ores.
+	std::vector<data::Data> makeChunkSaves(std::size_t count)
+	{
+		static voxels::BlockReferrer   referrer;
+		static voxels::BlockDictionary dictionary;
+
+		std::vector<voxels::BlockType*> types;
+		for (const char* id : {"core.stone", "core.dirt", "core.grass",
+		                       "core.coal_ore", "core.iron_ore"})
+		{
+			types.push_back(voxels::addTestBlock(referrer, id));
+		}
+
+		std::mt19937            rng(7);
+		std::vector<data::Data> saves;
+		for (std::size_t c = 0; c < count; ++c)
+		{
+			voxels::Chunk chunk({float(c), 0, 0}, &referrer, types[0]);
+			const int     top = 4 + int(c % 8);
+			chunk.fill({{0, top, 0}, {15, 15, 15}},
+			           referrer.blocks.get(voxels::BlockType::AIR_BLOCK));
+			chunk.fill({{0, top - 3, 0}, {15, top - 1, 15}}, types[1]);
+			chunk.fill({{0, top, 0}, {15, top, 15}}, types[2]);
+			for (int ore = 0; ore < 20; ++ore)
+			{
+				chunk.setBlockAt({float(rng() % 16), float(rng() % top),
+				                  float(rng() % 16)},
+				                 {types[3 + rng() % 2], nullptr});
+			}
+
+			Serializer ser;
+			ser << chunk;
+			saves.push_back(ser.getBuffer());
+		}
+		return saves;
+	}
+} // namespace
+
+TEST_CASE("Validate Compression Codecs", "[Codec]")
+{
+	const std::vector<data::Data> inputs = {
+	    {},
+	    {std::byte {1}, std::byte {2}},
+	    data::Data(100000, std::byte {7}),
+	    randomBytes(5000, 1),
+	    makeChunkSaves(1)[0],
+	};
+
+	SECTION("Everything survives a round trip at every level")
+	{
+		for (const data::Data& input : inputs)
+		{
+			for (int level = codec::LZCodec::MIN_LEVEL;
+			     level <= codec::LZCodec::MAX_LEVEL; level += 4)
+			{
+				const codec::Options options {codec::Type::LZ, level, nullptr};
+				const data::Data     frame =
+				    codec::compress(input.data(), input.size(), options);
+				REQUIRE(codec::isCompressed(frame.data(), frame.size()));
+
+				data::Data output;
+				REQUIRE(codec::decompress(frame.data(), frame.size(), output));
+				REQUIRE(output == input);
+			}
+		}
+	}
+
+	SECTION("Runs compress and random data is stored as it is")
+	{
+		const data::Data& runs = inputs[2];
+		const data::Data  small =
+		    codec::compress(runs.data(), runs.size(), codec::NETWORK);
+		REQUIRE(small.size() < 1000);
+
+		const data::Data& noise = inputs[3];
+		const data::Data  stored =
+		    codec::compress(noise.data(), noise.size(), codec::DISK);
+		REQUIRE(stored[4] == std::byte(codec::Type::STORE));
+		REQUIRE(stored.size() < noise.size() + 16);
+	}
+
+	SECTION("Data that isn't a frame or is damaged is rejected")
+	{
+		const data::Data& input = inputs[4];
+		data::Data        frame =
+		    codec::compress(input.data(), input.size(), codec::DISK);
+
+		data::Data output;
+		REQUIRE_FALSE(codec::decompress(input.data(), input.size(), output));
+		REQUIRE_FALSE(
+		    codec::decompress(frame.data(), frame.size() / 2, output));
+
+		// a raw size the payload could never expand to.
+		data::Data oversized = frame;
+		oversized[6]         = std::byte {0x7F};
+		REQUIRE_FALSE(
+		    codec::decompress(oversized.data(), oversized.size(), output));
+
+		// an unknown codec.
+		frame[4] = std::byte {200};
+		REQUIRE_FALSE(codec::decompress(frame.data(), frame.size(), output));
+	}
+
+	SECTION("Frames compressed with a dictionary need the same one")
+	{
+		const std::vector<data::Data> samples = makeChunkSaves(32);
+		auto                          dictionary =
+		    std::make_shared<codec::Dictionary>(
+		        codec::Dictionary::train(samples, 4096));
+		REQUIRE(!dictionary->getContent().empty());
+		REQUIRE(dictionary->getContent().size() <= 4096);
+
+		const data::Data& input = inputs[4];
+		const data::Data  plain =
+		    codec::compress(input.data(), input.size(), codec::NETWORK);
+		const data::Data withDictionary = codec::compress(
+		    input.data(), input.size(), {codec::Type::LZ, 1, dictionary});
+		REQUIRE(withDictionary.size() < plain.size());
+
+		data::Data output;
+		REQUIRE_FALSE(codec::decompress(withDictionary.data(),
+		                                withDictionary.size(), output));
+		REQUIRE(codec::decompress(withDictionary.data(), withDictionary.size(),
+		                          output, dictionary.get()));
+		REQUIRE(output == input);
+
+		const codec::Dictionary other(randomBytes(4096, 2));
+		REQUIRE_FALSE(codec::decompress(withDictionary.data(),
+		                                withDictionary.size(), output, &other));
+	}
+}
+
+TEST_CASE("Compression Codec Throughput", "[!benchmark][Codec]")
+{
+	// every chunk in the regions of every save in the working directory,
+	// or generated chunks if there aren't any.
+	std::vector<data::Data> saves;
+	if (std::filesystem::exists("Saves"))
+	{
+		for (const auto& entry :
+		     std::filesystem::recursive_directory_iterator("Saves"))
+		{
+			if (entry.path().extension() != ".region")
+			{
+				continue;
+			}
+
+			voxels::RegionFile region(entry.path());
+			for (std::size_t index = 0; index < voxels::RegionFile::CHUNKS;
+			     ++index)
+			{
+				data::Data save;
+				if (!region.read(index, save))
+				{
+					continue;
+				}
+
+				// chunks are benchmarked from what they were before they
+				// were compressed, saved with a dictionary they're skipped.
+				if (codec::isCompressed(save.data(), save.size()))
+				{
+					data::Data raw;
+					if (!codec::decompress(save.data(), save.size(), raw))
+					{
+						continue;
+					}
+					save = std::move(raw);
+				}
+				saves.push_back(std::move(save));
+			}
+		}
+	}
+	if (saves.empty())
+	{
+		saves = makeChunkSaves(256);
+	}
+
+	std::size_t rawSize = 0;
+	for (const data::Data& save : saves)
+	{
+		rawSize += save.size();
+	}
+
+	const auto dictionary = std::make_shared<codec::Dictionary>(
+	    codec::Dictionary::train(saves, 16 * 1024));
+
+	for (const codec::Options& options :
+	     {codec::NETWORK, codec::DISK,
+	      codec::Options {codec::Type::LZ, 1, dictionary}})
+	{
+		std::vector<data::Data> frames;
+		std::size_t             compressedSize = 0;
+
+		const auto start = std::chrono::steady_clock::now();
+		for (const data::Data& save : saves)
+		{
+			frames.push_back(codec::compress(save.data(), save.size(), options));
+			compressedSize += frames.back().size();
+		}
+		const auto middle = std::chrono::steady_clock::now();
+
+		data::Data output;
+		for (const data::Data& frame : frames)
+		{
+			codec::decompress(frame.data(), frame.size(), output,
+			                  dictionary.get());
+		}
+		const auto end = std::chrono::steady_clock::now();
+
+		const double megabytes = double(rawSize) / (1024 * 1024);
+		const double compressSeconds =
+		    std::chrono::duration<double>(middle - start).count();
+		const double decompressSeconds =
+		    std::chrono::duration<double>(end - middle).count();
+
+		WARN("level " << options.level
+		              << (options.dictionary ? " + dictionary" : "") << ": "
+		              << saves.size() << " chunks, ratio "
+		              << double(rawSize) / compressedSize << ", compress "
+		              << megabytes / compressSeconds << " MB/s, decompress "
+		              << megabytes / decompressSeconds << " MB/s");
+	}
+
+	BENCHMARK("Compress a chunk for the network")
+	{
+		return codec::compress(saves[0].data(), saves[0].size(),
+		                       codec::NETWORK);
+	};
+
+	BENCHMARK("Compress a chunk for saving")
+	{
+		return codec::compress(saves[0].data(), saves[0].size(), codec::DISK);
+	};
+}
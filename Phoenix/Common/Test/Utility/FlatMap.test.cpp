@@ -0,0 +1,241 @@
+#include <catch2/catch.hpp>
+
+#include <Common/Math/Math.hpp>
+#include <Common/Utility/FlatMap.hpp>
+
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace phx;
+
+namespace
+{
+	using ChunkMap = FlatMap<math::vec3i, int, math::MortonHasher,
+	                         math::Vector3KeyComparator>;
+
+	// what chunks used to be hashed with, for comparison.
+	struct XorHasher
+	{
+		std::size_t operator()(const math::vec3i& k) const
+		{
+			return std::hash<int>()(k.x) ^ std::hash<int>()(k.y) ^
+			       std::hash<int>()(k.z);
+		}
+	};
+
+	// the chunks around a player, as a box about as wide as it is tall.
+	std::vector<math::vec3i> makeChunks(std::size_t count)
+	{
+		int side = 1;
+		while (static_cast<std::size_t>(side * side * side) < count)
+		{
+			++side;
+		}
+
+		std::vector<math::vec3i> chunks;
+		for (int z = 0; z < side && chunks.size() < count; ++z)
+		{
+			for (int y = 0; y < side && chunks.size() < count; ++y)
+			{
+				for (int x = 0; x < side && chunks.size() < count; ++x)
+				{
+					chunks.emplace_back(x - side / 2, y - side / 2,
+					                    z - side / 2);
+				}
+			}
+		}
+		return chunks;
+	}
+} // namespace
+
+TEST_CASE("Flat Map Basics", "[FlatMap]")
+{
+	ChunkMap map;
+	REQUIRE(map.empty());
+	REQUIRE(map.find({0, 0, 0}) == map.end());
+	REQUIRE(map.begin() == map.end());
+
+	SECTION("Entries are found by their key")
+	{
+		REQUIRE(map.try_emplace({1, 2, 3}, 4).second);
+		REQUIRE_FALSE(map.try_emplace({1, 2, 3}, 5).second);
+		map[{-1, -2, -3}] = 6;
+
+		REQUIRE(map.size() == 2);
+		REQUIRE(map.at({1, 2, 3}) == 4);
+		REQUIRE(map.find({-1, -2, -3})->second == 6);
+		REQUIRE(map.contains({1, 2, 3}));
+		REQUIRE_FALSE(map.contains({3, 2, 1}));
+	}
+
+	SECTION("Values stay valid while the table grows if they're pointers")
+	{
+		FlatMap<math::vec3i, std::unique_ptr<int>, math::MortonHasher,
+		        math::Vector3KeyComparator>
+		    pointers;
+
+		auto first = pointers.emplace({0, 0, 0}, std::make_unique<int>(7));
+		int* value = first.first->second.get();
+		for (int i = 1; i < 1000; ++i)
+		{
+			pointers.emplace({i, 0, 0}, std::make_unique<int>(i));
+		}
+
+		REQUIRE(pointers.at({0, 0, 0}).get() == value);
+		REQUIRE(*value == 7);
+	}
+
+	SECTION("Erasing keeps every other entry reachable")
+	{
+		// a small table, so entries probe past each other a lot.
+		const std::vector<math::vec3i> chunks = makeChunks(200);
+		for (std::size_t i = 0; i < chunks.size(); ++i)
+		{
+			map[chunks[i]] = static_cast<int>(i);
+		}
+
+		for (std::size_t i = 0; i < chunks.size(); i += 2)
+		{
+			REQUIRE(map.erase(chunks[i]) == 1);
+		}
+		REQUIRE(map.erase(chunks[0]) == 0);
+
+		REQUIRE(map.size() == chunks.size() / 2);
+		for (std::size_t i = 0; i < chunks.size(); ++i)
+		{
+			const auto it = map.find(chunks[i]);
+			if (i % 2 == 0)
+			{
+				REQUIRE(it == map.end());
+			}
+			else
+			{
+				REQUIRE(it != map.end());
+				REQUIRE(it->second == static_cast<int>(i));
+			}
+		}
+
+		std::size_t visited = 0;
+		for (const auto& entry : map)
+		{
+			REQUIRE(entry.second % 2 == 1);
+			++visited;
+		}
+		REQUIRE(visited == map.size());
+	}
+
+	SECTION("It behaves like std::unordered_map")
+	{
+		std::unordered_map<math::vec3i, int, math::MortonHasher,
+		                   math::Vector3KeyComparator>
+		    expected;
+
+		std::mt19937                       random(42);
+		std::uniform_int_distribution<int> coord(-8, 8);
+		std::uniform_int_distribution<int> action(0, 2);
+		for (int i = 0; i < 20000; ++i)
+		{
+			const math::vec3i key(coord(random), coord(random), coord(random));
+			switch (action(random))
+			{
+			case 0:
+				map[key] = i;
+				expected[key] = i;
+				break;
+			case 1:
+				REQUIRE(map.erase(key) == expected.erase(key));
+				break;
+			default:
+			{
+				const auto found = expected.find(key);
+				const auto it    = map.find(key);
+				REQUIRE((it == map.end()) == (found == expected.end()));
+				if (found != expected.end())
+				{
+					REQUIRE(it->second == found->second);
+				}
+			}
+			}
+		}
+
+		REQUIRE(map.size() == expected.size());
+
+		map.clear();
+		REQUIRE(map.empty());
+		REQUIRE(map.begin() == map.end());
+	}
+}
+
+TEST_CASE("Flat Map Chunk Lookups", "[!benchmark][FlatMap]")
+{
+	for (std::size_t count : {10000, 100000})
+	{
+		const std::vector<math::vec3i> chunks = makeChunks(count);
+		const std::string              name   = std::to_string(count);
+
+		// how many chunks land in a slot that's already taken, if the table
+		// is twice the size of the amount of chunks.
+		std::size_t slots = 1;
+		while (slots < count * 2)
+		{
+			slots *= 2;
+		}
+		auto collisions = [&chunks, slots](auto hasher) {
+			std::unordered_set<std::size_t> used;
+			for (const math::vec3i& chunk : chunks)
+			{
+				used.insert(hasher(chunk) & (slots - 1));
+			}
+			return chunks.size() - used.size();
+		};
+		WARN(name << " chunks, collisions with xor: "
+		          << collisions(XorHasher()) << ", with morton: "
+		          << collisions(math::MortonHasher()));
+
+		std::unordered_map<math::vec3i, int, XorHasher,
+		                   math::Vector3KeyComparator>
+		    xorMap;
+		std::unordered_map<math::vec3i, int, math::MortonHasher,
+		                   math::Vector3KeyComparator>
+		         mortonMap;
+		ChunkMap flatMap;
+		for (const math::vec3i& chunk : chunks)
+		{
+			xorMap[chunk]    = chunk.x;
+			mortonMap[chunk] = chunk.x;
+			flatMap[chunk]   = chunk.x;
+		}
+
+		BENCHMARK("Look up " + name + " chunks, unordered_map with xor")
+		{
+			int sum = 0;
+			for (const math::vec3i& chunk : chunks)
+			{
+				sum += xorMap.find(chunk)->second;
+			}
+			return sum;
+		};
+
+		BENCHMARK("Look up " + name + " chunks, unordered_map with morton")
+		{
+			int sum = 0;
+			for (const math::vec3i& chunk : chunks)
+			{
+				sum += mortonMap.find(chunk)->second;
+			}
+			return sum;
+		};
+
+		BENCHMARK("Look up " + name + " chunks, flat map with morton")
+		{
+			int sum = 0;
+			for (const math::vec3i& chunk : chunks)
+			{
+				sum += flatMap.find(chunk)->second;
+			}
+			return sum;
+		};
+	}
+}
@@ -0,0 +1,65 @@
+#include <catch2/catch.hpp>
+
+#include <Common/Utility/MappedFile.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using namespace phx;
+
+TEST_CASE("Validate MappedFile", "[MappedFile]")
+{
+	namespace fs = std::filesystem;
+
+	const fs::path path = fs::temp_directory_path() / "phx-mapped-test";
+	fs::remove(path);
+
+	MappedFile file;
+
+	SECTION("Missing files can't be mapped")
+	{
+		REQUIRE_FALSE(file.open(path));
+		REQUIRE_FALSE(file.isOpen());
+	}
+
+	SECTION("Empty files map to nothing")
+	{
+		std::ofstream(path).close();
+		REQUIRE(file.open(path));
+		REQUIRE(file.size() == 0);
+		REQUIRE(file.data() == nullptr);
+		REQUIRE(file.getResidentPages(0, 100) == 0);
+	}
+
+	SECTION("The mapping has the content of the file")
+	{
+		std::string content;
+		for (int i = 0; i < 10000; ++i)
+		{
+			content += static_cast<char>('a' + i % 26);
+		}
+		std::ofstream(path, std::ios::binary) << content;
+
+		REQUIRE(file.open(path));
+		REQUIRE(file.size() == content.size());
+		REQUIRE(std::string(reinterpret_cast<const char*>(file.data()),
+		                    file.size()) == content);
+
+		file.advise(MappedFile::Access::SEQUENTIAL);
+		file.prefetch(5000, 5000);
+
+		// the file was just written, so it's in memory.
+		const std::size_t pages =
+		    (content.size() + MappedFile::getPageSize() - 1) /
+		    MappedFile::getPageSize();
+		REQUIRE(file.getResidentPages(0, file.size()) == pages);
+
+		file.close();
+		REQUIRE_FALSE(file.isOpen());
+		REQUIRE(file.data() == nullptr);
+	}
+
+	file.close();
+	fs::remove(path);
+}
@@ -0,0 +1,136 @@
+#include <catch2/catch.hpp>
+
+#include <Common/Input.hpp>
+#include <Common/Utility/Reader.hpp>
+#include <Common/Utility/Schema.hpp>
+
+using namespace phx;
+
+namespace
+{
+	struct Item
+	{
+		std::string               name;
+		std::int16_t              count     = 0;
+		bool                      stackable = false;
+		std::vector<std::int32_t> tags;
+
+		PHX_SERIALIZABLE(Item, name, count, stackable, tags);
+	};
+
+	struct Slot
+	{
+		Item        item;
+		float       durability = 1.f;
+		bool        locked     = false;
+		std::size_t index      = 0;
+
+		PHX_SERIALIZABLE(Slot, item, durability, locked, index);
+	};
+
+	Slot makeSlot()
+	{
+		Slot slot;
+		slot.item.name      = "core.pickaxe";
+		slot.item.count     = -2;
+		slot.item.stackable = true;
+		slot.item.tags      = {1, -70000, 300};
+		slot.durability     = 0.75f;
+		slot.locked         = true;
+		slot.index          = 260;
+		return slot;
+	}
+} // namespace
+
+TEST_CASE("Validate Serialization Schemas", "[Serializer]")
+{
+	const Slot slot = makeSlot();
+
+	SECTION("Only types with their own schema are reflected")
+	{
+		struct Derived : Item
+		{
+			int extra = 0;
+		};
+
+		REQUIRE(schema::isReflected<Item>);
+		REQUIRE(schema::isReflected<InputState>);
+		REQUIRE_FALSE(schema::isReflected<Derived>);
+		REQUIRE_FALSE(schema::isReflected<int>);
+	}
+
+	SECTION("The size is exact and nothing is reallocated")
+	{
+		for (const Encoding encoding : {Encoding::FIXED, Encoding::COMPACT})
+		{
+			Serializer ser(encoding);
+			ser << slot;
+
+			REQUIRE(ser.getBuffer().size() == schema::size(slot, encoding));
+			REQUIRE(ser.getBuffer().capacity() == ser.getBuffer().size());
+		}
+	}
+
+	SECTION("Writing many values only grows the buffer a few times")
+	{
+		Serializer  ser;
+		std::size_t growths  = 0;
+		std::size_t capacity  = ser.getBuffer().capacity();
+		for (int i = 0; i < 1000; ++i)
+		{
+			ser << slot;
+			if (ser.getBuffer().capacity() != capacity)
+			{
+				capacity = ser.getBuffer().capacity();
+				++growths;
+			}
+		}
+
+		REQUIRE(ser.getBuffer().size() == 1000 * schema::size(slot));
+		REQUIRE(growths < 16);
+	}
+
+	SECTION("Nested schemas survive a round trip")
+	{
+		for (const Encoding encoding : {Encoding::FIXED, Encoding::COMPACT})
+		{
+			Serializer ser(encoding);
+			ser << slot << std::int32_t(7);
+
+			Reader       reader(ser.getBuffer(), encoding);
+			Slot         read;
+			std::int32_t after;
+			reader >> read >> after;
+
+			REQUIRE(reader.ok());
+			REQUIRE(reader.remaining() == 0);
+			REQUIRE(read.item.name == slot.item.name);
+			REQUIRE(read.item.count == slot.item.count);
+			REQUIRE(read.item.stackable);
+			REQUIRE(read.item.tags == slot.item.tags);
+			REQUIRE(read.durability == slot.durability);
+			REQUIRE(read.locked);
+			REQUIRE(read.index == slot.index);
+			REQUIRE(after == 7);
+		}
+	}
+
+	SECTION("The fields are written in order, like by hand")
+	{
+		InputState state;
+		state.backward   = true;
+		state.rotation.x = -1000;
+		state.rotation.y = 2000;
+		state.sequence   = 99;
+
+		Serializer generated;
+		generated << state;
+
+		Serializer manual;
+		manual << state.forward << state.backward << state.left << state.right
+		       << state.up << state.down << state.rotation.x << state.rotation.y
+		       << state.sequence;
+
+		REQUIRE(generated.getBuffer() == manual.getBuffer());
+	}
+}
@@ -0,0 +1,297 @@
+#include <catch2/catch.hpp>
+
+#include <Common/Input.hpp>
+#include <Common/Utility/Reader.hpp>
+#include <Common/Utility/Serializer.hpp>
+
+#include <limits>
+#include <numeric>
+
+using namespace phx;
+
+TEST_CASE("Validate Reader Behavior", "[Serializer]")
+{
+	Serializer ser;
+	ser << 'a' << std::int32_t(-5) << 2.5f << std::uint64_t(1) << 42.0
+	    << std::string("core.dirt")
+	    << std::vector<std::uint16_t> {1, 2, 0xBEEF};
+
+	SECTION("Values read back as they were written")
+	{
+		Reader reader(ser.getBuffer());
+
+		char                       c;
+		std::int32_t               i;
+		float                      f;
+		std::uint64_t              u;
+		double                     d;
+		std::string                s;
+		std::vector<std::uint16_t> v;
+		reader >> c >> i >> f >> u >> d >> s >> v;
+
+		REQUIRE(reader.ok());
+		REQUIRE(reader.remaining() == 0);
+		REQUIRE(c == 'a');
+		REQUIRE(i == -5);
+		REQUIRE(f == 2.5f);
+		REQUIRE(u == 1);
+		REQUIRE(d == 42.0);
+		REQUIRE(s == "core.dirt");
+		REQUIRE(v == std::vector<std::uint16_t> {1, 2, 0xBEEF});
+	}
+
+	SECTION("The reader doesn't copy or consume the bytes")
+	{
+		Reader reader(ser.getBuffer());
+		REQUIRE(reader.readBytes(1) == ser.getBuffer().data());
+		REQUIRE(reader.tell() == 1);
+		REQUIRE(ser.getBuffer().size() == reader.size());
+	}
+
+	SECTION("Reading past the end fails instead of overrunning")
+	{
+		const data::Data truncated(ser.getBuffer().begin(),
+		                           ser.getBuffer().begin() + 6);
+		Reader           reader(truncated);
+
+		char          c;
+		std::int32_t  i;
+		float         f = 1.f;
+		std::uint64_t u = 1;
+		reader >> c >> i;
+		REQUIRE(reader.ok());
+
+		reader >> f >> u;
+		REQUIRE_FALSE(reader.ok());
+		REQUIRE(f == 0.f);
+		REQUIRE(u == 0);
+		REQUIRE(reader.remaining() == 0);
+	}
+
+	SECTION("A corrupt length is rejected")
+	{
+		Serializer bad;
+		bad << static_cast<unsigned int>(0xFFFFFFFF) << 'x';
+
+		Reader      reader(bad.getBuffer());
+		std::string s;
+		reader >> s;
+		REQUIRE_FALSE(reader.ok());
+		REQUIRE(s.empty());
+	}
+
+	SECTION("Objects only take their own bytes from a Serializer")
+	{
+		InputState state;
+		state.forward  = true;
+		state.sequence = 7;
+
+		Serializer objects;
+		objects << state << std::int32_t(99);
+
+		InputState   read;
+		std::int32_t after;
+		objects >> read >> after;
+		REQUIRE(read.forward);
+		REQUIRE(read.sequence == 7);
+		REQUIRE(after == 99);
+		REQUIRE(objects.empty());
+	}
+}
+
+TEST_CASE("Validate Serializer Bulk Writes", "[Serializer]")
+{
+	SECTION("Arrays are written the same as one value at a time")
+	{
+		const std::vector<std::uint32_t> values = {1, 0xDEADBEEF, 3, 4, 5};
+
+		Serializer bulk;
+		bulk.write(values.data(), values.size());
+
+		Serializer single;
+		for (const std::uint32_t value : values)
+		{
+			single << value;
+		}
+
+		REQUIRE(bulk.getBuffer() == single.getBuffer());
+	}
+
+	SECTION("Vectors and strings survive a round trip")
+	{
+		const std::vector<double> doubles = {0.5, -1.25, 1e10};
+		const std::u16string      wide    = u"Phoenix";
+
+		Serializer ser;
+		ser << doubles << wide << std::string("core.dirt");
+
+		std::vector<double> readDoubles;
+		std::u16string      readWide;
+		std::string         readNarrow;
+		ser >> readDoubles >> readWide >> readNarrow;
+
+		REQUIRE(readDoubles == doubles);
+		REQUIRE(readWide == wide);
+		REQUIRE(readNarrow == "core.dirt");
+		REQUIRE(ser.empty());
+	}
+}
+
+TEST_CASE("Validate Compact Encoding", "[Serializer]")
+{
+	SECTION("Small integers take a single byte")
+	{
+		Serializer ser(Encoding::COMPACT);
+		ser << std::uint64_t(0) << std::uint32_t(127) << std::int32_t(-1)
+		    << std::int16_t(63);
+		REQUIRE(ser.getBuffer().size() == 4);
+
+		ser << std::uint32_t(128);
+		REQUIRE(ser.getBuffer().size() == 6);
+	}
+
+	SECTION("Limits survive a round trip")
+	{
+		Serializer ser(Encoding::COMPACT);
+		ser << std::numeric_limits<std::uint64_t>::max()
+		    << std::numeric_limits<std::int64_t>::min()
+		    << std::numeric_limits<std::int32_t>::max()
+		    << std::numeric_limits<std::int16_t>::min() << 'z' << 0.25f;
+
+		Reader        reader(ser.getBuffer(), Encoding::COMPACT);
+		std::uint64_t u;
+		std::int64_t  i64;
+		std::int32_t  i32;
+		std::int16_t  i16;
+		char          c;
+		float         f;
+		reader >> u >> i64 >> i32 >> i16 >> c >> f;
+
+		REQUIRE(reader.ok());
+		REQUIRE(reader.remaining() == 0);
+		REQUIRE(u == std::numeric_limits<std::uint64_t>::max());
+		REQUIRE(i64 == std::numeric_limits<std::int64_t>::min());
+		REQUIRE(i32 == std::numeric_limits<std::int32_t>::max());
+		REQUIRE(i16 == std::numeric_limits<std::int16_t>::min());
+		REQUIRE(c == 'z');
+		REQUIRE(f == 0.25f);
+	}
+
+	SECTION("Bools are packed between other values")
+	{
+		Serializer ser(Encoding::COMPACT);
+		for (int i = 0; i < 10; ++i)
+		{
+			ser << (i % 3 == 0) << std::int32_t(i);
+		}
+
+		// 2 bytes of bools, 10 single byte integers.
+		REQUIRE(ser.getBuffer().size() == 12);
+
+		Reader reader(ser.getBuffer(), Encoding::COMPACT);
+		for (int i = 0; i < 10; ++i)
+		{
+			bool         b;
+			std::int32_t value;
+			reader >> b >> value;
+			REQUIRE(b == (i % 3 == 0));
+			REQUIRE(value == i);
+		}
+		REQUIRE(reader.ok());
+	}
+
+	SECTION("Strings and vectors use compact lengths")
+	{
+		const std::vector<std::int32_t> values = {-3, 0, 70000};
+
+		Serializer ser(Encoding::COMPACT);
+		ser << std::string("core.dirt") << values;
+		REQUIRE(ser.getBuffer().size() == 1 + 9 + 1 + 1 + 1 + 3);
+
+		Reader                    reader(ser.getBuffer(), Encoding::COMPACT);
+		std::string               s;
+		std::vector<std::int32_t> v;
+		reader >> s >> v;
+		REQUIRE(reader.ok());
+		REQUIRE(s == "core.dirt");
+		REQUIRE(v == values);
+	}
+
+	SECTION("An input state shrinks")
+	{
+		InputState state;
+		state.forward    = true;
+		state.up         = true;
+		state.rotation.x = 90000;
+		state.rotation.y = -45000;
+		state.sequence   = 1234;
+
+		Serializer fixed;
+		fixed << state;
+
+		Serializer compact(Encoding::COMPACT);
+		compact << state;
+		REQUIRE(compact.getBuffer().size() * 2 < fixed.getBuffer().size());
+
+		InputState read;
+		Reader     reader(compact.getBuffer(), Encoding::COMPACT);
+		reader >> read;
+		REQUIRE(reader.ok());
+		REQUIRE(read.forward);
+		REQUIRE_FALSE(read.backward);
+		REQUIRE(read.up);
+		REQUIRE(read.rotation.x == 90000);
+		REQUIRE(read.rotation.y == -45000);
+		REQUIRE(read.sequence == 1234);
+	}
+
+	SECTION("Malformed varints are rejected")
+	{
+		// never terminates.
+		const data::Data endless(11, std::byte {0xFF});
+		Reader           endlessReader(endless, Encoding::COMPACT);
+		std::uint64_t    u = 1;
+		endlessReader >> u;
+		REQUIRE_FALSE(endlessReader.ok());
+		REQUIRE(u == 0);
+
+		// too big for the type it's read into.
+		Serializer ser(Encoding::COMPACT);
+		ser << std::uint32_t(70000);
+
+		Reader        reader(ser.getBuffer(), Encoding::COMPACT);
+		std::uint16_t small = 1;
+		reader >> small;
+		REQUIRE_FALSE(reader.ok());
+		REQUIRE(small == 0);
+	}
+}
+
+TEST_CASE("Serializer Throughput", "[!benchmark][Serializer]")
+{
+	for (std::size_t size = 1024; size <= 1024 * 1024; size *= 32)
+	{
+		std::vector<std::uint32_t> values(size / sizeof(std::uint32_t));
+		std::iota(values.begin(), values.end(), 0);
+
+		Serializer payload;
+		payload << values;
+
+		const std::string kib = std::to_string(size / 1024) + " KiB";
+
+		BENCHMARK("Write " + kib)
+		{
+			Serializer ser;
+			ser << values;
+			return ser.getBuffer().size();
+		};
+
+		BENCHMARK("Read " + kib)
+		{
+			Reader                     reader(payload.getBuffer());
+			std::vector<std::uint32_t> out;
+			reader >> out;
+			return out.size();
+		};
+	}
+}
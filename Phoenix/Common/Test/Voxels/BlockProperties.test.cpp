@@ -0,0 +1,105 @@
+#include <catch2/catch.hpp>
+
+#include <Common/Voxels/BlockReferrer.hpp>
+
+using namespace phx::voxels;
+
+TEST_CASE("Validate Dense Registry Behavior", "[Registry]")
+{
+	phx::Registry<std::size_t, int> registry;
+	registry.add(0, 10);
+	registry.add(3, 13);
+
+	REQUIRE(registry.size() == 2);
+	REQUIRE(*registry.get(3) == 13);
+	REQUIRE(registry.get(1) == nullptr);
+	REQUIRE(registry.get(100) == nullptr);
+
+	SECTION("Pointers stay valid as the registry grows")
+	{
+		int* first = registry.get(0);
+		for (std::size_t i = 4; i < 1000; ++i)
+		{
+			registry.add(i, static_cast<int>(i));
+		}
+
+		REQUIRE(first == registry.get(0));
+		REQUIRE(*first == 10);
+	}
+
+	SECTION("Adding an existing key replaces the value in place")
+	{
+		const std::size_t key      = 3;
+		const int         newValue = 30;
+
+		int* value = registry.get(key);
+		registry.add(key, newValue);
+		REQUIRE(registry.size() == 2);
+		REQUIRE(*value == 30);
+	}
+
+	SECTION("Iteration skips missing keys")
+	{
+		std::size_t count = 0;
+		for (const auto entry : registry)
+		{
+			REQUIRE(entry.second == static_cast<int>(entry.first) + 10);
+			++count;
+		}
+		REQUIRE(count == 2);
+	}
+}
+
+TEST_CASE("Validate Block Property Table", "[Registry]")
+{
+	BlockReferrer referrer;
+
+	BlockType stone;
+	stone.id       = "core.stone";
+	stone.uid      = referrer.referrer.size();
+	stone.category = BlockCategory::SOLID;
+	stone.rotH     = true;
+	referrer.referrer.add(stone.id, stone.uid);
+	referrer.blocks.add(stone.uid, stone);
+
+	BlockType glass = stone;
+	glass.id        = "core.glass";
+	glass.uid       = referrer.referrer.size();
+	glass.opaque    = false;
+	referrer.referrer.add(glass.id, glass.uid);
+	referrer.blocks.add(glass.uid, glass);
+
+	referrer.freeze();
+
+	REQUIRE(referrer.properties.size() == referrer.blocks.size());
+	REQUIRE(referrer.properties.isOpaque(stone.uid));
+	REQUIRE(referrer.properties.isSolid(glass.uid));
+	REQUIRE_FALSE(referrer.properties.isOpaque(glass.uid));
+	REQUIRE_FALSE(referrer.properties.isSolid(BlockType::AIR_BLOCK));
+	REQUIRE(referrer.properties.has(stone.uid, BlockProperties::ROTATE_H));
+	REQUIRE_FALSE(
+	    referrer.properties.has(stone.uid, BlockProperties::ON_BREAK));
+	REQUIRE(referrer.properties.getCategory(BlockType::AIR_BLOCK) ==
+	        BlockCategory::AIR);
+
+	// unknown UIDs behave like the unknown block.
+	REQUIRE(referrer.properties.getCategory(1000) ==
+	        referrer.properties.getCategory(BlockType::UNKNOWN_BLOCK));
+
+	SECTION("A table that was never built treats every block as unknown")
+	{
+		BlockProperties empty;
+		REQUIRE(empty.size() == 0);
+		REQUIRE(empty.isOpaque(stone.uid));
+		REQUIRE(empty.getCategory(BlockType::AIR_BLOCK) ==
+		        BlockCategory::SOLID);
+		REQUIRE_FALSE(empty.has(stone.uid, BlockProperties::ON_PLACE));
+	}
+
+	SECTION("A new referrer already knows its own blocks")
+	{
+		BlockReferrer fresh;
+		REQUIRE_FALSE(fresh.properties.isSolid(BlockType::AIR_BLOCK));
+		REQUIRE(fresh.properties.isSolid(BlockType::UNKNOWN_BLOCK));
+	}
+}
@@ -0,0 +1,733 @@
+#include <catch2/catch.hpp>
+
+#include <Common/Voxels/Chunk.hpp>
+
+#include "TestBlocks.hpp"
+
+#include <algorithm>
+#include <random>
+
+using namespace phx::voxels;
+
+TEST_CASE("Validate BlockStorage Behavior", "[Chunk]")
+{
+	BlockReferrer referrer;
+	BlockType*    air = referrer.blocks.get(BlockType::AIR_BLOCK);
+
+	std::vector<BlockType*> types;
+	for (int i = 0; i < 300; ++i)
+	{
+		types.push_back(addTestBlock(referrer, "test." + std::to_string(i)));
+	}
+
+	SECTION("A new storage is uniform")
+	{
+		BlockStorage storage(Chunk::CHUNK_MAX_BLOCKS, air);
+		REQUIRE(storage.isUniform());
+		REQUIRE(storage.getBitsPerBlock() == 0);
+		REQUIRE(storage.getMemoryUsage() <
+		        sizeof(BlockType*) + sizeof(std::uint32_t) + 1);
+		REQUIRE(storage.getPaletteSize() == 1);
+		REQUIRE(storage.get(0) == air);
+		REQUIRE(storage.get(Chunk::CHUNK_MAX_BLOCKS - 1) == air);
+	}
+
+	SECTION("The width grows with the palette and shrinks back")
+	{
+		BlockStorage storage(Chunk::CHUNK_MAX_BLOCKS, air);
+
+		storage.set(0, types[0]);
+		REQUIRE(storage.getBitsPerBlock() == 1);
+
+		storage.set(1, types[1]);
+		REQUIRE(storage.getBitsPerBlock() == 2);
+
+		for (std::size_t i = 0; i < 20; ++i)
+		{
+			storage.set(i, types[i]);
+		}
+		REQUIRE(storage.getBitsPerBlock() == 8);
+		REQUIRE(storage.getPaletteSize() == 21);
+
+		for (std::size_t i = 0; i < 20; ++i)
+		{
+			REQUIRE(storage.get(i) == types[i]);
+		}
+
+		storage.set(0, 20, air);
+		REQUIRE(storage.getPaletteSize() == 1);
+		REQUIRE(storage.isUniform());
+		REQUIRE(storage.get(5) == air);
+	}
+
+	SECTION("A uniform storage only expands once a different block is set")
+	{
+		BlockStorage storage(Chunk::CHUNK_MAX_BLOCKS, air);
+
+		storage.set(0, 100, air);
+		REQUIRE(storage.isUniform());
+
+		storage.set(100, types[0]);
+		REQUIRE_FALSE(storage.isUniform());
+		REQUIRE(storage.get(100) == types[0]);
+		REQUIRE(storage.get(99) == air);
+
+		storage.set(0, Chunk::CHUNK_MAX_BLOCKS, types[1]);
+		REQUIRE(storage.isUniform());
+		REQUIRE(storage.get(100) == types[1]);
+	}
+
+	SECTION("The storage behaves like a flat list of blocks")
+	{
+		BlockStorage            storage(Chunk::CHUNK_MAX_BLOCKS, air);
+		std::vector<BlockType*> reference(Chunk::CHUNK_MAX_BLOCKS, air);
+
+		std::mt19937 random(1337);
+		for (int i = 0; i < 20000; ++i)
+		{
+			const std::size_t index = random() % Chunk::CHUNK_MAX_BLOCKS;
+
+			// skew towards a few types so the palette grows and shrinks.
+			BlockType* type = random() % 8 == 0
+			                      ? types[random() % types.size()]
+			                      : types[random() % 4];
+
+			storage.set(index, type);
+			reference[index] = type;
+		}
+
+		std::vector<BlockType*> unpacked(Chunk::CHUNK_MAX_BLOCKS);
+		storage.unpack(unpacked.data());
+
+		REQUIRE(unpacked == reference);
+
+		std::sort(reference.begin(), reference.end());
+		const auto distinct = static_cast<std::size_t>(
+		    std::unique(reference.begin(), reference.end()) -
+		    reference.begin());
+		REQUIRE(storage.getPaletteSize() == distinct);
+	}
+}
+
+TEST_CASE("Validate Chunk Geometry", "[Chunk]")
+{
+	using Geometry = ChunkGeometry<32, 256, 8>;
+
+	SECTION("Indices match the flattened layout")
+	{
+		const std::size_t index = Geometry::index(5, 200, 7);
+		REQUIRE(index == 5 + 32 * (200 + 256 * 7));
+		REQUIRE(Geometry::xOf(index) == 5);
+		REQUIRE(Geometry::yOf(index) == 200);
+		REQUIRE(Geometry::zOf(index) == 7);
+		REQUIRE(Geometry::VOLUME == 32 * 256 * 8);
+	}
+
+	SECTION("World coordinates are floored into chunks")
+	{
+		REQUIRE(Geometry::toChunk<Geometry::X>(31) == 0);
+		REQUIRE(Geometry::toChunk<Geometry::X>(32) == 1);
+		REQUIRE(Geometry::toChunk<Geometry::X>(-1) == -1);
+		REQUIRE(Geometry::toChunk<Geometry::Z>(-9) == -2);
+
+		REQUIRE(Geometry::toLocal<Geometry::X>(-1) == 31);
+		REQUIRE(Geometry::toLocal<Geometry::Y>(300) == 44);
+		REQUIRE(Geometry::toOrigin<Geometry::Z>(-9) == -16);
+	}
+}
+
+TEST_CASE("Validate Chunk Serialization", "[Chunk]")
+{
+	BlockReferrer referrer;
+	BlockType*    dirt  = addTestBlock(referrer, "core.dirt");
+	BlockType*    stone = addTestBlock(referrer, "core.stone");
+
+	Chunk chunk({16, 0, -16}, &referrer, dirt);
+	chunk.setBlockAt({1, 2, 3}, {stone, nullptr});
+	chunk.setBlockAt({15, 15, 15}, {stone, nullptr});
+
+	phx::Serializer ser;
+	ser << chunk;
+
+	Chunk loaded({0, 0, 0}, &referrer);
+	ser >> loaded;
+
+	REQUIRE(loaded.getChunkPos() == chunk.getChunkPos());
+	REQUIRE(loaded.getBlocks() == chunk.getBlocks());
+	REQUIRE(loaded.getBlockAt({1, 2, 3}).type == stone);
+	REQUIRE(loaded.getBlockAt({0, 0, 0}).type == dirt);
+
+	SECTION("Metadata is kept with its block")
+	{
+		phx::Metadata rotation;
+		rotation.set("core.rotation", phx::math::vec3 {90, 0, 0});
+		chunk.setBlockAt({4, 4, 4}, {stone, &rotation});
+		REQUIRE(chunk.setMetadataAt({2, 2, 2}, "test.power", 15));
+		REQUIRE_FALSE(chunk.setMetadataAt({2, 2, 2}, "test.power", 1.f));
+
+		phx::Serializer metaSer;
+		metaSer << chunk;
+		Chunk loadedMeta({0, 0, 0}, &referrer);
+		metaSer >> loadedMeta;
+
+		REQUIRE(loadedMeta.getMetadata() == chunk.getMetadata());
+		const phx::Metadata* data = loadedMeta.getBlockAt({4, 4, 4}).metadata;
+		REQUIRE(data != nullptr);
+		REQUIRE(*data->getAs<phx::math::vec3>(
+		            *phx::MetadataKeys::find("core.rotation")) ==
+		        phx::math::vec3 {90, 0, 0});
+
+		// replacing the block drops its metadata.
+		chunk.setBlockAt({4, 4, 4}, {dirt, nullptr});
+		REQUIRE(chunk.getBlockAt({4, 4, 4}).metadata == nullptr);
+		REQUIRE(chunk.getMetadata().size() == 1);
+	}
+
+	SECTION("Metadata of an unknown type fails the reader")
+	{
+		phx::Metadata power;
+		power.set("test.power", 15);
+		phx::Serializer powerSer;
+		powerSer << power;
+
+		// the type tag comes right before the int.
+		phx::data::Data& bytes = powerSer.getBuffer();
+		bytes[bytes.size() - 1 - sizeof(int)] = std::byte {'x'};
+
+		phx::Metadata loadedPower;
+		phx::Reader   reader(bytes);
+		loadedPower << reader;
+		REQUIRE_FALSE(reader.ok());
+		REQUIRE(loadedPower.empty());
+	}
+
+	SECTION("Metadata read by name keeps keys that weren't used yet")
+	{
+		// written the way metadata is, with a key nothing interned.
+		phx::Serializer named;
+		named << 1 << std::string("test.named-only") << 'i' << 1;
+		REQUIRE_FALSE(phx::MetadataKeys::find("test.named-only"));
+
+		phx::Metadata loadedNamed;
+		phx::Reader   reader(named.getBuffer());
+		loadedNamed << reader;
+		REQUIRE(reader.ok());
+		REQUIRE(loadedNamed.size() == 1);
+		REQUIRE(*loadedNamed.getAs<int>(
+		            *phx::MetadataKeys::find("test.named-only")) == 1);
+	}
+
+	SECTION("Chunks sent over the network use the connection's key IDs")
+	{
+		REQUIRE(chunk.setMetadataAt({2, 2, 2}, "test.power", 15));
+
+		phx::MetadataDictionary serverKeys;
+		phx::Serializer         sent;
+		chunk.send(sent, serverKeys);
+
+		// the key is only written by name in the dictionary.
+		const std::string      name = "test.power";
+		const phx::data::Data& data = sent.getBuffer();
+		REQUIRE(std::search(data.begin(), data.end(), name.begin(), name.end(),
+		                    [](std::byte a, char b) {
+			                    return a == std::byte(b);
+		                    }) == data.end());
+
+		phx::Serializer names;
+		serverKeys.writeNames(names);
+
+		phx::MetadataDictionary clientKeys(4);
+		phx::Reader             namesReader(names.getBuffer());
+		REQUIRE(clientKeys.readNames(namesReader));
+		REQUIRE(clientKeys.size() == serverKeys.size());
+
+		Chunk       received({0, 0, 0}, &referrer);
+		phx::Reader reader(sent.getBuffer());
+		REQUIRE(received.receive(reader, clientKeys));
+		REQUIRE(received.getMetadata() == chunk.getMetadata());
+
+		// without the names the blocks still arrive, the values can't.
+		phx::MetadataDictionary noKeys;
+		Chunk                   withoutKeys({0, 0, 0}, &referrer);
+		phx::Reader             noKeysReader(sent.getBuffer());
+		REQUIRE(withoutKeys.receive(noKeysReader, noKeys));
+		REQUIRE(withoutKeys.getBlocks() == chunk.getBlocks());
+		REQUIRE(withoutKeys.getBlockAt({2, 2, 2}).metadata->empty());
+
+		// names are only taken from the dictionary, not the chunk.
+		phx::Serializer named;
+		named << chunk;
+		Chunk       namedChunk({0, 0, 0}, &referrer);
+		phx::Reader namedReader(named.getBuffer());
+		REQUIRE_FALSE(namedChunk.receive(namedReader, clientKeys));
+	}
+
+	SECTION("A connection's keys stop at its limit")
+	{
+		phx::MetadataDictionary serverKeys;
+		for (const char* name :
+		     {"test.sent-a", "test.sent-b", "test.sent-c"})
+		{
+			serverKeys.getID(*phx::MetadataKeys::intern(name));
+		}
+
+		// names sent again are skipped, rather than numbered twice.
+		phx::Serializer first;
+		phx::Serializer again;
+		REQUIRE(serverKeys.writeNames(first) == 3);
+		REQUIRE(serverKeys.writeNames(again, 1) == 3);
+
+		phx::MetadataDictionary clientKeys(3);
+		phx::Reader             firstReader(first.getBuffer());
+		phx::Reader             againReader(again.getBuffer());
+		REQUIRE(clientKeys.readNames(firstReader));
+		REQUIRE(clientKeys.readNames(againReader));
+		REQUIRE(clientKeys.getNames() == serverKeys.getNames());
+
+		phx::MetadataDictionary limited(2);
+		phx::Reader             limitedReader(first.getBuffer());
+		REQUIRE_FALSE(limited.readNames(limitedReader));
+		REQUIRE(limited.size() == 2);
+	}
+
+	SECTION("Uniform chunks serialize to a constant size and stay uniform")
+	{
+		Chunk           uniform({0, 0, 0}, &referrer, stone);
+		phx::Serializer uniformSer;
+		uniformSer << uniform;
+
+		// position, the block id and a single run covering the chunk.
+		REQUIRE(uniformSer.getBuffer().size() ==
+		        3 * sizeof(float) + sizeof(unsigned int) +
+		            stone->id.size() + sizeof(char) + sizeof(std::size_t));
+
+		Chunk loadedUniform({0, 0, 0}, &referrer);
+		uniformSer >> loadedUniform;
+		REQUIRE(loadedUniform.isUniform());
+		REQUIRE(loadedUniform.getBlockAt(100).type == stone);
+	}
+}
+
+TEST_CASE("Validate Chunk Save Format", "[Chunk]")
+{
+	BlockReferrer referrer;
+	BlockType*    dirt  = addTestBlock(referrer, "core.dirt");
+	BlockType*    stone = addTestBlock(referrer, "core.stone");
+
+	Chunk chunk({16, 0, -16}, &referrer, dirt);
+	chunk.fill({{0, 0, 0}, {15, 3, 15}}, stone);
+	chunk.setBlockAt({1, 2, 3}, {dirt, nullptr});
+	REQUIRE(chunk.setMetadataAt({5, 5, 5}, "test.power", 15));
+
+	BlockDictionary         dictionary;
+	phx::MetadataDictionary keys;
+	phx::Serializer         ser(phx::Encoding::COMPACT);
+	chunk.save(ser, dictionary, keys);
+
+	SECTION("Chunks survive a round trip")
+	{
+		Chunk       loaded({0, 0, 0}, &referrer);
+		phx::Reader reader(ser.getBuffer());
+		REQUIRE(loaded.load(reader, dictionary, keys));
+		REQUIRE(reader.remaining() == 0);
+		REQUIRE(loaded.getChunkPos() == chunk.getChunkPos());
+		REQUIRE(loaded.getBlocks() == chunk.getBlocks());
+		REQUIRE(loaded.getMetadata() == chunk.getMetadata());
+		REQUIRE(dictionary.size() == 2);
+	}
+
+	SECTION("Saved IDs don't depend on the order blocks were registered")
+	{
+		// a later session, with the blocks registered the other way round.
+		BlockReferrer other;
+		BlockType*    otherStone = addTestBlock(other, "core.stone");
+		BlockType*    otherDirt  = addTestBlock(other, "core.dirt");
+		REQUIRE(otherStone->uid == dirt->uid);
+
+		BlockDictionary restored;
+		restored.restore(dictionary.getNames());
+
+		Chunk       loaded({0, 0, 0}, &other);
+		phx::Reader reader(ser.getBuffer());
+		REQUIRE(loaded.load(reader, restored, keys));
+		REQUIRE(loaded.getBlockAt({0, 0, 0}).type == otherStone);
+		REQUIRE(loaded.getBlockAt({1, 2, 3}).type == otherDirt);
+		REQUIRE(loaded.getBlockAt({0, 4, 0}).type == otherDirt);
+
+		// blocks looked up in one referrer aren't handed out for another.
+		const BlockDictionary::ID stoneID = dictionary.getID(stone);
+		REQUIRE(dictionary.getType(stoneID, &referrer) == stone);
+		REQUIRE(dictionary.getType(stoneID, &other) == otherStone);
+	}
+
+	SECTION("Metadata keys are saved as IDs from the save's dictionary")
+	{
+		const std::string      name = "test.power";
+		const phx::data::Data& data = ser.getBuffer();
+		REQUIRE(std::search(data.begin(), data.end(), name.begin(), name.end(),
+		                    [](std::byte a, char b) {
+			                    return a == std::byte(b);
+		                    }) == data.end());
+		REQUIRE(keys.getNames() == std::vector<std::string> {name});
+
+		// a later session interns every key of the save as it restores
+		// them, even ones nothing has used yet.
+		phx::MetadataDictionary restored;
+		restored.restore({"test.saved-only", name});
+		REQUIRE(phx::MetadataKeys::find("test.saved-only"));
+
+		phx::Metadata saved;
+		saved.set("test.saved-only", 3);
+		phx::Serializer savedSer;
+		restored.write(savedSer, saved);
+
+		phx::Metadata loadedSaved;
+		phx::Reader   savedReader(savedSer.getBuffer());
+		restored.read(savedReader, loadedSaved);
+		REQUIRE(savedReader.ok());
+		REQUIRE(loadedSaved == saved);
+
+		// an ID the dictionary doesn't have only loses its own value, the
+		// ID comes before the type tag and the int.
+		phx::Serializer fixed;
+		chunk.save(fixed, dictionary, keys);
+		phx::data::Data& bytes = fixed.getBuffer();
+		bytes[bytes.size() - 1 - sizeof(int) - 1] = std::byte {0x7F};
+		bytes[bytes.size() - 1 - sizeof(int) - 2] = std::byte {0x7F};
+
+		Chunk       loaded({0, 0, 0}, &referrer);
+		phx::Reader reader(bytes);
+		REQUIRE(loaded.load(reader, dictionary, keys));
+		REQUIRE(loaded.getBlocks() == chunk.getBlocks());
+		REQUIRE(loaded.getBlockAt({5, 5, 5}).metadata->empty());
+	}
+
+	SECTION("Saves without a version are still read")
+	{
+		phx::Serializer old;
+		old << chunk;
+
+		Chunk       loaded({0, 0, 0}, &referrer);
+		phx::Reader reader(old.getBuffer());
+		REQUIRE(loaded.load(reader, dictionary, keys));
+		REQUIRE(loaded.getBlocks() == chunk.getBlocks());
+		REQUIRE(loaded.getMetadata() == chunk.getMetadata());
+	}
+
+	SECTION("Runs are much smaller than string IDs")
+	{
+		phx::Serializer old;
+		old << chunk;
+		REQUIRE(ser.getBuffer().size() * 4 < old.getBuffer().size());
+	}
+
+	SECTION("Damaged saves are rejected")
+	{
+		const phx::data::Data truncated(ser.getBuffer().begin(),
+		                                ser.getBuffer().end() - 3);
+		Chunk                 loaded({0, 0, 0}, &referrer);
+		phx::Reader           reader(truncated);
+		REQUIRE_FALSE(loaded.load(reader, dictionary, keys));
+
+		// a run pointing past the palette, its index comes before the
+		// length of the run and the metadata count.
+		phx::Serializer bad(phx::Encoding::COMPACT);
+		Chunk           uniform({0, 0, 0}, &referrer, stone);
+		uniform.save(bad, dictionary, keys);
+		bad.getBuffer()[bad.getBuffer().size() - 4] = std::byte {5};
+
+		phx::Reader badReader(bad.getBuffer());
+		REQUIRE_FALSE(loaded.load(badReader, dictionary, keys));
+
+		// runs that stop before the end of the chunk, the last thing before
+		// the metadata count is the length of the only run.
+		phx::Serializer shortRuns;
+		uniform.save(shortRuns, dictionary, keys);
+		phx::Serializer half;
+		half << static_cast<std::uint32_t>(Chunk::CHUNK_MAX_BLOCKS / 2);
+		std::copy(half.getBuffer().begin(), half.getBuffer().end(),
+		          shortRuns.getBuffer().end() - 8);
+
+		phx::Reader shortReader(shortRuns.getBuffer());
+		REQUIRE_FALSE(loaded.load(shortReader, dictionary, keys));
+
+		// a version this build doesn't know, it comes right after "PHXC".
+		phx::data::Data newer = ser.getBuffer();
+		newer[4] = std::byte {Chunk::SAVE_VERSION + 1};
+		phx::Reader newerReader(newer);
+		REQUIRE_FALSE(loaded.load(newerReader, dictionary, keys));
+	}
+}
+
+TEST_CASE("Validate Chunk Occupancy Masks", "[Chunk]")
+{
+	BlockReferrer referrer;
+	BlockType*    air   = referrer.blocks.get(BlockType::AIR_BLOCK);
+	BlockType*    stone = addTestBlock(referrer, "core.stone");
+	BlockType*    slab  = addTestBlock(referrer, "core.slab");
+	slab->opaque        = false;
+	referrer.freeze();
+
+	Chunk chunk({0, 0, 0}, &referrer);
+	REQUIRE(chunk.isEmpty());
+	REQUIRE(chunk.getSolidCount() == 0);
+
+	SECTION("The masks follow blocks being placed and broken")
+	{
+		chunk.setBlockAt({3, 4, 5}, {stone, nullptr});
+		chunk.setBlockAt({3, 5, 5}, {slab, nullptr});
+		REQUIRE_FALSE(chunk.isEmpty());
+		REQUIRE(chunk.getSolidCount() == 2);
+		REQUIRE(chunk.isSolidAt(Chunk::getVectorIndex(3, 5, 5)));
+		REQUIRE(chunk.getOpaqueMask().count() == 1);
+
+		chunk.setBlockAt({3, 4, 5}, {air, nullptr});
+		REQUIRE(chunk.getSolidCount() == 1);
+		REQUIRE_FALSE(chunk.isSolidAt(Chunk::getVectorIndex(3, 4, 5)));
+	}
+
+	SECTION("Chunks built from a list of blocks have their masks")
+	{
+		Chunk::BlockList blocks(Chunk::CHUNK_MAX_BLOCKS, air);
+		blocks[Chunk::getVectorIndex(1, 2, 3)] = stone;
+		blocks[Chunk::getVectorIndex(1, 3, 3)] = slab;
+
+		Chunk built({0, 0, 0}, &referrer, blocks);
+		REQUIRE(built.getBlocks() == blocks);
+		REQUIRE(built.getSolidCount() == 2);
+		REQUIRE(built.getOpaqueMask().count() == 1);
+
+		// a list that doesn't cover the chunk is ignored.
+		blocks.pop_back();
+		Chunk truncated({0, 0, 0}, &referrer, blocks);
+		REQUIRE(truncated.isEmpty());
+		REQUIRE(truncated.isUniform());
+
+		Chunk empty({0, 0, 0}, &referrer, Chunk::BlockList {});
+		REQUIRE(empty.isEmpty());
+	}
+
+	SECTION("Visible faces match checking every neighbor")
+	{
+		std::mt19937                    rng(1234);
+		std::uniform_int_distribution<> pick(0, 2);
+		BlockType*                      types[] = {air, stone, slab};
+
+		for (int z = 0; z < Chunk::CHUNK_DEPTH; ++z)
+			for (int y = 0; y < Chunk::CHUNK_HEIGHT; ++y)
+				for (int x = 0; x < Chunk::CHUNK_WIDTH; ++x)
+					chunk.setBlockAt({x, y, z}, {types[pick(rng)], nullptr});
+
+		auto opaqueAt = [&chunk](int x, int y, int z) {
+			if (x < 0 || y < 0 || z < 0 || x >= Chunk::CHUNK_WIDTH ||
+			    y >= Chunk::CHUNK_HEIGHT || z >= Chunk::CHUNK_DEPTH)
+				return false;
+
+			const BlockType* type = chunk.getBlockAt({x, y, z}).type;
+			return type->category == BlockCategory::SOLID && type->opaque;
+		};
+
+		using Axis                = Chunk::Mask::Axis;
+		const Chunk::Mask faces[] = {
+		    chunk.getVisibleFaces(Axis::X, -1),
+		    chunk.getVisibleFaces(Axis::X, 1),
+		    chunk.getVisibleFaces(Axis::Y, -1),
+		    chunk.getVisibleFaces(Axis::Y, 1),
+		    chunk.getVisibleFaces(Axis::Z, -1),
+		    chunk.getVisibleFaces(Axis::Z, 1)};
+		const int offsets[][3] = {{-1, 0, 0}, {1, 0, 0},  {0, -1, 0},
+		                          {0, 1, 0},  {0, 0, -1}, {0, 0, 1}};
+
+		bool matches = true;
+		for (int z = 0; z < Chunk::CHUNK_DEPTH; ++z)
+			for (int y = 0; y < Chunk::CHUNK_HEIGHT; ++y)
+				for (int x = 0; x < Chunk::CHUNK_WIDTH; ++x)
+				{
+					const std::size_t i = Chunk::getVectorIndex(x, y, z);
+					const bool        solid =
+					    chunk.getBlockAt(i).type->category ==
+					    BlockCategory::SOLID;
+
+					for (int f = 0; f < 6; ++f)
+					{
+						const bool visible =
+						    solid && !opaqueAt(x + offsets[f][0],
+						                       y + offsets[f][1],
+						                       z + offsets[f][2]);
+						matches &= faces[f].test(i) == visible;
+					}
+				}
+		REQUIRE(matches);
+
+		// the masks are rebuilt when a chunk is loaded.
+		phx::Serializer ser;
+		ser << chunk;
+		Chunk loaded({0, 0, 0}, &referrer);
+		ser >> loaded;
+		REQUIRE(loaded.getSolidMask() == chunk.getSolidMask());
+		REQUIRE(loaded.getOpaqueMask() == chunk.getOpaqueMask());
+	}
+}
+
+TEST_CASE("Validate Chunk Change Tracking", "[Chunk]")
+{
+	BlockReferrer referrer;
+	BlockType*    stone = addTestBlock(referrer, "core.stone");
+
+	Chunk chunk({0, 0, 0}, &referrer);
+
+	// a new chunk hasn't been seen by anything yet.
+	REQUIRE(chunk.isDirty(Chunk::SAVER));
+	REQUIRE(chunk.isDirty(Chunk::MESHER));
+	REQUIRE(chunk.getDirtyRegion(Chunk::MESHER).max.z ==
+	        Chunk::CHUNK_DEPTH - 1);
+
+	chunk.markClean(Chunk::SAVER);
+	chunk.markClean(Chunk::MESHER);
+	REQUIRE_FALSE(chunk.isDirty(Chunk::SAVER));
+	REQUIRE(chunk.isDirty(Chunk::NETWORK));
+
+	SECTION("Changes grow the dirty region of every consumer")
+	{
+		const auto version = chunk.getVersion();
+		chunk.setBlockAt({1, 2, 3}, {stone, nullptr});
+		chunk.setBlockAt({5, 0, 4}, {stone, nullptr});
+		REQUIRE(chunk.getVersion() > version);
+		REQUIRE(chunk.isDirty(Chunk::SAVER));
+
+		const DirtyRegion region = chunk.markClean(Chunk::MESHER);
+		REQUIRE(region.min == phx::math::vec3i {1, 0, 3});
+		REQUIRE(region.max == phx::math::vec3i {5, 2, 4});
+		REQUIRE_FALSE(chunk.isDirty(Chunk::MESHER));
+		REQUIRE(chunk.getDirtyRegion(Chunk::MESHER).isEmpty());
+
+		// the saver hasn't caught up, so it still sees both changes.
+		REQUIRE(chunk.getDirtyRegion(Chunk::SAVER).min ==
+		        phx::math::vec3i {1, 0, 3});
+	}
+
+	SECTION("Batched edits bump the version once")
+	{
+		const auto version = chunk.getVersion();
+		chunk.setBlocks({{Chunk::getVectorIndex(1, 1, 1), stone},
+		                 {Chunk::getVectorIndex(6, 2, 0), stone},
+		                 {Chunk::getVectorIndex(3, 7, 9), stone}});
+		REQUIRE(chunk.getVersion() == version + 1);
+		REQUIRE(chunk.getSolidCount() == 3);
+		REQUIRE(chunk.isSolidAt(Chunk::getVectorIndex(6, 2, 0)));
+
+		const DirtyRegion region = chunk.markClean(Chunk::MESHER);
+		REQUIRE(region.min == phx::math::vec3i {1, 1, 0});
+		REQUIRE(region.max == phx::math::vec3i {6, 7, 9});
+	}
+
+	SECTION("Filling a region only touches the blocks inside it")
+	{
+		DirtyRegion box;
+		box.add(2, 3, 4);
+		box.add(5, 6, 7);
+
+		const auto version = chunk.getVersion();
+		chunk.fill(box, stone);
+		REQUIRE(chunk.getVersion() == version + 1);
+		REQUIRE(chunk.getSolidCount() == 4 * 4 * 4);
+		REQUIRE(chunk.getBlockAt({5, 6, 7}).type == stone);
+		REQUIRE(chunk.getBlockAt({6, 6, 7}).type != stone);
+		REQUIRE(chunk.markClean(Chunk::MESHER).max == box.max);
+
+		// filling all of it leaves a single block type behind.
+		DirtyRegion all;
+		all.add(0, 0, 0);
+		all.add(Chunk::CHUNK_WIDTH - 1, Chunk::CHUNK_HEIGHT - 1,
+		        Chunk::CHUNK_DEPTH - 1);
+		chunk.fill(all, stone);
+		REQUIRE(chunk.isUniform());
+		REQUIRE(chunk.getSolidCount() == Chunk::CHUNK_MAX_BLOCKS);
+	}
+
+	SECTION("Catching up with an older version leaves newer changes dirty")
+	{
+		chunk.setBlockAt({1, 2, 3}, {stone, nullptr});
+		const auto snapshot = chunk.snapshot();
+		chunk.setBlockAt({4, 5, 6}, {stone, nullptr});
+
+		chunk.markClean(Chunk::SAVER, snapshot.getVersion());
+		REQUIRE(chunk.isDirty(Chunk::SAVER));
+
+		chunk.markClean(Chunk::SAVER, chunk.getVersion());
+		REQUIRE_FALSE(chunk.isDirty(Chunk::SAVER));
+		REQUIRE(chunk.getDirtyRegion(Chunk::SAVER).isEmpty());
+	}
+
+	SECTION("Loading a chunk marks all of it as changed")
+	{
+		phx::Serializer ser;
+		ser << chunk;
+		ser >> chunk;
+		REQUIRE(chunk.isDirty(Chunk::MESHER));
+		REQUIRE(chunk.getDirtyRegion(Chunk::MESHER).min ==
+		        phx::math::vec3i {0, 0, 0});
+	}
+}
+
+TEST_CASE("Validate Chunk Snapshots", "[Chunk]")
+{
+	BlockReferrer referrer;
+	BlockType*    stone = addTestBlock(referrer, "core.stone");
+	BlockType*    air   = referrer.blocks.get(BlockType::AIR_BLOCK);
+
+	Chunk chunk({0, 0, 0}, &referrer);
+	chunk.setBlockAt({1, 1, 1}, {stone, nullptr});
+	chunk.setMetadataAt({1, 1, 1}, "test.value", 4);
+
+	SECTION("A snapshot shares the blocks until the chunk changes")
+	{
+		const ChunkSnapshot snapshot = chunk.snapshot();
+		REQUIRE(&snapshot.getStorage() == &chunk.getStorage());
+		REQUIRE(snapshot.getVersion() == chunk.getVersion());
+
+		chunk.setBlockAt({1, 1, 1}, {air, nullptr});
+		chunk.setBlockAt({2, 2, 2}, {stone, nullptr});
+		REQUIRE(&snapshot.getStorage() != &chunk.getStorage());
+
+		// the snapshot still sees the chunk as it was.
+		REQUIRE(snapshot.getBlockAt(Chunk::getVectorIndex(1, 1, 1)) == stone);
+		REQUIRE(snapshot.getBlockAt(Chunk::getVectorIndex(2, 2, 2)) == air);
+		REQUIRE(snapshot.getSolidMask().count() == 1);
+		REQUIRE(snapshot.getMetadataAt(Chunk::getVectorIndex(1, 1, 1)) !=
+		        nullptr);
+		REQUIRE(chunk.getMetadata().empty());
+
+		// once the snapshot is gone the chunk writes in place again.
+		const BlockStorage* storage = &chunk.getStorage();
+		chunk.setBlockAt({3, 3, 3}, {stone, nullptr});
+		REQUIRE(&chunk.getStorage() == storage);
+	}
+
+	SECTION("Reading blocks with metadata doesn't copy the chunk")
+	{
+		const ChunkSnapshot snapshot = chunk.snapshot();
+
+		const Block block = chunk.getBlockAt({1, 1, 1});
+		REQUIRE(block.type == stone);
+		REQUIRE(block.metadata ==
+		        snapshot.getMetadataAt(Chunk::getVectorIndex(1, 1, 1)));
+		REQUIRE(&snapshot.getStorage() == &chunk.getStorage());
+	}
+
+	SECTION("A snapshot serializes the same as its chunk")
+	{
+		const ChunkSnapshot snapshot = chunk.snapshot();
+		chunk.setBlockAt({5, 5, 5}, {stone, nullptr});
+
+		phx::Serializer fromSnapshot;
+		fromSnapshot << snapshot;
+
+		ChunkSnapshot loaded(&referrer);
+		fromSnapshot >> loaded;
+		REQUIRE(loaded.getBlockAt(Chunk::getVectorIndex(1, 1, 1)) == stone);
+		REQUIRE(loaded.getBlockAt(Chunk::getVectorIndex(5, 5, 5)) == air);
+		REQUIRE(loaded.getSolidMask() == snapshot.getSolidMask());
+		REQUIRE(loaded.getMetadata().size() == 1);
+	}
+}
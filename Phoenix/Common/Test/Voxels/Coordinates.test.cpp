@@ -0,0 +1,67 @@
+#include <catch2/catch.hpp>
+
+#include <Common/Voxels/Coordinates.hpp>
+
+using namespace phx::voxels;
+
+namespace
+{
+	constexpr int WIDTH  = ChunkConfig::WIDTH;
+	constexpr int HEIGHT = ChunkConfig::HEIGHT;
+	constexpr int DEPTH  = ChunkConfig::DEPTH;
+} // namespace
+
+// the conversions are all constexpr.
+static_assert(floorToBlock(-0.5f) == -1);
+static_assert(BlockPos(-1, 0, 0).getChunk() == ChunkPos(-1, 0, 0));
+static_assert(BlockPos(-1, 0, 0).getLocal() == LocalPos(WIDTH - 1, 0, 0));
+
+TEST_CASE("Block Coordinates", "[Coordinates]")
+{
+	SECTION("World positions are floored")
+	{
+		REQUIRE(floorToBlock(0.f) == 0);
+		REQUIRE(floorToBlock(0.99f) == 0);
+		REQUIRE(floorToBlock(1.f) == 1);
+		REQUIRE(floorToBlock(-0.01f) == -1);
+		REQUIRE(floorToBlock(-1.f) == -1);
+		REQUIRE(floorToBlock(-1.5f) == -2);
+
+		REQUIRE(BlockPos::fromWorld({-0.5f, 2.5f, -16.f}) ==
+		        BlockPos(-1, 2, -16));
+	}
+
+	SECTION("Blocks are split into their chunk and local position")
+	{
+		const BlockPos block(WIDTH + 1, -1, -DEPTH - 1);
+
+		REQUIRE(block.getChunk() == ChunkPos(1, -1, -2));
+		REQUIRE(block.getLocal() == LocalPos(1, HEIGHT - 1, DEPTH - 1));
+
+		// and put back together.
+		REQUIRE(BlockPos(block.getChunk(), block.getLocal()) == block);
+		REQUIRE(ChunkPos(1, -1, -2).getOrigin() ==
+		        BlockPos(WIDTH, -HEIGHT, -2 * DEPTH));
+	}
+
+	SECTION("Every block round trips through its chunk")
+	{
+		for (int x = -2 * WIDTH; x < 2 * WIDTH; ++x)
+		{
+			const BlockPos block(x, -x, x * 3);
+			const LocalPos local = block.getLocal();
+
+			REQUIRE(local.x >= 0);
+			REQUIRE(local.x < WIDTH);
+			REQUIRE(BlockPos(block.getChunk(), local) == block);
+			REQUIRE(LocalPos::fromIndex(local.getIndex()) == local);
+		}
+	}
+
+	SECTION("Chunk positions convert to the vectors the map is keyed by")
+	{
+		const phx::math::vec3i coords = ChunkPos(1, -2, 3);
+		REQUIRE(coords == phx::math::vec3i(1, -2, 3));
+		REQUIRE(ChunkPos(coords) == ChunkPos(1, -2, 3));
+	}
+}
@@ -0,0 +1,587 @@
+#include <catch2/catch.hpp>
+
+#include <Common/Voxels/ChunkNeighborhood.hpp>
+#include <Common/Voxels/Map.hpp>
+
+#include "TestBlocks.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <thread>
+
+using namespace phx::voxels;
+
+namespace
+{
+	// gives the workers time to finish, adding everything they did.
+	std::size_t updateUntil(Map& map, std::size_t count)
+	{
+		std::size_t added = 0;
+		for (int i = 0; i < 1000 && added < count; ++i)
+		{
+			added += map.update(count);
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		return added;
+	}
+} // namespace
+
+TEST_CASE("Validate Map Requests", "[Map]")
+{
+	namespace fs = std::filesystem;
+
+	fs::path directory = fs::temp_directory_path() / "phx-map-test";
+	fs::remove_all(directory);
+	fs::create_directories(directory);
+
+	BlockReferrer referrer;
+	addTestBlock(referrer, "core.air");
+	addTestBlock(referrer, "core.grass");
+
+	BlockDictionary         dictionary;
+	phx::MetadataDictionary keys;
+
+	SECTION("Requested chunks are added by update")
+	{
+		Map map(&directory, "map", &referrer, &dictionary, &keys);
+
+		std::vector<phx::math::vec3i> loaded;
+		for (int i = 0; i < 8; ++i)
+		{
+			const phx::math::vec3i pos(0, i - 4, 0);
+			map.request(pos, static_cast<float>(i),
+			            [&loaded, pos](Chunk* chunk) {
+				            REQUIRE(chunk->getChunkCoords() == pos);
+				            loaded.push_back(pos);
+			            });
+		}
+
+		REQUIRE(loaded.empty());
+		REQUIRE(map.getPendingCount() == 8);
+		REQUIRE(updateUntil(map, 8) == 8);
+		REQUIRE(loaded.size() == 8);
+		REQUIRE(map.getPendingCount() == 0);
+
+		// the chunks are in the map now, so they're handed out straight
+		// away.
+		bool called = false;
+		map.request(loaded.front(), 0.f, [&called](Chunk*) { called = true; });
+		REQUIRE(called);
+	}
+
+	SECTION("Requested chunks aren't sent again until they change")
+	{
+		Map map(&directory, "map", &referrer, &dictionary, &keys);
+
+		Chunk* result = nullptr;
+		map.request({0, 0, 0}, 0.f, [&result](Chunk* chunk) { result = chunk; });
+		REQUIRE(updateUntil(map, 1) == 1);
+		REQUIRE(result != nullptr);
+		REQUIRE(map.getDirtyChunks(Chunk::NETWORK).empty());
+
+		BlockType* grass = referrer.blocks.get(
+		    *referrer.referrer.get("core.grass"));
+		result->setBlockAt({1, 2, 3}, {grass, nullptr});
+		REQUIRE(map.getDirtyChunks(Chunk::NETWORK).size() == 1);
+	}
+
+	SECTION("The same chunk is only loaded once")
+	{
+		Map map(&directory, "map", &referrer, &dictionary, &keys);
+
+		int calls = 0;
+		for (int i = 0; i < 5; ++i)
+		{
+			map.request({0, 0, 0}, static_cast<float>(5 - i),
+			            [&calls](Chunk*) { ++calls; });
+		}
+
+		REQUIRE(updateUntil(map, 5) == 1);
+		REQUIRE(calls == 5);
+
+		// nothing else is waiting.
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		REQUIRE(map.update(10) == 0);
+	}
+
+	SECTION("Saved chunks are loaded rather than generated")
+	{
+		BlockType* grass = referrer.blocks.get(
+		    *referrer.referrer.get("core.grass"));
+		{
+			Map map(&directory, "map", &referrer, &dictionary, &keys);
+			map.getChunk({0, 0, 0})->setBlockAt({1, 2, 3}, {grass, nullptr});
+			map.flush();
+		}
+
+		Map   map(&directory, "map", &referrer, &dictionary, &keys);
+		Chunk* result = nullptr;
+		map.request({0, 0, 0}, 0.f, [&result](Chunk* chunk) { result = chunk; });
+		REQUIRE(updateUntil(map, 1) == 1);
+		REQUIRE(result != nullptr);
+		REQUIRE(result->getBlockAt({1, 2, 3}).type == grass);
+		REQUIRE(!result->isDirty(Chunk::SAVER));
+	}
+
+	SECTION("The budget limits how many chunks are added at once")
+	{
+		Map map(&directory, "map", &referrer, &dictionary, &keys);
+		for (int i = 0; i < 10; ++i)
+		{
+			map.request({i, 0, 0}, 0.f, [](Chunk*) {});
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		REQUIRE(map.update(3) == 3);
+		REQUIRE(map.getPendingCount() == 7);
+		REQUIRE(updateUntil(map, 7) == 7);
+	}
+
+	SECTION("Changes are written by the flusher, not when they're made")
+	{
+		BlockType* grass = referrer.blocks.get(
+		    *referrer.referrer.get("core.grass"));
+
+		Map map(&directory, "map", &referrer, &dictionary, &keys);
+		map.setFlushPolicy({std::chrono::hours(1), 1000});
+
+		Chunk* chunk = map.getChunk({1, 0, 0});
+		map.flush();
+		REQUIRE_FALSE(chunk->isDirty(Chunk::SAVER));
+		const auto written = map.getFlushStats().written;
+
+		for (int i = 0; i < 10; ++i)
+		{
+			map.setBlockAt(BlockPos(17, i, 0), {grass, nullptr});
+		}
+		map.update(0);
+		REQUIRE(chunk->isDirty(Chunk::SAVER));
+		REQUIRE(map.getFlushStats().dirty == 1);
+		REQUIRE(map.getFlushStats().written == written);
+
+		// every edit goes out in a single write.
+		REQUIRE(map.flush() == 1);
+		REQUIRE_FALSE(chunk->isDirty(Chunk::SAVER));
+		REQUIRE(map.getFlushStats().written == written + 1);
+		REQUIRE(map.getFlushStats().backlog == 0);
+		REQUIRE(map.getFlushStats().bytes > 0);
+	}
+
+	SECTION("Enough changed chunks are written without waiting")
+	{
+		Map map(&directory, "map", &referrer, &dictionary, &keys);
+		map.setFlushPolicy({std::chrono::hours(1), 4});
+
+		BlockType* grass = referrer.blocks.get(
+		    *referrer.referrer.get("core.grass"));
+		for (int i = 0; i < 4; ++i)
+		{
+			map.getChunk({i, 0, 0});
+		}
+		map.flush();
+
+		for (int i = 0; i < 4; ++i)
+		{
+			map.setBlockAt(BlockPos(i * 16, 0, 0), {grass, nullptr});
+			map.update(0);
+			REQUIRE(map.getFlushStats().dirty ==
+			        static_cast<std::size_t>(i < 3 ? i + 1 : 0));
+		}
+	}
+
+	SECTION("Unloaded chunks are written before they're read again")
+	{
+		BlockType* grass = referrer.blocks.get(
+		    *referrer.referrer.get("core.grass"));
+
+		Map map(&directory, "map", &referrer, &dictionary, &keys);
+		map.getChunk({0, 0, 0})->setBlockAt({1, 1, 1}, {grass, nullptr});
+		map.unloadChunk({0, 0, 0});
+
+		REQUIRE(map.getChunk({0, 0, 0})->getBlockAt({1, 1, 1}).type == grass);
+	}
+
+	SECTION("Changes are written when the map is closed")
+	{
+		BlockType* grass = referrer.blocks.get(
+		    *referrer.referrer.get("core.grass"));
+		{
+			Map map(&directory, "map", &referrer, &dictionary, &keys);
+			map.getChunk({0, 0, 0})->setBlockAt({2, 2, 2}, {grass, nullptr});
+		}
+
+		Map map(&directory, "map", &referrer, &dictionary, &keys);
+		REQUIRE(map.getChunk({0, 0, 0})->getBlockAt({2, 2, 2}).type == grass);
+	}
+
+	SECTION("Unused chunks are unloaded once over the budget")
+	{
+		Map map(&directory, "map", &referrer, &dictionary, &keys);
+		map.getChunk({0, 0, 0});
+		map.getChunk({1, 0, 0});
+		map.getChunk({2, 0, 0});
+		map.acquire({1, 0, 0});
+
+		map.update(0);
+		REQUIRE(map.getResidencyStats().resident == 3);
+		REQUIRE(map.getResidencyStats().referenced == 1);
+		REQUIRE(map.getResidencyStats().evicted == 0);
+
+		map.setMemoryBudget(0);
+		map.update(0);
+
+		Map::ResidencyStats stats = map.getResidencyStats();
+		REQUIRE(stats.resident == 1);
+		REQUIRE(stats.referenced == 1);
+		REQUIRE(stats.evicted == 2);
+		REQUIRE(stats.bytes > 0);
+
+		// released chunks can go too.
+		map.release({1, 0, 0});
+		map.update(0);
+		REQUIRE(map.getResidencyStats().resident == 0);
+		REQUIRE(map.getResidencyStats().evicted == 3);
+	}
+
+	SECTION("Edits are counted in the memory the map uses")
+	{
+		BlockType* grass = referrer.blocks.get(
+		    *referrer.referrer.get("core.grass"));
+
+		Map map(&directory, "map", &referrer, &dictionary, &keys);
+		Chunk* chunk = map.getChunk({0, 0, 0});
+		map.update(0);
+		const std::size_t before = map.getResidencyStats().bytes;
+		const std::size_t usage  = chunk->getMemoryUsage();
+		REQUIRE(before > usage);
+
+		phx::Metadata power;
+		power.set("test.power", 15);
+		for (int i = 0; i < 16; ++i)
+		{
+			chunk->setBlockAt({float(i), float(i), 0}, {grass, &power});
+		}
+		REQUIRE(chunk->getMemoryUsage() > usage);
+
+		map.update(0);
+		REQUIRE(map.getResidencyStats().bytes ==
+		        before - usage + chunk->getMemoryUsage());
+		REQUIRE(map.getFlushStats().dirty == 1);
+
+		map.unloadChunk({0, 0, 0});
+		REQUIRE(map.getResidencyStats().bytes == 0);
+		REQUIRE(map.getFlushStats().dirty == 0);
+	}
+
+	SECTION("The least recently used chunks are unloaded first")
+	{
+		Map map(&directory, "map", &referrer, &dictionary, &keys);
+		const std::size_t size = map.getChunk({0, 0, 0})->getMemoryUsage();
+		map.getChunk({1, 0, 0});
+		map.getChunk({2, 0, 0});
+
+		map.acquire({0, 0, 0});
+		map.release({0, 0, 0});
+
+		// there's room for two chunks, give or take.
+		map.setMemoryBudget(size * 2 + 1024);
+		map.update(0);
+		REQUIRE(map.getResidencyStats().resident == 2);
+
+		map.setMemoryBudget(0);
+		map.acquire({0, 0, 0});
+		map.update(0);
+		REQUIRE(map.getResidencyStats().resident == 1);
+		REQUIRE(map.getResidencyStats().evicted == 2);
+	}
+
+	SECTION("Unloaded chunks keep their changes")
+	{
+		BlockType* grass = referrer.blocks.get(
+		    *referrer.referrer.get("core.grass"));
+
+		Map map(&directory, "map", &referrer, &dictionary, &keys);
+		map.getChunk({0, 0, 0})->setBlockAt({3, 3, 3}, {grass, nullptr});
+
+		map.setMemoryBudget(0);
+		map.update(0);
+		REQUIRE(map.getResidencyStats().resident == 0);
+
+		REQUIRE(map.getChunk({0, 0, 0})->getBlockAt({3, 3, 3}).type == grass);
+	}
+
+	SECTION("Blocks at negative positions are in the chunk below them")
+	{
+		BlockType* stone = addTestBlock(referrer, "core.stone");
+
+		Map map(&directory, "map", &referrer, &dictionary, &keys);
+		map.setBlockAt(phx::math::vec3(-0.5f, 0.5f, -0.5f), {stone, nullptr});
+
+		const LocalPos corner(Chunk::CHUNK_WIDTH - 1, 0,
+		                      Chunk::CHUNK_DEPTH - 1);
+		Chunk* chunk = map.getChunk(ChunkPos(-1, 0, -1));
+		REQUIRE(chunk->getBlockAt(corner.getIndex()).type == stone);
+
+		REQUIRE(map.getBlockAt(BlockPos(-1, 0, -1)) == stone);
+		REQUIRE(map.getBlockAt(BlockPos(0, 0, 0)) != stone);
+	}
+
+	SECTION("Batches split their edits between the chunks they touch")
+	{
+		BlockType* stone = addTestBlock(referrer, "core.stone");
+
+		Map map(&directory, "map", &referrer, &dictionary, &keys);
+		map.applyBatch({{phx::math::vec3(-0.5f, 0.5f, -0.5f), stone},
+		                {phx::math::vec3(0.5f, 0.5f, 0.5f), stone},
+		                {phx::math::vec3(1.f, 0.f, 0.f), stone}});
+
+		REQUIRE(map.getBlockAt(BlockPos(-1, 0, -1)) == stone);
+		REQUIRE(map.getBlockAt(BlockPos(0, 0, 0)) == stone);
+		REQUIRE(map.getBlockAt(BlockPos(1, 0, 0)) == stone);
+		REQUIRE(map.getBlockAt(BlockPos(0, 0, -1)) != stone);
+	}
+
+	SECTION("Accessors see the same blocks as the map")
+	{
+		BlockType* stone = addTestBlock(referrer, "core.stone");
+
+		Map map(&directory, "map", &referrer, &dictionary, &keys);
+		map.setBlockAt(BlockPos(-1, 2, 0), {stone, nullptr});
+		map.setBlockAt(BlockPos(Chunk::CHUNK_WIDTH, 2, 0), {stone, nullptr});
+
+		// walks across three chunks, one block at a time.
+		Map::Accessor accessor(&map, BlockPos(-Chunk::CHUNK_WIDTH, 2, 0));
+		for (int x = -Chunk::CHUNK_WIDTH; x < Chunk::CHUNK_WIDTH * 2; ++x)
+		{
+			REQUIRE(accessor.getPosition() == BlockPos(x, 2, 0));
+			REQUIRE(accessor.getBlock() == map.getBlockAt(BlockPos(x, 2, 0)));
+			REQUIRE(accessor.getChunk() ==
+			        map.getChunk(BlockPos(x, 2, 0).getChunk()));
+			accessor.offset(1, 0, 0);
+		}
+
+		accessor.moveTo({-1, 2, 0});
+		REQUIRE(accessor.getBlock() == stone);
+
+		accessor.offset(0, 1, 0).setBlock({stone, nullptr});
+		REQUIRE(map.getBlockAt(BlockPos(-1, 3, 0)) == stone);
+		REQUIRE(accessor.isSolid());
+	}
+
+	SECTION("Accessors forget chunks that were unloaded")
+	{
+		BlockType* stone = addTestBlock(referrer, "core.stone");
+
+		Map map(&directory, "map", &referrer, &dictionary, &keys);
+		map.setBlockAt(BlockPos(1, 1, 1), {stone, nullptr});
+
+		Map::Accessor accessor(&map, BlockPos(1, 1, 1));
+		REQUIRE(accessor.getBlock() == stone);
+
+		map.setMemoryBudget(0);
+		map.update(0);
+		REQUIRE(map.getResidencyStats().resident == 0);
+
+		// the chunk is loaded again rather than read from the old pointer.
+		REQUIRE(accessor.getBlock() == stone);
+		REQUIRE(accessor.getChunk() == map.getChunk({0, 0, 0}));
+		REQUIRE(map.getResidencyStats().resident == 1);
+	}
+
+	SECTION("Loaded chunks are linked to the chunks next to them")
+	{
+		Map map(&directory, "map", &referrer, &dictionary, &keys);
+
+		Chunk* centre = map.getChunk({0, 0, 0});
+		Chunk* right  = map.getChunk({1, 0, 0});
+		REQUIRE(centre->getNeighbor(Chunk::POS_X) == right);
+		REQUIRE(right->getNeighbor(Chunk::NEG_X) == centre);
+		REQUIRE(centre->getNeighbor(Chunk::NEG_X) == nullptr);
+		REQUIRE(centre->getNeighbor(Chunk::POS_Y) == nullptr);
+
+		// chunks finished by the workers are linked too.
+		map.request({0, 0, -1}, 0.f, [](Chunk*) {});
+		REQUIRE(updateUntil(map, 1) == 1);
+		Chunk* back = map.getChunk({0, 0, -1});
+		REQUIRE(centre->getNeighbor(Chunk::NEG_Z) == back);
+		REQUIRE(back->getNeighbor(Chunk::POS_Z) == centre);
+
+		map.unloadChunk({1, 0, 0});
+		REQUIRE(centre->getNeighbor(Chunk::POS_X) == nullptr);
+
+		// copies aren't in the map, so they don't have neighbours.
+		const Chunk copy = *centre;
+		REQUIRE(copy.getNeighbor(Chunk::NEG_Z) == nullptr);
+	}
+
+	SECTION("Neighbourhoods include the edges of the chunks around")
+	{
+		BlockType* stone = addTestBlock(referrer, "core.stone");
+
+		Map map(&directory, "map", &referrer, &dictionary, &keys);
+		map.getChunk({0, 0, 0});
+		map.setBlockAt(BlockPos(-1, 0, 0), {stone, nullptr});
+		map.getChunk({1, 0, 0});
+		map.setBlockAt(BlockPos(Chunk::CHUNK_WIDTH, Chunk::CHUNK_HEIGHT, 0),
+		               {stone, nullptr});
+
+		const ChunkNeighborhood blocks(*map.getChunk({0, 0, 0}));
+		REQUIRE(blocks.getBlockAt(0, 0, 0) ==
+		        map.getBlockAt(BlockPos(0, 0, 0)));
+		REQUIRE(blocks.getBlockAt(Chunk::CHUNK_WIDTH - 1, 3, 5) ==
+		        map.getBlockAt(BlockPos(Chunk::CHUNK_WIDTH - 1, 3, 5)));
+		REQUIRE(blocks.getBlockAt(-1, 0, 0) == stone);
+		REQUIRE(blocks.isSolidAt(-1, 0, 0));
+
+		// the chunk on the edge is found through the chunk next to it.
+		REQUIRE(blocks.getBlockAt(Chunk::CHUNK_WIDTH, Chunk::CHUNK_HEIGHT,
+		                          0) == stone);
+
+		// that chunk isn't loaded.
+		REQUIRE(blocks.getBlockAt(0, 0, -1) == nullptr);
+		REQUIRE_FALSE(blocks.isSolidAt(0, 0, -1));
+	}
+
+	SECTION("Chunks the server sends again replace the loaded ones")
+	{
+		struct Updates : MapEventSubscriber
+		{
+			std::vector<Chunk*> chunks;
+
+			void onMapEvent(const MapEvent& mapEvent) override
+			{
+				if (mapEvent.type == MapEvent::CHUNK_UPDATE)
+				{
+					chunks.push_back(std::get<Chunk*>(mapEvent.data));
+				}
+			}
+		};
+
+		BlockType* grass =
+		    referrer.blocks.get(*referrer.referrer.get("core.grass"));
+
+		phx::BlockingQueue<ChunkData> queue;
+		const auto send = [&queue, &keys](const Chunk& chunk) {
+			phx::Serializer ser;
+			chunk.send(ser, keys);
+			queue.push({chunk.getChunkPos(), ser.getBuffer()});
+		};
+
+		Map     map(&queue, &referrer, &keys);
+		Updates updates;
+		map.registerEventSubscriber(&updates);
+
+		Chunk sent(Chunk::toChunkPos({0, 0, 0}), &referrer);
+		send(sent);
+		send(Chunk(Chunk::toChunkPos({1, 0, 0}), &referrer));
+		map.update(1);
+
+		Chunk* chunk = map.getChunk({0, 0, 0});
+		REQUIRE(chunk != nullptr);
+		REQUIRE(chunk->getNeighbor(Chunk::POS_X) != nullptr);
+		REQUIRE(updates.chunks.empty());
+
+		const std::uint64_t version = chunk->getVersion();
+		sent.setBlockAt(std::size_t(0), {grass, nullptr});
+		send(sent);
+		map.update(1);
+
+		// the same chunk, still linked, with the blocks that were sent.
+		REQUIRE(map.getChunk({0, 0, 0}) == chunk);
+		REQUIRE(chunk->getBlockAt(std::size_t(0)).type == grass);
+		REQUIRE(chunk->getNeighbor(Chunk::POS_X) != nullptr);
+		REQUIRE(chunk->getVersion() > version);
+		REQUIRE_FALSE(chunk->isDirty(Chunk::NETWORK));
+		REQUIRE(updates.chunks == std::vector<Chunk*> {chunk});
+	}
+
+	SECTION("New chunks are made by the terrain generator")
+	{
+		BlockType* grass =
+		    referrer.blocks.get(*referrer.referrer.get("core.grass"));
+
+		auto generator = std::make_shared<TerrainGenerator>(&referrer, 42);
+		generator->addBiome({"core.plains", 0.f, 0.f, 0.f, 12.f, grass,
+		                     grass, 3, grass});
+		generator->freeze();
+
+		Map map(&directory, "map", &referrer, &dictionary, &keys);
+		map.setGenerator(generator);
+
+		map.request({2, -1, 2}, 0.f, [](Chunk*) {});
+		REQUIRE(updateUntil(map, 1) == 1);
+		REQUIRE(map.getChunk({2, -1, 2})->getBlocks() ==
+		        generator->generate({2, -1, 2}).getBlocks());
+		REQUIRE(map.getChunk({0, 0, 0})->getBlocks() ==
+		        generator->generate({0, 0, 0}).getBlocks());
+	}
+
+	fs::remove_all(directory);
+}
+
+TEST_CASE("Map Accessor Throughput", "[!benchmark][Map]")
+{
+	namespace fs = std::filesystem;
+
+	fs::path directory = fs::temp_directory_path() / "phx-accessor-test";
+	fs::remove_all(directory);
+	fs::create_directories(directory);
+
+	BlockReferrer referrer;
+	addTestBlock(referrer, "core.air");
+	addTestBlock(referrer, "core.grass");
+
+	{
+		Map map(&directory, "map", &referrer, nullptr);
+
+		// a box of 4x4x4 chunks, loaded up front.
+		const int size = Chunk::CHUNK_WIDTH * 4;
+		map.getBlockAt(BlockPos(0, 0, 0));
+		for (int x = 0; x < 4; ++x)
+		{
+			for (int y = 0; y < 4; ++y)
+			{
+				for (int z = 0; z < 4; ++z)
+				{
+					map.getChunk({x, y, z});
+				}
+			}
+		}
+
+		BENCHMARK("Map::isSolidAt over a box")
+		{
+			std::size_t solid = 0;
+			for (int z = 0; z < size; ++z)
+			{
+				for (int y = 0; y < size; ++y)
+				{
+					for (int x = 0; x < size; ++x)
+					{
+						solid += map.isSolidAt(BlockPos(x, y, z));
+					}
+				}
+			}
+			return solid;
+		};
+
+		BENCHMARK("Map::Accessor::isSolid over a box")
+		{
+			std::size_t   solid = 0;
+			Map::Accessor accessor(&map);
+			for (int z = 0; z < size; ++z)
+			{
+				for (int y = 0; y < size; ++y)
+				{
+					for (int x = 0; x < size; ++x)
+					{
+						accessor.moveTo({x, y, z});
+						solid += accessor.isSolid();
+					}
+				}
+			}
+			return solid;
+		};
+	}
+
+	fs::remove_all(directory);
+}
@@ -0,0 +1,274 @@
+#include <catch2/catch.hpp>
+
+#include <Common/CoreIntrinsics.hpp>
+#include <Common/Voxels/RegionFile.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+#ifdef ENGINE_PLATFORM_LINUX
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
+
+using namespace phx::voxels;
+
+namespace
+{
+	phx::data::Data makeSave(std::size_t size, int seed)
+	{
+		phx::data::Data save(size);
+		for (std::size_t i = 0; i < size; ++i)
+		{
+			save[i] = std::byte((i * 31 + seed) & 0xFF);
+		}
+		return save;
+	}
+} // namespace
+
+TEST_CASE("Validate Region Files", "[RegionFile]")
+{
+	namespace fs = std::filesystem;
+
+	const fs::path directory = fs::temp_directory_path() / "phx-region-test";
+	fs::remove_all(directory);
+	fs::create_directories(directory);
+	const fs::path path = directory / "r.0.0.0.region";
+
+	SECTION("Chunks map to a region and an index")
+	{
+		REQUIRE(RegionFile::toRegion({7, 8, -1}) == phx::math::vec3i(0, 1, -1));
+		REQUIRE(RegionFile::toIndex({0, 0, 0}) == 0);
+		REQUIRE(RegionFile::toIndex({-1, -1, -1}) == RegionFile::CHUNKS - 1);
+		REQUIRE(RegionFile::toIndex({9, 0, 0}) == 1);
+	}
+
+	SECTION("Nothing is created until something is written")
+	{
+		RegionFile      region(path);
+		phx::data::Data out;
+		REQUIRE_FALSE(region.contains(0));
+		REQUIRE_FALSE(region.read(0, out));
+		REQUIRE_FALSE(fs::exists(path));
+	}
+
+	SECTION("Saves are read back, from the same or a new instance")
+	{
+		const phx::data::Data small = makeSave(100, 1);
+		const phx::data::Data large = makeSave(10000, 2);
+
+		{
+			RegionFile region(path);
+			REQUIRE(region.write(3, small.data(), small.size()));
+			REQUIRE(region.write(511, large.data(), large.size()));
+
+			phx::data::Data out;
+			REQUIRE(region.read(3, out));
+			REQUIRE(out == small);
+			REQUIRE_FALSE(region.read(4, out));
+		}
+
+		RegionFile      region(path);
+		phx::data::Data out;
+		REQUIRE(region.contains(511));
+		REQUIRE(region.read(511, out));
+		REQUIRE(out == large);
+		REQUIRE(region.read(3, out));
+		REQUIRE(out == small);
+	}
+
+	SECTION("Space from replaced saves is reused")
+	{
+		RegionFile region(path);
+		for (int i = 0; i < 50; ++i)
+		{
+			const phx::data::Data save = makeSave(5000, i);
+			REQUIRE(region.write(0, save.data(), save.size()));
+			REQUIRE(region.write(1, save.data(), save.size()));
+		}
+
+		// the tables, both chunks, and the saves the older table still
+		// points at.
+		REQUIRE(region.getSectorCount() <= 4 + 4 * 2 + 2);
+
+		phx::data::Data out;
+		REQUIRE(region.read(1, out));
+		REQUIRE(out == makeSave(5000, 49));
+	}
+
+	SECTION("Views see the same bytes as reads")
+	{
+		RegionFile region(path);
+		REQUIRE_FALSE(region.view(0));
+
+		const phx::data::Data first = makeSave(3000, 1);
+		REQUIRE(region.write(0, first.data(), first.size()));
+		region.prefetch(0);
+
+		RegionFile::View view = region.view(0);
+		REQUIRE(view);
+		REQUIRE(phx::data::Data(view.data, view.data + view.size) == first);
+
+		// the file grows past the first mapping.
+		const phx::data::Data second = makeSave(50000, 2);
+		REQUIRE(region.write(1, second.data(), second.size()));
+
+		RegionFile::View grown = region.view(1);
+		REQUIRE(grown);
+		REQUIRE(phx::data::Data(grown.data, grown.data + grown.size) ==
+		        second);
+
+		// the old view is still readable.
+		REQUIRE(phx::data::Data(view.data, view.data + view.size) == first);
+	}
+
+	SECTION("A damaged table falls back to the other copy")
+	{
+		const phx::data::Data first  = makeSave(100, 1);
+		const phx::data::Data second = makeSave(100, 2);
+		{
+			RegionFile region(path);
+			REQUIRE(region.write(0, first.data(), first.size()));
+			REQUIRE(region.write(0, second.data(), second.size()));
+		}
+
+		// the last write was the fourth commit, so its table is the first
+		// copy.
+		{
+			std::fstream file(path,
+			                  std::ios::in | std::ios::out | std::ios::binary);
+			file.seekp(100);
+			file.put('\xFF');
+		}
+
+		RegionFile      region(path);
+		phx::data::Data out;
+		REQUIRE(region.read(0, out));
+		REQUIRE(out == first);
+	}
+
+	fs::remove_all(directory);
+}
+
+TEST_CASE("Region File Read Latency", "[!benchmark][RegionFile]")
+{
+	namespace fs = std::filesystem;
+	using Clock  = std::chrono::steady_clock;
+
+	const fs::path directory = fs::temp_directory_path() / "phx-region-bench";
+	fs::remove_all(directory);
+	fs::create_directories(directory);
+	const fs::path path = directory / "r.0.0.0.region";
+
+	{
+		RegionFile region(path);
+		for (std::size_t i = 0; i < RegionFile::CHUNKS; ++i)
+		{
+			const phx::data::Data save =
+			    makeSave(1000 + (i * 7919) % 12000, static_cast<int>(i));
+			region.write(i, save.data(), save.size());
+		}
+	}
+
+	// drops the file from the page cache where that's possible, so the
+	// first pass has to go to the disk.
+	auto evict = [&path]() {
+#ifdef ENGINE_PLATFORM_LINUX
+		// dirty pages can't be dropped, they have to be written first.
+		const int file = ::open(path.c_str(), O_RDONLY);
+		fsync(file);
+		posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED);
+		::close(file);
+#endif
+	};
+
+	auto residentPages = [&path]() {
+		phx::MappedFile file;
+		file.open(path);
+		return file.getResidentPages(0, file.size());
+	};
+
+	auto report = [](const char* name, std::vector<double>& times) {
+		std::sort(times.begin(), times.end());
+		auto at = [&times](double p) {
+			return times[static_cast<std::size_t>(p * (times.size() - 1))];
+		};
+		WARN(name << ": p50 " << at(0.5) << " us, p90 " << at(0.9)
+		          << " us, p99 " << at(0.99) << " us, max " << times.back()
+		          << " us");
+	};
+
+	for (const bool cold : {true, false})
+	{
+		const char* state = cold ? "cold" : "warm";
+
+		// both paths touch every byte like a deserializer would, the stream
+		// path copies every save into a buffer first.
+		std::uint8_t        sum = 0;
+		std::vector<double> streamTimes;
+		{
+			if (cold)
+			{
+				evict();
+			}
+			WARN(state << " stream, resident pages before: "
+			           << residentPages());
+
+			RegionFile      region(path);
+			phx::data::Data out;
+			for (std::size_t i = 0; i < RegionFile::CHUNKS; ++i)
+			{
+				const auto start = Clock::now();
+				region.read(i, out);
+				for (const std::byte b : out)
+				{
+					sum += static_cast<std::uint8_t>(b);
+				}
+				streamTimes.push_back(
+				    std::chrono::duration<double, std::micro>(Clock::now() -
+				                                              start)
+				        .count());
+			}
+		}
+
+		std::vector<double> mappedTimes;
+		{
+			if (cold)
+			{
+				evict();
+			}
+			WARN(state << " mapped, resident pages before: "
+			           << residentPages());
+
+			RegionFile region(path);
+			for (std::size_t i = 0; i < RegionFile::CHUNKS; ++i)
+			{
+				region.prefetch(i);
+			}
+			WARN(state << " mapped, resident pages after prefetching: "
+			           << residentPages());
+
+			for (std::size_t i = 0; i < RegionFile::CHUNKS; ++i)
+			{
+				const auto             start = Clock::now();
+				const RegionFile::View view  = region.view(i);
+				for (std::size_t b = 0; b < view.size; ++b)
+				{
+					sum += static_cast<std::uint8_t>(view.data[b]);
+				}
+				mappedTimes.push_back(
+				    std::chrono::duration<double, std::micro>(Clock::now() -
+				                                              start)
+				        .count());
+			}
+		}
+		WARN("checksum " << static_cast<int>(sum));
+
+		report(cold ? "cold stream" : "warm stream", streamTimes);
+		report(cold ? "cold mapped" : "warm mapped", mappedTimes);
+	}
+
+	fs::remove_all(directory);
+}
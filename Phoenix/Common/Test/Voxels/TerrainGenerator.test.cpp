@@ -0,0 +1,230 @@
+#include <catch2/catch.hpp>
+
+#include <Common/Voxels/TerrainGenerator.hpp>
+
+#include "TestBlocks.hpp"
+
+#include <thread>
+
+using namespace phx::voxels;
+
+namespace
+{
+	// a stack of chunks a few columns wide, from under the ground to the sky.
+	std::vector<phx::math::vec3i> getArea(int size)
+	{
+		std::vector<phx::math::vec3i> area;
+		for (int x = -size; x < size; ++x)
+		{
+			for (int z = -size; z < size; ++z)
+			{
+				for (int y = -3; y < 3; ++y)
+				{
+					area.emplace_back(x, y, z);
+				}
+			}
+		}
+		return area;
+	}
+} // namespace
+
+TEST_CASE("Terrain Generation", "[Terrain]")
+{
+	BlockReferrer    referrer;
+	BlockType* const air   = referrer.blocks.get(BlockType::AIR_BLOCK);
+	BlockType* const grass = addTestBlock(referrer, "core.grass");
+	BlockType* const dirt  = addTestBlock(referrer, "core.dirt");
+	BlockType* const stone = addTestBlock(referrer, "core.stone");
+	BlockType* const sand  = addTestBlock(referrer, "core.sand");
+
+	TerrainGenerator generator(&referrer, 1234);
+	generator.addBiome(
+	    {"core.plains", -0.2f, 0.f, 0.f, 12.f, grass, dirt, 3, stone});
+	generator.addBiome(
+	    {"core.desert", 0.4f, -0.4f, 4.f, 6.f, sand, sand, 4, stone});
+
+	SECTION("Chunks are the same on any amount of threads")
+	{
+		const std::vector<phx::math::vec3i> area = getArea(2);
+
+		const std::vector<Chunk> single = generator.generate(area, 1);
+		const std::vector<Chunk> many   = generator.generate(area, 4);
+
+		// a fresh generator doesn't have any columns cached.
+		TerrainGenerator fresh(&referrer, 1234);
+		fresh.addBiome(
+		    {"core.plains", -0.2f, 0.f, 0.f, 12.f, grass, dirt, 3, stone});
+		fresh.addBiome(
+		    {"core.desert", 0.4f, -0.4f, 4.f, 6.f, sand, sand, 4, stone});
+		const std::vector<Chunk> again = fresh.generate(area, 3);
+
+		REQUIRE(single.size() == area.size());
+		for (std::size_t i = 0; i < area.size(); ++i)
+		{
+			REQUIRE(single[i].getChunkCoords() == area[i]);
+			REQUIRE(single[i].getBlocks() == many[i].getBlocks());
+			REQUIRE(single[i].getBlocks() == again[i].getBlocks());
+		}
+	}
+
+	SECTION("Different seeds make different terrain")
+	{
+		TerrainGenerator other(&referrer, 4321);
+		other.addBiome(
+		    {"core.plains", -0.2f, 0.f, 0.f, 12.f, grass, dirt, 3, stone});
+
+		bool differs = false;
+		for (int x = 0; x < 4 && !differs; ++x)
+		{
+			differs = generator.generate({x, 0, 0}).getBlocks() !=
+			          other.generate({x, 0, 0}).getBlocks();
+		}
+		REQUIRE(differs);
+	}
+
+	SECTION("Columns are shared by the chunks stacked in them")
+	{
+		for (int y = -4; y < 4; ++y)
+		{
+			generator.generate({7, y, -3});
+		}
+
+		const TerrainGenerator::ColumnStats stats =
+		    generator.getColumnStats();
+		REQUIRE(stats.misses == 1);
+		REQUIRE(stats.hits == 7);
+	}
+
+	SECTION("The ground is covered in the blocks of its biome")
+	{
+		const auto column = generator.getColumn(0, 0);
+		const std::vector<Chunk> stack =
+		    generator.generate({{0, -2, 0}, {0, -1, 0}, {0, 0, 0}, {0, 1, 0}},
+		                       1);
+
+		// the chunks of the stack as one tall list of blocks.
+		const auto blockAt = [&stack](int x, int y, int z) {
+			const BlockPos block(x, y, z);
+			return stack[static_cast<std::size_t>(block.getChunk().y + 2)]
+			    .getStorage()
+			    .get(block.getLocal().getIndex());
+		};
+
+		const int bottom = -2 * Chunk::CHUNK_HEIGHT;
+		const int top    = 2 * Chunk::CHUNK_HEIGHT - 1;
+		for (int z = 0; z < Chunk::CHUNK_DEPTH; ++z)
+		{
+			for (int x = 0; x < Chunk::CHUNK_WIDTH; ++x)
+			{
+				const Biome& biome = generator.getBiome(
+				    column->biome[TerrainGenerator::Column::getIndex(x, z)]);
+
+				// the topmost ground block is the surface of the biome,
+				// with filler under it.
+				int y = top;
+				while (y > bottom && blockAt(x, y, z) == air)
+				{
+					--y;
+				}
+				REQUIRE(y > bottom);
+				REQUIRE(blockAt(x, y, z) == biome.surface);
+				REQUIRE(blockAt(x, y - 1, z) != biome.stone);
+
+				// deep down is stone.
+				REQUIRE(blockAt(x, bottom, z) == biome.stone);
+			}
+		}
+	}
+
+	SECTION("Stages run in order and can be replaced")
+	{
+		REQUIRE(generator.getStages() ==
+		        std::vector<std::string> {"core.terrain", "core.surface"});
+
+		// turns the ground above the chunk's middle into sand.
+		generator.addStage("test.sand", [sand](TerrainGenerator::Context& c) {
+			for (std::size_t i = 0; i < c.blocks.size(); ++i)
+			{
+				if (LocalPos::fromIndex(i).y >= Chunk::CHUNK_HEIGHT / 2 &&
+				    c.blocks[i]->category == BlockCategory::SOLID)
+				{
+					c.blocks[i] = sand;
+				}
+			}
+		});
+		REQUIRE(generator.getStages().back() == "test.sand");
+
+		const Chunk chunk = generator.generate({0, -1, 0});
+		for (std::size_t i = 0; i < Chunk::CHUNK_MAX_BLOCKS; ++i)
+		{
+			if (LocalPos::fromIndex(i).y >= Chunk::CHUNK_HEIGHT / 2)
+			{
+				REQUIRE((chunk.getStorage().get(i) == air ||
+				         chunk.getStorage().get(i) == sand));
+			}
+		}
+
+		// without a terrain stage there's nothing but air.
+		generator.removeStage("core.terrain");
+		REQUIRE(generator.generate({0, -1, 0}).getStorage().isUniform());
+		REQUIRE(generator.generate({0, -1, 0}).getStorage().get(0) == air);
+	}
+
+	SECTION("Frozen generators keep their biomes and stages")
+	{
+		const Chunk before = generator.generate({1, -1, 1});
+
+		generator.freeze();
+		REQUIRE(generator.isFrozen());
+		REQUIRE_FALSE(generator.addBiome(
+		    {"core.plains", 0.f, 0.f, 40.f, 12.f, sand, sand, 3, sand}));
+		REQUIRE_FALSE(
+		    generator.addStage("test.air", [](TerrainGenerator::Context&) {}));
+		REQUIRE_FALSE(generator.removeStage("core.surface"));
+
+		REQUIRE(generator.getBiomeCount() == 2);
+		REQUIRE(generator.getStages() ==
+		        std::vector<std::string> {"core.terrain", "core.surface"});
+		REQUIRE(generator.generate({1, -1, 1}).getBlocks() ==
+		        before.getBlocks());
+	}
+
+	SECTION("Chunks made of a single block are stored as one")
+	{
+		REQUIRE(generator.generate({0, 20, 0}).isUniform());
+		REQUIRE(generator.generate({0, 20, 0}).isEmpty());
+		REQUIRE(generator.generate({0, -20, 0}).isUniform());
+		REQUIRE(generator.generate({0, -20, 0}).getSolidCount() ==
+		        Chunk::CHUNK_MAX_BLOCKS);
+	}
+}
+
+TEST_CASE("Terrain Generation Throughput", "[!benchmark][Terrain]")
+{
+	BlockReferrer referrer;
+	BlockType*    grass = addTestBlock(referrer, "core.grass");
+	BlockType*    dirt  = addTestBlock(referrer, "core.dirt");
+	BlockType*    stone = addTestBlock(referrer, "core.stone");
+
+	// 8x8 columns of 6 chunks, the vertical stack shares one column each.
+	const std::vector<phx::math::vec3i> area = getArea(4);
+	const std::size_t threads =
+	    std::max<std::size_t>(1, std::thread::hardware_concurrency());
+
+	int seed = 0;
+	const auto generate = [&](std::size_t count) {
+		// a new seed every time, so no columns are cached.
+		TerrainGenerator generator(&referrer,
+		                           static_cast<std::uint64_t>(++seed));
+		generator.addBiome(
+		    {"core.plains", 0.f, 0.f, 0.f, 12.f, grass, dirt, 3, stone});
+		return generator.generate(area, count).size();
+	};
+
+	BENCHMARK("Generate 384 chunks on 1 thread") { return generate(1); };
+
+	BENCHMARK("Generate 384 chunks on every core")
+	{
+		return generate(threads);
+	};
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <Common/Voxels/BlockReferrer.hpp>
+
+#include <string>
+
+namespace phx::voxels
+{
+	/**
+	 * @brief Registers a solid block for a test.
+	 * @param referrer The referrer to register the block with.
+	 * @param id The unique ID of the block.
+	 * @return The block that was registered.
+	 */
+	inline BlockType* addTestBlock(BlockReferrer&     referrer,
+	                               const std::string& id)
+	{
+		const auto uid = referrer.referrer.size();
+		BlockType  type;
+		type.displayName = id;
+		type.id          = id;
+		type.uid         = uid;
+		type.category    = BlockCategory::SOLID;
+		referrer.referrer.add(type.id, uid);
+		referrer.blocks.add(uid, type);
+
+		// like the game once its mods are loaded, changing the block
+		// afterwards needs another freeze.
+		referrer.freeze();
+		return referrer.blocks.get(uid);
+	}
+} // namespace phx::voxels
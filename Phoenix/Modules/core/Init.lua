@@ -94,3 +94,22 @@ register_block_pair({
     soundOnBreak = { "mod1.dirt_place" }
 })
 	
+
+voxel.terrain.registerBiome({
+    id = "core.plains",
+    surface = "core.grass",
+    filler = "core.dirt",
+    stone = "core.dirt",
+})
+
+voxel.terrain.registerBiome({
+    id = "core.hills",
+    temperature = -0.4,
+    humidity = 0.3,
+    height = 12,
+    variation = 28,
+    surface = "core.grass",
+    filler = "core.dirt",
+    fillerDepth = 5,
+    stone = "core.dirt",
+})
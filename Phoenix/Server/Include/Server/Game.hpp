@@ -30,9 +30,11 @@
 
 #include <Server/Commander.hpp>
 #include <Server/Iris.hpp>
+#include <Server/User.hpp>
 #include <Server/Voxels/BlockRegistry.hpp>
 
 #include <Common/Voxels/Map.hpp>
+#include <Common/Voxels/TerrainGenerator.hpp>
 
 #include <entt/entt.hpp>
 
@@ -57,6 +59,9 @@ namespace phx::server
 		/** @brief Loads all API's that the game utilizes into a CMS ModManager
 		 *
 		 * @param manager The mod manager to load the API into
+		 *
+		 * This includes registering biomes, so the mods have to be loaded
+		 * before the game is run.
 		 */
 		void registerAPI(cms::ModManager* manager);
 
@@ -74,7 +79,17 @@ namespace phx::server
 		/// @TODO Move this to a config file
 		static constexpr float dt = 1.f / 20.f;
 
+		/// @brief The most chunks added to the map each tick, the rest wait
+		/// for the next one.
+		static constexpr std::size_t CHUNKS_PER_TICK = 32;
+
 	private:
+		/**
+		 * @brief Loads the chunks a player can now see in the background,
+		 * sending each of them once it's loaded.
+		 */
+		void requestChunks(const Player& player);
+
 		/// @brief The main loop runs while this is true
 		bool m_running = false;
 		/// @brief The block registry to use.
@@ -85,7 +100,9 @@ namespace phx::server
 		net::Iris* m_iris;
 		/// @brief A commander object to process commands
 		Commander* m_commander;
-		/// @brief The map the players exist on
-		voxels::Map m_map;
+		/// @brief The map the players exist on, owned by the save.
+		voxels::Map* m_map;
+		/// @brief Generates the chunks of the map that were never saved.
+		std::shared_ptr<voxels::TerrainGenerator> m_terrain;
 	};
 } // namespace phx::server
\ No newline at end of file
@@ -36,6 +36,7 @@
 #include <Common/Input.hpp>
 #include <Common/Network/Host.hpp>
 #include <Common/Utility/BlockingQueue.hpp>
+#include <Common/Utility/Codec.hpp>
 #include <Common/Voxels/Chunk.hpp>
 
 #include <enet/enet.h>
@@ -61,7 +62,8 @@ namespace phx::server::net
 	{
 		enum class Type
 		{
-			CONNECT
+			CONNECT,
+			DISCONNECT
 		};
 		entt::entity player;
 		Type         type;
@@ -74,10 +76,10 @@ namespace phx::server::net
 		 * @brief Creates a networking object to handle listening for packets
 		 *
 		 * @param registry The shared EnTT registry
-		 * @param running Pointer to a boolean, the threaded function only runs
-		 * if this is true
+		 * @param metadataKeys The IDs metadata keys are sent with, the ones
+		 * of the save.
 		 */
-		explicit Iris(entt::registry* registry);
+		Iris(entt::registry* registry, MetadataDictionary* metadataKeys);
 
 		/**
 		 * @brief Cleans up any internal only objects
@@ -95,6 +97,9 @@ namespace phx::server::net
 		/**
 		 * @brief Actions taken when a user disconnects
 		 *
+		 * The player is left for the game to remove, it's the only thing
+		 * allowed to change the registry while it's running.
+		 *
 		 * @param userRef The user who disconnected
 		 */
 		void disconnect(std::size_t peerID);
@@ -162,9 +167,30 @@ namespace phx::server::net
 		 *
 		 * @param userID The user the data is being sent to
 		 * @param data The data to send (Currently, this is just a pointer to a chunk)
+		 *
+		 * Metadata keys the chunk numbered are sent to everyone first.
 		 */
 		void sendData(std::size_t userID, voxels::Chunk* data);
 
+		/**
+		 * @brief Sends every metadata key to a client that just connected.
+		 *
+		 * This has to happen before any chunk is sent to it, keys numbered
+		 * afterwards are sent by sendData.
+		 *
+		 * @param userID The user to send the keys to
+		 */
+		void sendMetadataKeys(std::size_t userID);
+
+		/**
+		 * @brief Sets how chunks are compressed before they're sent.
+		 * @param options The compression to use, codec::NETWORK by default.
+		 */
+		void setCompression(const codec::Options& options)
+		{
+			m_compression = options;
+		}
+
 		/**
 		 * @brief The Queue of events to process
 		 */
@@ -184,5 +210,11 @@ namespace phx::server::net
 		phx::net::Host*                               m_server;
 		entt::registry*                               m_registry;
 		std::unordered_map<std::size_t, entt::entity> m_users;
+		codec::Options                                m_compression =
+		    codec::NETWORK;
+
+		MetadataDictionary* m_metadataKeys;
+		/// @brief The metadata keys every connected client has been sent.
+		std::size_t m_sentMetadataKeys = 0;
 	};
 } // namespace phx::server::net
\ No newline at end of file
@@ -32,6 +32,7 @@
 #include <Common/Actor.hpp>
 #include <Common/PlayerView.hpp>
 
+#include <optional>
 #include <thread>
 
 using namespace phx;
@@ -40,7 +41,9 @@ using namespace phx::server;
 Game::Game(BlockRegistry* blockReg, entt::registry* registry,
            phx::server::net::Iris* iris, Save* save)
     : m_blockRegistry(blockReg), m_registry(registry), m_iris(iris),
-      m_map(voxels::Map(save, "map1", &blockReg->referrer))
+      m_map(save->getOrCreateMap("map1", &blockReg->referrer)),
+      m_terrain(std::make_shared<voxels::TerrainGenerator>(
+          &blockReg->referrer, save->getSeed()))
 {
 	m_commander = new Commander(m_iris);
 }
@@ -54,46 +57,77 @@ Game::~Game()
 void Game::registerAPI(cms::ModManager* manager)
 {
 	m_commander->registerAPI(manager);
+	m_terrain->registerAPI(manager);
 }
 
 void Game::run()
 {
+	// the mods have registered their blocks and biomes, nothing has been
+	// requested yet.
+	m_blockRegistry->referrer.freeze();
+	m_terrain->freeze();
+	m_map->setGenerator(m_terrain);
+
 	m_running = true;
 	while (m_running)
 	{
-		// Wait for a new input bundle from the network
-		if (m_iris->stateQueue.empty())
+		// Take a new input bundle from the network if there is one, the
+		// rest of the tick runs either way so the map keeps loading, sending
+		// and saving chunks while nobody is moving.
+		std::optional<net::StateBundle> m_currentState;
+		if (!m_iris->stateQueue.empty())
 		{
-			// This just keeps the CPU from spinning
-			std::this_thread::sleep_for(1_ms);
-			continue;
+			m_currentState = m_iris->stateQueue.pop();
 		}
-		net::StateBundle m_currentState = m_iris->stateQueue.pop();
 
 		// Process everybody's input first
-		for (const auto& state : m_currentState.states)
+		if (m_currentState)
+		{
+			for (const auto& state : m_currentState->states)
+			{
+				// the player might have left since sending it.
+				if (!m_registry->valid(state.first))
+				{
+					continue;
+				}
+
+				auto player = m_registry->get<Player>(state.first);
+				const Position& position =
+				    m_registry->get<Position>(player.actor);
+
+				const voxels::ChunkPos oldPos =
+				    position.getBlockPos().getChunk();
+				ActorSystem::tick(m_registry, player.actor, dt, state.second);
+				const voxels::ChunkPos newPos =
+				    position.getBlockPos().getChunk();
+				if (oldPos != newPos)
+				{
+					requestChunks(player);
+				}
+			}
+		}
+
+		// Add the chunks that finished loading, sending them to whoever
+		// asked for them.
+		m_map->update(CHUNKS_PER_TICK);
+
+		// Send chunks that changed this tick to everyone who can see them.
+		for (voxels::Chunk* chunk :
+		     m_map->getDirtyChunks(voxels::Chunk::NETWORK))
 		{
-			auto       player = m_registry->get<Player>(state.first);
-			math::vec3 pos = m_registry->get<Position>(player.actor).position;
-			const math::vec3i oldPos(
-			    static_cast<int>(pos.x) / voxels::Chunk::CHUNK_WIDTH,
-			    static_cast<int>(pos.y) / voxels::Chunk::CHUNK_HEIGHT,
-			    static_cast<int>(pos.z) / voxels::Chunk::CHUNK_DEPTH);
-			ActorSystem::tick(m_registry, player.actor, dt, state.second);
-			pos = m_registry->get<Position>(player.actor).position;
-			const math::vec3i newPos(
-			    static_cast<int>(pos.x) / voxels::Chunk::CHUNK_WIDTH,
-			    static_cast<int>(pos.y) / voxels::Chunk::CHUNK_HEIGHT,
-			    static_cast<int>(pos.z) / voxels::Chunk::CHUNK_DEPTH);
-			// TODO this needs fixed in the math lib
-			if (!(oldPos == newPos))
+			auto players = m_registry->view<Player>();
+			for (auto entity : players)
 			{
-				for (const auto& chunk :
-				     PlayerView::update(m_registry, player.actor))
+				const auto& player = players.get<Player>(entity);
+				const auto* view = m_registry->try_get<PlayerView>(player.actor);
+				if (view != nullptr &&
+				    view->chunks.contains(chunk->getChunkCoords()))
 				{
 					m_iris->sendData(player.id, chunk);
 				}
 			}
+
+			chunk->markClean(voxels::Chunk::NETWORK);
 		}
 
 		// Process events second
@@ -106,12 +140,23 @@ void Game::run()
 			case net::Event::Type::CONNECT:
 			{
 				auto entity = m_registry->get<Player>(event.player);
-				m_registry->emplace<PlayerView>(entity.actor, &m_map);
-				for (const auto& chunk :
-				     PlayerView::update(m_registry, entity.actor))
+				m_registry->emplace<PlayerView>(entity.actor, m_map);
+
+				// the chunks it's sent write metadata keys as IDs.
+				m_iris->sendMetadataKeys(entity.id);
+				requestChunks(entity);
+				break;
+			}
+			case net::Event::Type::DISCONNECT:
+			{
+				// the chunks it could see can be unloaded now.
+				const Player player = m_registry->get<Player>(event.player);
+				if (auto* view = m_registry->try_get<PlayerView>(player.actor))
 				{
-					m_iris->sendData(entity.id, chunk);
+					view->clear();
 				}
+				m_registry->destroy(player.actor);
+				m_registry->destroy(event.player);
 				break;
 			}
 			default:
@@ -130,8 +175,25 @@ void Game::run()
 		}
 
 		// Dispatch confirmation states
-		m_iris->sendState(m_registry, m_currentState.sequence);
+		if (m_currentState)
+		{
+			m_iris->sendState(m_registry, m_currentState->sequence);
+		}
+		else
+		{
+			// This just keeps the CPU from spinning
+			std::this_thread::sleep_for(1_ms);
+		}
 	}
 }
 
 void Game::kill() { m_running = false; }
+
+void Game::requestChunks(const Player& player)
+{
+	const auto id = player.id;
+	PlayerView::request(m_registry, player.actor,
+	                    [this, id](voxels::Chunk* chunk) {
+		                    m_iris->sendData(id, chunk);
+	                    });
+}
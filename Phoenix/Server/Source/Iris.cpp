@@ -42,7 +42,8 @@ using namespace phx::server::net;
 /// @todo Replace this with the config system
 static const std::size_t MAX_USERS = 32;
 
-Iris::Iris(entt::registry* registry) : m_registry(registry), m_running(false)
+Iris::Iris(entt::registry* registry, MetadataDictionary* metadataKeys)
+    : m_registry(registry), m_running(false), m_metadataKeys(metadataKeys)
 {
 	m_server = new phx::net::Host(phx::net::Address(7777), MAX_USERS, 4);
 
@@ -95,16 +96,22 @@ void Iris::run()
 void Iris::disconnect(std::size_t peerID)
 {
 	LOG_INFO("NETWORK") << peerID << " disconnected";
-	m_registry->destroy(m_users.at(peerID));
+
+	auto user = m_users.find(peerID);
+	if (user == m_users.end())
+	{
+		return;
+	}
+	eventQueue.push({user->second, Event::Type::DISCONNECT});
+	m_users.erase(user);
 }
 
 void Iris::parseEvent(std::size_t userID, Packet& packet)
 {
 	std::string data;
 
-	phx::Serializer ser;
-	ser.setBuffer(packet.getData());
-	ser >> data;
+	phx::Reader reader = packet.getReader();
+	reader >> data;
 
 	printf("Event received");
 	printf("An Event packet containing %s was received from %lu\n",
@@ -115,11 +122,12 @@ void Iris::parseState(std::size_t userID, phx::net::Packet& packet)
 {
 	InputState input;
 
-	auto data = packet.getData();
-
-	phx::Serializer ser;
-	ser.setBuffer(data.data(), packet.getSize());
-	ser >> input;
+	phx::Reader reader = packet.getReader(phx::Encoding::COMPACT);
+	reader >> input;
+	if (!reader)
+	{
+		return;
+	}
 
 	// If the queue is empty we need to add a new bundle
 	if (currentBundles.empty())
@@ -191,11 +199,12 @@ void Iris::parseMessage(std::size_t userID, phx::net::Packet& packet)
 {
 	std::string input;
 
-	auto data = packet.getData();
-
-	phx::Serializer ser;
-	ser.setBuffer(reinterpret_cast<std::byte*>(data.data()), data.size());
-	ser >> input;
+	phx::Reader reader = packet.getReader();
+	reader >> input;
+	if (!reader || input.empty())
+	{
+		return;
+	}
 
 	/// @TODO replace userID with userName
 	std::cout << userID << ": " << input << "\n";
@@ -217,8 +226,10 @@ void Iris::sendEvent(std::size_t userID, enet_uint8* data) {}
 
 void Iris::sendState(entt::registry* registry, std::size_t sequence)
 {
-	auto       view = registry->view<Position, Movement>();
-	Serializer ser;
+	auto view = registry->view<Position, Movement>();
+
+	// states are sent every tick, they're kept as small as possible.
+	Serializer ser(Encoding::COMPACT);
 	ser << sequence;
 	for (auto entity : view)
 	{
@@ -241,7 +252,37 @@ void Iris::sendMessage(std::size_t userID, const std::string& message)
 void Iris::sendData(std::size_t userID, voxels::Chunk* data)
 {
 	Serializer ser;
-	ser << *data;
+	ser << static_cast<char>(DataType::CHUNK);
+	data->send(ser, *m_metadataKeys);
+
+	// the chunk may have numbered new keys, everyone who could be sent it
+	// was sent the keys before these already.
+	if (m_metadataKeys->size() > m_sentMetadataKeys)
+	{
+		Serializer keys;
+		keys << static_cast<char>(DataType::METADATA_KEYS);
+		m_sentMetadataKeys =
+		    m_metadataKeys->writeNames(keys, m_sentMetadataKeys);
+
+		m_server->broadcast(Packet(keys.getBuffer(), PacketFlags::RELIABLE),
+		                    3);
+	}
+
+	// chunks are the bulk of what's sent, but they're sent to every player
+	// that gets near them so they need to be compressed quickly.
+	const phx::data::Data compressed = codec::compress(
+	    ser.getBuffer().data(), ser.getBuffer().size(), m_compression);
+	Packet packet = Packet(compressed, PacketFlags::RELIABLE);
+	Peer*  peer   = m_server->getPeer(userID);
+	peer->send(packet, 3);
+}
+
+void Iris::sendMetadataKeys(std::size_t userID)
+{
+	Serializer ser;
+	ser << static_cast<char>(DataType::METADATA_KEYS);
+	m_metadataKeys->writeNames(ser);
+
 	Packet packet = Packet(ser.getBuffer(), PacketFlags::RELIABLE);
 	Peer*  peer   = m_server->getPeer(userID);
 	peer->send(packet, 3);
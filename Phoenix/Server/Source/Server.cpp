@@ -47,7 +47,7 @@ Server::Server(const std::string& save)
     // must manually edit the JSON to load an another mod after initialization.
 	std::vector<std::string> commandLineModList = {"core", "chests", "mod3"};
 	m_save = new Save(save, commandLineModList);
-	m_iris = new server::net::Iris(&m_registry);
+	m_iris = new server::net::Iris(&m_registry, m_save->getMetadataKeys());
 	m_game = new Game(&m_blockRegistry, &m_registry, m_iris, m_save);
 }
 